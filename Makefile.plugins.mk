@@ -65,6 +65,12 @@ JACK_LIBS  += -lpthread
 endif # !HAIKU
 endif
 
+ifneq ($(WINDOWS),true)
+ifneq ($(MACOS),true)
+RENDER_LIBS = -lpthread
+endif
+endif
+
 # backwards compat
 BASE_FLAGS += -DHAVE_JACK
 
@@ -99,6 +105,9 @@ endif
 # Set plugin binary file targets
 
 jack       = $(TARGET_DIR)/$(NAME)$(APP_EXT)
+jack_dsp   = $(TARGET_DIR)/$(NAME)-headless$(APP_EXT)
+render     = $(TARGET_DIR)/$(NAME)-render$(APP_EXT)
+bench      = $(TARGET_DIR)/$(NAME)-bench$(APP_EXT)
 ladspa_dsp = $(TARGET_DIR)/$(NAME)-ladspa$(LIB_EXT)
 dssi_dsp   = $(TARGET_DIR)/$(NAME)-dssi$(LIB_EXT)
 dssi_ui    = $(TARGET_DIR)/$(NAME)-dssi/$(NAME)_ui$(APP_EXT)
@@ -180,6 +189,7 @@ endif
 
 ifeq ($(UI_TYPE),external)
 DGL_FLAGS += -DDGL_EXTERNAL
+DGL_LIBS  += $(SHARED_MEMORY_LIBS)
 HAVE_DGL   = true
 endif
 
@@ -279,6 +289,11 @@ $(BUILD_DIR)/DistrhoPluginMain_JACK.cpp.o: $(DPF_PATH)/distrho/DistrhoPluginMain
 	@echo "Compiling DistrhoPluginMain.cpp (JACK)"
 	$(SILENT)$(CXX) $< $(BUILD_CXX_FLAGS) -DDISTRHO_PLUGIN_TARGET_JACK $(JACK_FLAGS) -c -o $@
 
+$(BUILD_DIR)/DistrhoPluginMain_JACK_DSP.cpp.o: $(DPF_PATH)/distrho/DistrhoPluginMain.cpp
+	-@mkdir -p $(BUILD_DIR)
+	@echo "Compiling DistrhoPluginMain.cpp (JACK DSP-only)"
+	$(SILENT)$(CXX) $< $(BUILD_CXX_FLAGS) -DDISTRHO_PLUGIN_TARGET_JACK -DDISTRHO_PLUGIN_TARGET_JACK_DSP $(JACK_FLAGS) -c -o $@
+
 $(BUILD_DIR)/DistrhoUIMain_DSSI.cpp.o: $(DPF_PATH)/distrho/DistrhoUIMain.cpp
 	-@mkdir -p $(BUILD_DIR)
 	@echo "Compiling DistrhoUIMain.cpp (DSSI)"
@@ -298,6 +313,34 @@ endif
 	@echo "Creating JACK standalone for $(NAME)"
 	$(SILENT)$(CXX) $^ $(BUILD_CXX_FLAGS) $(LINK_FLAGS) $(DGL_LIBS) $(JACK_LIBS) -o $@
 
+# DSP-only JACK standalone, never links to DGL or any UI code
+jack_dsp: $(jack_dsp)
+
+$(jack_dsp): $(OBJS_DSP) $(BUILD_DIR)/DistrhoPluginMain_JACK_DSP.cpp.o
+	-@mkdir -p $(shell dirname $@)
+	@echo "Creating DSP-only JACK standalone for $(NAME)"
+	$(SILENT)$(CXX) $^ $(BUILD_CXX_FLAGS) $(LINK_FLAGS) $(JACK_LIBS) -o $@
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Offline renderer
+
+render: $(render)
+
+$(render): $(OBJS_DSP) $(BUILD_DIR)/DistrhoPluginMain_RENDER.cpp.o
+	-@mkdir -p $(shell dirname $@)
+	@echo "Creating offline renderer for $(NAME)"
+	$(SILENT)$(CXX) $^ $(BUILD_CXX_FLAGS) $(LINK_FLAGS) $(RENDER_LIBS) -o $@
+
+# ---------------------------------------------------------------------------------------------------------------------
+# DSP benchmark
+
+bench: $(bench)
+
+$(bench): $(OBJS_DSP) $(BUILD_DIR)/DistrhoPluginMain_BENCH.cpp.o
+	-@mkdir -p $(shell dirname $@)
+	@echo "Creating DSP benchmark for $(NAME)"
+	$(SILENT)$(CXX) $^ $(BUILD_CXX_FLAGS) $(LINK_FLAGS) -o $@
+
 # ---------------------------------------------------------------------------------------------------------------------
 # LADSPA
 
@@ -383,6 +426,9 @@ ifneq ($(UI_TYPE),)
 endif
 
 -include $(BUILD_DIR)/DistrhoPluginMain_JACK.cpp.d
+-include $(BUILD_DIR)/DistrhoPluginMain_JACK_DSP.cpp.d
+-include $(BUILD_DIR)/DistrhoPluginMain_RENDER.cpp.d
+-include $(BUILD_DIR)/DistrhoPluginMain_BENCH.cpp.d
 -include $(BUILD_DIR)/DistrhoPluginMain_LADSPA.cpp.d
 -include $(BUILD_DIR)/DistrhoPluginMain_DSSI.cpp.d
 -include $(BUILD_DIR)/DistrhoPluginMain_LV2.cpp.d
@@ -71,10 +71,10 @@ include(CMakeParseArguments)
 #
 #   `TARGETS` <tgt1>...<tgtN>
 #       a list of one of more of the following target types:
-#       `jack`, `ladspa`, `dssi`, `lv2`, `vst2`
+#       `jack`, `jack_dsp`, `render`, `bench`, `ladspa`, `dssi`, `lv2`, `vst2`
 #
 #   `UI_TYPE` <type>
-#       the user interface type: `opengl` (default), `cairo`
+#       the user interface type: `opengl` (default), `cairo`, `external`
 #
 #   `MONOLITHIC`
 #       build LV2 as a single binary for UI and DSP
@@ -107,6 +107,9 @@ function(dpf_add_plugin NAME)
     elseif(_dpf_plugin_UI_TYPE STREQUAL "opengl")
       dpf__add_dgl_opengl()
       set(_dgl_library dgl-opengl)
+    elseif(_dpf_plugin_UI_TYPE STREQUAL "external")
+      dpf__add_dgl_external()
+      set(_dgl_library dgl-external)
     else()
       message(FATAL_ERROR "Unrecognized UI type for plugin: ${_dpf_plugin_UI_TYPE}")
     endif()
@@ -125,8 +128,11 @@ function(dpf_add_plugin NAME)
   if(_dgl_library)
     # make sure that all code will see DGL_* definitions
     target_link_libraries("${NAME}" PUBLIC
-      "${_dgl_library}-definitions"
-      dgl-system-libs-definitions)
+      "${_dgl_library}-definitions")
+    if(NOT _dpf_plugin_UI_TYPE STREQUAL "external")
+      target_link_libraries("${NAME}" PUBLIC
+        dgl-system-libs-definitions)
+    endif()
   endif()
 
   dpf__add_static_library("${NAME}-dsp" ${_dpf_plugin_FILES_DSP})
@@ -136,7 +142,9 @@ function(dpf_add_plugin NAME)
     dpf__add_static_library("${NAME}-ui" ${_dpf_plugin_FILES_UI})
     target_link_libraries("${NAME}-ui" PUBLIC "${NAME}" ${_dgl_library})
     # add the files containing Objective-C classes, recompiled under namespace
-    dpf__add_plugin_specific_ui_sources("${NAME}-ui")
+    if(NOT _dpf_plugin_UI_TYPE STREQUAL "external")
+      dpf__add_plugin_specific_ui_sources("${NAME}-ui")
+    endif()
   else()
     add_library("${NAME}-ui" INTERFACE)
   endif()
@@ -145,6 +153,12 @@ function(dpf_add_plugin NAME)
   foreach(_target ${_dpf_plugin_TARGETS})
     if(_target STREQUAL "jack")
       dpf__build_jack("${NAME}" "${_dgl_library}")
+    elseif(_target STREQUAL "jack_dsp")
+      dpf__build_jack_dsp("${NAME}")
+    elseif(_target STREQUAL "render")
+      dpf__build_render("${NAME}")
+    elseif(_target STREQUAL "bench")
+      dpf__build_bench("${NAME}")
     elseif(_target STREQUAL "ladspa")
       dpf__build_ladspa("${NAME}")
     elseif(_target STREQUAL "dssi")
@@ -196,6 +210,72 @@ function(dpf__build_jack NAME DGL_LIBRARY)
   endif()
 endfunction()
 
+# dpf__build_jack_dsp
+# ------------------------------------------------------------------------------
+#
+# Add build rules for a DSP-only JACK program, without any UI code.
+#
+function(dpf__build_jack_dsp NAME)
+  dpf__create_dummy_source_list(_no_srcs)
+
+  dpf__add_executable("${NAME}-jack-dsp" ${_no_srcs})
+  dpf__add_plugin_main("${NAME}-jack-dsp" "jack")
+  dpf__add_plugin_target_definition("${NAME}-jack-dsp" "jack_dsp")
+  target_link_libraries("${NAME}-jack-dsp" PRIVATE "${NAME}-dsp")
+  set_target_properties("${NAME}-jack-dsp" PROPERTIES
+    RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin/$<0:>"
+    OUTPUT_NAME "${NAME}-headless")
+
+  # Note: libjack will be linked at runtime
+  if((NOT WIN32) AND (NOT APPLE) AND (NOT HAIKU))
+    target_link_libraries("${NAME}-jack-dsp" PRIVATE "dl")
+  endif()
+
+  # for RtAudio native fallback
+  if(APPLE)
+    find_library(APPLE_COREAUDIO_FRAMEWORK "CoreAudio")
+    find_library(APPLE_COREFOUNDATION_FRAMEWORK "CoreFoundation")
+    target_link_libraries("${NAME}-jack-dsp" PRIVATE "${APPLE_COREAUDIO_FRAMEWORK}" "${APPLE_COREFOUNDATION_FRAMEWORK}")
+  endif()
+endfunction()
+
+# dpf__build_render
+# ------------------------------------------------------------------------------
+#
+# Add build rules for an offline renderer program.
+#
+function(dpf__build_render NAME)
+  dpf__create_dummy_source_list(_no_srcs)
+
+  dpf__add_executable("${NAME}-render" ${_no_srcs})
+  dpf__add_plugin_main("${NAME}-render" "render")
+  target_link_libraries("${NAME}-render" PRIVATE "${NAME}-dsp")
+  set_target_properties("${NAME}-render" PROPERTIES
+    RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin/$<0:>"
+    OUTPUT_NAME "${NAME}-render")
+
+  if((NOT WIN32) AND (NOT APPLE) AND (NOT HAIKU))
+    find_package(Threads REQUIRED)
+    target_link_libraries("${NAME}-render" PRIVATE Threads::Threads)
+  endif()
+endfunction()
+
+# dpf__build_bench
+# ------------------------------------------------------------------------------
+#
+# Add build rules for a DSP benchmark program.
+#
+function(dpf__build_bench NAME)
+  dpf__create_dummy_source_list(_no_srcs)
+
+  dpf__add_executable("${NAME}-bench" ${_no_srcs})
+  dpf__add_plugin_main("${NAME}-bench" "bench")
+  target_link_libraries("${NAME}-bench" PRIVATE "${NAME}-dsp")
+  set_target_properties("${NAME}-bench" PROPERTIES
+    RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin/$<0:>"
+    OUTPUT_NAME "${NAME}-bench")
+endfunction()
+
 # dpf__build_ladspa
 # ------------------------------------------------------------------------------
 #
@@ -337,11 +417,13 @@ function(dpf__add_dgl_cairo)
   dpf__add_static_library(dgl-cairo STATIC
     "${DPF_ROOT_DIR}/dgl/src/Application.cpp"
     "${DPF_ROOT_DIR}/dgl/src/ApplicationPrivateData.cpp"
+    "${DPF_ROOT_DIR}/dgl/src/AsyncImageLoader.cpp"
     "${DPF_ROOT_DIR}/dgl/src/Color.cpp"
     "${DPF_ROOT_DIR}/dgl/src/EventHandlers.cpp"
     "${DPF_ROOT_DIR}/dgl/src/Geometry.cpp"
     "${DPF_ROOT_DIR}/dgl/src/ImageBase.cpp"
     "${DPF_ROOT_DIR}/dgl/src/ImageBaseWidgets.cpp"
+    "${DPF_ROOT_DIR}/dgl/src/ImageConversion.cpp"
     "${DPF_ROOT_DIR}/dgl/src/Resources.cpp"
     "${DPF_ROOT_DIR}/dgl/src/SubWidget.cpp"
     "${DPF_ROOT_DIR}/dgl/src/SubWidgetPrivateData.cpp"
@@ -398,11 +480,13 @@ function(dpf__add_dgl_opengl)
   dpf__add_static_library(dgl-opengl STATIC
     "${DPF_ROOT_DIR}/dgl/src/Application.cpp"
     "${DPF_ROOT_DIR}/dgl/src/ApplicationPrivateData.cpp"
+    "${DPF_ROOT_DIR}/dgl/src/AsyncImageLoader.cpp"
     "${DPF_ROOT_DIR}/dgl/src/Color.cpp"
     "${DPF_ROOT_DIR}/dgl/src/EventHandlers.cpp"
     "${DPF_ROOT_DIR}/dgl/src/Geometry.cpp"
     "${DPF_ROOT_DIR}/dgl/src/ImageBase.cpp"
     "${DPF_ROOT_DIR}/dgl/src/ImageBaseWidgets.cpp"
+    "${DPF_ROOT_DIR}/dgl/src/ImageConversion.cpp"
     "${DPF_ROOT_DIR}/dgl/src/Resources.cpp"
     "${DPF_ROOT_DIR}/dgl/src/SubWidget.cpp"
     "${DPF_ROOT_DIR}/dgl/src/SubWidgetPrivateData.cpp"
@@ -440,6 +524,32 @@ function(dpf__add_dgl_opengl)
   target_link_libraries(dgl-opengl PRIVATE dgl-opengl-definitions "${OPENGL_gl_LIBRARY}")
 endfunction()
 
+# dpf__add_dgl_external
+# ------------------------------------------------------------------------------
+#
+# Add the external UI variant of DGL, if not already available.
+# There is no DGL code to build, only definitions and the shared memory library.
+#
+function(dpf__add_dgl_external)
+  if(TARGET dgl-external)
+    return()
+  endif()
+
+  add_library(dgl-external INTERFACE)
+  target_include_directories(dgl-external INTERFACE
+    "${DPF_ROOT_DIR}/dgl")
+
+  add_library(dgl-external-definitions INTERFACE)
+  target_compile_definitions(dgl-external-definitions INTERFACE "DGL_EXTERNAL" "HAVE_DGL")
+
+  # for shm_open and shm_unlink, needed by ExternalChannel with older glibc
+  if((NOT WIN32) AND (NOT APPLE) AND (NOT HAIKU))
+    target_link_libraries(dgl-external INTERFACE "rt")
+  endif()
+
+  target_link_libraries(dgl-external INTERFACE dgl-external-definitions)
+endfunction()
+
 # dpf__add_plugin_specific_ui_sources
 # ------------------------------------------------------------------------------
 #
@@ -774,6 +774,12 @@ public:
     */
     bool containsY(const T& y) const noexcept;
 
+   /**
+      Check if this rectangle and @a rect overlap.
+      Rectangles that only touch at their edges do not overlap.
+    */
+    bool intersects(const Rectangle<T>& rect) const noexcept;
+
    /**
       Return true if size is null (0x0).
       An null size is also invalid.
@@ -36,6 +36,7 @@ START_NAMESPACE_DGL
 // Forward class names
 
 class NanoVG;
+struct NanoImageAsyncLoad;
 
 // -----------------------------------------------------------------------
 // NanoImage
@@ -98,9 +99,16 @@ public:
     */
     GLuint getTextureHandle() const;
 
+   /**
+      Whether this image is still being loaded in the background.
+      @see NanoVG::loadImageFromFileAsync
+    */
+    bool isLoading() const noexcept;
+
 private:
     Handle fHandle;
     Size<uint> fSize;
+    NanoImageAsyncLoad* fAsyncLoad;
     friend class NanoVG;
 
    /** @internal */
@@ -203,6 +211,10 @@ private:
    @endcode
 
    Note: currently only solid color fill is supported for text.
+
+   Rasterized glyphs are cached process-wide, so other windows and plugin instances using the same font
+   do not rasterize them again. This is only a rasterization cache, each context still keeps its own
+   glyph atlas texture and uploads the glyphs it uses into it.
  */
 class NanoVG
 {
@@ -605,6 +617,38 @@ public:
     */
     NanoImage::Handle createImageFromTextureHandle(GLuint textureId, uint w, uint h, int imageFlags, bool deleteTexture = false);
 
+   /**
+      Load an image from the disk in the background, replacing the current contents of @a image.
+      Decoding happens in a shared pool of threads, so many images can be loaded in parallel
+      without blocking the UI thread.
+
+      @a image stays invalid until decoding finishes, then its texture is created on the next beginFrame().
+      Windows are repainted when that happens, meanwhile drawing code should skip the image
+      or draw a placeholder, see NanoImage::isLoading().
+      Returns false if loading could not be started.
+    */
+    bool loadImageFromFileAsync(NanoImage& image, const char* filename, ImageFlags imageFlags);
+
+   /**
+      Load an image from the disk in the background.
+      Overloaded function for convenience.
+      @see ImageFlags
+    */
+    bool loadImageFromFileAsync(NanoImage& image, const char* filename, int imageFlags);
+
+   /**
+      Load an image from the specified chunk of memory in the background, see loadImageFromFileAsync().
+      The data is copied, it does not need to stay valid after this call.
+    */
+    bool loadImageFromMemoryAsync(NanoImage& image, const uchar* data, uint dataSize, ImageFlags imageFlags);
+
+   /**
+      Load an image from the specified chunk of memory in the background.
+      Overloaded function for convenience.
+      @see ImageFlags
+    */
+    bool loadImageFromMemoryAsync(NanoImage& image, const uchar* data, uint dataSize, int imageFlags);
+
    /* --------------------------------------------------------------------
     * Paints */
 
@@ -862,6 +906,12 @@ private:
     bool fInFrame;
     bool fIsSubWidget;
 
+   /** @internal */
+    bool _startAsyncLoad(NanoImage& image, NanoImageAsyncLoad* load);
+
+   /** @internal */
+    void _processAsyncLoads();
+
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NanoVG)
 };
 
@@ -168,6 +168,11 @@ GLenum asOpenGLImageFormat(const ImageFormat format)
 
 // -----------------------------------------------------------------------
 
+// texture shared between images with the same data, opaque to the outside
+struct OpenGLTexture;
+
+// -----------------------------------------------------------------------
+
 /**
    OpenGL Image class.
 
@@ -179,6 +184,12 @@ GLenum asOpenGLImageFormat(const ImageFormat format)
    instead of the default 'GL_BGRA'.
 
    Images are drawn on screen via 2D textures.
+   Textures are created on first draw and shared between all images using the same raw data pointer
+   within the same OpenGL context, so the same data is only uploaded once.
+   Small images are packed together into bigger atlas textures.
+   After changing the contents of the raw data, call loadFromMemory() again (even with the same pointer),
+   so that all images using it upload the new contents.
+   The deprecated drawing calls without a graphics context do not share textures.
  */
 class OpenGLImage : public ImageBase
 {
@@ -281,8 +292,7 @@ public:
     GLenum getType() const noexcept { return GL_UNSIGNED_BYTE; }
 
 private:
-    GLuint textureId;
-    bool setupCalled;
+    OpenGLTexture* texture;
 };
 
 // -----------------------------------------------------------------------
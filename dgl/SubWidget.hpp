@@ -158,6 +158,23 @@ public:
     */
     void setSkipDrawing(bool skipDrawing = true);
 
+   /**
+      Check if this subwidget is drawn from a cache.
+      @see setCached
+    */
+    bool isCached() const noexcept;
+
+   /**
+      Indicate that this subwidget and its children should be drawn from a cache.
+      The subwidget is drawn once into an offscreen framebuffer or surface, which is then reused on every frame
+      until repaint() is called on it or any of its children.
+      This is meant for static content like backgrounds, labels and panel art.
+
+      Drawing outside of the subwidget bounds, including children placed outside of them, is cut off while cached.
+      If a cache cannot be created (e.g. missing OpenGL framebuffer support) the subwidget is drawn as usual.
+    */
+    void setCached(bool cached = true);
+
 protected:
    /**
       A function called when the subwidget's absolute position is changed.
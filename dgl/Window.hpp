@@ -295,6 +295,65 @@ public:
     */
     void setIgnoringKeyRepeat(bool ignore) noexcept;
 
+   /**
+      Check if partial repaints are enabled.
+      @see setPartialRepaintEnabled
+    */
+    bool isPartialRepaintEnabled() const noexcept;
+
+   /**
+      Enable or disable partial repaints.
+      When enabled, only the area marked as dirty through repaint(const Rectangle<uint>&) or by the system is redrawn,
+      with drawing clipped to it and subwidgets outside of it not being drawn at all.
+
+      This requires the window contents to be preserved between frames.
+      That is the case for Cairo, where partial repaints are enabled by default,
+      but not guaranteed for OpenGL where the back buffer can be undefined after swapping.
+      Only enable this for OpenGL if you know the system keeps the back buffer contents.
+      NanoVG drawing is clipped to the dirty area too, its flush keeps the scissor test enabled during partial repaints.
+    */
+    void setPartialRepaintEnabled(bool enabled) noexcept;
+
+   /**
+      Check if geometry batching is enabled.
+      @see setGeometryBatchingEnabled
+    */
+    bool isGeometryBatchingEnabled() const noexcept;
+
+   /**
+      Enable or disable geometry batching, only used with OpenGL.
+      When enabled, primitives (Line, Circle, Triangle and Rectangle) are not drawn right away,
+      but collected and drawn together with as few draw calls as possible.
+      They are drawn at the latest when a widget's onDisplay returns, or before an image is drawn.
+
+      Only enable this if widgets do not mix primitives with raw OpenGL or NanoVG calls,
+      as those would be drawn out of order.
+      Colors and line widths must be set through DGL too (Color::setFor and the line width arguments of draw calls),
+      as the current OpenGL state is not queried for each primitive.
+    */
+    void setGeometryBatchingEnabled(bool enabled) noexcept;
+
+   /**
+      Get the highest rate at which this window is redrawn, in frames per second.
+      @see setMaxFrameRate
+    */
+    uint getMaxFrameRate() const noexcept;
+
+   /**
+      Limit how often this window is redrawn, in frames per second, or 0 for no limit (the default).
+      Repaint requests made faster than this are merged together and drawn in a single frame,
+      sent from a timer once enough time has passed since the previous one.
+
+      Regardless of this setting, repaint requests made while a frame is on its way are merged and sent after it is drawn,
+      and windows that are hidden or minimized are not redrawn until shown again.
+    */
+    void setMaxFrameRate(uint fps) noexcept;
+
+   /**
+      Get how long it took to draw the last frame, in milliseconds.
+    */
+    double getLastFrameTime() const noexcept;
+
    /**
       Add a callback function to be triggered on every idle cycle or on a specific timer frequency.
       You can add more than one, and remove them at anytime with removeIdleCallback().
@@ -0,0 +1,290 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "AsyncImageLoader.hpp"
+
+#include "../../distrho/extra/Mutex.hpp"
+#include "../../distrho/extra/Thread.hpp"
+
+#include <list>
+
+#ifdef DISTRHO_OS_WINDOWS
+# include <windows.h>
+#else
+# include <unistd.h>
+#endif
+
+START_NAMESPACE_DGL
+
+// --------------------------------------------------------------------------------------------------------------------
+
+enum AsyncImageJobState {
+    kAsyncImageJobIdle,
+    kAsyncImageJobQueued,
+    kAsyncImageJobDecoding,
+    kAsyncImageJobDone
+};
+
+/**
+   The most background threads used for decoding.
+   Fewer are used on machines with less CPUs, always leaving one free for the UI thread.
+ */
+static const uint kMaxAsyncImageThreads = 4;
+
+static uint getNumberOfAsyncImageThreads()
+{
+#ifdef DISTRHO_OS_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const uint count = info.dwNumberOfProcessors;
+#else
+    const long ret = sysconf(_SC_NPROCESSORS_ONLN);
+    const uint count = ret > 0 ? static_cast<uint>(ret) : 1;
+#endif
+
+    return std::max(1u, std::min(count - 1, kMaxAsyncImageThreads));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct AsyncImageLoader {
+    class Worker : public Thread
+    {
+    public:
+        Worker(AsyncImageLoader& l)
+            : Thread("AsyncImageLoader"),
+              idle(false),
+              loader(l),
+              signal() {}
+
+        // whether waiting for new jobs, protected by the loader mutex
+        bool idle;
+
+        void wakeUp() noexcept
+        {
+            signal.signal();
+        }
+
+        void stop() noexcept
+        {
+            signalThreadShouldExit();
+            signal.signal();
+            stopThread(-1);
+        }
+
+    protected:
+        void run() override
+        {
+            while (! shouldThreadExit())
+            {
+                if (AsyncImageJob* const job = loader.takeJob(this))
+                {
+                    job->decode();
+                    loader.finishJob(job);
+                }
+                else
+                {
+                    signal.wait();
+                }
+            }
+        }
+
+    private:
+        AsyncImageLoader& loader;
+        Signal signal;
+    };
+
+    Mutex mutex;
+    std::list<AsyncImageJob*> jobs;
+    Worker* workers[kMaxAsyncImageThreads];
+    uint numWorkers;
+    uint finishedCount;
+
+    AsyncImageLoader()
+        : mutex(),
+          jobs(),
+          numWorkers(0),
+          finishedCount(0)
+    {
+        std::memset(workers, 0, sizeof(workers));
+    }
+
+    ~AsyncImageLoader()
+    {
+        for (uint i = 0; i < numWorkers; ++i)
+        {
+            workers[i]->stop();
+            delete workers[i];
+        }
+    }
+
+    void queueJob(AsyncImageJob* const job)
+    {
+        Worker* idleWorker = nullptr;
+
+        {
+            const MutexLocker cml(mutex);
+
+            DISTRHO_SAFE_ASSERT_RETURN(job->state == kAsyncImageJobIdle,);
+            job->state = kAsyncImageJobQueued;
+            jobs.push_back(job);
+
+            // a single job only needs a single worker
+            for (uint i = 0; i < numWorkers; ++i)
+            {
+                if (workers[i]->idle)
+                {
+                    idleWorker = workers[i];
+                    idleWorker->idle = false;
+                    break;
+                }
+            }
+
+            // threads are only created once needed, so plugins without async images pay nothing
+            if (idleWorker == nullptr && numWorkers < getNumberOfAsyncImageThreads())
+            {
+                Worker* const worker = new Worker(*this);
+
+                if (worker->startThread())
+                    workers[numWorkers++] = worker;
+                else
+                    delete worker;
+            }
+        }
+
+        if (idleWorker != nullptr)
+            idleWorker->wakeUp();
+    }
+
+    AsyncImageJob* takeJob(Worker* const worker)
+    {
+        const MutexLocker cml(mutex);
+
+        if (jobs.empty())
+        {
+            worker->idle = true;
+            return nullptr;
+        }
+
+        AsyncImageJob* const job = jobs.front();
+        jobs.pop_front();
+        job->state = kAsyncImageJobDecoding;
+        return job;
+    }
+
+    void finishJob(AsyncImageJob* const job)
+    {
+        bool released;
+
+        {
+            const MutexLocker cml(mutex);
+            job->state = kAsyncImageJobDone;
+            released = job->released;
+            ++finishedCount;
+        }
+
+        if (released)
+            delete job;
+    }
+
+    void releaseJob(AsyncImageJob* const job)
+    {
+        {
+            const MutexLocker cml(mutex);
+
+            switch (job->state)
+            {
+            case kAsyncImageJobQueued:
+                jobs.remove(job);
+                break;
+            case kAsyncImageJobDecoding:
+                // deleted by the worker thread once done
+                job->released = true;
+                return;
+            }
+        }
+
+        delete job;
+    }
+
+    bool isJobDone(const AsyncImageJob* const job)
+    {
+        const MutexLocker cml(mutex);
+        return job->state == kAsyncImageJobDone;
+    }
+
+    uint getFinishedCount()
+    {
+        const MutexLocker cml(mutex);
+        return finishedCount;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(AsyncImageLoader)
+};
+
+// created on first use, see initAsyncImageLoader
+static AsyncImageLoader& getAsyncImageLoader()
+{
+    static AsyncImageLoader loader;
+    return loader;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+AsyncImageJob::AsyncImageJob() noexcept
+    : state(kAsyncImageJobIdle),
+      released(false) {}
+
+AsyncImageJob::~AsyncImageJob() {}
+
+bool AsyncImageJob::isDone() const noexcept
+{
+    return getAsyncImageLoader().isJobDone(this);
+}
+
+void initAsyncImageLoader(void (*const setupDecoding)())
+{
+    AsyncImageLoader& loader(getAsyncImageLoader());
+
+    if (setupDecoding != nullptr)
+    {
+        const MutexLocker cml(loader.mutex);
+        setupDecoding();
+    }
+}
+
+void queueAsyncImageJob(AsyncImageJob* const job)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(job != nullptr,);
+
+    getAsyncImageLoader().queueJob(job);
+}
+
+void releaseAsyncImageJob(AsyncImageJob* const job)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(job != nullptr,);
+
+    getAsyncImageLoader().releaseJob(job);
+}
+
+uint getAsyncImageJobsFinishedCount() noexcept
+{
+    return getAsyncImageLoader().getFinishedCount();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DGL
@@ -0,0 +1,78 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DGL_ASYNC_IMAGE_LOADER_HPP_INCLUDED
+#define DGL_ASYNC_IMAGE_LOADER_HPP_INCLUDED
+
+#include "../Base.hpp"
+
+START_NAMESPACE_DGL
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Image decoding work to run on the shared pool of background threads.
+   Subclasses implement decode(), everything else (uploading to the GPU, etc) happens on the UI thread
+   once isDone() returns true.
+ */
+struct AsyncImageJob {
+    AsyncImageJob() noexcept;
+    virtual ~AsyncImageJob();
+
+    /** Decode the image, called from a background thread. */
+    virtual void decode() = 0;
+
+    /** Whether decode() has finished. */
+    bool isDone() const noexcept;
+
+private:
+    friend struct AsyncImageLoader;
+    int state;
+    bool released;
+
+    DISTRHO_DECLARE_NON_COPYABLE(AsyncImageJob)
+};
+
+/**
+   Make sure the shared loader exists, without starting any threads.
+   Objects that can release jobs call this when constructed, so the loader is destroyed after them on exit.
+   @a setupDecoding, if not null, is called with the loader locked.
+   Use it for global decoder options, it must only change them the first time so running jobs never see them change.
+ */
+void initAsyncImageLoader(void (*setupDecoding)() = nullptr);
+
+/**
+   Queue a job for decoding in the background.
+   The caller keeps ownership until releaseAsyncImageJob() is called.
+ */
+void queueAsyncImageJob(AsyncImageJob* job);
+
+/**
+   Give up a job, the caller must not use it afterwards.
+   Jobs still in the queue are deleted right away, jobs being decoded are deleted once decoding finishes.
+ */
+void releaseAsyncImageJob(AsyncImageJob* job);
+
+/**
+   Get the amount of jobs finished so far, used by windows to repaint when new images are ready.
+ */
+uint getAsyncImageJobsFinishedCount() noexcept;
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DGL
+
+#endif // DGL_ASYNC_IMAGE_LOADER_HPP_INCLUDED
@@ -24,11 +24,14 @@
 #include "../Color.hpp"
 #include "../ImageBaseWidgets.hpp"
 
+#include "ImageConversion.hpp"
 #include "SubWidgetPrivateData.hpp"
 #include "TopLevelWidgetPrivateData.hpp"
 #include "WidgetPrivateData.hpp"
 #include "WindowPrivateData.hpp"
 
+#include "../../distrho/extra/Mutex.hpp"
+
 // templated classes
 #include "ImageBaseWidgets.cpp"
 
@@ -290,7 +293,6 @@ static cairo_format_t asCairoImageFormat(const ImageFormat format) noexcept
     case kImageFormatNull:
         break;
     case kImageFormatGrayscale:
-        return CAIRO_FORMAT_A8;
     case kImageFormatBGR:
     case kImageFormatRGB:
         return CAIRO_FORMAT_RGB24;
@@ -379,7 +381,7 @@ void CairoImage::loadFromMemory(const char* const rdata, const Size<uint>& s, co
     const int height = static_cast<int>(s.getHeight());
     const int stride = cairo_format_stride_for_width(cairoformat, width);
 
-    uchar* const newdata = (uchar*)std::malloc(static_cast<size_t>(width * height * stride * 4));
+    uchar* const newdata = (uchar*)std::malloc(static_cast<size_t>(height * stride));
     DISTRHO_SAFE_ASSERT_RETURN(newdata != nullptr,);
 
     cairo_surface_t* const newsurface = cairo_image_surface_create_for_data(newdata, cairoformat, width, height, stride);
@@ -398,58 +400,12 @@ void CairoImage::loadFromMemory(const char* const rdata, const Size<uint>& s, co
     surfacedata = newdata;
     *datarefcount = 1;
 
-    switch (fmt)
-    {
-    case kImageFormatNull:
-        break;
-    case kImageFormatGrayscale:
-        // Grayscale to A8
-        // TODO
-        break;
-    case kImageFormatBGR:
-        // BGR8 to CAIRO_FORMAT_RGB24
-        for (int h = 0; h < height; ++h)
-        {
-            for (int w = 0; w < width; ++w)
-            {
-                newdata[h*width*4+w*4+0] = static_cast<uchar>(rdata[h*width*3+w*3+0]);
-                newdata[h*width*4+w*4+1] = static_cast<uchar>(rdata[h*width*3+w*3+1]);
-                newdata[h*width*4+w*4+2] = static_cast<uchar>(rdata[h*width*3+w*3+2]);
-                newdata[h*width*4+w*4+3] = 0;
-            }
-        }
-        break;
-    case kImageFormatBGRA:
-        // BGRA8 to CAIRO_FORMAT_ARGB32
-        // FIXME something is wrong here...
-        for (int h = 0, t; h < height; ++h)
-        {
-            for (int w = 0; w < width; ++w)
-            {
-                if ((t = rdata[h*width*4+w*4+3]) != 0)
-                {
-                    newdata[h*width*4+w*4+0] = static_cast<uchar>(rdata[h*width*4+w*4+0]);
-                    newdata[h*width*4+w*4+1] = static_cast<uchar>(rdata[h*width*4+w*4+1]);
-                    newdata[h*width*4+w*4+2] = static_cast<uchar>(rdata[h*width*4+w*4+2]);
-                    newdata[h*width*4+w*4+3] = static_cast<uchar>(t);
-                }
-                else
-                {
-                    // make all pixels zero, cairo does not render full transparency otherwise
-                    memset(&newdata[h*width*4+w*4], 0, 4);
-                }
-            }
-        }
-        break;
-    case kImageFormatRGB:
-        // RGB8 to CAIRO_FORMAT_RGB24
-        // TODO
-        break;
-    case kImageFormatRGBA:
-        // RGBA8 to CAIRO_FORMAT_ARGB32
-        // TODO
-        break;
-    }
+    // CAIRO_FORMAT_RGB24 and CAIRO_FORMAT_ARGB32 are both BGRA in memory (on little-endian),
+    // the latter with premultiplied alpha. Grayscale is expanded into RGB24.
+    if (rdata != nullptr && fmt != kImageFormatNull)
+        convertImageData(reinterpret_cast<const uchar*>(rdata), fmt, s.getWidth() * getImageFormatPixelSize(fmt),
+                         newdata, kImageFormatBGRA, static_cast<uint>(stride),
+                         s.getWidth(), s.getHeight(), true);
 
     ImageBase::loadFromMemory(rdata, s, fmt);
 }
@@ -591,20 +547,6 @@ template class ImageBaseButton<CairoImage>;
 // -----------------------------------------------------------------------
 // ImageBaseKnob
 
-template <>
-void ImageBaseKnob<CairoImage>::PrivateData::init()
-{
-    alwaysRepaint = true;
-    cairoSurface = nullptr;
-}
-
-template <>
-void ImageBaseKnob<CairoImage>::PrivateData::cleanup()
-{
-    cairo_surface_destroy((cairo_surface_t*)cairoSurface);
-    cairoSurface = nullptr;
-}
-
 /**
    Get the pixel size in bytes.
    @return pixel size, or 0 if the format is unknown, or pixels are not aligned to bytes.
@@ -645,62 +587,247 @@ static cairo_surface_t* getRegion(cairo_surface_t* origsurface, int x, int y, in
     x = (x < fullWidth) ? x : fullWidth;
     y = (y < fullHeight) ? y : fullHeight;
     width = (x + width < fullWidth) ? width : (fullWidth - x);
-    height = (x + height < fullHeight) ? height : (fullHeight - x);
+    height = (y + height < fullHeight) ? height : (fullHeight - y);
 
     uchar* const data = fullData + (x * bpp + y * stride);
     return cairo_image_surface_create_for_data(data, format, width, height, stride);
 }
 
-template <>
-void ImageBaseKnob<CairoImage>::onDisplay()
+/**
+   The most memory used by the frames of a rotating knob, in bytes.
+   Each frame is a full ARGB32 copy of the knob image, knobs needing more are rotated on every paint instead.
+ */
+static const std::size_t kMaxKnobRotationCacheSize = 2 * 1024 * 1024;
+
+/**
+   Ready to paint frames of a knob, shared between all knobs using the same image and settings.
+   Film-strip layers point directly into the image data, rotated frames are rendered on first use.
+   Rotating knobs too big to cache have no frames.
+   The cache is protected by a mutex, as windows can be drawn from different threads.
+ */
+struct CairoKnobFrames {
+    cairo_surface_t* image; // referenced, keeps the layer pointers valid
+    int rotationAngle;
+    uint layerWidth, layerHeight, layerCount;
+    bool isVertical;
+    uint frameCount;
+    cairo_surface_t** frames;
+    uint refCount;
+};
+
+struct CairoKnobFramesCache {
+    Mutex mutex;
+    std::list<CairoKnobFrames*> knobFrames;
+};
+
+// created on first use, so it outlives knobs declared as globals in other translation units
+static CairoKnobFramesCache& getCairoKnobFramesCache()
 {
-    const GraphicsContext& context(getGraphicsContext());
-    cairo_t* const handle = ((const CairoGraphicsContext&)context).handle;
-    const double normValue = getNormalizedValue();
+    static CairoKnobFramesCache cache;
+    return cache;
+}
 
-    cairo_surface_t* surface = (cairo_surface_t*)pData->cairoSurface;
+/**
+   Get the amount of frames needed for a rotating knob, so that its outer edge moves at most 1 pixel between frames.
+   Returns 0 if those frames would not fit in kMaxKnobRotationCacheSize.
+ */
+static uint getKnobRotationFrameCount(const int rotationAngle, const uint width, const uint height) noexcept
+{
+    const double radius = 0.5 * std::sqrt(static_cast<double>(width * width + height * height));
+    const double arcLength = std::abs(rotationAngle) * (M_PI / 180) * radius;
+    const uint count = std::max(2u, static_cast<uint>(std::ceil(arcLength)) + 1);
+    const std::size_t frameSize = static_cast<std::size_t>(width) * height * 4;
 
-    if (! pData->isReady)
-    {
-        const int layerW = static_cast<int>(pData->imgLayerWidth);
-        const int layerH = static_cast<int>(pData->imgLayerHeight);
-        int layerNum = 0;
+    return static_cast<std::size_t>(count) * frameSize <= kMaxKnobRotationCacheSize ? count : 0;
+}
 
-        if (pData->rotationAngle == 0)
-            layerNum = static_cast<int>(normValue * static_cast<double>(pData->imgLayerCount - 1) + 0.5);
+static void paintRotatedKnob(cairo_t* const cr, cairo_surface_t* const image,
+                             const int width, const int height, const double angle)
+{
+    cairo_save(cr);
+    cairo_translate(cr, 0.5 * width, 0.5 * height);
+    cairo_rotate(cr, angle * (M_PI / 180));
+    cairo_set_source_surface(cr, image, -0.5 * width, -0.5 * height);
+    cairo_paint(cr);
+    cairo_restore(cr);
+}
 
-        const int layerX = pData->isImgVertical ? 0 : layerNum * layerW;
-        const int layerY = !pData->isImgVertical ? 0 : layerNum * layerH;
+static CairoKnobFrames* acquireCairoKnobFrames(cairo_surface_t* const image, const int rotationAngle,
+                                               const uint layerWidth, const uint layerHeight,
+                                               const uint layerCount, const bool isVertical)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(image != nullptr, nullptr);
+    DISTRHO_SAFE_ASSERT_RETURN(layerWidth != 0 && layerHeight != 0, nullptr);
 
-        cairo_surface_t* newsurface;
+    CairoKnobFramesCache& cache(getCairoKnobFramesCache());
+    const MutexLocker cml(cache.mutex);
 
-        if (pData->rotationAngle == 0)
+    for (std::list<CairoKnobFrames*>::iterator it = cache.knobFrames.begin(); it != cache.knobFrames.end(); ++it)
+    {
+        CairoKnobFrames* const knobFrames(*it);
+
+        if (knobFrames->image == image &&
+            knobFrames->rotationAngle == rotationAngle &&
+            knobFrames->layerWidth == layerWidth &&
+            knobFrames->layerHeight == layerHeight &&
+            knobFrames->layerCount == layerCount &&
+            knobFrames->isVertical == isVertical)
         {
-            newsurface = getRegion(pData->image.getSurface(), layerX, layerY, layerW, layerH);
+            ++knobFrames->refCount;
+            return knobFrames;
         }
-        else
+    }
+
+    const uint frameCount = rotationAngle != 0
+                          ? getKnobRotationFrameCount(rotationAngle, layerWidth, layerHeight)
+                          : layerCount;
+    DISTRHO_SAFE_ASSERT_RETURN(frameCount != 0 || rotationAngle != 0, nullptr);
+
+    cairo_surface_t** frames = nullptr;
+
+    if (frameCount != 0)
+    {
+        frames = (cairo_surface_t**)std::calloc(frameCount, sizeof(cairo_surface_t*));
+        DISTRHO_SAFE_ASSERT_RETURN(frames != nullptr, nullptr);
+    }
+
+    // slice all film-strip layers now, these do not copy any pixels
+    if (rotationAngle == 0)
+    {
+        const int w = static_cast<int>(layerWidth);
+        const int h = static_cast<int>(layerHeight);
+
+        for (uint i = 0; i < frameCount; ++i)
         {
-            newsurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, layerW, layerH);
-            cairo_t* const cr = cairo_create(newsurface);
-            cairo_translate(cr, 0.5 * layerW, 0.5 * layerH);
-            cairo_rotate(cr, normValue * pData->rotationAngle * (M_PI / 180));
-            cairo_set_source_surface(cr, pData->image.getSurface(), -0.5 * layerW, -0.5 * layerH);
-            cairo_paint(cr);
-            cairo_destroy(cr);
+            const int n = static_cast<int>(i);
+            frames[i] = getRegion(image, isVertical ? 0 : n * w, isVertical ? n * h : 0, w, h);
         }
+    }
 
-        DISTRHO_SAFE_ASSERT_RETURN(newsurface != nullptr,);
+    CairoKnobFrames* const knobFrames = new CairoKnobFrames;
+    knobFrames->image = cairo_surface_reference(image);
+    knobFrames->rotationAngle = rotationAngle;
+    knobFrames->layerWidth = layerWidth;
+    knobFrames->layerHeight = layerHeight;
+    knobFrames->layerCount = layerCount;
+    knobFrames->isVertical = isVertical;
+    knobFrames->frameCount = frameCount;
+    knobFrames->frames = frames;
+    knobFrames->refCount = 1;
+
+    cache.knobFrames.push_back(knobFrames);
+    return knobFrames;
+}
+
+static void releaseCairoKnobFrames(CairoKnobFrames* const knobFrames)
+{
+    if (knobFrames == nullptr)
+        return;
+
+    CairoKnobFramesCache& cache(getCairoKnobFramesCache());
+    const MutexLocker cml(cache.mutex);
+
+    if (--knobFrames->refCount != 0)
+        return;
+
+    cache.knobFrames.remove(knobFrames);
+
+    for (uint i = 0; i < knobFrames->frameCount; ++i)
+        cairo_surface_destroy(knobFrames->frames[i]);
+
+    std::free(knobFrames->frames);
+    cairo_surface_destroy(knobFrames->image);
+    delete knobFrames;
+}
+
+static cairo_surface_t* getCairoKnobFrame(CairoKnobFrames* const knobFrames, const double normValue)
+{
+    if (knobFrames->frameCount == 0)
+        return nullptr;
+
+    const uint index = static_cast<uint>(normValue * static_cast<double>(knobFrames->frameCount - 1) + 0.5);
+    DISTRHO_SAFE_ASSERT_RETURN(index < knobFrames->frameCount, nullptr);
+
+    // rotated frames are rendered on first use, possibly by knobs of other windows
+    const MutexLocker cml(getCairoKnobFramesCache().mutex);
+
+    cairo_surface_t* frame = knobFrames->frames[index];
+
+    if (frame == nullptr && knobFrames->rotationAngle != 0)
+    {
+        const int w = static_cast<int>(knobFrames->layerWidth);
+        const int h = static_cast<int>(knobFrames->layerHeight);
+        const double angle = static_cast<double>(index) / static_cast<double>(knobFrames->frameCount - 1)
+                           * knobFrames->rotationAngle;
+
+        frame = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+        cairo_t* const cr = cairo_create(frame);
+        paintRotatedKnob(cr, knobFrames->image, w, h, angle);
+        cairo_destroy(cr);
+
+        knobFrames->frames[index] = frame;
+    }
+
+    return frame;
+}
+
+template <>
+void ImageBaseKnob<CairoImage>::PrivateData::init()
+{
+    cairoFrames = nullptr;
+}
+
+template <>
+void ImageBaseKnob<CairoImage>::PrivateData::cleanup()
+{
+    releaseCairoKnobFrames((CairoKnobFrames*)cairoFrames);
+    cairoFrames = nullptr;
+}
+
+template <>
+void ImageBaseKnob<CairoImage>::onDisplay()
+{
+    const GraphicsContext& context(getGraphicsContext());
+    cairo_t* const handle = ((const CairoGraphicsContext&)context).handle;
+
+    CairoKnobFrames* knobFrames = (CairoKnobFrames*)pData->cairoFrames;
+
+    if (! pData->isReady)
+    {
+        // value changes do not need new frames, only changes to the image setup do
+        if (knobFrames == nullptr ||
+            knobFrames->image != pData->image.getSurface() ||
+            knobFrames->rotationAngle != pData->rotationAngle ||
+            knobFrames->layerWidth != pData->imgLayerWidth ||
+            knobFrames->layerHeight != pData->imgLayerHeight ||
+            knobFrames->layerCount != pData->imgLayerCount)
+        {
+            releaseCairoKnobFrames(knobFrames);
+            pData->cairoFrames = knobFrames = acquireCairoKnobFrames(pData->image.getSurface(),
+                                                                     pData->rotationAngle,
+                                                                     pData->imgLayerWidth,
+                                                                     pData->imgLayerHeight,
+                                                                     pData->imgLayerCount,
+                                                                     pData->isImgVertical);
+        }
 
-        cairo_surface_destroy(surface);
-        pData->cairoSurface = surface = newsurface;
         pData->isReady = true;
     }
 
-    if (surface != nullptr)
+    if (knobFrames == nullptr)
+        return;
+
+    if (cairo_surface_t* const frame = getCairoKnobFrame(knobFrames, getNormalizedValue()))
     {
-        cairo_set_source_surface(handle, surface, 0, 0);
+        cairo_set_source_surface(handle, frame, 0, 0);
         cairo_paint(handle);
     }
+    else if (knobFrames->frameCount == 0)
+    {
+        paintRotatedKnob(handle, knobFrames->image,
+                         static_cast<int>(knobFrames->layerWidth), static_cast<int>(knobFrames->layerHeight),
+                         getNormalizedValue() * knobFrames->rotationAngle);
+    }
 }
 
 template class ImageBaseKnob<CairoImage>;
@@ -716,12 +843,138 @@ template class ImageBaseSlider<CairoImage>;
 template class ImageBaseSwitch<CairoImage>;
 
 // -----------------------------------------------------------------------
+// SubWidget cache, using image surfaces
+
+// cairo context of the subwidget cache being updated, used for drawing instead of the window one
+static cairo_t* gCacheHandle = nullptr;
+
+struct SubWidget::PrivateData::Cache {
+    cairo_surface_t* surface;
+    int width, height;
+
+    Cache()
+        : surface(nullptr),
+          width(0),
+          height(0) {}
+
+    ~Cache()
+    {
+        clear();
+    }
+
+    bool resize(const int w, const int h)
+    {
+        clear();
+
+        surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+
+        if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+        {
+            clear();
+            return false;
+        }
+
+        width = w;
+        height = h;
+        return true;
+    }
 
-void SubWidget::PrivateData::display(const uint width, const uint height, const double autoScaleFactor)
+    void clear()
+    {
+        if (surface != nullptr)
+        {
+            cairo_surface_destroy(surface);
+            surface = nullptr;
+        }
+
+        width = height = 0;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(Cache)
+};
+
+bool SubWidget::PrivateData::displayCached(const uint width, const uint height, const double autoScaleFactor,
+                                           const Rectangle<int>*)
+{
+    const int w = static_cast<int>(std::ceil(self->getWidth() * autoScaleFactor));
+    const int h = static_cast<int>(std::ceil(self->getHeight() * autoScaleFactor));
+
+    if (w <= 0 || h <= 0)
+        return true;
+
+    if (cache == nullptr)
+        cache = new Cache;
+
+    if (cache->width != w || cache->height != h)
+    {
+        if (! cache->resize(w, h))
+        {
+            d_stderr2("Failed to create surface for subwidget cache, drawing it uncached");
+            destroyCache();
+            cached = false;
+            return false;
+        }
+
+        cacheNeedsUpdate = true;
+    }
+
+    cairo_t* const handle = static_cast<const CairoGraphicsContext&>(self->getGraphicsContext()).handle;
+
+    const double x = absolutePos.getX() * autoScaleFactor;
+    const double y = absolutePos.getY() * autoScaleFactor;
+
+    if (cacheNeedsUpdate)
+    {
+        cairo_t* const cacheHandle = cairo_create(cache->surface);
+
+        cairo_set_operator(cacheHandle, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(cacheHandle);
+        cairo_set_operator(cacheHandle, CAIRO_OPERATOR_OVER);
+
+        // widgets draw in window coordinates
+        cairo_translate(cacheHandle, -x, -y);
+
+        // draw everything as usual, but into the cache
+        cairo_t* const previousCacheHandle = gCacheHandle;
+        gCacheHandle = cacheHandle;
+
+        cached = false;
+        display(width, height, autoScaleFactor, nullptr);
+        cached = true;
+        cacheNeedsUpdate = false;
+
+        gCacheHandle = previousCacheHandle;
+
+        cairo_destroy(cacheHandle);
+        cairo_surface_flush(cache->surface);
+    }
+
+    // draw cache over the widget area
+    cairo_save(handle);
+    cairo_set_source_surface(handle, cache->surface, x, y);
+    cairo_paint(handle);
+    cairo_restore(handle);
+
+    return true;
+}
+
+void SubWidget::PrivateData::destroyCache()
+{
+    delete cache;
+    cache = nullptr;
+}
+
+// -----------------------------------------------------------------------
+
+void SubWidget::PrivateData::display(const uint width, const uint height, const double autoScaleFactor,
+                                     const Rectangle<int>* const damage)
 {
+    if (cached && displayCached(width, height, autoScaleFactor, damage))
+        return;
+
     cairo_t* const handle = static_cast<const CairoGraphicsContext&>(self->getGraphicsContext()).handle;
 
-    bool needsResetClip = false;
+    bool needsRestoreClip = false;
 
     cairo_matrix_t matrix;
     cairo_get_matrix(handle, &matrix);
@@ -742,7 +995,8 @@ void SubWidget::PrivateData::display(const uint width, const uint height, const
         // set viewport pos
         cairo_translate(handle, absolutePos.getX() * autoScaleFactor, absolutePos.getY() * autoScaleFactor);
 
-        // then cut the outer bounds
+        // then cut the outer bounds, keeping the clip of the area being redrawn
+        cairo_save(handle);
         cairo_rectangle(handle,
                         0,
                         0,
@@ -750,7 +1004,7 @@ void SubWidget::PrivateData::display(const uint width, const uint height, const
                         std::round(self->getHeight() * autoScaleFactor));
 
         cairo_clip(handle);
-        needsResetClip = true;
+        needsRestoreClip = true;
 
         // set viewport scaling
         cairo_scale(handle, autoScaleFactor, autoScaleFactor);
@@ -759,17 +1013,17 @@ void SubWidget::PrivateData::display(const uint width, const uint height, const
     // display widget
     self->onDisplay();
 
-    if (needsResetClip)
-        cairo_reset_clip(handle);
+    if (needsRestoreClip)
+        cairo_restore(handle);
 
     cairo_set_matrix(handle, &matrix);
 
-    selfw->pData->displaySubWidgets(width, height, autoScaleFactor);
+    selfw->pData->displaySubWidgets(width, height, autoScaleFactor, damage);
 }
 
 // -----------------------------------------------------------------------
 
-void TopLevelWidget::PrivateData::display()
+void TopLevelWidget::PrivateData::display(const Rectangle<int>* const damage)
 {
     if (! selfw->pData->visible)
         return;
@@ -803,7 +1057,7 @@ void TopLevelWidget::PrivateData::display()
     cairo_set_matrix(handle, &matrix);
 
     // now draw subwidgets if there are any
-    selfw->pData->displaySubWidgets(width, height, autoScaleFactor);
+    selfw->pData->displaySubWidgets(width, height, autoScaleFactor, damage);
 }
 
 // -----------------------------------------------------------------------
@@ -811,7 +1065,7 @@ void TopLevelWidget::PrivateData::display()
 const GraphicsContext& Window::PrivateData::getGraphicsContext() const noexcept
 {
     GraphicsContext& context((GraphicsContext&)graphicsContext);
-    ((CairoGraphicsContext&)context).handle = (cairo_t*)puglGetContext(view);
+    ((CairoGraphicsContext&)context).handle = gCacheHandle != nullptr ? gCacheHandle : (cairo_t*)puglGetContext(view);
     return context;
 }
 
@@ -943,6 +943,13 @@ bool Rectangle<T>::containsY(const T& y) const noexcept
     return (y >= pos.y && y <= pos.y + size.fHeight);
 }
 
+template<typename T>
+bool Rectangle<T>::intersects(const Rectangle<T>& rect) const noexcept
+{
+    return (pos.x < rect.pos.x + rect.size.fWidth  && rect.pos.x < pos.x + size.fWidth &&
+            pos.y < rect.pos.y + rect.size.fHeight && rect.pos.y < pos.y + size.fHeight);
+}
+
 template<typename T>
 bool Rectangle<T>::isNull() const noexcept
 {
@@ -221,8 +221,8 @@ struct ImageBaseKnob<ImageType>::PrivateData : public KnobEventHandler::Callback
     bool isReady;
 
     union {
-        uint glTextureId;
-        void* cairoSurface;
+        void* glTexture;
+        void* cairoFrames;
     };
 
     explicit PrivateData(const ImageType& img)
@@ -0,0 +1,386 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "ImageConversion.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define DGL_IMAGE_CONVERSION_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define DGL_IMAGE_CONVERSION_NEON
+#endif
+
+START_NAMESPACE_DGL
+
+// --------------------------------------------------------------------------------------------------------------------
+// helpers
+
+static inline bool hasAlpha(const ImageFormat format) noexcept
+{
+    return format == kImageFormatBGRA || format == kImageFormatRGBA;
+}
+
+static inline bool isBGR(const ImageFormat format) noexcept
+{
+    return format == kImageFormatBGR || format == kImageFormatBGRA;
+}
+
+// x * a / 255, rounded, exact for all 8-bit values
+static inline uint mulDiv255(const uint x, const uint a) noexcept
+{
+    const uint t = x * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+uint getImageFormatPixelSize(const ImageFormat format) noexcept
+{
+    switch (format)
+    {
+    case kImageFormatNull:
+        break;
+    case kImageFormatGrayscale:
+        return 1;
+    case kImageFormatBGR:
+    case kImageFormatRGB:
+        return 3;
+    case kImageFormatBGRA:
+    case kImageFormatRGBA:
+        return 4;
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// scalar conversion, works for any format pair
+
+static void convertRowScalar(const uchar* src, const ImageFormat srcFormat,
+                             uchar* dst, const ImageFormat dstFormat,
+                             const uint width, const bool premultiply) noexcept
+{
+    const uint srcPixelSize = getImageFormatPixelSize(srcFormat);
+    const uint dstPixelSize = getImageFormatPixelSize(dstFormat);
+
+    for (uint i = 0; i < width; ++i, src += srcPixelSize, dst += dstPixelSize)
+    {
+        uint r = 0, g = 0, b = 0, a = 255;
+
+        switch (srcFormat)
+        {
+        case kImageFormatNull:
+            return;
+        case kImageFormatGrayscale:
+            r = g = b = src[0];
+            break;
+        case kImageFormatBGR:
+            b = src[0];
+            g = src[1];
+            r = src[2];
+            break;
+        case kImageFormatBGRA:
+            b = src[0];
+            g = src[1];
+            r = src[2];
+            a = src[3];
+            break;
+        case kImageFormatRGB:
+            r = src[0];
+            g = src[1];
+            b = src[2];
+            break;
+        case kImageFormatRGBA:
+            r = src[0];
+            g = src[1];
+            b = src[2];
+            a = src[3];
+            break;
+        }
+
+        if (premultiply && a != 255)
+        {
+            r = mulDiv255(r, a);
+            g = mulDiv255(g, a);
+            b = mulDiv255(b, a);
+        }
+
+        switch (dstFormat)
+        {
+        case kImageFormatNull:
+            return;
+        case kImageFormatGrayscale:
+            // ITU-R BT.601 luma, weights add up to 256
+            dst[0] = static_cast<uchar>((r * 77 + g * 150 + b * 29 + 128) >> 8);
+            break;
+        case kImageFormatBGR:
+            dst[0] = static_cast<uchar>(b);
+            dst[1] = static_cast<uchar>(g);
+            dst[2] = static_cast<uchar>(r);
+            break;
+        case kImageFormatBGRA:
+            dst[0] = static_cast<uchar>(b);
+            dst[1] = static_cast<uchar>(g);
+            dst[2] = static_cast<uchar>(r);
+            dst[3] = static_cast<uchar>(a);
+            break;
+        case kImageFormatRGB:
+            dst[0] = static_cast<uchar>(r);
+            dst[1] = static_cast<uchar>(g);
+            dst[2] = static_cast<uchar>(b);
+            break;
+        case kImageFormatRGBA:
+            dst[0] = static_cast<uchar>(r);
+            dst[1] = static_cast<uchar>(g);
+            dst[2] = static_cast<uchar>(b);
+            dst[3] = static_cast<uchar>(a);
+            break;
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// vectorized conversion to 4 channels, returns the number of converted pixels, the rest is left for scalar code
+
+#if defined(DGL_IMAGE_CONVERSION_SSE2)
+
+static inline __m128i swapRedBlue(const __m128i v) noexcept
+{
+    const __m128i ga = _mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xff00ff00)));
+    const __m128i rb = _mm_and_si128(v, _mm_set1_epi32(0x00ff00ff));
+    return _mm_or_si128(ga, _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16)));
+}
+
+// 2 pixels with 16-bit channels
+static inline __m128i premultiply2(const __m128i v) noexcept
+{
+    const __m128i colorMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alphaMax  = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    // alpha of each pixel on its color channels, alpha itself stays as-is
+    __m128i a = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_or_si128(_mm_and_si128(a, colorMask), alphaMax);
+
+    // same as mulDiv255
+    const __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static uint convertRowVectorized(const uchar* const src, const ImageFormat srcFormat,
+                                 uchar* const dst, const ImageFormat dstFormat,
+                                 const uint width, const bool premultiply) noexcept
+{
+    if (! hasAlpha(dstFormat))
+        return 0;
+
+    const bool swap = isBGR(srcFormat) != isBGR(dstFormat);
+    uint i = 0;
+
+    switch (srcFormat)
+    {
+    case kImageFormatNull:
+        break;
+
+    case kImageFormatGrayscale:
+    {
+        const __m128i ff = _mm_set1_epi8(-1);
+
+        for (; i + 16 <= width; i += 16)
+        {
+            const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i gglo = _mm_unpacklo_epi8(g, g);
+            const __m128i gghi = _mm_unpackhi_epi8(g, g);
+            const __m128i galo = _mm_unpacklo_epi8(g, ff);
+            const __m128i gahi = _mm_unpackhi_epi8(g, ff);
+
+            __m128i* const d = reinterpret_cast<__m128i*>(dst + i * 4);
+            _mm_storeu_si128(d + 0, _mm_unpacklo_epi16(gglo, galo));
+            _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(gglo, galo));
+            _mm_storeu_si128(d + 2, _mm_unpacklo_epi16(gghi, gahi));
+            _mm_storeu_si128(d + 3, _mm_unpackhi_epi16(gghi, gahi));
+        }
+        break;
+    }
+
+    case kImageFormatBGR:
+    case kImageFormatRGB:
+    {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+        // each pixel is read as 4 bytes, so keep 1 pixel extra for the last read
+        for (; i + 5 <= width; i += 4)
+        {
+            const uchar* const s = src + i * 3;
+            int p0, p1, p2, p3;
+            std::memcpy(&p0, s, 4);
+            std::memcpy(&p1, s + 3, 4);
+            std::memcpy(&p2, s + 6, 4);
+            std::memcpy(&p3, s + 9, 4);
+
+            __m128i v = _mm_set_epi32(p3, p2, p1, p0);
+            v = _mm_or_si128(_mm_andnot_si128(alpha, v), alpha);
+
+            if (swap)
+                v = swapRedBlue(v);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), v);
+        }
+        break;
+    }
+
+    case kImageFormatBGRA:
+    case kImageFormatRGBA:
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 4 <= width; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+
+            if (swap)
+                v = swapRedBlue(v);
+
+            if (premultiply)
+                v = _mm_packus_epi16(premultiply2(_mm_unpacklo_epi8(v, zero)),
+                                     premultiply2(_mm_unpackhi_epi8(v, zero)));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), v);
+        }
+        break;
+    }
+    }
+
+    return i;
+}
+
+#elif defined(DGL_IMAGE_CONVERSION_NEON)
+
+// same as mulDiv255
+static inline uint8x16_t premultiply16(const uint8x16_t x, const uint8x16_t a) noexcept
+{
+    const uint16x8_t tlo = vmull_u8(vget_low_u8(x), vget_low_u8(a));
+    const uint16x8_t thi = vmull_u8(vget_high_u8(x), vget_high_u8(a));
+    return vcombine_u8(vraddhn_u16(tlo, vrshrq_n_u16(tlo, 8)),
+                       vraddhn_u16(thi, vrshrq_n_u16(thi, 8)));
+}
+
+static uint convertRowVectorized(const uchar* const src, const ImageFormat srcFormat,
+                                 uchar* const dst, const ImageFormat dstFormat,
+                                 const uint width, const bool premultiply) noexcept
+{
+    if (! hasAlpha(dstFormat))
+        return 0;
+
+    const bool swap = isBGR(srcFormat) != isBGR(dstFormat);
+    uint i = 0;
+
+    switch (srcFormat)
+    {
+    case kImageFormatNull:
+        break;
+
+    case kImageFormatGrayscale:
+        for (; i + 16 <= width; i += 16)
+        {
+            const uint8x16_t g = vld1q_u8(src + i);
+            uint8x16x4_t v;
+            v.val[0] = v.val[1] = v.val[2] = g;
+            v.val[3] = vdupq_n_u8(255);
+            vst4q_u8(dst + i * 4, v);
+        }
+        break;
+
+    case kImageFormatBGR:
+    case kImageFormatRGB:
+        for (; i + 16 <= width; i += 16)
+        {
+            const uint8x16x3_t s = vld3q_u8(src + i * 3);
+            uint8x16x4_t v;
+            v.val[0] = s.val[swap ? 2 : 0];
+            v.val[1] = s.val[1];
+            v.val[2] = s.val[swap ? 0 : 2];
+            v.val[3] = vdupq_n_u8(255);
+            vst4q_u8(dst + i * 4, v);
+        }
+        break;
+
+    case kImageFormatBGRA:
+    case kImageFormatRGBA:
+        for (; i + 16 <= width; i += 16)
+        {
+            uint8x16x4_t v = vld4q_u8(src + i * 4);
+
+            if (swap)
+            {
+                const uint8x16_t t = v.val[0];
+                v.val[0] = v.val[2];
+                v.val[2] = t;
+            }
+
+            if (premultiply)
+            {
+                v.val[0] = premultiply16(v.val[0], v.val[3]);
+                v.val[1] = premultiply16(v.val[1], v.val[3]);
+                v.val[2] = premultiply16(v.val[2], v.val[3]);
+            }
+
+            vst4q_u8(dst + i * 4, v);
+        }
+        break;
+    }
+
+    return i;
+}
+
+#else
+
+static uint convertRowVectorized(const uchar*, ImageFormat, uchar*, ImageFormat, uint, bool) noexcept
+{
+    return 0;
+}
+
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+
+void convertImageData(const uchar* src, const ImageFormat srcFormat, const uint srcStride,
+                      uchar* dst, const ImageFormat dstFormat, const uint dstStride,
+                      const uint width, const uint height, const bool premultiply) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(src != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(dst != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(srcFormat != kImageFormatNull,);
+    DISTRHO_SAFE_ASSERT_RETURN(dstFormat != kImageFormatNull,);
+
+    const uint srcPixelSize = getImageFormatPixelSize(srcFormat);
+    const uint dstPixelSize = getImageFormatPixelSize(dstFormat);
+
+    for (uint y = 0; y < height; ++y, src += srcStride, dst += dstStride)
+    {
+        const uint done = convertRowVectorized(src, srcFormat, dst, dstFormat, width, premultiply);
+
+        if (done < width)
+            convertRowScalar(src + done * srcPixelSize, srcFormat,
+                             dst + done * dstPixelSize, dstFormat,
+                             width - done, premultiply);
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DGL
@@ -0,0 +1,49 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DGL_IMAGE_CONVERSION_HPP_INCLUDED
+#define DGL_IMAGE_CONVERSION_HPP_INCLUDED
+
+#include "../ImageBase.hpp"
+
+START_NAMESPACE_DGL
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Get the size of a single pixel in bytes, or 0 for kImageFormatNull.
+ */
+uint getImageFormatPixelSize(ImageFormat format) noexcept;
+
+/**
+   Convert raw image data between any 2 image formats.
+   @a srcStride and @a dstStride are the number of bytes between rows, which can include padding.
+
+   Converting to grayscale uses the pixel luminance, formats without alpha are converted as fully opaque.
+   If @a premultiply is true, color values are multiplied by alpha (as needed by Cairo).
+
+   The most common conversions (grayscale or 3 channels to 4, and 4 to 4 channels) are vectorized
+   with SSE2 or NEON when available, everything else uses scalar code.
+ */
+void convertImageData(const uchar* src, ImageFormat srcFormat, uint srcStride,
+                      uchar* dst, ImageFormat dstFormat, uint dstStride,
+                      uint width, uint height, bool premultiply) noexcept;
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DGL
+
+#endif // DGL_IMAGE_CONVERSION_HPP_INCLUDED
@@ -15,10 +15,19 @@
  */
 
 #include "../NanoVG.hpp"
+#include "AsyncImageLoader.hpp"
 #include "SubWidgetPrivateData.hpp"
+#include "pugl.hpp"
+
+#include "../../distrho/extra/Mutex.hpp"
+
+#include <list>
+#include <map>
+#include <vector>
 
 #ifndef DGL_NO_SHARED_RESOURCES
 # include "Resources.hpp"
+# include "../../distrho/extra/LZ4.hpp"
 #endif
 
 // -----------------------------------------------------------------------
@@ -82,6 +91,10 @@ DGL_EXT(PFNGLUNIFORMBLOCKBINDINGPROC,      glUniformBlockBinding)
 # define glGenVertexArrays glGenVertexArraysAPPLE
 #endif
 
+// keep the scissor area set up for a partial repaint while flushing, see NanoVG::endFrame
+static bool gKeepScissorTest = false;
+#define NANOVG_GL_KEEP_SCISSOR_TEST gKeepScissorTest
+
 #include "nanovg/nanovg_gl.h"
 
 #if defined(NANOVG_GL2)
@@ -186,17 +199,86 @@ Color::operator NVGcolor() const noexcept
     return nc;
 }
 
+// -----------------------------------------------------------------------
+// Asynchronous image loading
+
+/**
+   An image being decoded in the background, for NanoVG::loadImageFromFileAsync and loadImageFromMemoryAsync.
+   The texture is created by the NanoVG instance owning @a context, in its next beginFrame() after decoding.
+ */
+struct NanoImageAsyncLoad : AsyncImageJob {
+    NanoImage* const image;
+    NVGcontext* const context;
+    const int imageFlags;
+
+    // input, either a filename or encoded data
+    char* filename;
+    uchar* data;
+    uint dataSize;
+
+    // output, null if decoding failed
+    uchar* pixels;
+    int width, height;
+
+    NanoImageAsyncLoad(NanoImage* const img, NVGcontext* const ctx, const int flags) noexcept
+        : AsyncImageJob(),
+          image(img),
+          context(ctx),
+          imageFlags(flags),
+          filename(nullptr),
+          data(nullptr),
+          dataSize(0),
+          pixels(nullptr),
+          width(0),
+          height(0) {}
+
+    // implemented after including nanovg.c, as they need stb_image
+    ~NanoImageAsyncLoad() override;
+    void decode() override;
+    static void setupDecoding();
+};
+
+/**
+   Pending loads of all NanoVG instances, only used from the UI thread.
+   Created on first use, see initAsyncLoads().
+ */
+static std::list<NanoImageAsyncLoad*>& getAsyncLoads()
+{
+    static std::list<NanoImageAsyncLoad*> loads;
+    return loads;
+}
+
+// called by NanoImage and NanoVG constructors, so everything they use on destruction is destroyed after them
+static void initAsyncLoads()
+{
+    initAsyncImageLoader(NanoImageAsyncLoad::setupDecoding);
+    getAsyncLoads();
+}
+
+static void cancelAsyncLoad(NanoImageAsyncLoad* const load)
+{
+    getAsyncLoads().remove(load);
+    releaseAsyncImageJob(load);
+}
+
 // -----------------------------------------------------------------------
 // NanoImage
 
 NanoImage::NanoImage()
     : fHandle(),
-      fSize() {}
+      fSize(),
+      fAsyncLoad(nullptr)
+{
+    initAsyncLoads();
+}
 
 NanoImage::NanoImage(const Handle& handle)
     : fHandle(handle),
-      fSize()
+      fSize(),
+      fAsyncLoad(nullptr)
 {
+    initAsyncLoads();
+
     DISTRHO_SAFE_ASSERT_RETURN(fHandle.context != nullptr && fHandle.imageId != 0,);
 
     _updateSize();
@@ -204,12 +286,21 @@ NanoImage::NanoImage(const Handle& handle)
 
 NanoImage::~NanoImage()
 {
+    if (fAsyncLoad != nullptr)
+        cancelAsyncLoad(fAsyncLoad);
+
     if (fHandle.context != nullptr && fHandle.imageId != 0)
         nvgDeleteImage(fHandle.context, fHandle.imageId);
 }
 
 NanoImage& NanoImage::operator=(const Handle& handle)
 {
+    if (fAsyncLoad != nullptr)
+    {
+        cancelAsyncLoad(fAsyncLoad);
+        fAsyncLoad = nullptr;
+    }
+
     if (fHandle.context != nullptr && fHandle.imageId != 0)
         nvgDeleteImage(fHandle.context, fHandle.imageId);
 
@@ -236,6 +327,11 @@ GLuint NanoImage::getTextureHandle() const
     return nvglImageHandle(fHandle.context, fHandle.imageId);
 }
 
+bool NanoImage::isLoading() const noexcept
+{
+    return fAsyncLoad != nullptr;
+}
+
 void NanoImage::_updateSize()
 {
     int w=0, h=0;
@@ -284,14 +380,37 @@ NanoVG::Paint::operator NVGpaint() const noexcept
 NanoVG::NanoVG(int flags)
     : fContext(nvgCreateGL_helper(flags)),
       fInFrame(false),
-      fIsSubWidget(false) {}
+      fIsSubWidget(false)
+{
+    initAsyncLoads();
+}
 
 NanoVG::~NanoVG()
 {
     DISTRHO_SAFE_ASSERT(! fInFrame);
 
     if (fContext != nullptr && ! fIsSubWidget)
+    {
+        // images still loading will never get a texture now
+        std::list<NanoImageAsyncLoad*>& loads(getAsyncLoads());
+
+        for (std::list<NanoImageAsyncLoad*>::iterator it = loads.begin(); it != loads.end();)
+        {
+            NanoImageAsyncLoad* const load(*it);
+
+            if (load->context != fContext)
+            {
+                ++it;
+                continue;
+            }
+
+            it = loads.erase(it);
+            load->image->fAsyncLoad = nullptr;
+            releaseAsyncImageJob(load);
+        }
+
         nvgDeleteGL(fContext);
+    }
 }
 
 // -----------------------------------------------------------------------
@@ -302,8 +421,11 @@ void NanoVG::beginFrame(const uint width, const uint height, const float scaleFa
     DISTRHO_SAFE_ASSERT_RETURN(! fInFrame,);
     fInFrame = true;
 
-    if (fContext != nullptr)
-        nvgBeginFrame(fContext, static_cast<int>(width), static_cast<int>(height), scaleFactor);
+    if (fContext == nullptr)
+        return;
+
+    _processAsyncLoads();
+    nvgBeginFrame(fContext, static_cast<int>(width), static_cast<int>(height), scaleFactor);
 }
 
 void NanoVG::beginFrame(Widget* const widget)
@@ -315,6 +437,8 @@ void NanoVG::beginFrame(Widget* const widget)
     if (fContext == nullptr)
         return;
 
+    _processAsyncLoads();
+
     if (TopLevelWidget* const tlw = widget->getTopLevelWidget())
         nvgBeginFrame(fContext,
                       static_cast<int>(tlw->getWidth()),
@@ -343,9 +467,14 @@ void NanoVG::endFrame()
     glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrc);
     glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDst);
 
+    // Keep drawing clipped to the area being redrawn during partial repaints, otherwise reset scissor as usual
+    gKeepScissorTest = puglOnDisplayIsAreaActive() && glIsEnabled(GL_SCISSOR_TEST) == GL_TRUE;
+
     if (fContext != nullptr)
         nvgEndFrame(fContext);
 
+    gKeepScissorTest = false;
+
     // Restore blend state
     if (blendEnabled)
         glEnable(GL_BLEND);
@@ -665,6 +794,97 @@ NanoImage::Handle NanoVG::createImageFromTextureHandle(GLuint textureId, uint w,
                                                                  static_cast<int>(h), imageFlags));
 }
 
+bool NanoVG::loadImageFromFileAsync(NanoImage& image, const char* filename, ImageFlags imageFlags)
+{
+    return loadImageFromFileAsync(image, filename, static_cast<int>(imageFlags));
+}
+
+bool NanoVG::loadImageFromFileAsync(NanoImage& image, const char* filename, int imageFlags)
+{
+    if (fContext == nullptr) return false;
+    DISTRHO_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+
+    NanoImageAsyncLoad* const load = new NanoImageAsyncLoad(&image, fContext, imageFlags);
+    load->filename = strdup(filename);
+
+    return _startAsyncLoad(image, load);
+}
+
+bool NanoVG::loadImageFromMemoryAsync(NanoImage& image, const uchar* data, uint dataSize, ImageFlags imageFlags)
+{
+    return loadImageFromMemoryAsync(image, data, dataSize, static_cast<int>(imageFlags));
+}
+
+bool NanoVG::loadImageFromMemoryAsync(NanoImage& image, const uchar* data, uint dataSize, int imageFlags)
+{
+    if (fContext == nullptr) return false;
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, false);
+    DISTRHO_SAFE_ASSERT_RETURN(dataSize > 0,    false);
+
+    NanoImageAsyncLoad* const load = new NanoImageAsyncLoad(&image, fContext, imageFlags);
+    load->data = static_cast<uchar*>(std::malloc(dataSize));
+    load->dataSize = dataSize;
+
+    if (load->data == nullptr)
+    {
+        delete load;
+        return false;
+    }
+
+    std::memcpy(load->data, data, dataSize);
+
+    return _startAsyncLoad(image, load);
+}
+
+bool NanoVG::_startAsyncLoad(NanoImage& image, NanoImageAsyncLoad* const load)
+{
+    // drop the previous image and any load still pending for it
+    image = NanoImage::Handle();
+    image.fSize = Size<uint>();
+    image.fAsyncLoad = load;
+
+    getAsyncLoads().push_back(load);
+    queueAsyncImageJob(load);
+    return true;
+}
+
+void NanoVG::_processAsyncLoads()
+{
+    std::list<NanoImageAsyncLoad*>& loads(getAsyncLoads());
+
+    for (std::list<NanoImageAsyncLoad*>::iterator it = loads.begin(); it != loads.end();)
+    {
+        NanoImageAsyncLoad* const load(*it);
+
+        if (load->context != fContext || ! load->isDone())
+        {
+            ++it;
+            continue;
+        }
+
+        it = loads.erase(it);
+
+        NanoImage& image(*load->image);
+        image.fAsyncLoad = nullptr;
+
+        if (load->pixels != nullptr)
+        {
+            image = NanoImage::Handle(fContext, nvgCreateImageRGBA(fContext, load->width, load->height,
+                                                                   load->imageFlags, load->pixels));
+            image._updateSize();
+        }
+        else
+        {
+            if (load->filename != nullptr)
+                d_stderr2("NanoVG: failed to decode image file '%s'", load->filename);
+            else
+                d_stderr2("NanoVG: failed to decode image data");
+        }
+
+        releaseAsyncImageJob(load);
+    }
+}
+
 // -----------------------------------------------------------------------
 // Paints
 
@@ -965,6 +1185,12 @@ bool NanoVG::loadSharedResources()
 
     using namespace dpf_resources;
 
+    // decompressed on first use, then shared by all contexts
+    const char* const dejavusans_ttf = d_getDecompressedResource(dejavusans_ttf_compressed,
+                                                                 dejavusans_ttf_compressed_size,
+                                                                 dejavusans_ttf_size);
+    DISTRHO_SAFE_ASSERT_RETURN(dejavusans_ttf != nullptr, false);
+
     return nvgCreateFontMem(fContext, NANOVG_DEJAVU_SANS_TTF, (uchar*)dejavusans_ttf, dejavusans_ttf_size, 0) >= 0;
 }
 #endif
@@ -1007,6 +1233,69 @@ NanoBaseWidget<StandaloneWindow>::NanoBaseWidget(Application& app, Window& paren
 
 template class NanoBaseWidget<StandaloneWindow>;
 
+// -----------------------------------------------------------------------
+// Shared glyph cache
+
+/**
+   Rasterized glyphs shared by the font stashes of all NanoVG contexts in the process,
+   so that opening more windows or plugin instances does not rasterize the same glyphs again.
+   Every font stash holds a reference, the cache is cleared when the last one goes away.
+   This only caches rasterization, GPU textures are still per context and glyphs found here are copied into their atlas.
+ */
+struct SharedGlyphCache {
+    struct Key {
+        unsigned long long dataHash;
+        int dataSize;
+        int fontIndex;
+        int glyph;
+        short size;
+        short blur;
+
+        bool operator<(const Key& other) const noexcept
+        {
+            if (dataHash != other.dataHash)
+                return dataHash < other.dataHash;
+            if (dataSize != other.dataSize)
+                return dataSize < other.dataSize;
+            if (fontIndex != other.fontIndex)
+                return fontIndex < other.fontIndex;
+            if (glyph != other.glyph)
+                return glyph < other.glyph;
+            if (size != other.size)
+                return size < other.size;
+            return blur < other.blur;
+        }
+    };
+
+    struct Bitmap {
+        int width, height;
+        std::vector<uchar> pixels;
+    };
+
+    // stop caching new glyphs after this, in bytes
+    static const std::size_t kMaxSize = 4 * 1024 * 1024;
+
+    Mutex mutex;
+    std::map<Key, Bitmap> bitmaps;
+    std::size_t size;
+    uint refCount;
+
+    SharedGlyphCache()
+        : mutex(),
+          bitmaps(),
+          size(0),
+          refCount(0) {}
+
+    DISTRHO_DECLARE_NON_COPYABLE(SharedGlyphCache)
+};
+
+// created on first use, so it is still around when font stashes of global objects are deleted
+static SharedGlyphCache& getSharedGlyphCache()
+{
+    static SharedGlyphCache cache;
+    return cache;
+}
+
 // -----------------------------------------------------------------------
 
 END_NAMESPACE_DGL
@@ -1019,6 +1308,8 @@ END_NAMESPACE_DGL
 # pragma GCC diagnostic ignored "-Wshift-negative-value"
 #endif
 
+#define FONS_SHARED_GLYPH_CACHE
+
 extern "C" {
 #include "nanovg/nanovg.c"
 }
@@ -1028,3 +1319,117 @@ extern "C" {
 #endif
 
 // -----------------------------------------------------------------------
+// Asynchronous image loading, stb_image side
+
+START_NAMESPACE_DGL
+
+NanoImageAsyncLoad::~NanoImageAsyncLoad()
+{
+    std::free(filename);
+    std::free(data);
+
+    if (pixels != nullptr)
+        stbi_image_free(pixels);
+}
+
+void NanoImageAsyncLoad::setupDecoding()
+{
+    // same global options as nvgCreateImage for file and memory loads,
+    // written once under the loader lock, before any job can be queued
+    nvg__setupImageLoading();
+}
+
+void NanoImageAsyncLoad::decode()
+{
+    int channels = 0;
+
+    // same as nvgCreateImage and nvgCreateImageMem, but without touching the NanoVG context
+    if (filename != nullptr)
+        pixels = stbi_load(filename, &width, &height, &channels, 4);
+    else
+        pixels = stbi_load_from_memory(data, static_cast<int>(dataSize), &width, &height, &channels, 4);
+
+    // encoded data is not needed anymore
+    std::free(data);
+    data = nullptr;
+}
+
+END_NAMESPACE_DGL
+
+// -----------------------------------------------------------------------
+// Shared glyph cache, fontstash side
+
+static void fons__sharedGlyphCacheRef(void)
+{
+    DGL_NAMESPACE::SharedGlyphCache& cache(DGL_NAMESPACE::getSharedGlyphCache());
+    const DISTRHO_NAMESPACE::MutexLocker cml(cache.mutex);
+
+    ++cache.refCount;
+}
+
+static void fons__sharedGlyphCacheUnref(void)
+{
+    DGL_NAMESPACE::SharedGlyphCache& cache(DGL_NAMESPACE::getSharedGlyphCache());
+    const DISTRHO_NAMESPACE::MutexLocker cml(cache.mutex);
+
+    DISTRHO_SAFE_ASSERT_RETURN(cache.refCount != 0,);
+
+    if (--cache.refCount != 0)
+        return;
+
+    cache.bitmaps.clear();
+    cache.size = 0;
+}
+
+static int fons__sharedGlyphCacheGet(const unsigned long long dataHash, const int dataSize, const int fontIndex,
+                                     const int glyph, const short isize, const short iblur,
+                                     unsigned char* const dst, const int dstStride, const int w, const int h)
+{
+    DGL_NAMESPACE::SharedGlyphCache& cache(DGL_NAMESPACE::getSharedGlyphCache());
+    const DGL_NAMESPACE::SharedGlyphCache::Key key = { dataHash, dataSize, fontIndex, glyph, isize, iblur };
+    const DISTRHO_NAMESPACE::MutexLocker cml(cache.mutex);
+
+    const std::map<DGL_NAMESPACE::SharedGlyphCache::Key,
+                   DGL_NAMESPACE::SharedGlyphCache::Bitmap>::const_iterator it = cache.bitmaps.find(key);
+
+    if (it == cache.bitmaps.end())
+        return 0;
+
+    const DGL_NAMESPACE::SharedGlyphCache::Bitmap& bitmap(it->second);
+    DISTRHO_SAFE_ASSERT_RETURN(bitmap.width == w && bitmap.height == h, 0);
+
+    for (int y = 0; y < h; ++y)
+        std::memcpy(dst + y * dstStride, &bitmap.pixels[static_cast<std::size_t>(y * w)], static_cast<std::size_t>(w));
+
+    return 1;
+}
+
+static void fons__sharedGlyphCachePut(const unsigned long long dataHash, const int dataSize, const int fontIndex,
+                                      const int glyph, const short isize, const short iblur,
+                                      const unsigned char* const src, const int srcStride, const int w, const int h)
+{
+    DGL_NAMESPACE::SharedGlyphCache& cache(DGL_NAMESPACE::getSharedGlyphCache());
+    const DGL_NAMESPACE::SharedGlyphCache::Key key = { dataHash, dataSize, fontIndex, glyph, isize, iblur };
+    const std::size_t bitmapSize = static_cast<std::size_t>(w * h);
+    const DISTRHO_NAMESPACE::MutexLocker cml(cache.mutex);
+
+    if (bitmapSize == 0 || cache.size + bitmapSize > DGL_NAMESPACE::SharedGlyphCache::kMaxSize)
+        return;
+
+    DGL_NAMESPACE::SharedGlyphCache::Bitmap& bitmap(cache.bitmaps[key]);
+
+    // another context was faster
+    if (! bitmap.pixels.empty())
+        return;
+
+    bitmap.width = w;
+    bitmap.height = h;
+    bitmap.pixels.resize(bitmapSize);
+
+    for (int y = 0; y < h; ++y)
+        std::memcpy(&bitmap.pixels[static_cast<std::size_t>(y * w)], src + y * srcStride, static_cast<std::size_t>(w));
+
+    cache.size += bitmapSize;
+}
+
+// -----------------------------------------------------------------------
@@ -28,20 +28,180 @@
 #include "WidgetPrivateData.hpp"
 #include "WindowPrivateData.hpp"
 
+#include "../../distrho/extra/Mutex.hpp"
+
 // templated classes
 #include "ImageBaseWidgets.cpp"
 
 START_NAMESPACE_DGL
 
+// -----------------------------------------------------------------------
+// Geometry batch
+
+/**
+   Primitives (Line, Circle, Triangle and Rectangle) are drawn through here.
+   Normally each primitive is drawn right away in immediate mode.
+   When batching is enabled (see Window::setGeometryBatchingEnabled) their geometry is accumulated instead and drawn
+   from vertex arrays once something else needs to be drawn, at the latest when a widget's onDisplay returns,
+   reducing draw calls to a minimum.
+   While batching, the current color and line width are tracked as set through DGL, so no OpenGL state has to be queried.
+ */
+struct GeometryBatch {
+    static const uint kMaxVertices = 8192;
+
+    GLfloat vertices[kMaxVertices * 2];
+    GLfloat texCoords[kMaxVertices * 2];
+    GLfloat colors[kMaxVertices * 4];
+    uint numVertices;
+
+    GLenum mode; // GL_TRIANGLES or GL_LINES
+    GLfloat lineWidth;
+    GLfloat color[4];
+    bool enabled;
+
+    GeometryBatch()
+        : numVertices(0),
+          mode(GL_TRIANGLES),
+          lineWidth(1.0f),
+          enabled(false)
+    {
+        color[0] = color[1] = color[2] = color[3] = 1.0f;
+    }
+
+    // pick up the color and line width of the context about to be drawn, once per frame
+    void syncState()
+    {
+        DISTRHO_SAFE_ASSERT(numVertices == 0);
+
+        glGetFloatv(GL_CURRENT_COLOR, color);
+        glGetFloatv(GL_LINE_WIDTH, &lineWidth);
+    }
+
+    void setColor(const GLfloat red, const GLfloat green, const GLfloat blue, const GLfloat alpha)
+    {
+        color[0] = red;
+        color[1] = green;
+        color[2] = blue;
+        color[3] = alpha;
+        glColor4fv(color);
+    }
+
+    void setLineWidth(const GLfloat width)
+    {
+        // pending lines keep the width they were added with
+        if (numVertices != 0 && mode == GL_LINES && lineWidth != width)
+            flush();
+
+        lineWidth = width;
+        glLineWidth(width);
+    }
+
+    // prepare for adding a primitive of @a count vertices
+    bool begin(const GLenum primitiveMode, const uint count)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(count <= kMaxVertices, false);
+
+        if (! enabled)
+        {
+            glBegin(primitiveMode);
+            return true;
+        }
+
+        if (numVertices != 0 && (mode != primitiveMode || numVertices + count > kMaxVertices))
+            flush();
+
+        mode = primitiveMode;
+        return true;
+    }
+
+    void add(const double x, const double y)
+    {
+        if (! enabled)
+        {
+            glVertex2d(x, y);
+            return;
+        }
+
+        addToBatch(x, y, 0.0f, 0.0f);
+    }
+
+    void add(const double x, const double y, const float s, const float t)
+    {
+        if (! enabled)
+        {
+            glTexCoord2f(s, t);
+            glVertex2d(x, y);
+            return;
+        }
+
+        addToBatch(x, y, s, t);
+    }
+
+    void end()
+    {
+        if (! enabled)
+            glEnd();
+    }
+
+    void flush()
+    {
+        if (numVertices == 0)
+            return;
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+
+        glVertexPointer(2, GL_FLOAT, 0, vertices);
+        glTexCoordPointer(2, GL_FLOAT, 0, texCoords);
+        glColorPointer(4, GL_FLOAT, 0, colors);
+        glDrawArrays(mode, 0, static_cast<GLsizei>(numVertices));
+
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        // the current color is undefined after drawing with a color array
+        glColor4fv(color);
+        numVertices = 0;
+    }
+
+private:
+    void addToBatch(const double x, const double y, const float s, const float t) noexcept
+    {
+        GLfloat* const v = vertices + numVertices * 2;
+        v[0] = static_cast<GLfloat>(x);
+        v[1] = static_cast<GLfloat>(y);
+
+        GLfloat* const tc = texCoords + numVertices * 2;
+        tc[0] = s;
+        tc[1] = t;
+
+        std::memcpy(colors + numVertices * 4, color, sizeof(color));
+        ++numVertices;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(GeometryBatch)
+};
+
+static GeometryBatch gGeometryBatch;
+
 // -----------------------------------------------------------------------
 // Color
 
 void Color::setFor(const GraphicsContext&, const bool includeAlpha)
 {
-    if (includeAlpha)
-        glColor4f(red, green, blue, alpha);
-    else
-        glColor3f(red, green, blue);
+    if (! gGeometryBatch.enabled)
+    {
+        if (includeAlpha)
+            glColor4f(red, green, blue, alpha);
+        else
+            glColor3f(red, green, blue);
+        return;
+    }
+
+    // batched geometry takes its color from here, without alpha the current one is kept as done by glColor3f
+    gGeometryBatch.setColor(red, green, blue, includeAlpha ? alpha : gGeometryBatch.color[3]);
 }
 
 // -----------------------------------------------------------------------
@@ -52,14 +212,12 @@ static void drawLine(const Point<T>& posStart, const Point<T>& posEnd)
 {
     DISTRHO_SAFE_ASSERT_RETURN(posStart != posEnd,);
 
-    glBegin(GL_LINES);
-
-    {
-        glVertex2d(posStart.getX(), posStart.getY());
-        glVertex2d(posEnd.getX(), posEnd.getY());
-    }
+    if (! gGeometryBatch.begin(GL_LINES, 2))
+        return;
 
-    glEnd();
+    gGeometryBatch.add(posStart.getX(), posStart.getY());
+    gGeometryBatch.add(posEnd.getX(), posEnd.getY());
+    gGeometryBatch.end();
 }
 
 template<typename T>
@@ -67,7 +225,7 @@ void Line<T>::draw(const GraphicsContext&, const T width)
 {
     DISTRHO_SAFE_ASSERT_RETURN(width != 0,);
 
-    glLineWidth(static_cast<GLfloat>(width));
+    gGeometryBatch.setLineWidth(static_cast<GLfloat>(width));
     drawLine<T>(posStart, posEnd);
 }
 
@@ -98,22 +256,45 @@ static void drawCircle(const Point<T>& pos,
 {
     DISTRHO_SAFE_ASSERT_RETURN(numSegments >= 3 && size > 0.0f,);
 
-    const T origx = pos.getX();
-    const T origy = pos.getY();
-    double t, x = size, y = 0.0;
+    // outline as line segments, filled as a triangle fan
+    if (! gGeometryBatch.begin(outline ? GL_LINES : GL_TRIANGLES, outline ? numSegments * 2 : (numSegments - 2) * 3))
+        return;
 
-    glBegin(outline ? GL_LINE_LOOP : GL_POLYGON);
+    const double origx = pos.getX();
+    const double origy = pos.getY();
+    const double firstx = size + origx;
+    const double firsty = origy;
+    double t, x = size, y = 0.0, lastx = firstx, lasty = firsty;
 
-    for (uint i=0; i<numSegments; ++i)
+    for (uint i=1; i<numSegments; ++i)
     {
-        glVertex2d(x + origx, y + origy);
-
         t = x;
         x = cos * x - sin * y;
         y = sin * t + cos * y;
+
+        if (outline)
+        {
+            gGeometryBatch.add(lastx, lasty);
+            gGeometryBatch.add(x + origx, y + origy);
+        }
+        else if (i >= 2)
+        {
+            gGeometryBatch.add(firstx, firsty);
+            gGeometryBatch.add(lastx, lasty);
+            gGeometryBatch.add(x + origx, y + origy);
+        }
+
+        lastx = x + origx;
+        lasty = y + origy;
     }
 
-    glEnd();
+    if (outline)
+    {
+        gGeometryBatch.add(lastx, lasty);
+        gGeometryBatch.add(firstx, firsty);
+    }
+
+    gGeometryBatch.end();
 }
 
 template<typename T>
@@ -127,7 +308,7 @@ void Circle<T>::drawOutline(const GraphicsContext&, const T lineWidth)
 {
     DISTRHO_SAFE_ASSERT_RETURN(lineWidth != 0,);
 
-    glLineWidth(static_cast<GLfloat>(lineWidth));
+    gGeometryBatch.setLineWidth(static_cast<GLfloat>(lineWidth));
     drawCircle<T>(fPos, fNumSegments, fSize, fSin, fCos, true);
 }
 
@@ -162,15 +343,29 @@ static void drawTriangle(const Point<T>& pos1,
 {
     DISTRHO_SAFE_ASSERT_RETURN(pos1 != pos2 && pos1 != pos3,);
 
-    glBegin(outline ? GL_LINE_LOOP : GL_TRIANGLES);
-
+    if (outline)
     {
-        glVertex2d(pos1.getX(), pos1.getY());
-        glVertex2d(pos2.getX(), pos2.getY());
-        glVertex2d(pos3.getX(), pos3.getY());
+        if (! gGeometryBatch.begin(GL_LINES, 6))
+            return;
+
+        gGeometryBatch.add(pos1.getX(), pos1.getY());
+        gGeometryBatch.add(pos2.getX(), pos2.getY());
+        gGeometryBatch.add(pos2.getX(), pos2.getY());
+        gGeometryBatch.add(pos3.getX(), pos3.getY());
+        gGeometryBatch.add(pos3.getX(), pos3.getY());
+        gGeometryBatch.add(pos1.getX(), pos1.getY());
     }
+    else
+    {
+        if (! gGeometryBatch.begin(GL_TRIANGLES, 3))
+            return;
 
-    glEnd();
+        gGeometryBatch.add(pos1.getX(), pos1.getY());
+        gGeometryBatch.add(pos2.getX(), pos2.getY());
+        gGeometryBatch.add(pos3.getX(), pos3.getY());
+    }
+
+    gGeometryBatch.end();
 }
 
 template<typename T>
@@ -184,7 +379,7 @@ void Triangle<T>::drawOutline(const GraphicsContext&, const T lineWidth)
 {
     DISTRHO_SAFE_ASSERT_RETURN(lineWidth != 0,);
 
-    glLineWidth(static_cast<GLfloat>(lineWidth));
+    gGeometryBatch.setLineWidth(static_cast<GLfloat>(lineWidth));
     drawTriangle<T>(pos1, pos2, pos3, true);
 }
 
@@ -216,28 +411,40 @@ static void drawRectangle(const Rectangle<T>& rect, const bool outline)
 {
     DISTRHO_SAFE_ASSERT_RETURN(rect.isValid(),);
 
-    glBegin(outline ? GL_LINE_LOOP : GL_QUADS);
+    const double x = rect.getX();
+    const double y = rect.getY();
+    const double w = rect.getWidth();
+    const double h = rect.getHeight();
 
+    if (outline)
     {
-        const T x = rect.getX();
-        const T y = rect.getY();
-        const T w = rect.getWidth();
-        const T h = rect.getHeight();
-
-        glTexCoord2f(0.0f, 0.0f);
-        glVertex2d(x, y);
-
-        glTexCoord2f(1.0f, 0.0f);
-        glVertex2d(x+w, y);
-
-        glTexCoord2f(1.0f, 1.0f);
-        glVertex2d(x+w, y+h);
-
-        glTexCoord2f(0.0f, 1.0f);
-        glVertex2d(x, y+h);
+        if (! gGeometryBatch.begin(GL_LINES, 8))
+            return;
+
+        gGeometryBatch.add(x, y);
+        gGeometryBatch.add(x+w, y);
+        gGeometryBatch.add(x+w, y);
+        gGeometryBatch.add(x+w, y+h);
+        gGeometryBatch.add(x+w, y+h);
+        gGeometryBatch.add(x, y+h);
+        gGeometryBatch.add(x, y+h);
+        gGeometryBatch.add(x, y);
+    }
+    else
+    {
+        if (! gGeometryBatch.begin(GL_TRIANGLES, 6))
+            return;
+
+        // texture coordinates are kept for drawing rectangles with a texture bound
+        gGeometryBatch.add(x, y, 0.0f, 0.0f);
+        gGeometryBatch.add(x+w, y, 1.0f, 0.0f);
+        gGeometryBatch.add(x+w, y+h, 1.0f, 1.0f);
+        gGeometryBatch.add(x, y, 0.0f, 0.0f);
+        gGeometryBatch.add(x+w, y+h, 1.0f, 1.0f);
+        gGeometryBatch.add(x, y+h, 0.0f, 1.0f);
     }
 
-    glEnd();
+    gGeometryBatch.end();
 }
 
 template<typename T>
@@ -251,7 +458,7 @@ void Rectangle<T>::drawOutline(const GraphicsContext&, const T lineWidth)
 {
     DISTRHO_SAFE_ASSERT_RETURN(lineWidth != 0,);
 
-    glLineWidth(static_cast<GLfloat>(lineWidth));
+    gGeometryBatch.setLineWidth(static_cast<GLfloat>(lineWidth));
     drawRectangle<T>(*this, true);
 }
 
@@ -276,12 +483,69 @@ template class Rectangle<short>;
 template class Rectangle<ushort>;
 
 // -----------------------------------------------------------------------
-// OpenGLImage
+// Texture cache
+
+/**
+   Textures are shared between all images using the same raw data within an OpenGL context, and uploaded only once.
+   Loading an image from memory marks the textures of that raw data as outdated, as its contents might have changed,
+   so every image using them uploads the data again on its next draw.
+   Images made of several layers (like knob film strips) have a 1 pixel transparent gutter between layers,
+   so that linear filtering on the layer edges behaves like the transparent border of single textures.
+   Images up to kMaxAtlasImageSize are packed row by row into bigger atlas textures, surrounded by a gutter as well.
+   Atlas space is not reused, an atlas is deleted once none of its images are in use anymore.
+   The cache is protected by a mutex, as windows can be drawn from different threads, each with its own context.
+ */
+static const uint kAtlasSize = 1024;
+static const uint kMaxAtlasImageSize = 256;
+
+struct OpenGLTextureAtlas {
+    const void* context;
+    GLuint textureId;
+    uint rowX, rowY, rowHeight;
+    uint numTextures;
+};
+
+struct OpenGLTexture {
+    const void* context;
+    const char* rawData; // nullptr for textures not shared
+    Size<uint> size;
+    ImageFormat format;
+    uint layerCount;
+    bool isVertical;
+    GLuint textureId;
+    OpenGLTextureAtlas* atlas;
+    uint x, y; // position of the first layer within the texture
+    uint textureWidth, textureHeight;
+    uint refCount;
+    bool outdated; // no longer shared, the raw data was reloaded
+
+    uint getLayerWidth() const noexcept
+    {
+        return isVertical ? size.getWidth() : size.getWidth() / layerCount;
+    }
+
+    uint getLayerHeight() const noexcept
+    {
+        return isVertical ? size.getHeight() / layerCount : size.getHeight();
+    }
+};
+
+struct OpenGLTextureCache {
+    Mutex mutex;
+    std::list<OpenGLTexture*> textures;
+    std::list<OpenGLTextureAtlas*> atlases;
+};
 
-static void setupOpenGLImage(const OpenGLImage& image, GLuint textureId)
+// created on first use, so it outlives images declared as globals in other translation units
+static OpenGLTextureCache& getOpenGLTextureCache()
 {
-    DISTRHO_SAFE_ASSERT_RETURN(image.isValid(),);
+    static OpenGLTextureCache cache;
+    return cache;
+}
 
+static void setupOpenGLTexture(const GLuint textureId, const uint width, const uint height,
+                               const GLenum format, const void* const data)
+{
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, textureId);
 
@@ -296,49 +560,311 @@ static void setupOpenGLImage(const OpenGLImage& image, GLuint textureId)
     glPixelStorei(GL_PACK_ALIGNMENT, 1);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-                 static_cast<GLsizei>(image.getWidth()),
-                 static_cast<GLsizei>(image.getHeight()),
+                 static_cast<GLsizei>(width),
+                 static_cast<GLsizei>(height),
                  0,
-                 asOpenGLImageFormat(image.getFormat()), GL_UNSIGNED_BYTE, image.getRawData());
+                 format, GL_UNSIGNED_BYTE, data);
 
     glBindTexture(GL_TEXTURE_2D, 0);
     glDisable(GL_TEXTURE_2D);
 }
 
-static void drawOpenGLImage(const OpenGLImage& image, const Point<int>& pos, const GLuint textureId, bool& setupCalled)
+// create a texture with transparent contents
+static bool setupEmptyOpenGLTexture(const GLuint textureId, const uint width, const uint height)
+{
+    void* const zeros = std::calloc(width * height, 4);
+    DISTRHO_SAFE_ASSERT_RETURN(zeros != nullptr, false);
+
+    setupOpenGLTexture(textureId, width, height, GL_RGBA, zeros);
+    std::free(zeros);
+    return true;
+}
+
+static void uploadOpenGLTextureLayers(const OpenGLTexture& texture)
+{
+    const uint layerWidth  = texture.getLayerWidth();
+    const uint layerHeight = texture.getLayerHeight();
+    const GLenum skipParam = texture.isVertical ? GL_UNPACK_SKIP_ROWS : GL_UNPACK_SKIP_PIXELS;
+
+    glBindTexture(GL_TEXTURE_2D, texture.textureId);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(texture.size.getWidth()));
+
+    for (uint i=0; i<texture.layerCount; ++i)
+    {
+        const uint x = texture.isVertical ? texture.x : texture.x + i * (layerWidth + 1);
+        const uint y = texture.isVertical ? texture.y + i * (layerHeight + 1) : texture.y;
+
+        glPixelStorei(skipParam, static_cast<GLint>(i * (texture.isVertical ? layerHeight : layerWidth)));
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        static_cast<GLint>(x), static_cast<GLint>(y),
+                        static_cast<GLsizei>(layerWidth), static_cast<GLsizei>(layerHeight),
+                        asOpenGLImageFormat(texture.format), GL_UNSIGNED_BYTE, texture.rawData);
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(skipParam, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static bool allocateAtlasArea(OpenGLTextureAtlas* const atlas, const uint width, const uint height, uint& x, uint& y)
+{
+    const uint paddedWidth  = width + 2;
+    const uint paddedHeight = height + 2;
+
+    uint rowX = atlas->rowX;
+    uint rowY = atlas->rowY;
+    uint rowHeight = atlas->rowHeight;
+
+    // start a new row if this one is full
+    if (rowX + paddedWidth > kAtlasSize)
+    {
+        rowX = 0;
+        rowY += rowHeight;
+        rowHeight = 0;
+    }
+
+    if (rowY + paddedHeight > kAtlasSize)
+        return false;
+
+    x = rowX + 1;
+    y = rowY + 1;
+
+    atlas->rowX = rowX + paddedWidth;
+    atlas->rowY = rowY;
+    atlas->rowHeight = std::max(rowHeight, paddedHeight);
+    return true;
+}
+
+// must be called with the texture cache mutex locked
+static OpenGLTextureAtlas* allocateAtlasTexture(std::list<OpenGLTextureAtlas*>& atlases, const void* const context,
+                                                const uint width, const uint height, uint& x, uint& y)
+{
+    for (std::list<OpenGLTextureAtlas*>::iterator it = atlases.begin(); it != atlases.end(); ++it)
+    {
+        OpenGLTextureAtlas* const atlas(*it);
+
+        if (atlas->context == context && allocateAtlasArea(atlas, width, height, x, y))
+            return atlas;
+    }
+
+    GLuint textureId = 0;
+    glGenTextures(1, &textureId);
+    DISTRHO_SAFE_ASSERT_RETURN(textureId != 0, nullptr);
+
+    if (! setupEmptyOpenGLTexture(textureId, kAtlasSize, kAtlasSize))
+    {
+        glDeleteTextures(1, &textureId);
+        return nullptr;
+    }
+
+    OpenGLTextureAtlas* const atlas = new OpenGLTextureAtlas;
+    atlas->context = context;
+    atlas->textureId = textureId;
+    atlas->rowX = atlas->rowY = atlas->rowHeight = 0;
+    atlas->numTextures = 0;
+
+    allocateAtlasArea(atlas, width, height, x, y);
+    atlases.push_back(atlas);
+    return atlas;
+}
+
+// texture for a single user in the current OpenGL context, with contents provided by the caller
+static OpenGLTexture* createOpenGLTexture(const Size<uint>& size)
+{
+    OpenGLTexture* const texture = new OpenGLTexture;
+    texture->context = puglGetCurrentOpenGLContext();
+    texture->rawData = nullptr;
+    texture->size = size;
+    texture->format = kImageFormatNull;
+    texture->layerCount = 1;
+    texture->isVertical = false;
+    texture->textureId = 0;
+    texture->atlas = nullptr;
+    texture->x = texture->y = 0;
+    texture->textureWidth = size.getWidth();
+    texture->textureHeight = size.getHeight();
+    texture->refCount = 1;
+    texture->outdated = false;
+
+    glGenTextures(1, &texture->textureId);
+    DISTRHO_SAFE_ASSERT(texture->textureId != 0);
+
+    return texture;
+}
+
+// texture shared between all images with the same data and layers in the current OpenGL context,
+// returns null if the image is too big
+static OpenGLTexture* acquireOpenGLTexture(const ImageBase& image, const uint layerCount = 1, bool isVertical = false)
 {
-    if (textureId == 0 || image.isInvalid())
+    DISTRHO_SAFE_ASSERT_RETURN(image.isValid(), nullptr);
+    DISTRHO_SAFE_ASSERT_RETURN(layerCount != 0, nullptr);
+
+    OpenGLTextureCache& cache(getOpenGLTextureCache());
+    const MutexLocker cml(cache.mutex);
+
+    const void* const context = puglGetCurrentOpenGLContext();
+    const char* const rawData = image.getRawData();
+    const Size<uint> size(image.getSize());
+    const ImageFormat format = image.getFormat();
+
+    if (layerCount == 1)
+        isVertical = false;
+
+    for (std::list<OpenGLTexture*>::iterator it = cache.textures.begin(); it != cache.textures.end(); ++it)
+    {
+        OpenGLTexture* const texture(*it);
+
+        if (texture->context == context && texture->rawData == rawData && texture->size == size
+            && texture->format == format && texture->layerCount == layerCount && texture->isVertical == isVertical
+            && ! texture->outdated)
+        {
+            ++texture->refCount;
+            return texture;
+        }
+    }
+
+    OpenGLTexture* const texture = new OpenGLTexture;
+    texture->context = context;
+    texture->rawData = rawData;
+    texture->size = size;
+    texture->format = format;
+    texture->layerCount = layerCount;
+    texture->isVertical = isVertical;
+    texture->textureId = 0;
+    texture->atlas = nullptr;
+    texture->x = texture->y = 0;
+    texture->refCount = 1;
+    texture->outdated = false;
+
+    // size including gutters between layers
+    const uint width  = isVertical ? size.getWidth() : (texture->getLayerWidth() + 1) * layerCount - 1;
+    const uint height = isVertical ? (texture->getLayerHeight() + 1) * layerCount - 1 : size.getHeight();
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    if (width > static_cast<uint>(maxTextureSize) || height > static_cast<uint>(maxTextureSize))
+    {
+        delete texture;
+        return nullptr;
+    }
+
+    if (width <= kMaxAtlasImageSize && height <= kMaxAtlasImageSize && kAtlasSize <= static_cast<uint>(maxTextureSize))
+        texture->atlas = allocateAtlasTexture(cache.atlases, context, width, height, texture->x, texture->y);
+
+    if (OpenGLTextureAtlas* const atlas = texture->atlas)
+    {
+        ++atlas->numTextures;
+        texture->textureId = atlas->textureId;
+        texture->textureWidth = texture->textureHeight = kAtlasSize;
+        uploadOpenGLTextureLayers(*texture);
+    }
+    else
+    {
+        glGenTextures(1, &texture->textureId);
+        DISTRHO_SAFE_ASSERT(texture->textureId != 0);
+
+        texture->textureWidth = width;
+        texture->textureHeight = height;
+
+        if (layerCount == 1)
+        {
+            setupOpenGLTexture(texture->textureId, width, height, asOpenGLImageFormat(format), rawData);
+        }
+        else if (setupEmptyOpenGLTexture(texture->textureId, width, height))
+        {
+            uploadOpenGLTextureLayers(*texture);
+        }
+    }
+
+    cache.textures.push_back(texture);
+    return texture;
+}
+
+// called when images load @a rawData, its contents might have changed since the textures were uploaded
+static void invalidateOpenGLTextures(const char* const rawData)
+{
+    if (rawData == nullptr)
+        return;
+
+    OpenGLTextureCache& cache(getOpenGLTextureCache());
+    const MutexLocker cml(cache.mutex);
+
+    for (std::list<OpenGLTexture*>::iterator it = cache.textures.begin(); it != cache.textures.end(); ++it)
+    {
+        OpenGLTexture* const texture(*it);
+
+        if (texture->rawData == rawData)
+            texture->outdated = true;
+    }
+}
+
+static void releaseOpenGLTexture(OpenGLTexture* const texture)
+{
+    OpenGLTextureCache& cache(getOpenGLTextureCache());
+    const MutexLocker cml(cache.mutex);
+
+    DISTRHO_SAFE_ASSERT_RETURN(texture->refCount != 0,);
+
+    if (--texture->refCount != 0)
         return;
 
-    if (! setupCalled)
+    cache.textures.remove(texture);
+
+    if (OpenGLTextureAtlas* const atlas = texture->atlas)
+    {
+        if (--atlas->numTextures == 0)
+        {
+            cache.atlases.remove(atlas);
+            glDeleteTextures(1, &atlas->textureId);
+            delete atlas;
+        }
+    }
+    else if (texture->textureId != 0)
     {
-        setupOpenGLImage(image, textureId);
-        setupCalled = true;
+        glDeleteTextures(1, &texture->textureId);
     }
 
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    delete texture;
+}
+
+static void drawOpenGLTexture(const OpenGLTexture& texture, const uint layer,
+                              const int x, const int y, const int w, const int h)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(layer < texture.layerCount,);
+
+    // anything drawn before goes below the texture
+    gGeometryBatch.flush();
+
+    const uint layerWidth  = texture.getLayerWidth();
+    const uint layerHeight = texture.getLayerHeight();
+    const uint layerX = texture.isVertical ? texture.x : texture.x + layer * (layerWidth + 1);
+    const uint layerY = texture.isVertical ? texture.y + layer * (layerHeight + 1) : texture.y;
+
+    const GLfloat s1 = static_cast<GLfloat>(layerX) / texture.textureWidth;
+    const GLfloat t1 = static_cast<GLfloat>(layerY) / texture.textureHeight;
+    const GLfloat s2 = static_cast<GLfloat>(layerX + layerWidth) / texture.textureWidth;
+    const GLfloat t2 = static_cast<GLfloat>(layerY + layerHeight) / texture.textureHeight;
+
+    gGeometryBatch.setColor(1.0f, 1.0f, 1.0f, 1.0f);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureId);
+    glBindTexture(GL_TEXTURE_2D, texture.textureId);
 
     glBegin(GL_QUADS);
 
     {
-        const int x = pos.getX();
-        const int y = pos.getY();
-        const int w = static_cast<int>(image.getWidth());
-        const int h = static_cast<int>(image.getHeight());
-
-        glTexCoord2f(0.0f, 0.0f);
+        glTexCoord2f(s1, t1);
         glVertex2d(x, y);
 
-        glTexCoord2f(1.0f, 0.0f);
+        glTexCoord2f(s2, t1);
         glVertex2d(x+w, y);
 
-        glTexCoord2f(1.0f, 1.0f);
+        glTexCoord2f(s2, t2);
         glVertex2d(x+w, y+h);
 
-        glTexCoord2f(0.0f, 1.0f);
+        glTexCoord2f(s1, t2);
         glVertex2d(x, y+h);
     }
 
@@ -348,100 +874,121 @@ static void drawOpenGLImage(const OpenGLImage& image, const Point<int>& pos, con
     glDisable(GL_TEXTURE_2D);
 }
 
-OpenGLImage::OpenGLImage()
-    : ImageBase(),
-      textureId(0),
-      setupCalled(false)
+// -----------------------------------------------------------------------
+// OpenGLImage
+
+// images drawn through the deprecated calls without a graphics context use a texture of their own, as before
+static void drawOpenGLImage(const OpenGLImage& image, const Point<int>& pos, OpenGLTexture*& texture, const bool shared)
 {
-    glGenTextures(1, &textureId);
-    DISTRHO_SAFE_ASSERT(textureId != 0);
+    if (image.isInvalid())
+        return;
+
+    if (texture != nullptr && (texture->context != puglGetCurrentOpenGLContext() || texture->outdated
+                               || (texture->rawData != nullptr) != shared))
+    {
+        releaseOpenGLTexture(texture);
+        texture = nullptr;
+    }
+
+    if (texture == nullptr)
+    {
+        if (shared)
+        {
+            texture = acquireOpenGLTexture(image);
+        }
+        else
+        {
+            texture = createOpenGLTexture(image.getSize());
+            setupOpenGLTexture(texture->textureId, image.getWidth(), image.getHeight(),
+                               asOpenGLImageFormat(image.getFormat()), image.getRawData());
+        }
+
+        if (texture == nullptr)
+            return;
+    }
+
+    drawOpenGLTexture(*texture, 0,
+                      pos.getX(), pos.getY(),
+                      static_cast<int>(image.getWidth()), static_cast<int>(image.getHeight()));
 }
 
+OpenGLImage::OpenGLImage()
+    : ImageBase(),
+      texture(nullptr) {}
+
 OpenGLImage::OpenGLImage(const char* const rdata, const uint w, const uint h, const ImageFormat fmt)
     : ImageBase(rdata, w, h, fmt),
-      textureId(0),
-      setupCalled(false)
-{
-    glGenTextures(1, &textureId);
-    DISTRHO_SAFE_ASSERT(textureId != 0);
-}
+      texture(nullptr) {}
 
 OpenGLImage::OpenGLImage(const char* const rdata, const Size<uint>& s, const ImageFormat fmt)
     : ImageBase(rdata, s, fmt),
-      textureId(0),
-      setupCalled(false)
-{
-    glGenTextures(1, &textureId);
-    DISTRHO_SAFE_ASSERT(textureId != 0);
-}
+      texture(nullptr) {}
 
 OpenGLImage::OpenGLImage(const OpenGLImage& image)
     : ImageBase(image),
-      textureId(0),
-      setupCalled(false)
-{
-    glGenTextures(1, &textureId);
-    DISTRHO_SAFE_ASSERT(textureId != 0);
-}
+      texture(nullptr) {}
 
 OpenGLImage::~OpenGLImage()
 {
-    if (textureId != 0)
-        glDeleteTextures(1, &textureId);
+    if (texture != nullptr)
+        releaseOpenGLTexture(texture);
 }
 
 void OpenGLImage::loadFromMemory(const char* const rdata, const Size<uint>& s, const ImageFormat fmt) noexcept
 {
-    setupCalled = false;
+    if (texture != nullptr)
+    {
+        releaseOpenGLTexture(texture);
+        texture = nullptr;
+    }
+
+    // other images might share textures of this data
+    invalidateOpenGLTextures(rdata);
+
     ImageBase::loadFromMemory(rdata, s, fmt);
 }
 
 void OpenGLImage::drawAt(const GraphicsContext&, const Point<int>& pos)
 {
-    drawOpenGLImage(*this, pos, textureId, setupCalled);
+    drawOpenGLImage(*this, pos, texture, true);
 }
 
 OpenGLImage& OpenGLImage::operator=(const OpenGLImage& image) noexcept
 {
+    if (texture != nullptr)
+    {
+        releaseOpenGLTexture(texture);
+        texture = nullptr;
+    }
+
     rawData = image.rawData;
     size    = image.size;
     format  = image.format;
-    setupCalled = false;
     return *this;
 }
 
 // deprecated calls
 OpenGLImage::OpenGLImage(const char* const rdata, const uint w, const uint h, const GLenum fmt)
     : ImageBase(rdata, w, h, asDISTRHOImageFormat(fmt)),
-      textureId(0),
-      setupCalled(false)
-{
-    glGenTextures(1, &textureId);
-    DISTRHO_SAFE_ASSERT(textureId != 0);
-}
+      texture(nullptr) {}
 
 OpenGLImage::OpenGLImage(const char* const rdata, const Size<uint>& s, const GLenum fmt)
     : ImageBase(rdata, s, asDISTRHOImageFormat(fmt)),
-      textureId(0),
-      setupCalled(false)
-{
-    glGenTextures(1, &textureId);
-    DISTRHO_SAFE_ASSERT(textureId != 0);
-}
+      texture(nullptr) {}
 
 void OpenGLImage::draw()
 {
-    drawOpenGLImage(*this, Point<int>(0, 0), textureId, setupCalled);
+    drawOpenGLImage(*this, Point<int>(0, 0), texture, false);
 }
 
 void OpenGLImage::drawAt(const int x, const int y)
 {
-    drawOpenGLImage(*this, Point<int>(x, y), textureId, setupCalled);
+    drawOpenGLImage(*this, Point<int>(x, y), texture, false);
 }
 
 void OpenGLImage::drawAt(const Point<int>& pos)
 {
-    drawOpenGLImage(*this, pos, textureId, setupCalled);
+    drawOpenGLImage(*this, pos, texture, false);
 }
 
 // -----------------------------------------------------------------------
@@ -469,70 +1016,95 @@ template class ImageBaseButton<OpenGLImage>;
 template <>
 void ImageBaseKnob<OpenGLImage>::PrivateData::init()
 {
-    glTextureId = 0;
-    glGenTextures(1, &glTextureId);
+    glTexture = nullptr;
 }
 
 template <>
 void ImageBaseKnob<OpenGLImage>::PrivateData::cleanup()
 {
-    if (glTextureId == 0)
+    if (glTexture == nullptr)
         return;
 
-    glDeleteTextures(1, &glTextureId);
-    glTextureId = 0;
+    releaseOpenGLTexture(static_cast<OpenGLTexture*>(glTexture));
+    glTexture = nullptr;
 }
 
 template <>
 void ImageBaseKnob<OpenGLImage>::onDisplay()
 {
-    const GraphicsContext& context(getGraphicsContext());
     const float normValue = getNormalizedValue();
 
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, pData->glTextureId);
+    if (pData->image.isInvalid())
+        return;
+
+    OpenGLTexture* texture = static_cast<OpenGLTexture*>(pData->glTexture);
 
-    if (! pData->isReady)
+    const Size<uint> layerSize(pData->imgLayerWidth, pData->imgLayerHeight);
+
+    // the layer count can change after the texture was created
+    if (texture != nullptr && (texture->context != puglGetCurrentOpenGLContext() || texture->outdated
+                               || (texture->rawData != nullptr ? texture->layerCount != pData->imgLayerCount
+                                                               : texture->size != layerSize)))
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        pData->cleanup();
+        texture = nullptr;
+    }
 
-        static const float trans[] = { 0.0f, 0.0f, 0.0f, 0.0f };
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, trans);
+    if (texture == nullptr)
+    {
+        // all layers are shared with other knobs, unless too big for a single texture
+        texture = acquireOpenGLTexture(pData->image, pData->imgLayerCount, pData->isImgVertical);
 
-        glPixelStorei(GL_PACK_ALIGNMENT, 1);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (texture == nullptr)
+            texture = createOpenGLTexture(layerSize);
 
-        uint imageDataOffset = 0;
+        pData->glTexture = texture;
+        pData->isReady = false;
+    }
+
+    uint layer = 0;
+
+    if (pData->rotationAngle == 0)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(pData->imgLayerCount > 0,);
+        DISTRHO_SAFE_ASSERT_RETURN(normValue >= 0.0f,);
+
+        layer = uint(normValue * float(pData->imgLayerCount-1));
+    }
 
-        if (pData->rotationAngle == 0)
+    if (texture->rawData == nullptr)
+    {
+        // upload only the current layer into our own texture
+        if (! pData->isReady)
         {
-            DISTRHO_SAFE_ASSERT_RETURN(pData->imgLayerCount > 0,);
-            DISTRHO_SAFE_ASSERT_RETURN(normValue >= 0.0f,);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(pData->image.getWidth()));
 
-            const uint& v1(pData->isImgVertical ? pData->imgLayerWidth : pData->imgLayerHeight);
-            const uint& v2(pData->isImgVertical ? pData->imgLayerHeight : pData->imgLayerWidth);
+            if (pData->isImgVertical)
+                glPixelStorei(GL_UNPACK_SKIP_ROWS, static_cast<GLint>(layer * pData->imgLayerHeight));
+            else
+                glPixelStorei(GL_UNPACK_SKIP_PIXELS, static_cast<GLint>(layer * pData->imgLayerWidth));
 
-            // TODO kImageFormatGreyscale
-            const uint layerDataSize   = v1 * v2 * ((pData->image.getFormat() == kImageFormatBGRA ||
-                                                     pData->image.getFormat() == kImageFormatRGBA) ? 4 : 3);
-            /*      */ imageDataOffset = layerDataSize * uint(normValue * float(pData->imgLayerCount-1));
-        }
+            setupOpenGLTexture(texture->textureId, pData->imgLayerWidth, pData->imgLayerHeight,
+                               asOpenGLImageFormat(pData->image.getFormat()), pData->image.getRawData());
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-                     static_cast<GLsizei>(getWidth()), static_cast<GLsizei>(getHeight()), 0,
-                     asOpenGLImageFormat(pData->image.getFormat()), GL_UNSIGNED_BYTE, pData->image.getRawData() + imageDataOffset);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+        }
 
-        pData->isReady = true;
+        layer = 0;
     }
 
+    pData->isReady = true;
+
     const int w = static_cast<int>(getWidth());
     const int h = static_cast<int>(getHeight());
 
     if (pData->rotationAngle != 0)
     {
+        // anything drawn before must not be affected by the rotation
+        gGeometryBatch.flush();
+
         glPushMatrix();
 
         const int w2 = w/2;
@@ -541,17 +1113,14 @@ void ImageBaseKnob<OpenGLImage>::onDisplay()
         glTranslatef(static_cast<float>(w2), static_cast<float>(h2), 0.0f);
         glRotatef(normValue*static_cast<float>(pData->rotationAngle), 0.0f, 0.0f, 1.0f);
 
-        Rectangle<int>(-w2, -h2, w, h).draw(context);
+        drawOpenGLTexture(*texture, layer, -w2, -h2, w, h);
 
         glPopMatrix();
     }
     else
     {
-        Rectangle<int>(0, 0, w, h).draw(context);
+        drawOpenGLTexture(*texture, layer, 0, 0, w, h);
     }
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
 }
 
 template class ImageBaseKnob<OpenGLImage>;
@@ -567,12 +1136,286 @@ template class ImageBaseSlider<OpenGLImage>;
 template class ImageBaseSwitch<OpenGLImage>;
 
 // -----------------------------------------------------------------------
+// SubWidget cache, using framebuffer objects
+
+#ifndef GL_DEPTH24_STENCIL8
+# define GL_DEPTH24_STENCIL8 0x88F0
+#endif
+
+#ifdef DISTRHO_OS_WINDOWS
+# define DGL_EXT(PROC, func) static PROC func;
+DGL_EXT(PFNGLBINDFRAMEBUFFERPROC,         glBindFramebuffer)
+DGL_EXT(PFNGLBINDRENDERBUFFERPROC,        glBindRenderbuffer)
+DGL_EXT(PFNGLBLENDFUNCSEPARATEPROC,       glBlendFuncSeparate)
+DGL_EXT(PFNGLCHECKFRAMEBUFFERSTATUSPROC,  glCheckFramebufferStatus)
+DGL_EXT(PFNGLDELETEFRAMEBUFFERSPROC,      glDeleteFramebuffers)
+DGL_EXT(PFNGLDELETERENDERBUFFERSPROC,     glDeleteRenderbuffers)
+DGL_EXT(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer)
+DGL_EXT(PFNGLFRAMEBUFFERTEXTURE2DPROC,    glFramebufferTexture2D)
+DGL_EXT(PFNGLGENFRAMEBUFFERSPROC,         glGenFramebuffers)
+DGL_EXT(PFNGLGENRENDERBUFFERSPROC,        glGenRenderbuffers)
+DGL_EXT(PFNGLRENDERBUFFERSTORAGEPROC,     glRenderbufferStorage)
+# undef DGL_EXT
+#endif
 
-void SubWidget::PrivateData::display(const uint width, const uint height, const double autoScaleFactor)
+static bool loadFramebufferFunctions()
+{
+#ifdef DISTRHO_OS_WINDOWS
+# if defined(__GNUC__) && (__GNUC__ >= 9)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wcast-function-type"
+# endif
+    static bool needsInit = true;
+# define DGL_EXT(PROC, func) \
+      if (needsInit) func = (PROC) wglGetProcAddress ( #func ); \
+      DISTRHO_SAFE_ASSERT_RETURN(func != nullptr, false);
+DGL_EXT(PFNGLBINDFRAMEBUFFERPROC,         glBindFramebuffer)
+DGL_EXT(PFNGLBINDRENDERBUFFERPROC,        glBindRenderbuffer)
+DGL_EXT(PFNGLBLENDFUNCSEPARATEPROC,       glBlendFuncSeparate)
+DGL_EXT(PFNGLCHECKFRAMEBUFFERSTATUSPROC,  glCheckFramebufferStatus)
+DGL_EXT(PFNGLDELETEFRAMEBUFFERSPROC,      glDeleteFramebuffers)
+DGL_EXT(PFNGLDELETERENDERBUFFERSPROC,     glDeleteRenderbuffers)
+DGL_EXT(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer)
+DGL_EXT(PFNGLFRAMEBUFFERTEXTURE2DPROC,    glFramebufferTexture2D)
+DGL_EXT(PFNGLGENFRAMEBUFFERSPROC,         glGenFramebuffers)
+DGL_EXT(PFNGLGENRENDERBUFFERSPROC,        glGenRenderbuffers)
+DGL_EXT(PFNGLRENDERBUFFERSTORAGEPROC,     glRenderbufferStorage)
+# undef DGL_EXT
+    needsInit = false;
+# if defined(__GNUC__) && (__GNUC__ >= 9)
+#  pragma GCC diagnostic pop
+# endif
+#endif
+    return true;
+}
+
+// origin of the framebuffer being drawn into, not zero while updating a subwidget cache
+static int gFramebufferOffsetX = 0;
+static int gFramebufferOffsetY = 0;
+
+struct SubWidget::PrivateData::Cache {
+    GLuint framebuffer;
+    GLuint renderbuffer; // depth and stencil, needed for NanoVG
+    GLuint texture;
+    int width, height;
+
+    Cache()
+        : framebuffer(0),
+          renderbuffer(0),
+          texture(0),
+          width(0),
+          height(0) {}
+
+    ~Cache()
+    {
+        clear();
+    }
+
+    bool resize(const int w, const int h)
+    {
+        clear();
+
+        if (! loadFramebufferFunctions())
+            return false;
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenRenderbuffers(1, &renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLint previousFramebuffer = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
+
+        const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+
+        if (! complete)
+        {
+            clear();
+            return false;
+        }
+
+        width = w;
+        height = h;
+        return true;
+    }
+
+    void clear()
+    {
+        if (framebuffer != 0)
+        {
+            glDeleteFramebuffers(1, &framebuffer);
+            framebuffer = 0;
+        }
+
+        if (renderbuffer != 0)
+        {
+            glDeleteRenderbuffers(1, &renderbuffer);
+            renderbuffer = 0;
+        }
+
+        if (texture != 0)
+        {
+            glDeleteTextures(1, &texture);
+            texture = 0;
+        }
+
+        width = height = 0;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(Cache)
+};
+
+bool SubWidget::PrivateData::displayCached(const uint width, const uint height, const double autoScaleFactor,
+                                           const Rectangle<int>*)
+{
+    // cache area in pixels, GL origin is bottom-left
+    const int w = static_cast<int>(std::round(self->getWidth() * autoScaleFactor));
+    const int h = static_cast<int>(std::round(self->getHeight() * autoScaleFactor));
+    const int x = static_cast<int>(std::round(absolutePos.getX() * autoScaleFactor));
+    const int y = static_cast<int>(height) - static_cast<int>(std::round(absolutePos.getY() * autoScaleFactor)) - h;
+
+    if (w <= 0 || h <= 0)
+        return true;
+
+    if (cache == nullptr)
+        cache = new Cache;
+
+    if (cache->width != w || cache->height != h)
+    {
+        if (! cache->resize(w, h))
+        {
+            d_stderr2("Failed to create framebuffer for subwidget cache, drawing it uncached");
+            destroyCache();
+            cached = false;
+            return false;
+        }
+
+        cacheNeedsUpdate = true;
+    }
+
+    if (cacheNeedsUpdate)
+    {
+        GLint previousFramebuffer = 0, previousScissorBox[4];
+        GLfloat previousClearColor[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_SCISSOR_BOX, previousScissorBox);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor);
+
+        const bool previousScissorTest = glIsEnabled(GL_SCISSOR_TEST);
+        const int previousOffsetX = gFramebufferOffsetX;
+        const int previousOffsetY = gFramebufferOffsetY;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, cache->framebuffer);
+        gFramebufferOffsetX = x;
+        gFramebufferOffsetY = y;
+
+        glDisable(GL_SCISSOR_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+        // keep alpha usable for compositing, colors end up premultiplied
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+        // draw everything as usual, but into the cache
+        cached = false;
+        display(width, height, autoScaleFactor, nullptr);
+        cached = true;
+        cacheNeedsUpdate = false;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+        gFramebufferOffsetX = previousOffsetX;
+        gFramebufferOffsetY = previousOffsetY;
+
+        glClearColor(previousClearColor[0], previousClearColor[1], previousClearColor[2], previousClearColor[3]);
+        glScissor(previousScissorBox[0], previousScissorBox[1], previousScissorBox[2], previousScissorBox[3]);
+
+        if (previousScissorTest)
+            glEnable(GL_SCISSOR_TEST);
+        else
+            glDisable(GL_SCISSOR_TEST);
+    }
+
+    // draw cache over the widget area, the projection covers the full window
+    glViewport(x - gFramebufferOffsetX, y - gFramebufferOffsetY, w, h);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    gGeometryBatch.setColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, cache->texture);
+
+    glBegin(GL_QUADS);
+
+    {
+        glTexCoord2f(0.0f, 1.0f);
+        glVertex2d(0.0, 0.0);
+
+        glTexCoord2f(1.0f, 1.0f);
+        glVertex2d(width, 0.0);
+
+        glTexCoord2f(1.0f, 0.0f);
+        glVertex2d(width, height);
+
+        glTexCoord2f(0.0f, 0.0f);
+        glVertex2d(0.0, height);
+    }
+
+    glEnd();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    return true;
+}
+
+void SubWidget::PrivateData::destroyCache()
+{
+    delete cache;
+    cache = nullptr;
+}
+
+// -----------------------------------------------------------------------
+
+// scissor box for an area in widget coordinates, rounding outwards, matching Window::PrivateData::onPuglExpose
+static void getScissorBox(const Rectangle<int>& area, const uint height, const double autoScaleFactor, int box[4])
+{
+    const int x = static_cast<int>(std::floor(area.getX() * autoScaleFactor));
+    const int y = static_cast<int>(std::floor(area.getY() * autoScaleFactor));
+    const int r = static_cast<int>(std::ceil((area.getX() + area.getWidth()) * autoScaleFactor));
+    const int b = static_cast<int>(std::ceil((area.getY() + area.getHeight()) * autoScaleFactor));
+
+    // GL origin is bottom-left
+    box[0] = x;
+    box[1] = static_cast<int>(height) - b;
+    box[2] = r - x;
+    box[3] = b - y;
+}
+
+void SubWidget::PrivateData::display(const uint width, const uint height, const double autoScaleFactor,
+                                     const Rectangle<int>* const damage)
 {
     if (skipDrawing)
         return;
 
+    if (cached && displayCached(width, height, autoScaleFactor, damage))
+        return;
+
     bool needsDisableScissor = false;
 
     if (needsViewportScaling)
@@ -584,57 +1427,84 @@ void SubWidget::PrivateData::display(const uint width, const uint height, const
 
         if (viewportScaleFactor != 0.0 && viewportScaleFactor != 1.0)
         {
-            glViewport(x,
-                       -static_cast<int>(height * viewportScaleFactor - height + absolutePos.getY() + 0.5),
+            glViewport(x - gFramebufferOffsetX,
+                       -static_cast<int>(height * viewportScaleFactor - height + absolutePos.getY() + 0.5)
+                       - gFramebufferOffsetY,
                        static_cast<int>(width * viewportScaleFactor + 0.5),
                        static_cast<int>(height * viewportScaleFactor + 0.5));
         }
         else
         {
             const int y = static_cast<int>(height - self->getHeight()) - absolutePos.getY();
-            glViewport(x, y, w, h);
+            glViewport(x - gFramebufferOffsetX, y - gFramebufferOffsetY, w, h);
         }
     }
     else if (needsFullViewportForDrawing || (absolutePos.isZero() && self->getSize() == Size<uint>(width, height)))
     {
         // full viewport size
-        glViewport(0,
-                   -static_cast<int>(height * autoScaleFactor - height + 0.5),
+        glViewport(-gFramebufferOffsetX,
+                   -static_cast<int>(height * autoScaleFactor - height + 0.5) - gFramebufferOffsetY,
                    static_cast<int>(width * autoScaleFactor + 0.5),
                    static_cast<int>(height * autoScaleFactor + 0.5));
     }
     else
     {
         // set viewport pos
-        glViewport(static_cast<int>(absolutePos.getX() * autoScaleFactor + 0.5),
+        glViewport(static_cast<int>(absolutePos.getX() * autoScaleFactor + 0.5) - gFramebufferOffsetX,
                    -static_cast<int>(std::round((height * autoScaleFactor - height)
-                                     + (absolutePos.getY() * autoScaleFactor))),
+                                     + (absolutePos.getY() * autoScaleFactor))) - gFramebufferOffsetY,
                    static_cast<int>(std::round(width * autoScaleFactor)),
                    static_cast<int>(std::round(height * autoScaleFactor)));
 
         // then cut the outer bounds
-        glScissor(static_cast<int>(absolutePos.getX() * autoScaleFactor + 0.5),
-                  static_cast<int>(height - std::round((static_cast<int>(self->getHeight()) + absolutePos.getY())
-                                                       * autoScaleFactor)),
-                  static_cast<int>(std::round(self->getWidth() * autoScaleFactor)),
-                  static_cast<int>(std::round(self->getHeight() * autoScaleFactor)));
+        int x = static_cast<int>(absolutePos.getX() * autoScaleFactor + 0.5);
+        int y = static_cast<int>(height - std::round((static_cast<int>(self->getHeight()) + absolutePos.getY())
+                                                     * autoScaleFactor));
+        int r = x + static_cast<int>(std::round(self->getWidth() * autoScaleFactor));
+        int t = y + static_cast<int>(std::round(self->getHeight() * autoScaleFactor));
+
+        // and anything outside the area being redrawn
+        if (damage != nullptr)
+        {
+            int box[4];
+            getScissorBox(*damage, height, autoScaleFactor, box);
 
+            x = std::max(x, box[0]);
+            y = std::max(y, box[1]);
+            r = std::min(r, box[0] + box[2]);
+            t = std::min(t, box[1] + box[3]);
+        }
+
+        glScissor(x - gFramebufferOffsetX, y - gFramebufferOffsetY, std::max(0, r - x), std::max(0, t - y));
         glEnable(GL_SCISSOR_TEST);
         needsDisableScissor = true;
     }
 
     // display widget
     self->onDisplay();
+    gGeometryBatch.flush();
 
     if (needsDisableScissor)
-        glDisable(GL_SCISSOR_TEST);
+    {
+        if (damage != nullptr)
+        {
+            // go back to the scissor set up for the area being redrawn
+            int box[4];
+            getScissorBox(*damage, height, autoScaleFactor, box);
+            glScissor(box[0], box[1], box[2], box[3]);
+        }
+        else
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
+    }
 
-    selfw->pData->displaySubWidgets(width, height, autoScaleFactor);
+    selfw->pData->displaySubWidgets(width, height, autoScaleFactor, damage);
 }
 
 // -----------------------------------------------------------------------
 
-void TopLevelWidget::PrivateData::display()
+void TopLevelWidget::PrivateData::display(const Rectangle<int>* const damage)
 {
     if (! selfw->pData->visible)
         return;
@@ -658,11 +1528,17 @@ void TopLevelWidget::PrivateData::display()
         glViewport(0, 0, static_cast<int>(width), static_cast<int>(height));
     }
 
+    gGeometryBatch.syncState();
+    gGeometryBatch.enabled = window.pData->geometryBatching;
+
     // main widget drawing
     self->onDisplay();
+    gGeometryBatch.flush();
 
     // now draw subwidgets if there are any
-    selfw->pData->displaySubWidgets(width, height, autoScaleFactor);
+    selfw->pData->displaySubWidgets(width, height, autoScaleFactor, damage);
+
+    gGeometryBatch.enabled = false;
 }
 
 // -----------------------------------------------------------------------
@@ -5,7 +5,8 @@
 
 namespace dpf_resources
 {
-    extern const char* dejavusans_ttf;
+    extern const char* dejavusans_ttf_compressed;
+    const unsigned int dejavusans_ttf_compressed_size = 469773;
     const unsigned int dejavusans_ttf_size = 741536;
 };
 
@@ -122,6 +122,9 @@ Widget* SubWidget::getParentWidget() const noexcept
 
 void SubWidget::repaint() noexcept
 {
+    // contents have changed, so has the cache of this widget and its parents
+    pData->invalidateCache();
+
     if (! isVisible())
         return;
 
@@ -158,6 +161,23 @@ void SubWidget::setSkipDrawing(const bool skipDrawing)
     pData->skipDrawing = skipDrawing;
 }
 
+bool SubWidget::isCached() const noexcept
+{
+    return pData->cached;
+}
+
+void SubWidget::setCached(const bool cached)
+{
+    if (pData->cached == cached)
+        return;
+
+    pData->cached = cached;
+    pData->cacheNeedsUpdate = true;
+
+    if (! cached)
+        pData->destroyCache();
+}
+
 void SubWidget::onPositionChanged(const PositionChangedEvent&)
 {
 }
@@ -30,7 +30,10 @@ SubWidget::PrivateData::PrivateData(SubWidget* const s, Widget* const pw)
       needsFullViewportForDrawing(false),
       needsViewportScaling(false),
       skipDrawing(false),
-      viewportScaleFactor(0.0)
+      viewportScaleFactor(0.0),
+      cached(false),
+      cacheNeedsUpdate(false),
+      cache(nullptr)
 {
     parentWidget->pData->subWidgets.push_back(self);
 }
@@ -38,6 +41,13 @@ SubWidget::PrivateData::PrivateData(SubWidget* const s, Widget* const pw)
 SubWidget::PrivateData::~PrivateData()
 {
     parentWidget->pData->subWidgets.remove(self);
+    destroyCache();
+}
+
+void SubWidget::PrivateData::invalidateCache() noexcept
+{
+    for (SubWidget* w = self; w != nullptr; w = dynamic_cast<SubWidget*>(w->pData->parentWidget))
+        w->pData->cacheNeedsUpdate = true;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -33,12 +33,27 @@ struct SubWidget::PrivateData {
     bool needsViewportScaling; // needed for NanoVG
     bool skipDrawing; // for context reuse in NanoVG based guis
     double viewportScaleFactor; // auto-scaling for NanoVG
+    bool cached; // draw from offscreen cache, see SubWidget::setCached
+    bool cacheNeedsUpdate;
+
+    // NOTE cache contents are different depending on build type
+    struct Cache;
+    Cache* cache;
 
     explicit PrivateData(SubWidget* const s, Widget* const pw);
     ~PrivateData();
 
     // NOTE display function is different depending on build type, must call displaySubWidgets at the end
-    void display(uint width, uint height, double autoScaleFactor);
+    // drawing must be limited to damage if not null, see TopLevelWidget::PrivateData::display
+    void display(uint width, uint height, double autoScaleFactor, const Rectangle<int>* damage);
+
+    // NOTE cache functions are different depending on build type
+    // displayCached returns false if a cache could not be used, in which case regular drawing is needed
+    bool displayCached(uint width, uint height, double autoScaleFactor, const Rectangle<int>* damage);
+    void destroyCache();
+
+    // mark cache of this widget and of all its parents as outdated
+    void invalidateCache() noexcept;
 
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PrivateData)
 };
@@ -32,7 +32,9 @@ struct TopLevelWidget::PrivateData {
 
     explicit PrivateData(TopLevelWidget* const s, Window& w);
     ~PrivateData();
-    void display();
+    // NOTE display function is different depending on build type
+    // damage is the area being redrawn in widget coordinates, or null for a full redraw
+    void display(const Rectangle<int>* damage);
     bool keyboardEvent(const KeyboardEvent& ev);
     bool specialEvent(const SpecialEvent& ev);
     bool characterInputEvent(const CharacterInputEvent& ev);
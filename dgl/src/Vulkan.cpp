@@ -200,16 +200,33 @@ VulkanImage& VulkanImage::operator=(const VulkanImage& image) noexcept
 
 // -----------------------------------------------------------------------
 
-void SubWidget::PrivateData::display(const uint width, const uint height, const double autoScaleFactor)
+struct SubWidget::PrivateData::Cache {};
+
+bool SubWidget::PrivateData::displayCached(uint, uint, double, const Rectangle<int>*)
+{
+    // TODO
+    return false;
+}
+
+void SubWidget::PrivateData::destroyCache()
+{
+    delete cache;
+    cache = nullptr;
+}
+
+// -----------------------------------------------------------------------
+
+void SubWidget::PrivateData::display(const uint width, const uint height, const double autoScaleFactor,
+                                     const Rectangle<int>* const damage)
 {
     // TODO
 
-    selfw->pData->displaySubWidgets(width, height, autoScaleFactor);
+    selfw->pData->displaySubWidgets(width, height, autoScaleFactor, damage);
 }
 
 // -----------------------------------------------------------------------
 
-void TopLevelWidget::PrivateData::display()
+void TopLevelWidget::PrivateData::display(const Rectangle<int>* const damage)
 {
     if (! selfw->pData->visible)
         return;
@@ -226,7 +243,7 @@ void TopLevelWidget::PrivateData::display()
     self->onDisplay();
 
     // now draw subwidgets if there are any
-    selfw->pData->displaySubWidgets(width, height, autoScaleFactor);
+    selfw->pData->displaySubWidgets(width, height, autoScaleFactor, damage);
 }
 
 // -----------------------------------------------------------------------
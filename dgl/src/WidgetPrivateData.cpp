@@ -53,7 +53,8 @@ Widget::PrivateData::~PrivateData()
     subWidgets.clear();
 }
 
-void Widget::PrivateData::displaySubWidgets(const uint width, const uint height, const double autoScaleFactor)
+void Widget::PrivateData::displaySubWidgets(const uint width, const uint height, const double autoScaleFactor,
+                                            const Rectangle<int>* const damage)
 {
     if (subWidgets.size() == 0)
         return;
@@ -62,8 +63,20 @@ void Widget::PrivateData::displaySubWidgets(const uint width, const uint height,
     {
         SubWidget* const subwidget(*it);
 
-        if (subwidget->isVisible())
-            subwidget->pData->display(width, height, autoScaleFactor);
+        if (! subwidget->isVisible())
+            continue;
+
+        // skip drawing widgets outside of the area being redrawn, their own subwidgets might still be inside it
+        // (unless cached, as then subwidgets are limited to the widget bounds)
+        if (damage != nullptr && ! subwidget->pData->needsFullViewportForDrawing
+                              && ! damage->intersects(subwidget->getAbsoluteArea()))
+        {
+            if (! subwidget->pData->cached)
+                subwidget->pData->selfw->pData->displaySubWidgets(width, height, autoScaleFactor, damage);
+            continue;
+        }
+
+        subwidget->pData->display(width, height, autoScaleFactor, damage);
     }
 }
 
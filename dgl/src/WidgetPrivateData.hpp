@@ -41,7 +41,7 @@ struct Widget::PrivateData {
     explicit PrivateData(Widget* const s, Widget* const pw);
     ~PrivateData();
 
-    void displaySubWidgets(uint width, uint height, double autoScaleFactor);
+    void displaySubWidgets(uint width, uint height, double autoScaleFactor, const Rectangle<int>* damage);
 
     bool giveKeyboardEventForSubWidgets(const KeyboardEvent& ev);
     bool giveSpecialEventForSubWidgets(const SpecialEvent& ev);
@@ -242,6 +242,47 @@ void Window::setIgnoringKeyRepeat(const bool ignore) noexcept
     puglSetViewHint(pData->view, PUGL_IGNORE_KEY_REPEAT, ignore);
 }
 
+bool Window::isPartialRepaintEnabled() const noexcept
+{
+    return pData->partialRepaint;
+}
+
+void Window::setPartialRepaintEnabled(const bool enabled) noexcept
+{
+    pData->partialRepaint = enabled;
+}
+
+bool Window::isGeometryBatchingEnabled() const noexcept
+{
+    return pData->geometryBatching;
+}
+
+void Window::setGeometryBatchingEnabled(const bool enabled) noexcept
+{
+    pData->geometryBatching = enabled;
+}
+
+uint Window::getMaxFrameRate() const noexcept
+{
+    return pData->maxFrameRate;
+}
+
+void Window::setMaxFrameRate(const uint fps) noexcept
+{
+    pData->maxFrameRate = fps;
+
+    // restart the frame timer with the new interval, if needed
+    if (pData->frameTimerRunning)
+        pData->stopFrameTimer();
+
+    pData->sendPendingRedisplay();
+}
+
+double Window::getLastFrameTime() const noexcept
+{
+    return pData->lastFrameTime;
+}
+
 bool Window::addIdleCallback(IdleCallback* const callback, const uint timerFrequencyInMs)
 {
     DISTRHO_SAFE_ASSERT_RETURN(callback != nullptr, false)
@@ -292,10 +333,7 @@ bool Window::openFileBrowser(const FileBrowserOptions& options)
 
 void Window::repaint() noexcept
 {
-    if (pData->view == nullptr)
-        return;
-
-    puglPostRedisplay(pData->view);
+    pData->postRedisplay(nullptr);
 }
 
 void Window::repaint(const Rectangle<uint>& rect) noexcept
@@ -318,7 +356,16 @@ void Window::repaint(const Rectangle<uint>& rect) noexcept
         prect.width *= autoScaleFactor;
         prect.height *= autoScaleFactor;
     }
-    puglPostRedisplayRect(pData->view, prect);
+
+    // the system never exposes areas outside the window, so those would never be drawn
+    const PuglRect frame = puglGetFrame(pData->view);
+    prect.width = std::min(prect.x + prect.width, frame.width) - prect.x;
+    prect.height = std::min(prect.y + prect.height, frame.height) - prect.y;
+
+    if (prect.width <= 0.0 || prect.height <= 0.0)
+        return;
+
+    pData->postRedisplay(&prect);
 }
 
 void Window::runAsModal(bool blockWait)
@@ -16,10 +16,12 @@
 
 #include "WindowPrivateData.hpp"
 #include "TopLevelWidgetPrivateData.hpp"
+#include "AsyncImageLoader.hpp"
 
 #include "pugl.hpp"
 
 #include "../../distrho/extra/String.hpp"
+#include "../../distrho/extra/Time.hpp"
 
 #ifdef DISTRHO_OS_WINDOWS
 # include <direct.h>
@@ -64,6 +66,9 @@ START_NAMESPACE_DGL
 static const char* const kWin32SelectedFileCancelled = "__dpf_cancelled__";
 #endif
 
+// time after which a repaint sent to pugl but never drawn is considered lost, in nanoseconds
+static const uint64_t kFrameRequestTimeout = 1000000000ULL;
+
 static double getDesktopScaleFactor(const PuglView* const view)
 {
     // allow custom scale for testing
@@ -91,6 +96,24 @@ Window::PrivateData::PrivateData(Application& a, Window* const s)
       scaleFactor(getDesktopScaleFactor(view)),
       autoScaling(false),
       autoScaleFactor(1.0),
+#ifdef DGL_CAIRO
+      partialRepaint(true),
+#else
+      partialRepaint(false),
+#endif
+      exposeArea(),
+      geometryBatching(false),
+      asyncImageJobsFinished(getAsyncImageJobsFinishedCount()),
+      maxFrameRate(0),
+      lastFrameStart(0),
+      lastFrameTime(0.0),
+      isMapped(true),
+      pendingRedisplay(false),
+      pendingRedisplayFull(false),
+      pendingRedisplayArea(),
+      frameRequested(false),
+      frameRequestTime(0),
+      frameTimerRunning(false),
       minWidth(0),
       minHeight(0),
       keepAspectRatio(false),
@@ -115,6 +138,24 @@ Window::PrivateData::PrivateData(Application& a, Window* const s, PrivateData* c
       scaleFactor(ppData->scaleFactor),
       autoScaling(false),
       autoScaleFactor(1.0),
+#ifdef DGL_CAIRO
+      partialRepaint(true),
+#else
+      partialRepaint(false),
+#endif
+      exposeArea(),
+      geometryBatching(false),
+      asyncImageJobsFinished(getAsyncImageJobsFinishedCount()),
+      maxFrameRate(0),
+      lastFrameStart(0),
+      lastFrameTime(0.0),
+      isMapped(true),
+      pendingRedisplay(false),
+      pendingRedisplayFull(false),
+      pendingRedisplayArea(),
+      frameRequested(false),
+      frameRequestTime(0),
+      frameTimerRunning(false),
       minWidth(0),
       minHeight(0),
       keepAspectRatio(false),
@@ -144,6 +185,24 @@ Window::PrivateData::PrivateData(Application& a, Window* const s,
       scaleFactor(scale != 0.0 ? scale : getDesktopScaleFactor(view)),
       autoScaling(false),
       autoScaleFactor(1.0),
+#ifdef DGL_CAIRO
+      partialRepaint(true),
+#else
+      partialRepaint(false),
+#endif
+      exposeArea(),
+      geometryBatching(false),
+      asyncImageJobsFinished(getAsyncImageJobsFinishedCount()),
+      maxFrameRate(0),
+      lastFrameStart(0),
+      lastFrameTime(0.0),
+      isMapped(true),
+      pendingRedisplay(false),
+      pendingRedisplayFull(false),
+      pendingRedisplayArea(),
+      frameRequested(false),
+      frameRequestTime(0),
+      frameTimerRunning(false),
       minWidth(0),
       minHeight(0),
       keepAspectRatio(false),
@@ -174,6 +233,24 @@ Window::PrivateData::PrivateData(Application& a, Window* const s,
       scaleFactor(scale != 0.0 ? scale : getDesktopScaleFactor(view)),
       autoScaling(false),
       autoScaleFactor(1.0),
+#ifdef DGL_CAIRO
+      partialRepaint(true),
+#else
+      partialRepaint(false),
+#endif
+      exposeArea(),
+      geometryBatching(false),
+      asyncImageJobsFinished(getAsyncImageJobsFinishedCount()),
+      maxFrameRate(0),
+      lastFrameStart(0),
+      lastFrameTime(0.0),
+      isMapped(true),
+      pendingRedisplay(false),
+      pendingRedisplayFull(false),
+      pendingRedisplayArea(),
+      frameRequested(false),
+      frameRequestTime(0),
+      frameTimerRunning(false),
       minWidth(0),
       minHeight(0),
       keepAspectRatio(false),
@@ -333,6 +410,7 @@ void Window::PrivateData::show()
     }
 
     isVisible = true;
+    frameRequested = false;
 }
 
 void Window::PrivateData::hide()
@@ -359,6 +437,10 @@ void Window::PrivateData::hide()
     puglHide(view);
 
     isVisible = false;
+    frameRequested = false;
+
+    if (frameTimerRunning)
+        stopFrameTimer();
 }
 
 // -----------------------------------------------------------------------
@@ -396,6 +478,25 @@ void Window::PrivateData::setResizable(const bool resizable)
 
 void Window::PrivateData::idleCallback()
 {
+    // images loaded in the background get their textures on the next frame
+    const uint asyncImageJobsFinishedNow = getAsyncImageJobsFinishedCount();
+
+    if (asyncImageJobsFinished != asyncImageJobsFinishedNow)
+    {
+        asyncImageJobsFinished = asyncImageJobsFinishedNow;
+        postRedisplay(nullptr);
+    }
+
+    // the system may drop a requested frame, for instance while the window is occluded, ask again after a while
+    if (frameRequested && d_gettime_ns() - frameRequestTime >= kFrameRequestTimeout)
+        frameRequested = false;
+
+    // send repaints held back by frame pacing, this is also called from the frame timer
+    sendPendingRedisplay();
+
+    if (frameTimerRunning && (! pendingRedisplay || frameRequested))
+        stopFrameTimer();
+
 #ifndef DGL_FILE_BROWSER_DISABLED
 # ifdef DISTRHO_OS_WINDOWS
     if (const char* path = win32SelectedFile)
@@ -414,6 +515,97 @@ void Window::PrivateData::idleCallback()
 #endif
 }
 
+// -----------------------------------------------------------------------
+// repaint handling
+
+void Window::PrivateData::postRedisplay(const PuglRect* const rect)
+{
+    if (view == nullptr)
+        return;
+
+    // merge with previous requests not sent yet
+    if (rect == nullptr)
+    {
+        pendingRedisplayFull = true;
+    }
+    else if (! pendingRedisplay)
+    {
+        pendingRedisplayArea = *rect;
+    }
+    else if (! pendingRedisplayFull)
+    {
+        const double x = std::min(pendingRedisplayArea.x, rect->x);
+        const double y = std::min(pendingRedisplayArea.y, rect->y);
+        const double r = std::max(pendingRedisplayArea.x + pendingRedisplayArea.width, rect->x + rect->width);
+        const double b = std::max(pendingRedisplayArea.y + pendingRedisplayArea.height, rect->y + rect->height);
+        pendingRedisplayArea.x = x;
+        pendingRedisplayArea.y = y;
+        pendingRedisplayArea.width = r - x;
+        pendingRedisplayArea.height = b - y;
+    }
+
+    pendingRedisplay = true;
+
+    sendPendingRedisplay();
+}
+
+void Window::PrivateData::sendPendingRedisplay()
+{
+    if (! pendingRedisplay)
+        return;
+
+    // nothing to draw while hidden or minimized, the system asks for a full redraw once shown again
+    if (! isVisible || ! isMapped)
+        return;
+
+    // a frame is on its way already, anything requested meanwhile is sent once it was drawn
+    if (frameRequested)
+        return;
+
+    if (isFrameDue())
+        return flushRedisplay();
+
+    // too soon, sent later from a timer running at the frame rate (which calls idleCallback)
+    if (! frameTimerRunning)
+        frameTimerRunning = puglStartTimer(view, (uintptr_t)static_cast<IdleCallback*>(this),
+                                           1.0 / maxFrameRate) == PUGL_SUCCESS;
+}
+
+void Window::PrivateData::flushRedisplay()
+{
+    if (! pendingRedisplay)
+        return;
+
+    const bool posted = pendingRedisplayFull
+                      ? puglPostRedisplay(view) == PUGL_SUCCESS
+                      : pendingRedisplayArea.width > 0.0 && pendingRedisplayArea.height > 0.0
+                        && puglPostRedisplayRect(view, pendingRedisplayArea) == PUGL_SUCCESS;
+
+    pendingRedisplay = false;
+    pendingRedisplayFull = false;
+
+    // only wait for frames that will actually arrive, the system does not expose empty areas
+    if (posted)
+    {
+        frameRequested = true;
+        frameRequestTime = d_gettime_ns();
+    }
+}
+
+bool Window::PrivateData::isFrameDue() const noexcept
+{
+    if (maxFrameRate == 0)
+        return true;
+
+    return d_gettime_ns() - lastFrameStart >= 1000000000ULL / maxFrameRate;
+}
+
+void Window::PrivateData::stopFrameTimer()
+{
+    puglStopTimer(view, (uintptr_t)static_cast<IdleCallback*>(this));
+    frameTimerRunning = false;
+}
+
 // -----------------------------------------------------------------------
 // idle callback stuff
 
@@ -685,21 +877,76 @@ void Window::PrivateData::onPuglConfigure(const double width, const double heigh
     puglPostRedisplay(view);
 }
 
-void Window::PrivateData::onPuglExpose()
+void Window::PrivateData::onPuglExpose(const Rectangle<int>& area)
 {
-    DGL_DBGp("PUGL: onPuglExpose\n");
+    DGL_DBGp("PUGL: onPuglExpose : %i %i %i %i\n", area.getX(), area.getY(), area.getWidth(), area.getHeight());
+
+    const uint64_t frameStart = d_gettime_ns();
+    lastFrameStart = frameStart;
+    frameRequested = false;
+
+    // a full window expose does not need any clipping
+    const Size<uint> size(self->getSize());
+    const bool fullExpose = area.getX() <= 0 && area.getY() <= 0 &&
+                            area.getX() + area.getWidth() >= static_cast<int>(size.getWidth()) &&
+                            area.getY() + area.getHeight() >= static_cast<int>(size.getHeight());
+    const bool partial = partialRepaint && ! fullExpose;
 
-    puglOnDisplayPrepare(view);
+    // held back repaints are covered by this frame
+    if (fullExpose)
+    {
+        pendingRedisplay = false;
+        pendingRedisplayFull = false;
+    }
+    else if (pendingRedisplay && ! pendingRedisplayFull
+             && pendingRedisplayArea.x >= area.getX()
+             && pendingRedisplayArea.y >= area.getY()
+             && pendingRedisplayArea.x + pendingRedisplayArea.width <= area.getX() + area.getWidth()
+             && pendingRedisplayArea.y + pendingRedisplayArea.height <= area.getY() + area.getHeight())
+    {
+        pendingRedisplay = false;
+    }
+
+    if (partial)
+    {
+        // widgets work in unscaled coordinates, round outwards
+        const int x = static_cast<int>(std::floor(area.getX() / autoScaleFactor));
+        const int y = static_cast<int>(std::floor(area.getY() / autoScaleFactor));
+        const int r = static_cast<int>(std::ceil((area.getX() + area.getWidth()) / autoScaleFactor));
+        const int b = static_cast<int>(std::ceil((area.getY() + area.getHeight()) / autoScaleFactor));
+        exposeArea = Rectangle<int>(x, y, r - x, b - y);
+
+        // and back to pixels, so that clipping matches what subwidgets use
+        const int px = static_cast<int>(std::floor(x * autoScaleFactor));
+        const int py = static_cast<int>(std::floor(y * autoScaleFactor));
+        const int pr = static_cast<int>(std::ceil(r * autoScaleFactor));
+        const int pb = static_cast<int>(std::ceil(b * autoScaleFactor));
+        puglOnDisplayPrepareArea(view, px, py, pr - px, pb - py);
+    }
+    else
+    {
+        puglOnDisplayPrepare(view);
+    }
 
 #ifndef DPF_TEST_WINDOW_CPP
+    const Rectangle<int>* const damage = partial ? &exposeArea : nullptr;
+
     FOR_EACH_TOP_LEVEL_WIDGET(it)
     {
         TopLevelWidget* const widget(*it);
 
         if (widget->isVisible())
-            widget->pData->display();
+            widget->pData->display(damage);
     }
 #endif
+
+    if (partial)
+        puglOnDisplayFinishArea(view);
+
+    lastFrameTime = static_cast<double>(d_gettime_ns() - frameStart) / 1000000.0;
+
+    // repaints requested while this frame was on its way or being drawn
+    sendPendingRedisplay();
 }
 
 void Window::PrivateData::onPuglClose()
@@ -890,10 +1137,14 @@ PuglStatus Window::PrivateData::puglEventCallback(PuglView* const view, const Pu
 
     ///< View made visible, a #PuglEventMap
     case PUGL_MAP:
+        pData->isMapped = true;
+        pData->frameRequested = false;
         break;
 
     ///< View made invisible, a #PuglEventUnmap
     case PUGL_UNMAP:
+        pData->isMapped = false;
+        pData->frameRequested = false;
         break;
 
     ///< View ready to draw, a #PuglEventUpdate
@@ -902,9 +1153,15 @@ PuglStatus Window::PrivateData::puglEventCallback(PuglView* const view, const Pu
 
     ///< View must be drawn, a #PuglEventExpose
     case PUGL_EXPOSE:
-        // unused x, y, width, height (double)
-        pData->onPuglExpose();
+    {
+        // round outwards to whole pixels
+        const int x = static_cast<int>(std::floor(event->expose.x));
+        const int y = static_cast<int>(std::floor(event->expose.y));
+        const int r = static_cast<int>(std::ceil(event->expose.x + event->expose.width));
+        const int b = static_cast<int>(std::ceil(event->expose.y + event->expose.height));
+        pData->onPuglExpose(Rectangle<int>(x, y, r - x, b - y));
         break;
+    }
 
     ///< View will be closed, a #PuglEventClose
     case PUGL_CLOSE:
@@ -70,6 +70,39 @@ struct Window::PrivateData : IdleCallback {
     bool autoScaling;
     double autoScaleFactor;
 
+    /** Whether to only redraw the area exposed by the system, see Window::setPartialRepaintEnabled. */
+    bool partialRepaint;
+
+    /** Area being redrawn in the current expose event, in unscaled widget coordinates.
+        Only valid during drawing and when partialRepaint is enabled. */
+    Rectangle<int> exposeArea;
+
+    /** Whether to batch geometry drawing, see Window::setGeometryBatchingEnabled. */
+    bool geometryBatching;
+
+    /** Amount of background image loads finished as of the last idle, used to repaint when new images are ready. */
+    uint asyncImageJobsFinished;
+
+    /** Frame pacing, see Window::setMaxFrameRate. */
+    uint maxFrameRate;
+    uint64_t lastFrameStart; // in nanoseconds
+    double lastFrameTime;    // in milliseconds
+
+    /** Whether the view is mapped, that is not minimized. Unlike isVisible this is only known through pugl events. */
+    bool isMapped;
+
+    /** Repaint requests not sent to pugl yet, merged together until the next frame. */
+    bool pendingRedisplay;
+    bool pendingRedisplayFull;
+    PuglRect pendingRedisplayArea;
+
+    /** Whether a repaint was sent to pugl but not drawn yet, new requests are held back until then. */
+    bool frameRequested;
+    uint64_t frameRequestTime; // in nanoseconds
+
+    /** Whether the pugl timer sending repaints held back by frame pacing is running. */
+    bool frameTimerRunning;
+
     /** Pugl geometry constraints access. */
     uint minWidth, minHeight;
     bool keepAspectRatio;
@@ -146,6 +179,13 @@ struct Window::PrivateData : IdleCallback {
 
     const GraphicsContext& getGraphicsContext() const noexcept;
 
+    // repaint handling, with frame pacing
+    void postRedisplay(const PuglRect* rect);
+    void sendPendingRedisplay();
+    void flushRedisplay();
+    bool isFrameDue() const noexcept;
+    void stopFrameTimer();
+
     // idle callback stuff
     void idleCallback() override;
     bool addIdleCallback(IdleCallback* callback, uint timerFrequencyInMs);
@@ -166,7 +206,7 @@ struct Window::PrivateData : IdleCallback {
 
     // pugl events
     void onPuglConfigure(double width, double height);
-    void onPuglExpose();
+    void onPuglExpose(const Rectangle<int>& area);
     void onPuglClose();
     void onPuglFocus(bool focus, CrossingMode mode);
     void onPuglKey(const Widget::KeyboardEvent& ev);
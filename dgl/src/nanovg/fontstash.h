@@ -386,6 +386,32 @@ static unsigned int fons__hashint(unsigned int a)
 	return a;
 }
 
+#ifdef FONS_SHARED_GLYPH_CACHE
+// Rasterized glyphs can be shared between all font stashes, by defining FONS_SHARED_GLYPH_CACHE and
+// implementing these before including the fontstash implementation.
+// Fonts are identified by a hash of their data, glyph bitmaps include padding and blur.
+static void fons__sharedGlyphCacheRef(void);
+static void fons__sharedGlyphCacheUnref(void);
+static int fons__sharedGlyphCacheGet(unsigned long long dataHash, int dataSize, int fontIndex,
+									 int glyph, short isize, short iblur,
+									 unsigned char* dst, int dstStride, int w, int h);
+static void fons__sharedGlyphCachePut(unsigned long long dataHash, int dataSize, int fontIndex,
+									  int glyph, short isize, short iblur,
+									  const unsigned char* src, int srcStride, int w, int h);
+
+// FNV-1a
+static unsigned long long fons__hashData(const unsigned char* data, int dataSize)
+{
+	unsigned long long h = 14695981039346656037ULL;
+	int i;
+	for (i = 0; i < dataSize; ++i) {
+		h ^= data[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+#endif
+
 static int fons__mini(int a, int b)
 {
 	return a < b ? a : b;
@@ -414,6 +440,10 @@ struct FONSfont
 	unsigned char* data;
 	int dataSize;
 	unsigned char freeData;
+	int fontIndex;
+#ifdef FONS_SHARED_GLYPH_CACHE
+	unsigned long long dataHash;
+#endif
 	float ascender;
 	float descender;
 	float lineh;
@@ -755,6 +785,10 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 
 	stash->params = *params;
 
+#ifdef FONS_SHARED_GLYPH_CACHE
+	fons__sharedGlyphCacheRef();
+#endif
+
 	// Allocate scratch buffer.
 	stash->scratch = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
 	if (stash->scratch == NULL) goto error;
@@ -976,6 +1010,10 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	font->dataSize = dataSize;
 	font->data = data;
 	font->freeData = (unsigned char)freeData;
+	font->fontIndex = fontIndex;
+#ifdef FONS_SHARED_GLYPH_CACHE
+	font->dataHash = fons__hashData(data, dataSize);
+#endif
 
 	// Init font
 	stash->nscratch = 0;
@@ -1086,16 +1124,57 @@ static void fons__blur(FONScontext* stash, unsigned char* dst, int w, int h, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
+static void fons__renderGlyph(FONScontext* stash, FONSfont* renderFont, FONSglyph* glyph,
+							  int g, int pad, short iblur, float scale)
+{
+	int x, y;
+	int gw = glyph->x1 - glyph->x0;
+	int gh = glyph->y1 - glyph->y0;
+	unsigned char* bdst;
+	unsigned char* dst;
+
+	// Rasterize
+	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
+	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
+
+	// Make sure there is one pixel empty border.
+	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
+	for (y = 0; y < gh; y++) {
+		dst[y*stash->params.width] = 0;
+		dst[gw-1 + y*stash->params.width] = 0;
+	}
+	for (x = 0; x < gw; x++) {
+		dst[x] = 0;
+		dst[x + (gh-1)*stash->params.width] = 0;
+	}
+
+	// Debug code to color the glyph background
+/*	unsigned char* fdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
+	for (y = 0; y < gh; y++) {
+		for (x = 0; x < gw; x++) {
+			int a = (int)fdst[x+y*stash->params.width] + 20;
+			if (a > 255) a = 255;
+			fdst[x+y*stash->params.width] = a;
+		}
+	}*/
+
+	// Blur
+	if (iblur > 0) {
+		stash->nscratch = 0;
+		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
+		fons__blur(stash, bdst, gw, gh, stash->params.width, iblur);
+	}
+}
+
 static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
 								 short isize, short iblur, int bitmapOption)
 {
-	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
+	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy;
 	float scale;
 	FONSglyph* glyph = NULL;
 	unsigned int h;
 	float size = isize/10.0f;
 	int pad, added;
-	unsigned char* bdst;
 	unsigned char* dst;
 	FONSfont* renderFont = font;
 
@@ -1183,37 +1262,18 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		return glyph;
 	}
 
-	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
-
-	// Make sure there is one pixel empty border.
+	// Rasterize, or copy from the shared cache
 	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		dst[y*stash->params.width] = 0;
-		dst[gw-1 + y*stash->params.width] = 0;
-	}
-	for (x = 0; x < gw; x++) {
-		dst[x] = 0;
-		dst[x + (gh-1)*stash->params.width] = 0;
-	}
-
-	// Debug code to color the glyph background
-/*	unsigned char* fdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		for (x = 0; x < gw; x++) {
-			int a = (int)fdst[x+y*stash->params.width] + 20;
-			if (a > 255) a = 255;
-			fdst[x+y*stash->params.width] = a;
-		}
-	}*/
-
-	// Blur
-	if (iblur > 0) {
-		stash->nscratch = 0;
-		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-		fons__blur(stash, bdst, gw, gh, stash->params.width, iblur);
+#ifdef FONS_SHARED_GLYPH_CACHE
+	if (!fons__sharedGlyphCacheGet(renderFont->dataHash, renderFont->dataSize, renderFont->fontIndex,
+								   g, isize, iblur, dst, stash->params.width, gw, gh)) {
+		fons__renderGlyph(stash, renderFont, glyph, g, pad, iblur, scale);
+		fons__sharedGlyphCachePut(renderFont->dataHash, renderFont->dataSize, renderFont->fontIndex,
+								  g, isize, iblur, dst, stash->params.width, gw, gh);
 	}
+#else
+	fons__renderGlyph(stash, renderFont, glyph, g, pad, iblur, scale);
+#endif
 
 	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
 	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
@@ -1682,6 +1742,10 @@ void fonsDeleteInternal(FONScontext* stash)
 	if (stash->scratch) free(stash->scratch);
 	free(stash);
 	fons__tt_done(stash);
+
+#ifdef FONS_SHARED_GLYPH_CACHE
+	fons__sharedGlyphCacheUnref();
+#endif
 }
 
 void fonsSetErrorCallback(FONScontext* stash, void (*callback)(void* uptr, int error, int val), void* uptr)
@@ -788,12 +788,23 @@ void nvgFillPaint(NVGcontext* ctx, NVGpaint paint)
 	nvgTransformMultiply(state->fill.xform, state->xform);
 }
 
+// DPF: stb_image options are global and read by background decoding threads, so only set them once.
+// DGL calls this with the async image loader locked when creating NanoVG instances and images,
+// before any image can be loaded, so the flag is never written concurrently.
+static void nvg__setupImageLoading(void)
+{
+	static int done = 0;
+	if (done) return;
+	stbi_set_unpremultiply_on_load(1);
+	stbi_convert_iphone_png_to_rgb(1);
+	done = 1;
+}
+
 int nvgCreateImage(NVGcontext* ctx, const char* filename, int imageFlags)
 {
 	int w, h, n, image;
 	unsigned char* img;
-	stbi_set_unpremultiply_on_load(1);
-	stbi_convert_iphone_png_to_rgb(1);
+	nvg__setupImageLoading();
 	img = stbi_load(filename, &w, &h, &n, 4);
 	if (img == NULL) {
 //		printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
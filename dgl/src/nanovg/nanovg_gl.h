@@ -1193,6 +1193,9 @@ static void glnvg__renderFlush(void* uptr)
 		glFrontFace(GL_CCW);
 		glEnable(GL_BLEND);
 		glDisable(GL_DEPTH_TEST);
+#ifdef NANOVG_GL_KEEP_SCISSOR_TEST
+		if (! (NANOVG_GL_KEEP_SCISSOR_TEST))
+#endif
 		glDisable(GL_SCISSOR_TEST);
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 		glStencilMask(0xffffffff);
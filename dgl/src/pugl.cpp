@@ -427,6 +427,69 @@ void puglOnDisplayPrepare(PuglView*)
 #endif
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+// DGL specific, set between puglOnDisplayPrepareArea and puglOnDisplayFinishArea
+
+static bool gDisplayAreaActive = false;
+
+bool puglOnDisplayIsAreaActive()
+{
+    return gDisplayAreaActive;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// DGL specific, build-specific drawing prepare limited to an area
+
+void puglOnDisplayPrepareArea(PuglView* const view, const int x, const int y, const int width, const int height)
+{
+#if defined(DGL_CAIRO)
+    cairo_t* const handle = static_cast<cairo_t*>(puglGetContext(view));
+    DISTRHO_SAFE_ASSERT_RETURN(handle != nullptr,);
+
+    cairo_save(handle);
+    cairo_rectangle(handle, x, y, width, height);
+    cairo_clip(handle);
+    gDisplayAreaActive = true;
+#elif defined(DGL_OPENGL)
+    // GL scissor box origin is bottom-left
+    glScissor(x, static_cast<int>(view->frame.height + 0.5) - y - height, width, height);
+    glEnable(GL_SCISSOR_TEST);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glLoadIdentity();
+    gDisplayAreaActive = true;
+#else
+    // unused
+    (void)view;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+#endif
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// DGL specific, build-specific drawing finish after puglOnDisplayPrepareArea
+
+void puglOnDisplayFinishArea(PuglView* const view)
+{
+#if defined(DGL_CAIRO)
+    cairo_t* const handle = static_cast<cairo_t*>(puglGetContext(view));
+    DISTRHO_SAFE_ASSERT_RETURN(handle != nullptr,);
+
+    cairo_restore(handle);
+    gDisplayAreaActive = false;
+#elif defined(DGL_OPENGL)
+    glDisable(GL_SCISSOR_TEST);
+    gDisplayAreaActive = false;
+
+    // unused
+    (void)view;
+#else
+    // unused
+    (void)view;
+#endif
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 // DGL specific, build-specific fallback resize
 
@@ -444,6 +507,24 @@ void puglFallbackOnResize(PuglView* const view)
 #endif
 }
 
+#ifdef DGL_OPENGL
+// --------------------------------------------------------------------------------------------------------------------
+// DGL specific, get the OpenGL context current in the calling thread
+
+void* puglGetCurrentOpenGLContext()
+{
+# if defined(DISTRHO_OS_HAIKU)
+    return nullptr;
+# elif defined(DISTRHO_OS_MAC)
+    return [NSOpenGLContext currentContext];
+# elif defined(DISTRHO_OS_WINDOWS)
+    return wglGetCurrentContext();
+# else
+    return glXGetCurrentContext();
+# endif
+}
+#endif
+
 #ifdef DISTRHO_OS_MAC
 // --------------------------------------------------------------------------------------------------------------------
 // macOS specific, allow standalone window to gain focus
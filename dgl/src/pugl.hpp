@@ -91,10 +91,28 @@ puglSetWindowSize(PuglView* view, unsigned int width, unsigned int height);
 PUGL_API void
 puglOnDisplayPrepare(PuglView* view);
 
+// DGL specific, build-specific drawing prepare limited to an area, must be followed by puglOnDisplayFinishArea
+PUGL_API void
+puglOnDisplayPrepareArea(PuglView* view, int x, int y, int width, int height);
+
+// DGL specific, build-specific drawing finish after puglOnDisplayPrepareArea
+PUGL_API void
+puglOnDisplayFinishArea(PuglView* view);
+
+// DGL specific, check if drawing is limited to an area, that is between puglOnDisplayPrepareArea and puglOnDisplayFinishArea
+PUGL_API bool
+puglOnDisplayIsAreaActive();
+
 // DGL specific, build-specific fallback resize
 PUGL_API void
 puglFallbackOnResize(PuglView* view);
 
+#ifdef DGL_OPENGL
+// DGL specific, get the OpenGL context current in the calling thread
+PUGL_API void*
+puglGetCurrentOpenGLContext();
+#endif
+
 #ifdef DISTRHO_OS_MAC
 // macOS specific, allow standalone window to gain focus
 PUGL_API void
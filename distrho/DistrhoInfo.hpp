@@ -516,11 +516,24 @@ START_NAMESPACE_DISTRHO
 #define DISTRHO_PLUGIN_WANT_DIRECT_ACCESS 0
 
 /**
-   Whether the plugin introduces latency during audio or midi processing.
+   Whether the plugin introduces latency during audio or midi processing.@n
+   This is automatically enabled if @ref DISTRHO_PLUGIN_FIXED_BLOCK_SIZE is used.
    @see Plugin::setLatency(uint32_t)
  */
 #define DISTRHO_PLUGIN_WANT_LATENCY 1
 
+/**
+   Run the plugin in blocks of this exact number of frames, regardless of what the host does.@n
+   Audio and MIDI are buffered and re-blocked before calling Plugin::run(), so that @a frames is always this value
+   and getBufferSize() never changes. Useful for FFT or partitioned convolution based plugins.@n
+   Re-blocking adds exactly this many frames of latency, which is reported to the host on top of Plugin::setLatency().
+   When the host guarantees its blocks are already a multiple of this size (LV2 fixedBlockLength, or powerOf2BlockLength
+   with a large enough minBlockLength), host buffers are sliced directly and no latency is added.@n
+   Parameter changes are applied at the start of the next internal block.@n
+   Default is 0, meaning the plugin runs with whatever block size the host uses.
+ */
+#define DISTRHO_PLUGIN_FIXED_BLOCK_SIZE 256
+
 /**
    Whether the plugin wants MIDI input.@n
    This is automatically enabled if @ref DISTRHO_PLUGIN_IS_SYNTH is true.
@@ -571,6 +584,16 @@ START_NAMESPACE_DISTRHO
  */
 #define DISTRHO_PLUGIN_WANT_TIMEPOS 1
 
+/**
+   Whether the plugin sends visualization data (waveforms, spectra, meters, etc) from the DSP to the %UI.@n
+   Frames written with Plugin::writeVisualFrame() are received by the %UI in UI::visualFrameReceived().@n
+   When the %UI runs in the same process as the DSP (JACK standalone, VST2) frames go through a lock-free ring buffer,
+   otherwise (LV2) the latest frame is sent through the events output port as an atom vector, decimated to the %UI rate.
+   Frames are only queued while a %UI exists, in LV2 the %UI announces itself through the events input port.
+   @note Not supported in LADSPA and DSSI plugin formats.
+ */
+#define DISTRHO_PLUGIN_WANT_VISUAL_STREAM 1
+
 /**
    Whether the %UI uses a custom toolkit implementation based on OpenGL.@n
    When enabled, the macros @ref DISTRHO_UI_CUSTOM_INCLUDE_PATH and @ref DISTRHO_UI_CUSTOM_WIDGET_TYPE are required.
@@ -763,6 +763,14 @@ struct TimePosition {
     }
 };
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+/**
+   Maximum number of values in a single visualization frame.
+   @see Plugin::writeVisualFrame(const float*, uint32_t)
+ */
+static const uint32_t kMaxVisualFrameSize = 2048;
+#endif
+
 /** @} */
 
 /* ------------------------------------------------------------------------------------------------------------
@@ -832,6 +840,14 @@ public:
     */
     double getSampleRate() const noexcept;
 
+   /**
+      Check if this plugin instance is a "dummy" one used only for plugin meta-data and/or port information.@n
+      Wrappers create such instances when hosts scan plugins, or when generating LV2 turtle files.@n
+      A dummy instance is never activated nor processed, so heavy DSP allocations and setup can be skipped for it,
+      as long as parameters, programs, states and ports are still initialized normally.
+    */
+    bool isDummyInstance() const noexcept;
+
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
    /**
       Get the current host transport time position.@n
@@ -878,6 +894,18 @@ public:
     bool requestParameterValueChange(uint32_t index, float value) noexcept;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+   /**
+      Send a frame of visualization data (for example a waveform or spectrum) to the %UI.@n
+      The frame is copied, @a values can be reused right after this call. @a count must not exceed kMaxVisualFrameSize.@n
+      This function is real-time safe and meant to be called during run(), it never blocks nor allocates.@n
+      Returns false if the frame was dropped, which happens while the %UI is closed or not keeping up.
+      @note This function is only available if DISTRHO_PLUGIN_WANT_VISUAL_STREAM is enabled.
+      @see UI::visualFrameReceived(const float*, uint32_t)
+    */
+    bool writeVisualFrame(const float* values, uint32_t count) noexcept;
+#endif
+
 protected:
    /* --------------------------------------------------------------------------------------------------------
     * Information */
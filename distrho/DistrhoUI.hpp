@@ -250,6 +250,16 @@ protected:
     */
     virtual void sampleRateChanged(double newSampleRate);
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+   /**
+      Optional callback to receive a frame of visualization data sent by the plugin side.@n
+      This is called during idle time, @a values are only valid for the duration of this call.@n
+      Frames are not guaranteed to arrive at the rate they were sent, some might be dropped or decimated.
+      @see Plugin::writeVisualFrame(const float*, uint32_t)
+    */
+    virtual void visualFrameReceived(const float* values, uint32_t count);
+#endif
+
    /* --------------------------------------------------------------------------------------------------------
     * UI Callbacks (optional) */
 
@@ -0,0 +1,176 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_ATOMIC_HPP_INCLUDED
+#define DISTRHO_ATOMIC_HPP_INCLUDED
+
+#include "../DistrhoUtils.hpp"
+
+#if defined(DISTRHO_PROPER_CPP11_SUPPORT)
+# include <atomic>
+#elif defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+// Atomic operations on plain variables
+
+/*
+ * These work on regular variables instead of atomic types,
+ * so they can be used for POD structs and data placed in shared memory.
+ * Only 1 and 4 byte types are supported, like bool, int32_t and uint32_t.
+ *
+ * d_atomicLoad and d_atomicStore use acquire and release ordering, enough for publishing data to another thread.
+ * The "SeqCst" variants and d_atomicAddFetch are sequentially consistent, for handshakes that need a total order.
+ */
+
+#if defined(DISTRHO_PROPER_CPP11_SUPPORT)
+template<typename T>
+static inline
+std::atomic<T>* d_atomicCast(const T* const ptr) noexcept
+{
+    static_assert(sizeof(std::atomic<T>) == sizeof(T), "atomic type must have the same size as plain type");
+    return reinterpret_cast<std::atomic<T>*>(const_cast<T*>(ptr));
+}
+#elif defined(_MSC_VER)
+// Interlocked functions are full barriers, for both compiler and CPU
+template<typename T, int size = sizeof(T)>
+struct DistrhoAtomicOps;
+
+template<typename T>
+struct DistrhoAtomicOps<T, 1> {
+    static T load(const T* const ptr) noexcept
+    {
+        return static_cast<T>(_InterlockedCompareExchange8((volatile char*)const_cast<T*>(ptr), 0, 0));
+    }
+
+    static void store(T* const ptr, const T value) noexcept
+    {
+        _InterlockedExchange8((volatile char*)ptr, static_cast<char>(value));
+    }
+
+    static T addFetch(T* const ptr, const T value) noexcept
+    {
+        return static_cast<T>(_InterlockedExchangeAdd8((volatile char*)ptr, static_cast<char>(value)) + value);
+    }
+};
+
+template<typename T>
+struct DistrhoAtomicOps<T, 4> {
+    static T load(const T* const ptr) noexcept
+    {
+        return static_cast<T>(_InterlockedCompareExchange((volatile long*)const_cast<T*>(ptr), 0, 0));
+    }
+
+    static void store(T* const ptr, const T value) noexcept
+    {
+        _InterlockedExchange((volatile long*)ptr, static_cast<long>(value));
+    }
+
+    static T addFetch(T* const ptr, const T value) noexcept
+    {
+        return static_cast<T>(_InterlockedExchangeAdd((volatile long*)ptr, static_cast<long>(value)) + value);
+    }
+};
+#endif
+
+/**
+   Load a value with acquire ordering.
+ */
+template<typename T>
+static inline
+T d_atomicLoad(const T* const ptr) noexcept
+{
+#if defined(DISTRHO_PROPER_CPP11_SUPPORT)
+    return d_atomicCast(ptr)->load(std::memory_order_acquire);
+#elif defined(_MSC_VER)
+    return DistrhoAtomicOps<T>::load(ptr);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+   Store a value with release ordering.
+ */
+template<typename T>
+static inline
+void d_atomicStore(T* const ptr, const T value) noexcept
+{
+#if defined(DISTRHO_PROPER_CPP11_SUPPORT)
+    d_atomicCast(ptr)->store(value, std::memory_order_release);
+#elif defined(_MSC_VER)
+    DistrhoAtomicOps<T>::store(ptr, value);
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+   Load a value with sequentially consistent ordering.
+ */
+template<typename T>
+static inline
+T d_atomicLoadSeqCst(const T* const ptr) noexcept
+{
+#if defined(DISTRHO_PROPER_CPP11_SUPPORT)
+    return d_atomicCast(ptr)->load(std::memory_order_seq_cst);
+#elif defined(_MSC_VER)
+    return DistrhoAtomicOps<T>::load(ptr);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+   Store a value with sequentially consistent ordering.
+ */
+template<typename T>
+static inline
+void d_atomicStoreSeqCst(T* const ptr, const T value) noexcept
+{
+#if defined(DISTRHO_PROPER_CPP11_SUPPORT)
+    d_atomicCast(ptr)->store(value, std::memory_order_seq_cst);
+#elif defined(_MSC_VER)
+    DistrhoAtomicOps<T>::store(ptr, value);
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+   Add to a value and return the result, with sequentially consistent ordering.
+ */
+template<typename T>
+static inline
+T d_atomicAddFetch(T* const ptr, const T value) noexcept
+{
+#if defined(DISTRHO_PROPER_CPP11_SUPPORT)
+    return d_atomicCast(ptr)->fetch_add(value, std::memory_order_seq_cst) + value;
+#elif defined(_MSC_VER)
+    return DistrhoAtomicOps<T>::addFetch(ptr, value);
+#else
+    return __atomic_add_fetch(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // DISTRHO_ATOMIC_HPP_INCLUDED
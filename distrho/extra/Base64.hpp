@@ -1,6 +1,6 @@
 /*
  * DISTRHO Plugin Framework (DPF)
- * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
  *
  * Permission to use, copy, modify, and/or distribute this software for any purpose with
  * or without fee is hereby granted, provided that the above copyright notice and this
@@ -19,7 +19,6 @@
 
 #include "../DistrhoUtils.hpp"
 
-#include <cctype>
 #include <vector>
 
 // -----------------------------------------------------------------------
@@ -60,88 +59,334 @@ static const char* const kBase64Chars =
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
-static inline
-uint8_t findBase64CharIndex(const char c)
-{
-    static const uint8_t kBase64CharsLen(static_cast<uint8_t>(std::strlen(kBase64Chars)));
+// special values in the decode table, everything else is a 6-bit value
+static const uint8_t kBase64End     = 0x40; // '=' padding or null terminator
+static const uint8_t kBase64Skip    = 0x80; // whitespace
+static const uint8_t kBase64Invalid = 0xff;
+
+static const uint8_t kBase64DecodeTable[256] = {
+    0x40, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x80, 0xff, 0xff, 0x80, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0x40, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
 
-    for (uint8_t i=0; i<kBase64CharsLen; ++i)
-    {
-        if (kBase64Chars[i] == c)
-            return i;
-    }
+} // namespace DistrhoBase64Helpers
+#endif
+
+// -----------------------------------------------------------------------
 
-    d_stderr2("findBase64CharIndex('%c') - failed", c);
-    return 0;
+/*
+ * Get the number of characters needed to base64-encode @a dataSize bytes, not counting a null terminator.
+ */
+static inline
+std::size_t d_getBase64EncodedSize(const std::size_t dataSize) noexcept
+{
+    return (dataSize + 2) / 3 * 4;
 }
 
+/*
+ * Get the maximum number of bytes that decoding @a textSize characters of base64 can produce.
+ */
 static inline
-bool isBase64Char(const char c)
+std::size_t d_getBase64DecodedMaxSize(const std::size_t textSize) noexcept
 {
-    return (std::isalnum(c) || (c == '+') || (c == '/'));
+    return textSize / 4 * 3 + 3;
 }
 
-} // namespace DistrhoBase64Helpers
-#endif
+START_NAMESPACE_DISTRHO
 
 // -----------------------------------------------------------------------
+// Base64Encoder class
 
-static inline
-std::vector<uint8_t> d_getChunkFromBase64String(const char* const base64string)
+/**
+   Table-driven base64 encoder, writing into caller-provided buffers.
+
+   Data can be given in several chunks of any size, leftover bytes are kept until the next call.
+   The output buffer for each encode() call must fit d_getBase64EncodedSize(size + 2) characters,
+   and a final call to finish() writes the last padded group (up to 4 characters).
+   No null terminator is written.
+ */
+class Base64Encoder
 {
-    DISTRHO_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
+public:
+    Base64Encoder() noexcept
+        : fPendingSize(0)
+    {
+        fPending[0] = fPending[1] = 0;
+    }
+
+   /**
+      Encode a chunk of data, returning the number of characters written to @a out.
+    */
+    std::size_t encode(const void* const data, std::size_t size, char* const out) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(data != nullptr || size == 0, 0);
+        DISTRHO_SAFE_ASSERT_RETURN(out != nullptr, 0);
 
-    uint i=0, j=0;
-    uint charArray3[3], charArray4[4];
+        const uint8_t* in = static_cast<const uint8_t*>(data);
+        char* o = out;
 
-    std::vector<uint8_t> ret;
-    ret.reserve(std::strlen(base64string)*3/4 + 4);
+        // complete the group left over from the previous chunk
+        while (fPendingSize != 0 && size != 0)
+        {
+            fPending[fPendingSize++] = *in++;
+            --size;
+
+            if (fPendingSize == 3)
+            {
+                const uint8_t group[3] = { fPending[0], fPending[1], fPending[2] };
+                encodeGroup(group, o);
+                o += 4;
+                fPendingSize = 0;
+            }
+        }
+
+        for (; size >= 3; size -= 3, in += 3, o += 4)
+            encodeGroup(in, o);
 
-    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+        for (; size != 0; --size)
+            fPending[fPendingSize++] = *in++;
+
+        return static_cast<std::size_t>(o - out);
+    }
+
+   /**
+      Write out the last group of data with padding, returning the number of characters written to @a out.
+      The encoder is ready for new data afterwards.
+    */
+    std::size_t finish(char* const out) noexcept
     {
-        const char c = base64string[l];
+        DISTRHO_SAFE_ASSERT_RETURN(out != nullptr, 0);
 
-        if (c == '\0' || c == '=')
-            break;
-        if (c == ' ' || c == '\n')
-            continue;
+        if (fPendingSize == 0)
+            return 0;
 
-        DISTRHO_SAFE_ASSERT_CONTINUE(DistrhoBase64Helpers::isBase64Char(c));
+        using DistrhoBase64Helpers::kBase64Chars;
 
-        charArray4[i++] = static_cast<uint>(c);
+        const uint32_t v = (static_cast<uint32_t>(fPending[0]) << 16)
+                         | (fPendingSize == 2 ? static_cast<uint32_t>(fPending[1]) << 8 : 0);
 
-        if (i == 4)
-        {
-            for (i=0; i<4; ++i)
-                charArray4[i] = DistrhoBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[i]));
+        out[0] = kBase64Chars[(v >> 18) & 0x3f];
+        out[1] = kBase64Chars[(v >> 12) & 0x3f];
+        out[2] = fPendingSize == 2 ? kBase64Chars[(v >> 6) & 0x3f] : '=';
+        out[3] = '=';
+
+        fPendingSize = 0;
+        return 4;
+    }
+
+private:
+    uint8_t fPending[3];
+    uint8_t fPendingSize;
+
+    static void encodeGroup(const uint8_t* const in, char* const out) noexcept
+    {
+        using DistrhoBase64Helpers::kBase64Chars;
+
+        const uint32_t v = (static_cast<uint32_t>(in[0]) << 16) | (static_cast<uint32_t>(in[1]) << 8) | in[2];
+
+        out[0] = kBase64Chars[v >> 18];
+        out[1] = kBase64Chars[(v >> 12) & 0x3f];
+        out[2] = kBase64Chars[(v >> 6) & 0x3f];
+        out[3] = kBase64Chars[v & 0x3f];
+    }
+};
+
+// -----------------------------------------------------------------------
+// Base64Decoder class
+
+/**
+   Table-driven base64 decoder, writing into caller-provided buffers.
+
+   Text can be given in several chunks of any size, leftover characters are kept until the next call.
+   The output buffer for each decode() call must fit d_getBase64DecodedMaxSize(size) bytes.
+   Whitespace is skipped, and decoding stops at the first padding or null character.
+   Invalid characters are skipped too, and reported once per decoder.
+   If the text has no padding, call finish() after the last chunk to write out any incomplete group.
+ */
+class Base64Decoder
+{
+public:
+    Base64Decoder() noexcept
+        : fPendingBits(0),
+          fPendingSize(0),
+          fFinished(false),
+          fErrorReported(false) {}
+
+   /**
+      Decode a chunk of text, returning the number of bytes written to @a out.
+    */
+    std::size_t decode(const char* const text, const std::size_t size, uint8_t* const out) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(text != nullptr || size == 0, 0);
+        DISTRHO_SAFE_ASSERT_RETURN(out != nullptr, 0);
 
-            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+        using DistrhoBase64Helpers::kBase64DecodeTable;
 
-            for (i=0; i<3; ++i)
-                ret.push_back(static_cast<uint8_t>(charArray3[i]));
+        const uint8_t* const in = reinterpret_cast<const uint8_t*>(text);
+        uint8_t* o = out;
 
-            i = 0;
+        for (std::size_t i = 0; i < size && ! fFinished;)
+        {
+            // fast path, 4 valid characters at a time
+            if (fPendingSize == 0)
+            {
+                for (; i + 4 <= size; i += 4, o += 3)
+                {
+                    const uint32_t a = kBase64DecodeTable[in[i]];
+                    const uint32_t b = kBase64DecodeTable[in[i+1]];
+                    const uint32_t c = kBase64DecodeTable[in[i+2]];
+                    const uint32_t d = kBase64DecodeTable[in[i+3]];
+
+                    if ((a | b | c | d) & 0xc0)
+                        break;
+
+                    const uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+                    o[0] = static_cast<uint8_t>(v >> 16);
+                    o[1] = static_cast<uint8_t>(v >> 8);
+                    o[2] = static_cast<uint8_t>(v);
+                }
+
+                if (i >= size)
+                    break;
+            }
+
+            // slow path, one character at a time until the next group boundary
+            const uint8_t v = kBase64DecodeTable[in[i++]];
+
+            switch (v)
+            {
+            case DistrhoBase64Helpers::kBase64End:
+                o += finish(o);
+                fFinished = true;
+                break;
+
+            case DistrhoBase64Helpers::kBase64Skip:
+                break;
+
+            case DistrhoBase64Helpers::kBase64Invalid:
+                if (! fErrorReported)
+                {
+                    fErrorReported = true;
+                    d_stderr2("Base64Decoder::decode() - invalid character '%c' skipped", text[i-1]);
+                }
+                break;
+
+            default:
+                fPendingBits = (fPendingBits << 6) | v;
+
+                if (++fPendingSize == 4)
+                {
+                    o[0] = static_cast<uint8_t>(fPendingBits >> 16);
+                    o[1] = static_cast<uint8_t>(fPendingBits >> 8);
+                    o[2] = static_cast<uint8_t>(fPendingBits);
+                    o += 3;
+                    fPendingBits = 0;
+                    fPendingSize = 0;
+                }
+                break;
+            }
         }
+
+        return static_cast<std::size_t>(o - out);
     }
 
-    if (i != 0)
+   /**
+      Write out an incomplete last group, returning the number of bytes written to @a out (up to 2).
+      Only needed for text without padding, as padding finishes decoding automatically.
+    */
+    std::size_t finish(uint8_t* const out) noexcept
     {
-        for (j=0; j<i && j<4; ++j)
-            charArray4[j] = DistrhoBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[j]));
+        DISTRHO_SAFE_ASSERT_RETURN(out != nullptr, 0);
 
-        for (j=i; j<4; ++j)
-            charArray4[j] = 0;
+        // a single leftover character does not make a full byte
+        const std::size_t size = fPendingSize > 1 ? fPendingSize - 1u : 0u;
+        const uint32_t bits = fPendingBits << (6 * (4 - fPendingSize));
 
-        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-        charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+        for (std::size_t i = 0; i < size; ++i)
+            out[i] = static_cast<uint8_t>(bits >> (16 - 8 * i));
 
-        for (j=0; i>0 && j<i-1; j++)
-            ret.push_back(static_cast<uint8_t>(charArray3[j]));
+        fPendingBits = 0;
+        fPendingSize = 0;
+        return size;
     }
 
+   /**
+      Check if padding or a null character was found, after which further text is ignored.
+    */
+    bool isFinished() const noexcept
+    {
+        return fFinished;
+    }
+
+   /**
+      Check if any invalid characters were skipped.
+    */
+    bool hadErrors() const noexcept
+    {
+        return fErrorReported;
+    }
+
+private:
+    uint32_t fPendingBits;
+    uint32_t fPendingSize;
+    bool fFinished;
+    bool fErrorReported;
+};
+
+END_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+/*
+ * Encode @a dataSize bytes of @a data as base64 into @a out, returning the number of characters written.
+ * @a out must fit d_getBase64EncodedSize(dataSize) characters, no null terminator is written.
+ */
+static inline
+std::size_t d_encodeBase64(const void* const data, const std::size_t dataSize, char* const out) noexcept
+{
+    DISTRHO_NAMESPACE::Base64Encoder encoder;
+    const std::size_t written = encoder.encode(data, dataSize, out);
+    return written + encoder.finish(out + written);
+}
+
+/*
+ * Decode @a textSize characters of base64 @a text into @a out, returning the number of bytes written.
+ * @a out must fit d_getBase64DecodedMaxSize(textSize) bytes.
+ */
+static inline
+std::size_t d_decodeBase64(const char* const text, const std::size_t textSize, uint8_t* const out) noexcept
+{
+    DISTRHO_NAMESPACE::Base64Decoder decoder;
+    const std::size_t written = decoder.decode(text, textSize, out);
+    return written + decoder.finish(out + written);
+}
+
+static inline
+std::vector<uint8_t> d_getChunkFromBase64String(const char* const base64string)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
+
+    const std::size_t len = std::strlen(base64string);
+
+    if (len == 0)
+        return std::vector<uint8_t>();
+
+    std::vector<uint8_t> ret(d_getBase64DecodedMaxSize(len));
+    ret.resize(d_decodeBase64(base64string, len, &ret[0]));
     return ret;
 }
 
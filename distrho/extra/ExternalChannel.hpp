@@ -0,0 +1,534 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_EXTERNAL_CHANNEL_HPP_INCLUDED
+#define DISTRHO_EXTERNAL_CHANNEL_HPP_INCLUDED
+
+#include "Atomic.hpp"
+#include "RingBuffer.hpp"
+#include "Sleep.hpp"
+
+#ifndef DISTRHO_OS_WINDOWS
+# include <cerrno>
+# include <cstdio>
+# include <cstdlib>
+# include <ctime>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+# ifdef DISTRHO_OS_LINUX
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+# endif
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+// ExternalChannel class
+
+/**
+   Shared memory channel between a plugin UI and an external UI process.
+
+   The plugin side creates the channel and passes its name to the external process (usually as a command-line argument),
+   which then connects to it. From there on both sides can send parameter changes, states and notes to each other.
+   This header does not depend on anything else from DPF besides DistrhoUtils, so external processes can use it too.
+
+   Each direction has its own lock-free ring buffer placed directly in shared memory (see RingBufferControl),
+   messages are written in binary form and never go through text serialization.
+   All message types share the same ring so they are received in the order they were sent.
+
+   Each direction also has a doorbell, so a side that has nothing else to do can sleep until new messages arrive.
+   On Linux this is a futex living in the shared memory, writers only do a system call if the other side is sleeping.
+   On other systems waiting falls back to polling.
+
+   Typical usage on the plugin side, using ExternalWindow helpers:
+   ```
+   // when the UI becomes visible
+   ExternalChannel& channel(getExternalChannel());
+   channel.create();
+   const char* args[] = { "my-external-ui", channel.getName(), nullptr };
+   startExternalProcess(args);
+
+   // in parameterChanged()
+   channel.writeParameterValue(index, value);
+
+   // in uiIdle()
+   channel.readMessages(*this); // with this UI class implementing ExternalChannel::Callbacks
+   ```
+
+   And on the external process side:
+   ```
+   ExternalChannel channel;
+   channel.connect(argv[1]);
+
+   while (channel.isPeerConnected())
+   {
+       if (channel.waitForMessages(50))
+           channel.readMessages(myCallbacks);
+   }
+   ```
+
+   @note Not available on Windows, create() and connect() always fail there.
+ */
+class ExternalChannel
+{
+public:
+   /**
+      Callbacks for received messages, see readMessages().
+      All functions are optional, the default implementations ignore the message.
+    */
+    struct Callbacks {
+        virtual ~Callbacks() {}
+        virtual void channelParameterValue(uint32_t index, float value) { return; (void)index; (void)value; }
+        virtual void channelState(const char* key, const char* value) { return; (void)key; (void)value; }
+        virtual void channelNote(uint8_t channel, uint8_t note, uint8_t velocity) { return; (void)channel; (void)note; (void)velocity; }
+    };
+
+   /**
+      Constructor, for a closed channel.
+    */
+    ExternalChannel() noexcept
+        : fData(nullptr),
+          fIsCreator(false),
+          fReadRing(),
+          fWriteRing(),
+          fReadBuffer(nullptr),
+          fReadBufferSize(0)
+    {
+        fName[0] = '\0';
+    }
+
+   /**
+      Destructor, closes the channel if needed.
+    */
+    ~ExternalChannel() noexcept
+    {
+        close();
+        std::free(fReadBuffer);
+    }
+
+   /**
+      Check if the channel is created or connected.
+    */
+    bool isOpen() const noexcept
+    {
+        return fData != nullptr;
+    }
+
+   /**
+      Check if the other side is connected.
+      This is false on the plugin side until the external process connects, and after either side closes the channel.
+      A process that crashes or gets killed is not detected, check the process itself for that (e.g. ExternalWindow::isRunning()).
+    */
+    bool isPeerConnected() const noexcept
+    {
+        return fData != nullptr && loadPeerState() == kPeerOpen;
+    }
+
+   /**
+      Get the name of the channel, to be given to the external process.
+      Returns an empty string if the channel is closed.
+    */
+    const char* getName() const noexcept
+    {
+        return fName;
+    }
+
+   /**
+      Create a new channel, closing the previous one if needed.
+      This is meant for the plugin side.
+    */
+    bool create() noexcept
+    {
+#ifndef DISTRHO_OS_WINDOWS
+        close();
+
+        static uint32_t counter = 0;
+        std::snprintf(fName, sizeof(fName), "/dpf-channel-%ld-%u-%lx",
+                      static_cast<long>(::getpid()), ++counter, static_cast<ulong>(std::time(nullptr)));
+
+        const int fd = ::shm_open(fName, O_CREAT|O_EXCL|O_RDWR, 0600);
+        DISTRHO_SAFE_ASSERT_RETURN(fd >= 0, fail());
+
+        if (::ftruncate(fd, sizeof(SharedData)) != 0)
+        {
+            ::close(fd);
+            ::shm_unlink(fName);
+            d_stderr2("ExternalChannel::create() - failed to resize shared memory");
+            return fail();
+        }
+
+        if (! map(fd))
+        {
+            ::shm_unlink(fName);
+            return fail();
+        }
+
+        // shared memory starts zeroed, only the ring buffers need setup
+        fIsCreator = true;
+        fReadRing.setRingBuffer(&fData->toPlugin, true);
+        fWriteRing.setRingBuffer(&fData->toExternal, true);
+        fData->version = kVersion;
+        d_atomicStore(&fData->pluginState, static_cast<int32_t>(kPeerOpen));
+        return true;
+#else
+        return false;
+#endif
+    }
+
+   /**
+      Connect to an existing channel, closing the previous one if needed.
+      This is meant for the external process side, using the name received from the plugin.
+    */
+    bool connect(const char* const name) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(name != nullptr && name[0] == '/', false);
+
+#ifndef DISTRHO_OS_WINDOWS
+        close();
+
+        std::strncpy(fName, name, sizeof(fName)-1);
+        fName[sizeof(fName)-1] = '\0';
+
+        const int fd = ::shm_open(fName, O_RDWR, 0);
+        DISTRHO_SAFE_ASSERT_RETURN(fd >= 0, fail());
+
+        if (! map(fd))
+            return fail();
+
+        // the layout might differ, so do not touch anything else
+        if (fData->version != kVersion)
+        {
+            d_stderr2("ExternalChannel::connect(\"%s\") - version mismatch", name);
+            ::munmap(fData, sizeof(SharedData));
+            fData = nullptr;
+            return fail();
+        }
+
+        // nothing else needs to find the channel by name now
+        ::shm_unlink(fName);
+
+        fIsCreator = false;
+        fReadRing.setRingBuffer(&fData->toExternal, false);
+        fWriteRing.setRingBuffer(&fData->toPlugin, false);
+        d_atomicStore(&fData->externalState, static_cast<int32_t>(kPeerOpen));
+        return true;
+#else
+        return false;
+#endif
+    }
+
+   /**
+      Close the channel.
+      The other side sees isPeerConnected() return false, and wakes up if it is waiting for messages.
+    */
+    void close() noexcept
+    {
+#ifndef DISTRHO_OS_WINDOWS
+        if (fData == nullptr)
+            return;
+
+        d_atomicStore(fIsCreator ? &fData->pluginState : &fData->externalState, static_cast<int32_t>(kPeerClosed));
+        ringPeerBell();
+
+        fReadRing.setRingBuffer(nullptr, false);
+        fWriteRing.setRingBuffer(nullptr, false);
+
+        ::munmap(fData, sizeof(SharedData));
+        fData = nullptr;
+
+        // the external side unlinks on connect, but it might have never done so
+        if (fIsCreator)
+            ::shm_unlink(fName);
+
+        fName[0] = '\0';
+#endif
+    }
+
+    // -------------------------------------------------------------------
+    // write operations, never block
+
+   /**
+      Send a parameter value change to the other side.
+    */
+    bool writeParameterValue(const uint32_t index, const float value) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, false);
+
+        fWriteRing.writeUInt(kMessageParameterValue);
+        fWriteRing.writeUInt(index);
+        fWriteRing.writeFloat(value);
+        return commit();
+    }
+
+   /**
+      Send a state change to the other side.
+    */
+    bool writeState(const char* const key, const char* const value) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(key != nullptr && key[0] != '\0', false);
+        DISTRHO_SAFE_ASSERT_RETURN(value != nullptr, false);
+
+        const uint32_t keySize   = static_cast<uint32_t>(std::strlen(key) + 1);
+        const uint32_t valueSize = static_cast<uint32_t>(std::strlen(value) + 1);
+
+        fWriteRing.writeUInt(kMessageState);
+        fWriteRing.writeUInt(keySize + valueSize);
+        fWriteRing.writeCustomData(key, keySize);
+        fWriteRing.writeCustomData(value, valueSize);
+        return commit();
+    }
+
+   /**
+      Send a MIDI note to the other side.
+      A note with zero velocity means note-off.
+    */
+    bool writeNote(const uint8_t channel, const uint8_t note, const uint8_t velocity) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, false);
+        DISTRHO_SAFE_ASSERT_UINT_RETURN(channel < 16, channel, false);
+        DISTRHO_SAFE_ASSERT_UINT_RETURN(note < 128, note, false);
+        DISTRHO_SAFE_ASSERT_UINT_RETURN(velocity < 128, velocity, false);
+
+        fWriteRing.writeUInt(kMessageNote);
+        fWriteRing.writeByte(channel);
+        fWriteRing.writeByte(note);
+        fWriteRing.writeByte(velocity);
+        return commit();
+    }
+
+    // -------------------------------------------------------------------
+    // read operations
+
+   /**
+      Check if there are messages waiting to be read.
+    */
+    bool hasMessages() const noexcept
+    {
+        return fData != nullptr && fReadRing.isDataAvailableForReading();
+    }
+
+   /**
+      Read all pending messages, passing each one to @a callbacks.
+      Returns the number of messages read.
+      A state too big to be allocated is dropped, while a malformed message closes the channel as nothing after it can be trusted.
+    */
+    uint32_t readMessages(Callbacks& callbacks)
+    {
+        uint32_t count = 0;
+
+        for (; hasMessages(); ++count)
+        {
+            switch (fReadRing.readUInt())
+            {
+            case kMessageParameterValue: {
+                const uint32_t index = fReadRing.readUInt();
+                const float value = fReadRing.readFloat();
+                callbacks.channelParameterValue(index, value);
+                break;
+            }
+            case kMessageState: {
+                const uint32_t size = fReadRing.readUInt();
+
+                // messages are committed whole, so the payload must already be there
+                RingBufferSpans spans;
+                if (size < 3 || size > fReadRing.peekReadSpans(spans))
+                    return closeOnInvalidMessage(count);
+
+                if (! ensureReadBufferSize(size))
+                {
+                    d_stderr2("ExternalChannel::readMessages() - state of %u bytes dropped, out of memory", size);
+                    fReadRing.commitReadSpans(size);
+                    break;
+                }
+
+                if (! fReadRing.readCustomData(fReadBuffer, size))
+                    return closeOnInvalidMessage(count);
+
+                fReadBuffer[size-1] = '\0';
+                callbacks.channelState(fReadBuffer, fReadBuffer + std::strlen(fReadBuffer) + 1);
+                break;
+            }
+            case kMessageNote: {
+                const uint8_t channel  = fReadRing.readByte();
+                const uint8_t note     = fReadRing.readByte();
+                const uint8_t velocity = fReadRing.readByte();
+                callbacks.channelNote(channel, note, velocity);
+                break;
+            }
+            default:
+                return closeOnInvalidMessage(count);
+            }
+        }
+
+        return count;
+    }
+
+   /**
+      Wait until there are messages to read, the other side closes the channel, or @a timeoutInMs milliseconds have passed.
+      Returns true if there are messages waiting to be read.
+      This blocks the calling thread, so do not use it from the plugin UI side.
+    */
+    bool waitForMessages(const uint timeoutInMs) noexcept
+    {
+        if (hasMessages())
+            return true;
+        if (fData == nullptr)
+            return false;
+
+#ifdef DISTRHO_OS_LINUX
+        Doorbell& bell(fIsCreator ? fData->pluginBell : fData->externalBell);
+
+        const int32_t value = d_atomicLoadSeqCst(&bell.counter);
+        d_atomicStoreSeqCst(&bell.waiting, 1);
+
+        // a write or close after reading the counter makes the futex wait return right away
+        if (! fReadRing.isDataAvailableForReading() && loadPeerState() != kPeerClosed)
+        {
+            struct timespec timeout;
+            timeout.tv_sec  = static_cast<time_t>(timeoutInMs / 1000);
+            timeout.tv_nsec = static_cast<long>(timeoutInMs % 1000) * 1000000L;
+            ::syscall(SYS_futex, &bell.counter, FUTEX_WAIT, value, &timeout, nullptr, 0);
+        }
+
+        d_atomicStoreSeqCst(&bell.waiting, 0);
+#else
+        for (uint i = 0; i < timeoutInMs && ! fReadRing.isDataAvailableForReading() && loadPeerState() != kPeerClosed; ++i)
+            d_msleep(1);
+#endif
+
+        return hasMessages();
+    }
+
+private:
+    static const uint32_t kVersion = 3;
+
+    enum MessageType {
+        kMessageNull = 0,
+        kMessageParameterValue,
+        kMessageState,
+        kMessageNote
+    };
+
+    /** Connection state of each side, as seen by the other. */
+    enum PeerState {
+        kPeerNone = 0,
+        kPeerOpen,
+        kPeerClosed
+    };
+
+    /** Futex word and sleeping flag for one direction, rung on each committed message. */
+    struct Doorbell {
+        int32_t counter;
+        int32_t waiting;
+    };
+
+    /** Memory layout of the channel, must be POD as it lives in shared memory. */
+    struct SharedData {
+        uint32_t version;
+        int32_t pluginState;
+        int32_t externalState;
+        Doorbell pluginBell;
+        Doorbell externalBell;
+        HugeStackBuffer toPlugin;
+        HugeStackBuffer toExternal;
+    };
+
+    SharedData* fData;
+    bool fIsCreator;
+    char fName[64];
+
+    RingBufferControl<HugeStackBuffer> fReadRing;
+    RingBufferControl<HugeStackBuffer> fWriteRing;
+
+    char*    fReadBuffer;
+    uint32_t fReadBufferSize;
+
+    bool fail() noexcept
+    {
+        fName[0] = '\0';
+        return false;
+    }
+
+#ifndef DISTRHO_OS_WINDOWS
+    bool map(const int fd) noexcept
+    {
+        void* const ptr = ::mmap(nullptr, sizeof(SharedData), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        DISTRHO_SAFE_ASSERT_RETURN(ptr != MAP_FAILED, false);
+
+        fData = static_cast<SharedData*>(ptr);
+        return true;
+    }
+#endif
+
+    bool commit() noexcept
+    {
+        if (! fWriteRing.commitWrite())
+            return false;
+
+        ringPeerBell();
+        return true;
+    }
+
+    void ringPeerBell() noexcept
+    {
+#ifdef DISTRHO_OS_LINUX
+        Doorbell& bell(fIsCreator ? fData->externalBell : fData->pluginBell);
+
+        d_atomicAddFetch(&bell.counter, 1);
+
+        if (d_atomicLoadSeqCst(&bell.waiting) != 0)
+            ::syscall(SYS_futex, &bell.counter, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+    }
+
+    int32_t loadPeerState() const noexcept
+    {
+        return d_atomicLoad(fIsCreator ? &fData->externalState : &fData->pluginState);
+    }
+
+    uint32_t closeOnInvalidMessage(const uint32_t count) noexcept
+    {
+        d_stderr2("ExternalChannel::readMessages() - invalid message received, closing channel");
+        close();
+        return count;
+    }
+
+    bool ensureReadBufferSize(const uint32_t size) noexcept
+    {
+        if (size <= fReadBufferSize)
+            return true;
+
+        char* const buffer = static_cast<char*>(std::realloc(fReadBuffer, size));
+        DISTRHO_SAFE_ASSERT_RETURN(buffer != nullptr, false);
+
+        fReadBuffer = buffer;
+        fReadBufferSize = size;
+        return true;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(ExternalChannel)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // DISTRHO_EXTERNAL_CHANNEL_HPP_INCLUDED
@@ -20,6 +20,7 @@
 #include "String.hpp"
 
 #ifndef DISTRHO_OS_WINDOWS
+# include "ExternalChannel.hpp"
 # include <cerrno>
 # include <signal.h>
 # include <sys/wait.h>
@@ -376,11 +377,25 @@ protected:
 #ifndef DISTRHO_OS_WINDOWS
         ext.isQuitting = true;
         ext.terminateAndWait();
+        ext.channel.close();
 #else
         // TODO
 #endif
     }
 
+#ifndef DISTRHO_OS_WINDOWS
+   /**
+      Get the shared memory channel for communicating with the external process.
+      Create it before calling startExternalProcess() and pass its name to the process, so it can connect too.
+      The channel is closed after the external process terminates.
+      @see ExternalChannel
+    */
+    ExternalChannel& getExternalChannel() noexcept
+    {
+        return ext.channel;
+    }
+#endif
+
    /* --------------------------------------------------------------------------------------------------------
     * ExternalWindow specific callbacks */
 
@@ -432,11 +447,13 @@ private:
         bool inUse;
         bool isQuitting;
         mutable pid_t pid;
+        mutable ExternalChannel channel;
 
         ExternalProcess()
             : inUse(false),
               isQuitting(false),
-              pid(0) {}
+              pid(0),
+              channel() {}
 
         bool isRunning() const noexcept
         {
@@ -449,6 +466,8 @@ private:
             {
                 d_stdout("NOTICE: Child process exited while idle");
                 pid = 0;
+                // let our side know the peer is gone, it cannot do so itself anymore
+                channel.close();
                 return false;
             }
 
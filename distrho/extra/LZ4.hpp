@@ -0,0 +1,193 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_LZ4_HPP_INCLUDED
+#define DISTRHO_LZ4_HPP_INCLUDED
+
+#include "Mutex.hpp"
+
+#include <vector>
+
+// -----------------------------------------------------------------------
+// LZ4 block decoding, see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+
+#ifndef DOXYGEN
+namespace DistrhoLZ4Helpers {
+
+static inline
+bool readLength(const uint8_t*& ip, const uint8_t* const iend, std::size_t& length) noexcept
+{
+    if (length != 15)
+        return true;
+
+    for (uint8_t byte = 255; byte == 255;)
+    {
+        if (ip >= iend)
+            return false;
+
+        byte = *ip++;
+        length += byte;
+    }
+
+    return true;
+}
+
+struct DecompressedResource {
+    const char* compressedData;
+    char* data;
+};
+
+struct DecompressedResources {
+    DISTRHO_NAMESPACE::Mutex mutex;
+    std::vector<DecompressedResource> resources;
+
+    ~DecompressedResources()
+    {
+        for (std::vector<DecompressedResource>::iterator it = resources.begin(); it != resources.end(); ++it)
+            std::free(it->data);
+    }
+};
+
+// not static, so that all translation units share the same cache
+inline DecompressedResources& getDecompressedResources()
+{
+    static DecompressedResources resources;
+    return resources;
+}
+
+} // namespace DistrhoLZ4Helpers
+#endif
+
+// -----------------------------------------------------------------------
+
+/*
+ * Decompress a raw LZ4 block (without frame header) into @a out, which can hold up to @a outSize bytes.
+ * Malformed or truncated input is detected and never read or written out of bounds.
+ * Returns the number of decompressed bytes, or 0 on error.
+ */
+static inline
+std::size_t d_decompressLZ4(const void* const data, const std::size_t dataSize,
+                            void* const out, const std::size_t outSize) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, 0);
+    DISTRHO_SAFE_ASSERT_RETURN(out != nullptr, 0);
+
+    const uint8_t* ip = static_cast<const uint8_t*>(data);
+    const uint8_t* const iend = ip + dataSize;
+    uint8_t* const ostart = static_cast<uint8_t*>(out);
+    uint8_t* op = ostart;
+    uint8_t* const oend = op + outSize;
+
+    while (ip < iend)
+    {
+        const uint8_t token = *ip++;
+
+        // literals
+        std::size_t length = token >> 4;
+
+        if (! DistrhoLZ4Helpers::readLength(ip, iend, length))
+            return 0;
+        if (length > static_cast<std::size_t>(iend - ip) || length > static_cast<std::size_t>(oend - op))
+            return 0;
+
+        std::memcpy(op, ip, length);
+        ip += length;
+        op += length;
+
+        // the last sequence has no match
+        if (ip == iend)
+            break;
+
+        // match
+        if (iend - ip < 2)
+            return 0;
+
+        const std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if (offset == 0 || offset > static_cast<std::size_t>(op - ostart))
+            return 0;
+
+        length = token & 15;
+
+        if (! DistrhoLZ4Helpers::readLength(ip, iend, length))
+            return 0;
+
+        length += 4;
+
+        if (length > static_cast<std::size_t>(oend - op))
+            return 0;
+
+        const uint8_t* match = op - offset;
+
+        if (offset >= length)
+        {
+            std::memcpy(op, match, length);
+            op += length;
+        }
+        else
+        {
+            // overlapping copy, repeats the last offset bytes
+            for (uint8_t* const mend = op + length; op < mend;)
+                *op++ = *match++;
+        }
+    }
+
+    return static_cast<std::size_t>(op - ostart);
+}
+
+/*
+ * Get the contents of a resource embedded with `utils/res2c.py --compress`.
+ * The data is decompressed on first use and kept until the program ends, shared by all callers,
+ * so resources that are never used (for example UI assets while only running the DSP) cost no memory.
+ * This function is thread-safe. Returns null if the data is invalid.
+ */
+static inline
+const char* d_getDecompressedResource(const char* const compressedData,
+                                      const std::size_t compressedDataSize,
+                                      const std::size_t dataSize)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(compressedData != nullptr, nullptr);
+
+    DistrhoLZ4Helpers::DecompressedResources& cache(DistrhoLZ4Helpers::getDecompressedResources());
+    const DISTRHO_NAMESPACE::MutexLocker cml(cache.mutex);
+
+    for (std::vector<DistrhoLZ4Helpers::DecompressedResource>::iterator it = cache.resources.begin();
+         it != cache.resources.end(); ++it)
+    {
+        if (it->compressedData == compressedData)
+            return it->data;
+    }
+
+    // always allocate something, so empty resources are not null
+    char* const data = static_cast<char*>(std::malloc(dataSize != 0 ? dataSize : 1));
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, nullptr);
+
+    if (d_decompressLZ4(compressedData, compressedDataSize, data, dataSize) != dataSize)
+    {
+        d_stderr2("d_getDecompressedResource: invalid compressed data");
+        std::free(data);
+        return nullptr;
+    }
+
+    const DistrhoLZ4Helpers::DecompressedResource resource = { compressedData, data };
+    cache.resources.push_back(resource);
+    return data;
+}
+
+// -----------------------------------------------------------------------
+
+#endif // DISTRHO_LZ4_HPP_INCLUDED
@@ -17,13 +17,18 @@
 #ifndef DISTRHO_RING_BUFFER_HPP_INCLUDED
 #define DISTRHO_RING_BUFFER_HPP_INCLUDED
 
-#include "../DistrhoUtils.hpp"
+#include "Atomic.hpp"
 
 START_NAMESPACE_DISTRHO
 
 // -----------------------------------------------------------------------
 // Buffer structs
 
+/**
+   Cache line size assumed for padding the reader and writer positions apart.
+ */
+static const uint32_t kRingBufferCacheLineSize = 64;
+
 /**
    Base structure for all RingBuffer containers.
    This struct details the data model used in DPF's RingBuffer class.
@@ -45,6 +50,10 @@ START_NAMESPACE_DISTRHO
    thus avoiding the issue of reading data too early from the other side.
    For example, write the size of some data first, and then the actual data.
    The reading side will only see data available once size + data is completely written and "committed".
+
+   Positions are split by owner: head, wrtn and invalidateCommit are only modified by the writer,
+   while tail is only modified by the reader.
+   Padding keeps both groups on separate cache lines so the two sides do not keep invalidating each other's cache.
  */
 struct HeapBuffer {
    /**
@@ -59,13 +68,6 @@ struct HeapBuffer {
     */
     uint32_t head;
 
-   /**
-      Current reading position, last used position of the buffer.
-      Increments when reading.
-      head == tail means empty buffer.
-    */
-    uint32_t tail;
-
    /**
       Temporary position of head until a commitWrite() is called.
       If buffer writing fails, wrtn will be back to head position thus ignoring the last operation(s).
@@ -79,6 +81,24 @@ struct HeapBuffer {
     */
     bool invalidateCommit;
 
+   /**
+      Padding between writer and reader positions.
+      A full cache line, so they never share one regardless of where the struct is placed.
+    */
+    uint8_t padding1[kRingBufferCacheLineSize];
+
+   /**
+      Current reading position, last used position of the buffer.
+      Increments when reading.
+      head == tail means empty buffer.
+    */
+    uint32_t tail;
+
+   /**
+      Padding between reader position and buffer data.
+    */
+    uint8_t padding2[kRingBufferCacheLineSize - sizeof(uint32_t)];
+
    /**
       Pointer to buffer data.
       This can be either stack or heap data, depending on the usecase.
@@ -92,8 +112,11 @@ struct HeapBuffer {
 */
 struct SmallStackBuffer {
     static const uint32_t size = 4096;
-    uint32_t head, tail, wrtn;
+    uint32_t head, wrtn;
     bool     invalidateCommit;
+    uint8_t  padding1[kRingBufferCacheLineSize];
+    uint32_t tail;
+    uint8_t  padding2[kRingBufferCacheLineSize - sizeof(uint32_t)];
     uint8_t  buf[size];
 };
 
@@ -103,8 +126,11 @@ struct SmallStackBuffer {
 */
 struct BigStackBuffer {
     static const uint32_t size = 16384;
-    uint32_t head, tail, wrtn;
+    uint32_t head, wrtn;
     bool     invalidateCommit;
+    uint8_t  padding1[kRingBufferCacheLineSize];
+    uint32_t tail;
+    uint8_t  padding2[kRingBufferCacheLineSize - sizeof(uint32_t)];
     uint8_t  buf[size];
 };
 
@@ -114,19 +140,34 @@ struct BigStackBuffer {
 */
 struct HugeStackBuffer {
     static const uint32_t size = 65536;
-    uint32_t head, tail, wrtn;
+    uint32_t head, wrtn;
     bool     invalidateCommit;
+    uint8_t  padding1[kRingBufferCacheLineSize];
+    uint32_t tail;
+    uint8_t  padding2[kRingBufferCacheLineSize - sizeof(uint32_t)];
     uint8_t  buf[size];
 };
 
 #ifdef DISTRHO_PROPER_CPP11_SUPPORT
-# define HeapBuffer_INIT  {0, 0, 0, 0, false, nullptr}
-# define StackBuffer_INIT {0, 0, 0, false, {0}}
+# define HeapBuffer_INIT  {0, 0, 0, false, {0}, 0, {0}, nullptr}
+# define StackBuffer_INIT {0, 0, false, {0}, 0, {0}, {0}}
 #else
 # define HeapBuffer_INIT
 # define StackBuffer_INIT
 #endif
 
+/**
+   Direct access to a region of ring buffer memory, as given by the peek functions of RingBufferControl.
+   Because the memory wraps around, a region can be split in 2 parts.
+   The 2nd part is only used when the 1st one reaches the end of the buffer, otherwise it is null and with 0 size.
+ */
+struct RingBufferSpans {
+    uint8_t* data1;
+    uint32_t size1;
+    uint8_t* data2;
+    uint32_t size2;
+};
+
 // -----------------------------------------------------------------------
 // RingBufferControl templated class
 
@@ -136,6 +177,9 @@ struct HugeStackBuffer {
 
    This is meant for single-writer, single-reader type of control.
    Writing and reading is wait and lock-free.
+   Committing a write publishes its data with release semantics, and the reader acquires it before reading,
+   so both sides can safely run on different threads or processes.
+   Only one thread may write and only one thread may read at a time.
 
    Typically usage involves:
    ```
@@ -161,6 +205,15 @@ struct HugeStackBuffer {
    }
    ```
 
+   Bigger blocks of data can be accessed in-place through peekWriteSpans and peekReadSpans, avoiding a copy:
+   ```
+   RingBufferSpans spans;
+   const uint32_t size = myHeapBuffer.peekReadSpans(spans);
+   process(spans.data1, spans.size1);
+   process(spans.data2, spans.size2);
+   myHeapBuffer.commitReadSpans(size);
+   ```
+
    @see HeapBuffer
  */
 template <class BufferStruct>
@@ -197,19 +250,21 @@ public:
     {
         DISTRHO_SAFE_ASSERT_RETURN(buffer != nullptr, false);
 
-        return (buffer->buf == nullptr || buffer->head == buffer->tail);
+        return (buffer->buf == nullptr || loadHead() == buffer->tail);
     }
 
     /*
-     * Get the size of the data available to read.
+     * Get the size of the free space available for writing, counting writes not yet committed.
+     * To be called from the writer side.
      */
     uint32_t getAvailableDataSize() const noexcept
     {
         DISTRHO_SAFE_ASSERT_RETURN(buffer != nullptr, 0);
 
-        const uint32_t wrap((buffer->tail > buffer->wrtn) ? 0 : buffer->size);
+        const uint32_t tail(loadTail());
+        const uint32_t wrap((tail > buffer->wrtn) ? 0 : buffer->size);
 
-        return wrap + buffer->tail - buffer->wrtn;
+        return wrap + tail - buffer->wrtn;
     }
 
     // -------------------------------------------------------------------
@@ -475,6 +530,92 @@ public:
         return tryWrite(&type, sizeof(T));
     }
 
+    // -------------------------------------------------------------------
+    // in-place operations
+
+    /*!
+     * Get direct access to all committed data that is available for reading.
+     * Returns the total size of the data in @a spans, which is 0 if there is nothing to read.
+     * Data stays in the ring buffer until a commitReadSpans() call.
+     */
+    uint32_t peekReadSpans(RingBufferSpans& spans) const noexcept
+    {
+        std::memset(&spans, 0, sizeof(spans));
+        DISTRHO_SAFE_ASSERT_RETURN(buffer != nullptr, 0);
+
+        const uint32_t head(loadHead());
+        const uint32_t tail(buffer->tail);
+
+        if (head == tail)
+            return 0;
+
+        const uint32_t wrap((head > tail) ? 0 : buffer->size);
+        return fillSpans(spans, tail, wrap + head - tail);
+    }
+
+    /*!
+     * Mark @a size bytes of data as read, after a call to peekReadSpans().
+     * This makes the space available for writing again.
+     */
+    bool commitReadSpans(const uint32_t size) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(buffer != nullptr, false);
+
+        const uint32_t head(loadHead());
+        const uint32_t tail(buffer->tail);
+        const uint32_t wrap((head >= tail) ? 0 : buffer->size);
+        DISTRHO_SAFE_ASSERT_UINT2_RETURN(size <= wrap + head - tail, size, wrap + head - tail, false);
+
+        storeTail((tail + size) % buffer->size);
+        errorReading = false;
+        return true;
+    }
+
+    /*!
+     * Get direct access to all free space available for writing, after any writes not yet committed.
+     * Returns the total size of the space in @a spans, which is 0 if the buffer is full.
+     * Nothing is visible to the reader until a commitWriteSpans() call.
+     */
+    uint32_t peekWriteSpans(RingBufferSpans& spans) const noexcept
+    {
+        std::memset(&spans, 0, sizeof(spans));
+        DISTRHO_SAFE_ASSERT_RETURN(buffer != nullptr, 0);
+
+        const uint32_t tail(loadTail());
+        const uint32_t wrtn(buffer->wrtn);
+        const uint32_t wrap((tail > wrtn) ? 0 : buffer->size);
+
+        // one byte always stays free, so a full buffer is not mistaken for an empty one
+        return fillSpans(spans, wrtn, wrap + tail - wrtn - 1);
+    }
+
+    /*!
+     * Mark @a size bytes as written, after a call to peekWriteSpans(), and commit them together with any previous writes.
+     * Committing 0 bytes with no previous writes does nothing and returns true.
+     * @see commitWrite()
+     */
+    bool commitWriteSpans(const uint32_t size) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(buffer != nullptr, false);
+
+        if (size != 0)
+        {
+            const uint32_t tail(loadTail());
+            const uint32_t wrtn(buffer->wrtn);
+            const uint32_t wrap((tail > wrtn) ? 0 : buffer->size);
+            DISTRHO_SAFE_ASSERT_UINT2_RETURN(size < wrap + tail - wrtn, size, wrap + tail - wrtn, false);
+
+            buffer->wrtn = (wrtn + size) % buffer->size;
+        }
+        // nothing written through spans nor before, nothing to do
+        else if (buffer->head == buffer->wrtn && ! buffer->invalidateCommit)
+        {
+            return true;
+        }
+
+        return commitWrite();
+    }
+
     // -------------------------------------------------------------------
 
     /*!
@@ -496,7 +637,7 @@ public:
         DISTRHO_SAFE_ASSERT_RETURN(buffer->head != buffer->wrtn, false);
 
         // all ok
-        buffer->head = buffer->wrtn;
+        storeHead(buffer->wrtn);
         errorWriting = false;
         return true;
     }
@@ -535,14 +676,15 @@ protected:
         DISTRHO_SAFE_ASSERT_RETURN(size > 0, false);
         DISTRHO_SAFE_ASSERT_RETURN(size < buffer->size, false);
 
+        const uint32_t head(loadHead());
+        const uint32_t tail(buffer->tail);
+
         // empty
-        if (buffer->head == buffer->tail)
+        if (head == tail)
             return false;
 
         uint8_t* const bytebuf(static_cast<uint8_t*>(buf));
 
-        const uint32_t head(buffer->head);
-        const uint32_t tail(buffer->tail);
         const uint32_t wrap((head > tail) ? 0 : buffer->size);
 
         if (size > wrap + head - tail)
@@ -580,7 +722,7 @@ protected:
                 readto = 0;
         }
 
-        buffer->tail = readto;
+        storeTail(readto);
         errorReading = false;
         return true;
     }
@@ -595,7 +737,7 @@ protected:
 
         const uint8_t* const bytebuf(static_cast<const uint8_t*>(buf));
 
-        const uint32_t tail(buffer->tail);
+        const uint32_t tail(loadTail());
         const uint32_t wrtn(buffer->wrtn);
         const uint32_t wrap((tail > wrtn) ? 0 : buffer->size);
 
@@ -643,6 +785,52 @@ private:
     /** Buffer struct pointer. */
     BufferStruct* buffer;
 
+    /** @internal load head as written by the other side, the writer only needs its own committed value. */
+    uint32_t loadHead() const noexcept
+    {
+        return d_atomicLoad(&buffer->head);
+    }
+
+    /** @internal publish written data to the reader. */
+    void storeHead(const uint32_t head) noexcept
+    {
+        d_atomicStore(&buffer->head, head);
+    }
+
+    /** @internal load tail as written by the reader, so that the space it released is really free. */
+    uint32_t loadTail() const noexcept
+    {
+        return d_atomicLoad(&buffer->tail);
+    }
+
+    /** @internal release read space back to the writer. */
+    void storeTail(const uint32_t tail) noexcept
+    {
+        d_atomicStore(&buffer->tail, tail);
+    }
+
+    /** @internal fill spans for @a size bytes starting at @a pos, returns @a size. */
+    uint32_t fillSpans(RingBufferSpans& spans, const uint32_t pos, const uint32_t size) const noexcept
+    {
+        if (size == 0)
+            return 0;
+
+        spans.data1 = buffer->buf + pos;
+
+        if (pos + size > buffer->size)
+        {
+            spans.size1 = buffer->size - pos;
+            spans.data2 = buffer->buf;
+            spans.size2 = size - spans.size1;
+        }
+        else
+        {
+            spans.size1 = size;
+        }
+
+        return size;
+    }
+
     /** Whether read errors have been printed to terminal. */
     bool errorReading;
 
@@ -656,13 +844,13 @@ private:
 template <class BufferStruct>
 inline bool RingBufferControl<BufferStruct>::isDataAvailableForReading() const noexcept
 {
-    return (buffer != nullptr && buffer->head != buffer->tail);
+    return (buffer != nullptr && loadHead() != buffer->tail);
 }
 
 template <>
 inline bool RingBufferControl<HeapBuffer>::isDataAvailableForReading() const noexcept
 {
-    return (buffer != nullptr && buffer->buf != nullptr && buffer->head != buffer->tail);
+    return (buffer != nullptr && buffer->buf != nullptr && loadHead() != buffer->tail);
 }
 
 // -----------------------------------------------------------------------
@@ -18,6 +18,7 @@
 #define DISTRHO_STRING_HPP_INCLUDED
 
 #include "../DistrhoUtils.hpp"
+#include "../extra/Base64.hpp"
 #include "../extra/ScopedSafeLocale.hpp"
 
 #include <algorithm>
@@ -27,6 +28,15 @@ START_NAMESPACE_DISTRHO
 // -----------------------------------------------------------------------
 // String class
 
+/**
+   DPF built-in String class.
+
+   Short strings are stored inline within the object itself, without any heap allocation.
+   This covers most parameter names, symbols, units and state keys.
+   Longer strings are heap-allocated, and can be moved around without copying when C++11 is available.
+
+   @see StringView
+ */
 class String
 {
 public:
@@ -228,9 +238,23 @@ public:
           fBufferLen(0),
           fBufferAlloc(false)
     {
-        _dup(str.fBuffer);
+        _dup(str.fBuffer, str.fBufferLen);
     }
 
+#ifdef DISTRHO_PROPER_CPP11_SUPPORT
+    /*
+     * Create string by taking over the contents of another string.
+     * The other string is left empty.
+     */
+    String(String&& str) noexcept
+        : fBuffer(_null()),
+          fBufferLen(0),
+          fBufferAlloc(false)
+    {
+        _move(str);
+    }
+#endif
+
     // -------------------------------------------------------------------
     // destructor
 
@@ -633,7 +657,14 @@ public:
      */
     char* getAndReleaseBuffer() noexcept
     {
-        char* ret = fBufferLen > 0 ? fBuffer : nullptr;
+        char* ret = nullptr;
+
+        if (fBufferAlloc)
+            ret = fBuffer;
+        // inline buffer can't be released, give a heap copy instead
+        else if (fBufferLen > 0 && (ret = static_cast<char*>(std::malloc(fBufferLen + 1))) != nullptr)
+            std::memcpy(ret, fBuffer, fBufferLen + 1);
+
         fBuffer = _null();
         fBufferLen = 0;
         fBufferAlloc = false;
@@ -641,82 +672,21 @@ public:
     }
 
     // -------------------------------------------------------------------
-    // base64 stuff, based on http://www.adp-gmbh.ch/cpp/common/base64.html
-    // Copyright (C) 2004-2008 René Nyffenegger
+    // base64 stuff, see Base64.hpp
 
     static String asBase64(const void* const data, const std::size_t dataSize)
     {
-        static const char* const kBase64Chars =
-            "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-            "abcdefghijklmnopqrstuvwxyz"
-            "0123456789+/";
-
-#ifndef _MSC_VER
-        const std::size_t kTmpBufSize = std::min(d_nextPowerOf2(static_cast<uint32_t>(dataSize/3)), 65536U);
-#else
-        constexpr std::size_t kTmpBufSize = 65536U;
-#endif
-
-        const uchar* bytesToEncode((const uchar*)data);
+        const std::size_t strBufSize = d_getBase64EncodedSize(dataSize);
 
-        uint i=0, j=0;
-        uint charArray3[3], charArray4[4];
+        if (strBufSize == 0)
+            return String();
 
-        char strBuf[kTmpBufSize + 1];
-        strBuf[kTmpBufSize] = '\0';
-        std::size_t strBufIndex = 0;
+        char* const strBuf = (char*)std::malloc(strBufSize + 1);
+        DISTRHO_SAFE_ASSERT_RETURN(strBuf != nullptr, String());
 
-        String ret;
+        strBuf[d_encodeBase64(data, dataSize, strBuf)] = '\0';
 
-        for (std::size_t s=0; s<dataSize; ++s)
-        {
-            charArray3[i++] = *(bytesToEncode++);
-
-            if (i == 3)
-            {
-                charArray4[0] =  (charArray3[0] & 0xfc) >> 2;
-                charArray4[1] = ((charArray3[0] & 0x03) << 4) + ((charArray3[1] & 0xf0) >> 4);
-                charArray4[2] = ((charArray3[1] & 0x0f) << 2) + ((charArray3[2] & 0xc0) >> 6);
-                charArray4[3] =   charArray3[2] & 0x3f;
-
-                for (i=0; i<4; ++i)
-                    strBuf[strBufIndex++] = kBase64Chars[charArray4[i]];
-
-                if (strBufIndex >= kTmpBufSize-7)
-                {
-                    strBuf[strBufIndex] = '\0';
-                    strBufIndex = 0;
-                    ret += strBuf;
-                }
-
-                i = 0;
-            }
-        }
-
-        if (i != 0)
-        {
-            for (j=i; j<3; ++j)
-              charArray3[j] = '\0';
-
-            charArray4[0] =  (charArray3[0] & 0xfc) >> 2;
-            charArray4[1] = ((charArray3[0] & 0x03) << 4) + ((charArray3[1] & 0xf0) >> 4);
-            charArray4[2] = ((charArray3[1] & 0x0f) << 2) + ((charArray3[2] & 0xc0) >> 6);
-            charArray4[3] =   charArray3[2] & 0x3f;
-
-            for (j=0; j<4 && i<3 && j<i+1; ++j)
-                strBuf[strBufIndex++] = kBase64Chars[charArray4[j]];
-
-            for (; i++ < 3;)
-                strBuf[strBufIndex++] = '=';
-        }
-
-        if (strBufIndex != 0)
-        {
-            strBuf[strBufIndex] = '\0';
-            ret += strBuf;
-        }
-
-        return ret;
+        return String(strBuf, false);
     }
 
     // -------------------------------------------------------------------
@@ -780,10 +750,20 @@ public:
 
     String& operator=(const String& str) noexcept
     {
-        _dup(str.fBuffer);
+        _dup(str.fBuffer, str.fBufferLen);
+
+        return *this;
+    }
+
+#ifdef DISTRHO_PROPER_CPP11_SUPPORT
+    String& operator=(String&& str) noexcept
+    {
+        if (this != &str)
+            _move(str);
 
         return *this;
     }
+#endif
 
     String& operator+=(const char* const strBuf) noexcept
     {
@@ -799,15 +779,44 @@ public:
             return *this;
         }
 
-        // we have some data ourselves, reallocate to add the new stuff
-        char* const newBuf = (char*)realloc(fBuffer, fBufferLen + strBufLen + 1);
+        const std::size_t newBufLen = fBufferLen + strBufLen;
+
+        // still fits in the inline buffer, memmove in case we are appending part of ourselves
+        if (! fBufferAlloc && newBufLen < kSmallBufferSize)
+        {
+            std::memmove(fBuffer + fBufferLen, strBuf, strBufLen + 1);
+            fBufferLen = newBufLen;
+            return *this;
+        }
+
+        // we have some heap data ourselves, reallocate to add the new stuff
+        if (fBufferAlloc)
+        {
+            // realloc might move our data, so keep track of appending part of ourselves
+            const bool appendingSelf = strBuf >= fBuffer && strBuf <= fBuffer + fBufferLen;
+            const std::size_t selfOffset = appendingSelf ? static_cast<std::size_t>(strBuf - fBuffer) : 0;
+
+            char* const newBuf = (char*)realloc(fBuffer, newBufLen + 1);
+            DISTRHO_SAFE_ASSERT_RETURN(newBuf != nullptr, *this);
+
+            std::memmove(newBuf + fBufferLen, appendingSelf ? newBuf + selfOffset : strBuf, strBufLen);
+            newBuf[newBufLen] = '\0';
+
+            fBuffer = newBuf;
+            fBufferLen = newBufLen;
+            return *this;
+        }
+
+        // moving out of the inline buffer
+        char* const newBuf = (char*)std::malloc(newBufLen + 1);
         DISTRHO_SAFE_ASSERT_RETURN(newBuf != nullptr, *this);
 
+        std::memcpy(newBuf, fBuffer, fBufferLen);
         std::memcpy(newBuf + fBufferLen, strBuf, strBufLen + 1);
 
         fBuffer = newBuf;
-        fBufferLen += strBufLen;
-
+        fBufferLen = newBufLen;
+        fBufferAlloc = true;
         return *this;
     }
 
@@ -818,20 +827,9 @@ public:
 
     String operator+(const char* const strBuf) noexcept
     {
-        if (strBuf == nullptr || strBuf[0] == '\0')
-            return *this;
-        if (isEmpty())
-            return String(strBuf);
-
-        const std::size_t strBufLen = std::strlen(strBuf);
-        const std::size_t newBufSize = fBufferLen + strBufLen;
-        char* const newBuf = (char*)malloc(newBufSize + 1);
-        DISTRHO_SAFE_ASSERT_RETURN(newBuf != nullptr, String());
-
-        std::memcpy(newBuf, fBuffer, fBufferLen);
-        std::memcpy(newBuf + fBufferLen, strBuf, strBufLen + 1);
-
-        return String(newBuf);
+        String ret(*this);
+        ret += strBuf;
+        return ret;
     }
 
     String operator+(const String& str) noexcept
@@ -842,9 +840,13 @@ public:
     // -------------------------------------------------------------------
 
 private:
+    // strings shorter than this are stored inline, sized so that String takes 48 bytes on 64-bit systems
+    static const std::size_t kSmallBufferSize = 31;
+
     char*       fBuffer;      // the actual string buffer
     std::size_t fBufferLen;   // string length
-    bool        fBufferAlloc; // wherever the buffer is allocated, not using _null()
+    bool        fBufferAlloc; // wherever the buffer is heap allocated, not using _null() or fSmallBuffer
+    char        fSmallBuffer[kSmallBufferSize]; // inline storage for short strings
 
     /*
      * Static null string.
@@ -872,35 +874,55 @@ private:
             if (std::strcmp(fBuffer, strBuf) == 0)
                 return;
 
-            if (fBufferAlloc)
-                std::free(fBuffer);
+            const std::size_t newBufLen = (size > 0) ? size : std::strlen(strBuf);
 
-            fBufferLen = (size > 0) ? size : std::strlen(strBuf);
-            fBuffer    = (char*)std::malloc(fBufferLen+1);
+            // only ever free heap data, freed after copying as strBuf might be part of ourselves
+            char* const oldBuf = fBufferAlloc ? fBuffer : nullptr;
 
-            if (fBuffer == nullptr)
+            if (newBufLen < kSmallBufferSize)
             {
+                // memmove as strBuf might be part of ourselves
+                std::memmove(fSmallBuffer, strBuf, newBufLen);
+                fSmallBuffer[newBufLen] = '\0';
+
+                std::free(oldBuf);
+
+                fBuffer      = fSmallBuffer;
+                fBufferLen   = newBufLen;
+                fBufferAlloc = false;
+                return;
+            }
+
+            char* const newBuf = (char*)std::malloc(newBufLen+1);
+
+            if (newBuf == nullptr)
+            {
+                std::free(oldBuf);
+
                 fBuffer      = _null();
                 fBufferLen   = 0;
                 fBufferAlloc = false;
                 return;
             }
 
-            fBufferAlloc = true;
+            std::memcpy(newBuf, strBuf, newBufLen);
+            newBuf[newBufLen] = '\0';
+
+            std::free(oldBuf);
 
-            std::strcpy(fBuffer, strBuf);
-            fBuffer[fBufferLen] = '\0';
+            fBuffer      = newBuf;
+            fBufferLen   = newBufLen;
+            fBufferAlloc = true;
         }
         else
         {
             DISTRHO_SAFE_ASSERT_UINT(size == 0, static_cast<uint>(size));
 
             // don't recreate null string
-            if (! fBufferAlloc)
+            if (fBuffer == _null())
                 return;
 
-            DISTRHO_SAFE_ASSERT(fBuffer != nullptr);
-            std::free(fBuffer);
+            std::free(fBufferAlloc ? fBuffer : nullptr);
 
             fBuffer      = _null();
             fBufferLen   = 0;
@@ -908,6 +930,39 @@ private:
         }
     }
 
+#ifdef DISTRHO_PROPER_CPP11_SUPPORT
+    /*
+     * Helper function.
+     * Takes over the contents of another string, leaving it empty.
+     * Heap buffers change owner, inline buffers are copied.
+     */
+    void _move(String& str) noexcept
+    {
+        std::free(fBufferAlloc ? fBuffer : nullptr);
+
+        if (str.fBufferAlloc)
+        {
+            fBuffer = str.fBuffer;
+        }
+        else if (str.fBuffer == str.fSmallBuffer)
+        {
+            std::memcpy(fSmallBuffer, str.fSmallBuffer, str.fBufferLen + 1);
+            fBuffer = fSmallBuffer;
+        }
+        else
+        {
+            fBuffer = _null();
+        }
+
+        fBufferLen   = str.fBufferLen;
+        fBufferAlloc = str.fBufferAlloc;
+
+        str.fBuffer      = _null();
+        str.fBufferLen   = 0;
+        str.fBufferAlloc = false;
+    }
+#endif
+
     DISTRHO_PREVENT_HEAP_ALLOCATION
 };
 
@@ -916,42 +971,125 @@ private:
 static inline
 String operator+(const String& strBefore, const char* const strBufAfter) noexcept
 {
-    if (strBufAfter == nullptr || strBufAfter[0] == '\0')
-        return strBefore;
-    if (strBefore.isEmpty())
-        return String(strBufAfter);
-
-    const std::size_t strBeforeLen = strBefore.length();
-    const std::size_t strBufAfterLen = std::strlen(strBufAfter);
-    const std::size_t newBufSize = strBeforeLen + strBufAfterLen;
-    char* const newBuf = (char*)malloc(newBufSize + 1);
-    DISTRHO_SAFE_ASSERT_RETURN(newBuf != nullptr, String());
-
-    std::memcpy(newBuf, strBefore.buffer(), strBeforeLen);
-    std::memcpy(newBuf + strBeforeLen, strBufAfter, strBufAfterLen + 1);
-
-    return String(newBuf, false);
+    String ret(strBefore);
+    ret += strBufAfter;
+    return ret;
 }
 
 static inline
 String operator+(const char* const strBufBefore, const String& strAfter) noexcept
 {
-    if (strAfter.isEmpty())
-        return String(strBufBefore);
-    if (strBufBefore == nullptr || strBufBefore[0] == '\0')
-        return strAfter;
+    String ret(strBufBefore);
+    ret += strAfter;
+    return ret;
+}
 
-    const std::size_t strBufBeforeLen = std::strlen(strBufBefore);
-    const std::size_t strAfterLen = strAfter.length();
-    const std::size_t newBufSize = strBufBeforeLen + strAfterLen;
-    char* const newBuf = (char*)malloc(newBufSize + 1);
-    DISTRHO_SAFE_ASSERT_RETURN(newBuf != nullptr, String());
+// -----------------------------------------------------------------------
+// StringView class
+
+/**
+   Non-owning view over some string data, meant for cheap lookups and comparisons.
+   It never allocates or copies, so the viewed data must outlive it.
+   Comparisons check the length first, so mismatching keys are usually rejected without looking at their contents.
+
+   Example usage:
+   ```
+   const StringView keyView(key);
+
+   for (uint32_t i=0; i < stateCount; ++i)
+   {
+       if (keyView == stateKeys[i])
+           return i;
+   }
+   ```
+ */
+class StringView
+{
+public:
+    /*
+     * Empty view.
+     */
+    StringView() noexcept
+        : fBuffer(""),
+          fBufferLen(0) {}
 
-    std::memcpy(newBuf, strBufBefore, strBufBeforeLen);
-    std::memcpy(newBuf + strBufBeforeLen, strAfter.buffer(), strAfterLen + 1);
+    /*
+     * View over a null-terminated char string.
+     */
+    StringView(const char* const strBuf) noexcept
+        : fBuffer(strBuf != nullptr ? strBuf : ""),
+          fBufferLen(strBuf != nullptr ? std::strlen(strBuf) : 0) {}
 
-    return String(newBuf, false);
-}
+    /*
+     * View over the first @a size characters of a char string, which does not need to be null-terminated.
+     */
+    StringView(const char* const strBuf, const std::size_t size) noexcept
+        : fBuffer(strBuf != nullptr ? strBuf : ""),
+          fBufferLen(strBuf != nullptr ? size : 0) {}
+
+    /*
+     * View over a String, reusing its already known length.
+     */
+    StringView(const String& str) noexcept
+        : fBuffer(str.buffer()),
+          fBufferLen(str.length()) {}
+
+    /*
+     * Get length of the viewed string.
+     */
+    std::size_t length() const noexcept
+    {
+        return fBufferLen;
+    }
+
+    /*
+     * Check if the viewed string is empty.
+     */
+    bool isEmpty() const noexcept
+    {
+        return (fBufferLen == 0);
+    }
+
+    /*
+     * Direct access to the viewed data.
+     * Only null-terminated if the view was created over a null-terminated string.
+     */
+    const char* data() const noexcept
+    {
+        return fBuffer;
+    }
+
+    /*
+     * Check if the viewed string starts with @a prefix.
+     */
+    bool startsWith(const StringView& prefix) const noexcept
+    {
+        return (fBufferLen >= prefix.fBufferLen && std::memcmp(fBuffer, prefix.fBuffer, prefix.fBufferLen) == 0);
+    }
+
+    bool operator==(const StringView& view) const noexcept
+    {
+        return (fBufferLen == view.fBufferLen && std::memcmp(fBuffer, view.fBuffer, fBufferLen) == 0);
+    }
+
+    bool operator!=(const StringView& view) const noexcept
+    {
+        return !operator==(view);
+    }
+
+   /*
+    * Lexicographical ordering, usable as key comparison for ordered containers.
+    */
+    bool operator<(const StringView& view) const noexcept
+    {
+        const int ret = std::memcmp(fBuffer, view.fBuffer, std::min(fBufferLen, view.fBufferLen));
+        return ret != 0 ? ret < 0 : fBufferLen < view.fBufferLen;
+    }
+
+private:
+    const char* fBuffer;
+    std::size_t fBufferLen;
+};
 
 // -----------------------------------------------------------------------
 
@@ -0,0 +1,88 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_TIME_HPP_INCLUDED
+#define DISTRHO_TIME_HPP_INCLUDED
+
+#include "../DistrhoUtils.hpp"
+
+#ifdef DISTRHO_OS_WINDOWS
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <winsock2.h>
+# include <windows.h>
+#elif defined(DISTRHO_OS_MAC)
+# include <mach/mach_time.h>
+#else
+# include <time.h>
+#endif
+
+// -----------------------------------------------------------------------
+// d_gettime_*
+
+/*
+ * Get a monotonic time value in nanoseconds.
+ * The value has no defined starting point, use it only for measuring time intervals.
+ * Safe to call from the audio thread.
+ */
+static inline
+uint64_t d_gettime_ns() noexcept
+{
+#if defined(DISTRHO_OS_WINDOWS)
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return static_cast<uint64_t>(static_cast<double>(counter.QuadPart) * 1e9 / static_cast<double>(frequency.QuadPart));
+#elif defined(DISTRHO_OS_MAC)
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if (timebase.denom == 0)
+        mach_timebase_info(&timebase);
+
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+/*
+ * Get a monotonic time value in microseconds.
+ * @see d_gettime_ns
+ */
+static inline
+uint64_t d_gettime_us() noexcept
+{
+    return d_gettime_ns() / 1000;
+}
+
+/*
+ * Get a monotonic time value in milliseconds.
+ * @see d_gettime_ns
+ */
+static inline
+uint64_t d_gettime_ms() noexcept
+{
+    return d_gettime_ns() / 1000000;
+}
+
+// -----------------------------------------------------------------------
+
+#endif // DISTRHO_TIME_HPP_INCLUDED
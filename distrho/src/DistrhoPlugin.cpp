@@ -24,6 +24,8 @@ START_NAMESPACE_DISTRHO
 uint32_t d_lastBufferSize = 0;
 double   d_lastSampleRate = 0.0;
 bool     d_lastCanRequestParameterValueChanges = false;
+bool     d_nextPluginIsDummy = false;
+bool     d_lastHostHasAlignedBlocks = false;
 
 /* ------------------------------------------------------------------------------------------------------------
  * Static fallback data, see DistrhoPluginInternal.hpp */
@@ -90,6 +92,11 @@ double Plugin::getSampleRate() const noexcept
     return pData->sampleRate;
 }
 
+bool Plugin::isDummyInstance() const noexcept
+{
+    return pData->isDummy;
+}
+
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
 const TimePosition& Plugin::getTimePosition() const noexcept
 {
@@ -123,6 +130,13 @@ bool Plugin::requestParameterValueChange(const uint32_t index, const float value
 }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+bool Plugin::writeVisualFrame(const float* const values, const uint32_t count) noexcept
+{
+    return pData->visualFrames.write(values, count);
+}
+#endif
+
 /* ------------------------------------------------------------------------------------------------------------
  * Init */
 
@@ -0,0 +1,646 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "DistrhoPluginInternal.hpp"
+
+#include "../extra/Time.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__i386__) || defined(__x86_64__)
+# include <x86intrin.h>
+# define DISTRHO_BENCH_HAS_CYCLE_COUNTER
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+# include <intrin.h>
+# define DISTRHO_BENCH_HAS_CYCLE_COUNTER
+#endif
+
+// -----------------------------------------------------------------------
+// DSP benchmark, runs the plugin through PluginExporter over a matrix of
+// block sizes, sample rates, MIDI and automation densities.
+// Results are written as JSON, one case per line, and can be compared against a previous run.
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+struct BenchCase {
+    uint32_t blockSize;
+    uint32_t sampleRate;
+    uint32_t midiDensity;       // events per second
+    uint32_t automationDensity; // parameter changes per second
+    double nsPerSample;
+    double cyclesPerSample;     // negative if not available
+};
+
+struct BenchOptions {
+    std::vector<uint32_t> blockSizes;
+    std::vector<uint32_t> sampleRates;
+    std::vector<uint32_t> midiDensities;
+    std::vector<uint32_t> automationDensities;
+    double seconds;     // amount of audio processed per measurement
+    uint32_t repeats;   // best of N measurements is reported
+};
+
+static inline
+uint64_t getCycleCount() noexcept
+{
+#ifdef DISTRHO_BENCH_HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// simple deterministic generator, so that runs are comparable
+static inline
+uint32_t nextRandom(uint32_t& seed) noexcept
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+// -----------------------------------------------------------------------
+
+class PluginBench
+{
+public:
+    PluginBench(const uint32_t maxBlockSize)
+        : fPlugin(nullptr, nullptr, nullptr),
+          fBuffers(new float[maxBlockSize * (DISTRHO_PLUGIN_NUM_INPUTS + DISTRHO_PLUGIN_NUM_OUTPUTS + 1)]),
+          fSeed(1),
+          fHeldNote(-1)
+    {
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+        {
+            fAudioIns[i] = fBuffers + maxBlockSize * i;
+
+            // some noise at -12dB
+            for (uint32_t j=0; j < maxBlockSize; ++j)
+                fAudioIns[i][j] = (static_cast<float>(nextRandom(fSeed) >> 8) / 8388608.0f - 1.0f) * 0.25f;
+        }
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            fAudioOuts[i] = fBuffers + maxBlockSize * (DISTRHO_PLUGIN_NUM_INPUTS + i);
+#endif
+
+        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        {
+            if (! fPlugin.isParameterOutput(i))
+                fAutomatableParameters.push_back(i);
+        }
+    }
+
+    ~PluginBench()
+    {
+        fPlugin.deactivateIfNeeded();
+        delete[] fBuffers;
+    }
+
+    const PluginExporter& getPlugin() const noexcept
+    {
+        return fPlugin;
+    }
+
+    bool hasAutomatableParameters() const noexcept
+    {
+        return !fAutomatableParameters.empty();
+    }
+
+    void measure(BenchCase& bcase, const BenchOptions& options)
+    {
+        fPlugin.deactivateIfNeeded();
+        // the buffer size is the maximum block size, which DPF requires to be at least 2
+        fPlugin.setBufferSize(std::max<uint32_t>(2, bcase.blockSize), true);
+        fPlugin.setSampleRate(bcase.sampleRate, true);
+        fPlugin.activate();
+        fHeldNote = -1;
+
+        const uint64_t frames = static_cast<uint64_t>(options.seconds * bcase.sampleRate);
+
+        // warm up caches and let the plugin settle
+        process(bcase, std::min<uint64_t>(frames, bcase.sampleRate / 10 + bcase.blockSize));
+
+        double bestNs = 0.0, bestCycles = 0.0;
+
+        for (uint32_t i=0; i < options.repeats; ++i)
+        {
+            const uint64_t cyclesStart = getCycleCount();
+            const uint64_t timeStart = d_gettime_ns();
+
+            const uint64_t processed = process(bcase, frames);
+
+            const uint64_t timeTaken = d_gettime_ns() - timeStart;
+            const uint64_t cyclesTaken = getCycleCount() - cyclesStart;
+
+            const double ns = static_cast<double>(timeTaken) / static_cast<double>(processed);
+            const double cycles = static_cast<double>(cyclesTaken) / static_cast<double>(processed);
+
+            if (i == 0 || ns < bestNs)
+            {
+                bestNs = ns;
+                bestCycles = cycles;
+            }
+        }
+
+        bcase.nsPerSample = bestNs;
+#ifdef DISTRHO_BENCH_HAS_CYCLE_COUNTER
+        bcase.cyclesPerSample = bestCycles;
+#else
+        bcase.cyclesPerSample = -1.0;
+        // unused
+        (void)bestCycles;
+#endif
+
+        fPlugin.deactivate();
+    }
+
+private:
+    PluginExporter fPlugin;
+
+    float* const fBuffers;
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+    float* fAudioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+    float* fAudioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEvent fMidiEvents[kMaxMidiEvents];
+#endif
+
+    std::vector<uint32_t> fAutomatableParameters;
+    uint32_t fSeed;
+
+    // note currently playing, -1 if none, so each note-on is followed by its matching note-off
+    int fHeldNote;
+
+    // returns the number of frames processed
+    uint64_t process(const BenchCase& bcase, const uint64_t frames)
+    {
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        const float** const audioIns = const_cast<const float**>(fAudioIns);
+#else
+        static const float** const audioIns = nullptr;
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        float** const audioOuts = fAudioOuts;
+#else
+        static float** const audioOuts = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        TimePosition timePosition;
+        timePosition.playing = true;
+        timePosition.bbt.valid = false;
+#endif
+
+        // fractional event accumulators, events are spread evenly over time
+        const double midiPerFrame = static_cast<double>(bcase.midiDensity) / bcase.sampleRate;
+        const double automationPerFrame = static_cast<double>(bcase.automationDensity) / bcase.sampleRate;
+        double midiPending = 0.0, automationPending = 0.0;
+        uint32_t automationIndex = 0;
+
+        uint64_t frame = 0;
+
+        for (; frame < frames; frame += bcase.blockSize)
+        {
+            automationPending += automationPerFrame * bcase.blockSize;
+
+            for (; automationPending >= 1.0 && hasAutomatableParameters(); automationPending -= 1.0)
+            {
+                const uint32_t index = fAutomatableParameters[automationIndex++ % fAutomatableParameters.size()];
+                const ParameterRanges& ranges(fPlugin.getParameterRanges(index));
+                const float normalized = static_cast<float>(nextRandom(fSeed) >> 8) / 16777216.0f;
+                fPlugin.setParameterValue(index, ranges.getUnnormalizedValue(normalized));
+            }
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+            timePosition.frame = frame;
+            fPlugin.setTimePosition(timePosition);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            midiPending += midiPerFrame * bcase.blockSize;
+
+            uint32_t midiEventCount = 0;
+
+            for (; midiPending >= 1.0 && midiEventCount < kMaxMidiEvents; midiPending -= 1.0)
+            {
+                MidiEvent& midiEvent(fMidiEvents[midiEventCount]);
+
+                midiEvent.frame = bcase.blockSize * midiEventCount / kMaxMidiEvents;
+                midiEvent.size = 3;
+
+                if (fHeldNote < 0)
+                {
+                    fHeldNote = static_cast<int>(36 + nextRandom(fSeed) % 48);
+                    midiEvent.data[0] = 0x90;
+                    midiEvent.data[2] = 100;
+                }
+                else
+                {
+                    midiEvent.data[0] = 0x80;
+                    midiEvent.data[2] = 0;
+                }
+
+                midiEvent.data[1] = static_cast<uint8_t>(fHeldNote);
+                midiEvent.data[3] = 0;
+                ++midiEventCount;
+
+                if (midiEvent.data[0] == 0x80)
+                    fHeldNote = -1;
+            }
+
+            // drop what does not fit in a single block
+            if (midiPending >= 1.0)
+                midiPending = 0.0;
+
+            fPlugin.run(audioIns, audioOuts, bcase.blockSize, fMidiEvents, midiEventCount);
+#else
+            fPlugin.run(audioIns, audioOuts, bcase.blockSize);
+            // unused
+            (void)midiPerFrame;
+            (void)midiPending;
+#endif
+        }
+
+        return frame;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(PluginBench)
+};
+
+// -----------------------------------------------------------------------
+// JSON output and baseline comparison
+
+static void writeString(FILE* const file, const char* const key, const char* str)
+{
+    std::fprintf(file, "  \"%s\": \"", key);
+
+    for (; *str != '\0'; ++str)
+    {
+        const uchar c = static_cast<uchar>(*str);
+
+        switch (c)
+        {
+        case '"':  std::fputs("\\\"", file); break;
+        case '\\': std::fputs("\\\\", file); break;
+        case '\n': std::fputs("\\n", file); break;
+        case '\r': std::fputs("\\r", file); break;
+        case '\t': std::fputs("\\t", file); break;
+        default:
+            if (c < 0x20)
+                std::fprintf(file, "\\u%04x", c);
+            else
+                std::fputc(c, file);
+            break;
+        }
+    }
+
+    std::fprintf(file, "\",\n");
+}
+
+static void writeResults(FILE* const file, const PluginExporter& plugin, const std::vector<BenchCase>& cases)
+{
+    const uint32_t version = plugin.getVersion();
+
+    std::fprintf(file, "{\n");
+    writeString(file, "plugin", plugin.getName());
+    writeString(file, "label", plugin.getLabel());
+    std::fprintf(file, "  \"version\": \"%u.%u.%u\",\n", (version >> 16) & 0xff, (version >> 8) & 0xff, version & 0xff);
+    std::fprintf(file, "  \"cycle_counter\": %s,\n",
+#ifdef DISTRHO_BENCH_HAS_CYCLE_COUNTER
+                 "true"
+#else
+                 "false"
+#endif
+                 );
+    std::fprintf(file, "  \"cases\": [\n");
+
+    for (size_t i=0; i < cases.size(); ++i)
+    {
+        const BenchCase& bcase(cases[i]);
+
+        std::fprintf(file, "    { \"block_size\": %u, \"sample_rate\": %u, \"midi_density\": %u, "
+                           "\"automation_density\": %u, \"ns_per_sample\": %.4f, \"cycles_per_sample\": ",
+                     bcase.blockSize, bcase.sampleRate, bcase.midiDensity, bcase.automationDensity,
+                     bcase.nsPerSample);
+
+        if (bcase.cyclesPerSample >= 0.0)
+            std::fprintf(file, "%.4f }", bcase.cyclesPerSample);
+        else
+            std::fprintf(file, "null }");
+
+        std::fprintf(file, i + 1 < cases.size() ? ",\n" : "\n");
+    }
+
+    std::fprintf(file, "  ]\n");
+    std::fprintf(file, "}\n");
+}
+
+// only reads files written by writeResults, one case per line
+static bool readBaseline(const char* const filename, std::vector<BenchCase>& cases)
+{
+    FILE* const file = std::fopen(filename, "r");
+
+    if (file == nullptr)
+    {
+        d_stderr("%s: cannot open baseline file", filename);
+        return false;
+    }
+
+    char line[0xff+1];
+
+    while (std::fgets(line, sizeof(line), file) != nullptr)
+    {
+        BenchCase bcase;
+
+        if (std::sscanf(line, " { \"block_size\": %u, \"sample_rate\": %u, \"midi_density\": %u, "
+                              "\"automation_density\": %u, \"ns_per_sample\": %lf",
+                        &bcase.blockSize, &bcase.sampleRate, &bcase.midiDensity, &bcase.automationDensity,
+                        &bcase.nsPerSample) != 5)
+            continue;
+
+        bcase.cyclesPerSample = -1.0;
+        cases.push_back(bcase);
+    }
+
+    std::fclose(file);
+
+    if (cases.empty())
+    {
+        d_stderr("%s: no benchmark results found", filename);
+        return false;
+    }
+
+    return true;
+}
+
+// returns the number of regressions
+static uint32_t compareResults(const std::vector<BenchCase>& baseline,
+                               const std::vector<BenchCase>& cases,
+                               const double thresholdPercent)
+{
+    uint32_t regressions = 0, compared = 0;
+    double totalRatio = 0.0;
+
+    for (size_t i=0; i < cases.size(); ++i)
+    {
+        const BenchCase& current(cases[i]);
+
+        for (size_t j=0; j < baseline.size(); ++j)
+        {
+            const BenchCase& base(baseline[j]);
+
+            if (base.blockSize != current.blockSize || base.sampleRate != current.sampleRate)
+                continue;
+            if (base.midiDensity != current.midiDensity || base.automationDensity != current.automationDensity)
+                continue;
+            if (base.nsPerSample <= 0.0)
+                break;
+
+            const double ratio = current.nsPerSample / base.nsPerSample;
+            const double change = (ratio - 1.0) * 100.0;
+
+            totalRatio += ratio;
+            ++compared;
+
+            if (change > thresholdPercent)
+            {
+                ++regressions;
+                std::fprintf(stderr, "REGRESSION block %4u, rate %6u, midi %5u/s, automation %5u/s: "
+                                     "%.3f -> %.3f ns/sample (%+.1f%%)\n",
+                             current.blockSize, current.sampleRate, current.midiDensity, current.automationDensity,
+                             base.nsPerSample, current.nsPerSample, change);
+            }
+            break;
+        }
+    }
+
+    if (compared != 0)
+        std::fprintf(stderr, "Compared %u cases against baseline, average change %+.1f%%, %u regressions above %.1f%%\n",
+                     compared, (totalRatio / compared - 1.0) * 100.0, regressions, thresholdPercent);
+    else
+        std::fprintf(stderr, "No matching cases found in baseline\n");
+
+    return regressions;
+}
+
+// -----------------------------------------------------------------------
+
+static bool parseList(const char* const arg, std::vector<uint32_t>& list)
+{
+    list.clear();
+
+    for (const char* s = arg; *s != '\0';)
+    {
+        char* end;
+        const long value = std::strtol(s, &end, 10);
+
+        if (end == s || value < 0)
+            return false;
+
+        list.push_back(static_cast<uint32_t>(value));
+
+        s = end;
+        if (*s == ',')
+            ++s;
+    }
+
+    return !list.empty();
+}
+
+static void printHelp(const char* const name)
+{
+    d_stdout("usage: %s [options]\n"
+             "\n"
+             "Measure DSP performance of " DISTRHO_PLUGIN_NAME " over a matrix of processing conditions.\n"
+             "\n"
+             "options:\n"
+             "  --block-sizes LIST       comma-separated block sizes, defaults to powers of 2 from 1 to 4096\n"
+             "  --sample-rates LIST      comma-separated sample rates, defaults to 44100,48000,96000\n"
+             "  --midi-densities LIST    MIDI events per second, defaults to 0,1000 (MIDI plugins only)\n"
+             "  --automation LIST        parameter changes per second, defaults to 0,1000 (if plugin has parameters)\n"
+             "  --seconds N              seconds of audio processed per measurement, defaults to 1\n"
+             "  --repeats N              report the best of N measurements, defaults to 3\n"
+             "  --output FILE            write JSON results to FILE instead of stdout\n"
+             "  --baseline FILE          compare results against a previous JSON output\n"
+             "  --threshold PERCENT      slowdown reported as regression, defaults to 5\n"
+             "  -h, --help               show this help and quit\n"
+             "\n"
+             "Returns 2 when regressions against the baseline are found.", name);
+}
+
+END_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    USE_NAMESPACE_DISTRHO;
+
+    BenchOptions options;
+    options.seconds = 1.0;
+    options.repeats = 3;
+
+    for (uint32_t blockSize = 1; blockSize <= 4096; blockSize *= 2)
+        options.blockSizes.push_back(blockSize);
+
+    options.sampleRates.push_back(44100);
+    options.sampleRates.push_back(48000);
+    options.sampleRates.push_back(96000);
+
+    options.midiDensities.push_back(0);
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    options.midiDensities.push_back(1000);
+#endif
+
+    options.automationDensities.push_back(0);
+    options.automationDensities.push_back(1000);
+
+    const char* outputFile = nullptr;
+    const char* baselineFile = nullptr;
+    double threshold = 5.0;
+
+    for (int i=1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        bool ok = true;
+
+        if (std::strcmp(arg, "--block-sizes") == 0 && i+1 < argc)
+            ok = parseList(argv[++i], options.blockSizes);
+        else if (std::strcmp(arg, "--sample-rates") == 0 && i+1 < argc)
+            ok = parseList(argv[++i], options.sampleRates);
+        else if (std::strcmp(arg, "--midi-densities") == 0 && i+1 < argc)
+            ok = parseList(argv[++i], options.midiDensities);
+        else if (std::strcmp(arg, "--automation") == 0 && i+1 < argc)
+            ok = parseList(argv[++i], options.automationDensities);
+        else if (std::strcmp(arg, "--seconds") == 0 && i+1 < argc)
+            ok = (options.seconds = std::atof(argv[++i])) > 0.0;
+        else if (std::strcmp(arg, "--repeats") == 0 && i+1 < argc)
+            ok = (options.repeats = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])))) > 0;
+        else if (std::strcmp(arg, "--output") == 0 && i+1 < argc)
+            outputFile = argv[++i];
+        else if (std::strcmp(arg, "--baseline") == 0 && i+1 < argc)
+            baselineFile = argv[++i];
+        else if (std::strcmp(arg, "--threshold") == 0 && i+1 < argc)
+            threshold = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0)
+        {
+            printHelp(argv[0]);
+            return 0;
+        }
+        else
+            ok = false;
+
+        if (! ok)
+        {
+            d_stderr("Invalid or incomplete argument '%s'", arg);
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    for (size_t i=0; i < options.blockSizes.size(); ++i)
+    {
+        if (options.blockSizes[i] == 0)
+        {
+            d_stderr("Invalid block size 0");
+            return 1;
+        }
+    }
+
+    for (size_t i=0; i < options.sampleRates.size(); ++i)
+    {
+        if (options.sampleRates[i] == 0)
+        {
+            d_stderr("Invalid sample rate 0");
+            return 1;
+        }
+    }
+
+    std::vector<BenchCase> baseline;
+
+    if (baselineFile != nullptr && ! readBaseline(baselineFile, baseline))
+        return 1;
+
+    const uint32_t maxBlockSize = *std::max_element(options.blockSizes.begin(), options.blockSizes.end());
+
+    // the plugin takes its initial values from these globals
+    d_lastBufferSize = maxBlockSize;
+    d_lastSampleRate = options.sampleRates[0];
+
+    PluginBench* const bench = new PluginBench(maxBlockSize);
+
+    if (! bench->hasAutomatableParameters())
+    {
+        options.automationDensities.clear();
+        options.automationDensities.push_back(0);
+    }
+
+#if ! DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    options.midiDensities.clear();
+    options.midiDensities.push_back(0);
+#endif
+
+    std::vector<BenchCase> cases;
+
+    for (size_t r=0; r < options.sampleRates.size(); ++r)
+    for (size_t b=0; b < options.blockSizes.size(); ++b)
+    for (size_t m=0; m < options.midiDensities.size(); ++m)
+    for (size_t a=0; a < options.automationDensities.size(); ++a)
+    {
+        BenchCase bcase;
+        bcase.blockSize = options.blockSizes[b];
+        bcase.sampleRate = options.sampleRates[r];
+        bcase.midiDensity = options.midiDensities[m];
+        bcase.automationDensity = options.automationDensities[a];
+
+        bench->measure(bcase, options);
+        cases.push_back(bcase);
+
+        std::fprintf(stderr, "block %4u, rate %6u, midi %5u/s, automation %5u/s: %8.3f ns/sample\n",
+                     bcase.blockSize, bcase.sampleRate, bcase.midiDensity, bcase.automationDensity,
+                     bcase.nsPerSample);
+    }
+
+    FILE* const file = outputFile != nullptr ? std::fopen(outputFile, "w") : stdout;
+
+    if (file == nullptr)
+    {
+        d_stderr("%s: cannot open output file", outputFile);
+        delete bench;
+        return 1;
+    }
+
+    writeResults(file, bench->getPlugin(), cases);
+
+    if (file != stdout)
+        std::fclose(file);
+
+    delete bench;
+
+    if (! baseline.empty() && compareResults(baseline, cases, threshold) != 0)
+        return 2;
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
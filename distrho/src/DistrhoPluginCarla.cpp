@@ -53,16 +53,24 @@ class UICarla
 public:
     UICarla(const NativeHostDescriptor* const host, PluginExporter* const plugin)
         : fHost(host),
+          fPlugin(plugin),
           fUI(this, 0, editParameterCallback, setParameterCallback, setStateCallback, sendNoteCallback, setSizeCallback, plugin->getInstancePointer())
     {
         fUI.setWindowTitle(host->uiName);
 
         if (host->uiParentId != 0)
             fUI.setWindowTransientWinId(host->uiParentId);
+
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        fPlugin->attachVisualStream();
+#endif
     }
 
     ~UICarla()
     {
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        fPlugin->detachVisualStream();
+#endif
         fUI.quit();
     }
 
@@ -75,6 +83,12 @@ public:
 
     bool carla_idle()
     {
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        uint32_t visualFrameCount;
+        while (const float* const visualFrame = fPlugin->readVisualFrame(visualFrameCount))
+            fUI.visualFrameReceived(visualFrame, visualFrameCount);
+#endif
+
         return fUI.idle();
     }
 
@@ -139,6 +153,7 @@ protected:
 private:
     // Plugin stuff
     const NativeHostDescriptor* const fHost;
+    PluginExporter* const fPlugin;
 
     // UI
     UIExporter fUI;
@@ -369,26 +384,19 @@ protected:
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
     void process(float** const inBuffer, float** const outBuffer, const uint32_t frames, const NativeMidiEvent* const midiEvents, const uint32_t midiEventCount) override
     {
-        MidiEvent realMidiEvents[midiEventCount];
+        fMidiEvents.clear();
 
         for (uint32_t i=0; i < midiEventCount; ++i)
         {
             const NativeMidiEvent& midiEvent(midiEvents[i]);
-            MidiEvent& realMidiEvent(realMidiEvents[i]);
 
-            realMidiEvent.frame = midiEvent.time;
-            realMidiEvent.size  = midiEvent.size;
-
-            uint8_t j=0;
-            for (; j<midiEvent.size; ++j)
-                realMidiEvent.data[j] = midiEvent.data[j];
-            for (; j<midiEvent.size; ++j)
-                realMidiEvent.data[j] = midiEvent.data[j];
-
-            realMidiEvent.dataExt = nullptr;
+            if (midiEvent.size > MidiEvent::kDataSize)
+                continue;
+            if (! fMidiEvents.appendFixed(midiEvent.time, midiEvent.data, midiEvent.size))
+                break;
         }
 
-        fPlugin.run(const_cast<const float**>(inBuffer), outBuffer, frames, realMidiEvents, midiEventCount);
+        fPlugin.run(const_cast<const float**>(inBuffer), outBuffer, frames, fMidiEvents.events, fMidiEvents.count);
     }
 #else
     void process(float** const inBuffer, float** const outBuffer, const uint32_t frames, const NativeMidiEvent* const, const uint32_t) override
@@ -490,6 +498,9 @@ protected:
 private:
     PluginExporter fPlugin;
     mutable NativeParameterScalePoint* fScalePointsCache;
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEventList fMidiEvents;
+#endif
 
 #if DISTRHO_PLUGIN_HAS_UI
     // UI
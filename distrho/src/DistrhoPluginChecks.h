@@ -41,6 +41,10 @@
 // -----------------------------------------------------------------------
 // Define optional macros if not done yet
 
+#ifndef DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+# define DISTRHO_PLUGIN_FIXED_BLOCK_SIZE 0
+#endif
+
 #ifndef DISTRHO_PLUGIN_HAS_UI
 # define DISTRHO_PLUGIN_HAS_UI 0
 #endif
@@ -61,10 +65,6 @@
 # define DISTRHO_PLUGIN_WANT_DIRECT_ACCESS 0
 #endif
 
-#ifndef DISTRHO_PLUGIN_WANT_LATENCY
-# define DISTRHO_PLUGIN_WANT_LATENCY 0
-#endif
-
 #ifndef DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
 # define DISTRHO_PLUGIN_WANT_MIDI_OUTPUT 0
 #endif
@@ -93,6 +93,10 @@
 # define DISTRHO_PLUGIN_WANT_TIMEPOS 0
 #endif
 
+#ifndef DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+# define DISTRHO_PLUGIN_WANT_VISUAL_STREAM 0
+#endif
+
 #ifndef DISTRHO_UI_USER_RESIZABLE
 # define DISTRHO_UI_USER_RESIZABLE 0
 #endif
@@ -135,6 +139,23 @@
 # error Synths need MIDI input to work!
 #endif
 
+// -----------------------------------------------------------------------
+// Enable latency if plugin runs in fixed blocks, test if latency disabled when fixed blocks are used
+
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE == 1
+# error Fixed block size must be at least 2 frames!
+#endif
+
+#ifndef DISTRHO_PLUGIN_WANT_LATENCY
+# if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE != 0
+#  define DISTRHO_PLUGIN_WANT_LATENCY 1
+# else
+#  define DISTRHO_PLUGIN_WANT_LATENCY 0
+# endif
+#elif DISTRHO_PLUGIN_FIXED_BLOCK_SIZE != 0 && ! DISTRHO_PLUGIN_WANT_LATENCY
+# error Fixed block size processing needs latency reporting to work!
+#endif
+
 // -----------------------------------------------------------------------
 // Enable state if plugin wants state files
 
@@ -166,6 +187,16 @@
 # define DISTRHO_PLUGIN_HAS_UI 0
 #endif
 
+// -----------------------------------------------------------------------
+// Disable UI for DSP-only standalone builds
+
+#if DISTRHO_PLUGIN_HAS_UI && (defined(DISTRHO_PLUGIN_TARGET_JACK_DSP) || \
+                              defined(DISTRHO_PLUGIN_TARGET_RENDER) || \
+                              defined(DISTRHO_PLUGIN_TARGET_BENCH))
+# undef DISTRHO_PLUGIN_HAS_UI
+# define DISTRHO_PLUGIN_HAS_UI 0
+#endif
+
 // -----------------------------------------------------------------------
 // Prevent users from messing about with DPF internals
 
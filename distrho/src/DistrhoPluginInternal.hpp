@@ -19,6 +19,11 @@
 
 #include "../DistrhoPlugin.hpp"
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+# include "../extra/Atomic.hpp"
+# include "../extra/RingBuffer.hpp"
+#endif
+
 #include <set>
 
 START_NAMESPACE_DISTRHO
@@ -28,12 +33,210 @@ START_NAMESPACE_DISTRHO
 
 static const uint32_t kMaxMidiEvents = 512;
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+static const uint32_t kVisualFrameQueueSize = 4 * (1 + kMaxVisualFrameSize) * sizeof(float);
+#endif
+
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+static const uint32_t kFixedBlockSize = DISTRHO_PLUGIN_FIXED_BLOCK_SIZE;
+static const uint32_t kFixedBlockMidiDataSize = 4096;
+#endif
+
+// -----------------------------------------------------------------------
+// MIDI input events, as passed to Plugin::run()
+
+/**
+   Packed list of incoming MIDI events, shared by all plugin wrappers.
+
+   None of the host event layouts match MidiEvent, so each host event is packed once into this fixed-size list,
+   which the plugin then reads directly. No other copy happens between the host and the plugin.
+   Messages longer than MidiEvent::kDataSize are not copied at all, they keep pointing to host memory
+   which stays valid until the current run() call returns.
+
+   Events past kMaxMidiEvents are dropped.
+ */
+struct MidiEventList {
+    MidiEvent events[kMaxMidiEvents];
+    uint32_t  count;
+
+    MidiEventList() noexcept
+        : count(0) {}
+
+    void clear() noexcept
+    {
+        count = 0;
+    }
+
+    bool isFull() const noexcept
+    {
+        return count >= kMaxMidiEvents;
+    }
+
+   /**
+      Append an event whose source always has MidiEvent::kDataSize readable bytes.
+      The data is copied in one go regardless of @a size, use for hosts with fixed-size short messages.
+    */
+    bool appendFixed(const uint32_t frame, const void* const data, const uint32_t size) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(size <= MidiEvent::kDataSize, false);
+
+        if (count >= kMaxMidiEvents)
+            return false;
+
+        MidiEvent& midiEvent(events[count++]);
+        midiEvent.frame   = frame;
+        midiEvent.size    = size;
+        midiEvent.dataExt = nullptr;
+        std::memcpy(midiEvent.data, data, MidiEvent::kDataSize);
+        return true;
+    }
+
+   /**
+      Append a variable-sized event.
+      Long messages are referenced instead of copied, so @a data must outlive the next run() call.
+    */
+    bool append(const uint32_t frame, const uint8_t* const data, const uint32_t size) noexcept
+    {
+        if (count >= kMaxMidiEvents)
+            return false;
+
+        MidiEvent& midiEvent(events[count++]);
+        midiEvent.frame = frame;
+        midiEvent.size  = size;
+
+        if (size > MidiEvent::kDataSize)
+        {
+            midiEvent.dataExt = data;
+            std::memset(midiEvent.data, 0, MidiEvent::kDataSize);
+        }
+        else
+        {
+            midiEvent.dataExt = nullptr;
+            std::memcpy(midiEvent.data, data, size);
+        }
+
+        return true;
+    }
+};
+
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+// -----------------------------------------------------------------------
+// Visualization frames, from Plugin::writeVisualFrame() to UI::visualFrameReceived()
+
+/**
+   Queue of visualization frames, with a single writer (the plugin, in the audio thread)
+   and a single reader (the plugin wrapper, on behalf of the UI).
+
+   Frames are stored as a value count followed by the values.
+   Nothing is queued until a reader attaches, which wrappers do when their UI is created and undo when it is destroyed,
+   so frames written while there is no UI are dropped right away instead of going stale.
+   The ring buffer is only allocated on first use, dummy and headless instances never allocate it.
+   The writer never blocks, allocates or logs, frames that do not fit are dropped.
+ */
+struct VisualFrameQueue {
+    HeapRingBuffer ring;
+    float values[kMaxVisualFrameSize];
+    bool attached;
+    bool allocated;
+
+    VisualFrameQueue() noexcept
+        : ring(),
+          attached(false),
+          allocated(false) {}
+
+   /**
+      Allocate the ring buffer ahead of attach(), for readers that attach from the audio thread.
+      Must not be called while attached.
+    */
+    bool allocate() noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(! isAttached(), allocated);
+
+        if (! allocated)
+            allocated = ring.createBuffer(kVisualFrameQueueSize);
+
+        return allocated;
+    }
+
+   /**
+      Start queueing frames, discarding any left over from a previous reader.
+      This only allocates if allocate() was not called before.
+    */
+    void attach() noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(! isAttached(),);
+
+        if (allocated)
+        {
+            uint32_t count;
+            while (read(count) != nullptr) {}
+        }
+        else
+        {
+            allocated = ring.createBuffer(kVisualFrameQueueSize);
+            DISTRHO_SAFE_ASSERT_RETURN(allocated,);
+        }
+
+        // publishes the ring buffer to the writer
+        d_atomicStore(&attached, true);
+    }
+
+   /**
+      Stop queueing frames.
+      The ring buffer is kept, as the writer might still be using it.
+    */
+    void detach() noexcept
+    {
+        d_atomicStore(&attached, false);
+    }
+
+    bool isAttached() const noexcept
+    {
+        return d_atomicLoad(&attached);
+    }
+
+    bool write(const float* const frame, const uint32_t count) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(frame != nullptr, false);
+        DISTRHO_SAFE_ASSERT_UINT_RETURN(count != 0 && count <= kMaxVisualFrameSize, count, false);
+
+        if (! isAttached())
+            return false;
+
+        // check for space first, so a full ring does not get reported from the audio thread
+        if (sizeof(uint32_t) + count * sizeof(float) >= ring.getAvailableDataSize())
+            return false;
+
+        ring.writeUInt(count);
+        ring.writeCustomData(frame, count * sizeof(float));
+        return ring.commitWrite();
+    }
+
+   /**
+      Read the next frame, if any.
+      The returned values are valid until the next read.
+    */
+    const float* read(uint32_t& count) noexcept
+    {
+        if (! ring.isDataAvailableForReading())
+            return nullptr;
+
+        count = ring.readUInt();
+        DISTRHO_SAFE_ASSERT_UINT_RETURN(count != 0 && count <= kMaxVisualFrameSize, count, nullptr);
+
+        return ring.readCustomData(values, count * sizeof(float)) ? values : nullptr;
+    }
+};
+#endif
+
 // -----------------------------------------------------------------------
 // Static data, see DistrhoPlugin.cpp
 
 extern uint32_t d_lastBufferSize;
 extern double   d_lastSampleRate;
 extern bool     d_lastCanRequestParameterValueChanges;
+extern bool     d_nextPluginIsDummy;
+extern bool     d_lastHostHasAlignedBlocks;
 
 // -----------------------------------------------------------------------
 // DSP callbacks
@@ -107,6 +310,10 @@ struct Plugin::PrivateData {
     TimePosition timePosition;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+    VisualFrameQueue visualFrames;
+#endif
+
     // Callbacks
     void*         callbacksPtr;
     writeMidiFunc writeMidiCallbackFunc;
@@ -115,6 +322,7 @@ struct Plugin::PrivateData {
     uint32_t bufferSize;
     double   sampleRate;
     bool     canRequestParameterValueChanges;
+    bool     isDummy;
 
     PrivateData() noexcept
         : isProcessing(false),
@@ -141,9 +349,14 @@ struct Plugin::PrivateData {
           callbacksPtr(nullptr),
           writeMidiCallbackFunc(nullptr),
           requestParameterValueChangeCallbackFunc(nullptr),
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+          bufferSize(kFixedBlockSize),
+#else
           bufferSize(d_lastBufferSize),
+#endif
           sampleRate(d_lastSampleRate),
-          canRequestParameterValueChanges(d_lastCanRequestParameterValueChanges)
+          canRequestParameterValueChanges(d_lastCanRequestParameterValueChanges),
+          isDummy(d_nextPluginIsDummy)
     {
         DISTRHO_SAFE_ASSERT(bufferSize != 0);
         DISTRHO_SAFE_ASSERT(d_isNotZero(sampleRate));
@@ -159,7 +372,7 @@ struct Plugin::PrivateData {
 # if (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || DISTRHO_PLUGIN_WANT_STATE)
         parameterOffset += 1;
 # endif
-# if (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || DISTRHO_PLUGIN_WANT_STATE)
+# if (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || DISTRHO_PLUGIN_WANT_STATE || (DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI))
         parameterOffset += 1;
 # endif
 #endif
@@ -243,10 +456,37 @@ public:
         : fPlugin(createPlugin()),
           fData((fPlugin != nullptr) ? fPlugin->pData : nullptr),
           fIsActive(false)
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        , fFixedBlockAligned(d_lastHostHasAlignedBlocks),
+          fFixedBlockPos(0),
+          fFixedBlockBuffer(nullptr)
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        , fFixedBlockMidiEvents(),
+          fFixedBlockMidiDataUsed(0)
+# endif
+#endif
     {
         DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
         DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
 
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        // dummy instances never run, no need for buffers
+        if (! fData->isDummy)
+        {
+            fFixedBlockBuffer = new float[kFixedBlockSize * kFixedBlockChannels];
+            std::memset(fFixedBlockBuffer, 0, sizeof(float) * kFixedBlockSize * kFixedBlockChannels);
+
+# if DISTRHO_PLUGIN_NUM_INPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+                fFixedBlockInputs[i] = fFixedBlockBuffer + kFixedBlockSize * i;
+# endif
+# if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+                fFixedBlockOutputs[i] = fFixedBlockBuffer + kFixedBlockSize * (DISTRHO_PLUGIN_NUM_INPUTS + i);
+# endif
+        }
+#endif
+
 #if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
         {
             uint32_t j=0;
@@ -313,6 +553,9 @@ public:
     ~PluginExporter()
     {
         delete fPlugin;
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        delete[] fFixedBlockBuffer;
+#endif
     }
 
     // -------------------------------------------------------------------
@@ -385,6 +628,10 @@ public:
     {
         DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, 0);
 
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        if (! fFixedBlockAligned)
+            return fData->latency + kFixedBlockSize;
+#endif
         return fData->latency;
     }
 #endif
@@ -674,6 +921,39 @@ public:
     }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+    // -------------------------------------------------------------------
+    // Visualization frames, read by wrappers on behalf of the UI
+
+    bool allocateVisualStream() noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, false);
+
+        return fData->visualFrames.allocate();
+    }
+
+    void attachVisualStream() noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+        fData->visualFrames.attach();
+    }
+
+    void detachVisualStream() noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+        fData->visualFrames.detach();
+    }
+
+    const float* readVisualFrame(uint32_t& count) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, nullptr);
+
+        return fData->visualFrames.read(count);
+    }
+#endif
+
     // -------------------------------------------------------------------
 
     bool isActive() const noexcept
@@ -687,6 +967,9 @@ public:
         DISTRHO_SAFE_ASSERT_RETURN(! fIsActive,);
 
         fIsActive = true;
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        resetFixedBlock();
+#endif
         fPlugin->activate();
     }
 
@@ -720,11 +1003,18 @@ public:
         if (! fIsActive)
         {
             fIsActive = true;
+# if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+            resetFixedBlock();
+# endif
             fPlugin->activate();
         }
 
         fData->isProcessing = true;
+# if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        runFixedBlock(inputs, outputs, frames, midiEvents, midiEventCount);
+# else
         fPlugin->run(inputs, outputs, frames, midiEvents, midiEventCount);
+# endif
         fData->isProcessing = false;
     }
 #else
@@ -736,11 +1026,18 @@ public:
         if (! fIsActive)
         {
             fIsActive = true;
+# if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+            resetFixedBlock();
+# endif
             fPlugin->activate();
         }
 
         fData->isProcessing = true;
+# if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        runFixedBlock(inputs, outputs, frames);
+# else
         fPlugin->run(inputs, outputs, frames);
+# endif
         fData->isProcessing = false;
     }
 #endif
@@ -765,6 +1062,12 @@ public:
         DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
         DISTRHO_SAFE_ASSERT(bufferSize >= 2);
 
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        // plugin always runs with kFixedBlockSize, host block size does not matter
+        (void)doCallback;
+        return;
+#endif
+
         if (fData->bufferSize == bufferSize)
             return;
 
@@ -805,6 +1108,160 @@ private:
     Plugin::PrivateData* const fData;
     bool fIsActive;
 
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+    // -------------------------------------------------------------------
+    // Fixed block size processing
+
+    static const uint32_t kFixedBlockChannels = DISTRHO_PLUGIN_NUM_INPUTS + DISTRHO_PLUGIN_NUM_OUTPUTS;
+
+    // host blocks are always a multiple of kFixedBlockSize, slice them directly without latency
+    bool       fFixedBlockAligned;
+    uint32_t   fFixedBlockPos;
+    float*     fFixedBlockBuffer;
+    const float* fFixedBlockInputs[DISTRHO_PLUGIN_NUM_INPUTS > 0 ? DISTRHO_PLUGIN_NUM_INPUTS : 1];
+    float*       fFixedBlockOutputs[DISTRHO_PLUGIN_NUM_OUTPUTS > 0 ? DISTRHO_PLUGIN_NUM_OUTPUTS : 1];
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEventList fFixedBlockMidiEvents;
+    uint8_t       fFixedBlockMidiData[kFixedBlockMidiDataSize];
+    uint32_t      fFixedBlockMidiDataUsed;
+# endif
+
+    void resetFixedBlock() noexcept
+    {
+        fFixedBlockPos = 0;
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        fFixedBlockMidiEvents.clear();
+        fFixedBlockMidiDataUsed = 0;
+# endif
+
+        if (fFixedBlockBuffer != nullptr)
+            std::memset(fFixedBlockBuffer, 0, sizeof(float) * kFixedBlockSize * kFixedBlockChannels);
+    }
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // move host events within [offset, offset+frames) into the pending list, at block position pos
+    void queueFixedBlockMidiEvents(const MidiEvent* const midiEvents, const uint32_t midiEventCount,
+                                   uint32_t& midiEventIndex, const uint32_t offset, const uint32_t frames,
+                                   const bool isLastChunk, const uint32_t pos) noexcept
+    {
+        for (; midiEventIndex < midiEventCount; ++midiEventIndex)
+        {
+            const MidiEvent& midiEvent(midiEvents[midiEventIndex]);
+
+            // events past the end of the host block go into the last chunk
+            if (midiEvent.frame >= offset + frames && ! isLastChunk)
+                break;
+
+            const uint32_t frame = pos + std::min(midiEvent.frame - std::min(midiEvent.frame, offset), frames - 1);
+
+            if (midiEvent.size <= MidiEvent::kDataSize)
+            {
+                fFixedBlockMidiEvents.appendFixed(frame, midiEvent.data, midiEvent.size);
+            }
+            else if (fFixedBlockAligned)
+            {
+                // host memory is still valid during this run
+                fFixedBlockMidiEvents.append(frame, midiEvent.dataExt, midiEvent.size);
+            }
+            else if (fFixedBlockMidiDataUsed + midiEvent.size <= kFixedBlockMidiDataSize)
+            {
+                // host memory is gone by the time the block is complete, keep a copy
+                uint8_t* const data = fFixedBlockMidiData + fFixedBlockMidiDataUsed;
+                std::memcpy(data, midiEvent.dataExt, midiEvent.size);
+                fFixedBlockMidiDataUsed += midiEvent.size;
+                fFixedBlockMidiEvents.append(frame, data, midiEvent.size);
+            }
+        }
+    }
+# endif
+
+    void runFixedBlock(const float** const inputs, float** const outputs, const uint32_t frames
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                     , const MidiEvent* const midiEvents, const uint32_t midiEventCount
+# endif
+                       )
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fFixedBlockBuffer != nullptr,);
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        uint32_t midiEventIndex = 0;
+# endif
+
+        // a misbehaving host sent a block that cannot be sliced, buffer from now on.
+        // this adds latency, which wrappers report to the host the same way as Plugin::setLatency()
+        if (fFixedBlockAligned && (frames % kFixedBlockSize) != 0)
+        {
+            fFixedBlockAligned = false;
+            resetFixedBlock();
+        }
+
+        for (uint32_t offset = 0; offset < frames;)
+        {
+            if (fFixedBlockAligned)
+            {
+                const uint32_t todo = kFixedBlockSize;
+
+                const float* ins[DISTRHO_PLUGIN_NUM_INPUTS > 0 ? DISTRHO_PLUGIN_NUM_INPUTS : 1];
+                float* outs[DISTRHO_PLUGIN_NUM_OUTPUTS > 0 ? DISTRHO_PLUGIN_NUM_OUTPUTS : 1];
+
+# if DISTRHO_PLUGIN_NUM_INPUTS > 0
+                for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+                    ins[i] = inputs[i] + offset;
+# endif
+# if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+                for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+                    outs[i] = outputs[i] + offset;
+# endif
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                fFixedBlockMidiEvents.clear();
+                queueFixedBlockMidiEvents(midiEvents, midiEventCount, midiEventIndex,
+                                          offset, todo, offset + todo == frames, 0);
+                fPlugin->run(ins, outs, todo, fFixedBlockMidiEvents.events, fFixedBlockMidiEvents.count);
+# else
+                fPlugin->run(ins, outs, todo);
+# endif
+                offset += todo;
+                continue;
+            }
+
+            const uint32_t pos = fFixedBlockPos;
+            const uint32_t todo = std::min(frames - offset, kFixedBlockSize - pos);
+
+            // inputs first, host buffers might be used in-place
+# if DISTRHO_PLUGIN_NUM_INPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+                std::memcpy(fFixedBlockBuffer + kFixedBlockSize * i + pos, inputs[i] + offset, sizeof(float) * todo);
+# endif
+# if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+                std::memcpy(outputs[i] + offset, fFixedBlockOutputs[i] + pos, sizeof(float) * todo);
+# endif
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            queueFixedBlockMidiEvents(midiEvents, midiEventCount, midiEventIndex,
+                                      offset, todo, offset + todo == frames, pos);
+# endif
+
+            offset += todo;
+            fFixedBlockPos += todo;
+
+            if (fFixedBlockPos == kFixedBlockSize)
+            {
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                fPlugin->run(fFixedBlockInputs, fFixedBlockOutputs, kFixedBlockSize,
+                             fFixedBlockMidiEvents.events, fFixedBlockMidiEvents.count);
+                fFixedBlockMidiEvents.clear();
+                fFixedBlockMidiDataUsed = 0;
+# else
+                fPlugin->run(fFixedBlockInputs, fFixedBlockOutputs, kFixedBlockSize);
+# endif
+                fFixedBlockPos = 0;
+            }
+        }
+    }
+#endif
+
     // -------------------------------------------------------------------
     // Static fallback data, see DistrhoPlugin.cpp
 
@@ -19,17 +19,28 @@
 #if DISTRHO_PLUGIN_HAS_UI
 # include "DistrhoUIInternal.hpp"
 # include "../extra/RingBuffer.hpp"
-#else
-# include "../extra/Sleep.hpp"
 #endif
 
+#include "../extra/ScopedPointer.hpp"
+#include "../extra/Sleep.hpp"
+#include "../extra/Thread.hpp"
+#include "../extra/Time.hpp"
+
 #include "jackbridge/JackBridge.cpp"
 #include "lv2/lv2.h"
 
 #ifndef DISTRHO_OS_WINDOWS
+# include <fcntl.h>
+# include <poll.h>
 # include <signal.h>
+# include <unistd.h>
+# include <sys/socket.h>
+# include <sys/stat.h>
+# include <sys/un.h>
 #endif
 
+#include <time.h>
+
 #ifndef JACK_METADATA_ORDER
 # define JACK_METADATA_ORDER "http://jackaudio.org/metadata/order"
 #endif
@@ -66,13 +77,31 @@ static const requestParameterValueChangeFunc requestParameterValueChangeCallback
 // -----------------------------------------------------------------------
 
 static volatile bool gCloseSignalReceived = false;
+static volatile uint32_t gXrunCount = 0;
+
+static int jackXrunCallback(void*)
+{
+    __atomic_add_fetch(&gXrunCount, 1, __ATOMIC_RELAXED);
+    return 0;
+}
 
 #ifdef DISTRHO_OS_WINDOWS
+// event used to wake up the main thread when running headless
+static HANDLE gCloseEvent = nullptr;
+
+static void triggerCloseSignal() noexcept
+{
+    gCloseSignalReceived = true;
+
+    if (gCloseEvent != nullptr)
+        SetEvent(gCloseEvent);
+}
+
 static BOOL WINAPI winSignalHandler(DWORD dwCtrlType) noexcept
 {
     if (dwCtrlType == CTRL_C_EVENT)
     {
-        gCloseSignalReceived = true;
+        triggerCloseSignal();
         return TRUE;
     }
     return FALSE;
@@ -80,16 +109,44 @@ static BOOL WINAPI winSignalHandler(DWORD dwCtrlType) noexcept
 
 static void initSignalHandler()
 {
+    gCloseEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
     SetConsoleCtrlHandler(winSignalHandler, TRUE);
 }
 #else
-static void closeSignalHandler(int) noexcept
+// self-pipe used to wake up the main thread when running headless, written from the signal handler
+static int gClosePipe[2] = { -1, -1 };
+
+static void triggerCloseSignal() noexcept
 {
     gCloseSignalReceived = true;
+
+    if (gClosePipe[1] != -1)
+    {
+        const char c = 0;
+        if (::write(gClosePipe[1], &c, 1) != 1) {}
+    }
+}
+
+static void closeSignalHandler(int) noexcept
+{
+    triggerCloseSignal();
 }
 
 static void initSignalHandler()
 {
+    if (::pipe(gClosePipe) == 0)
+    {
+        for (int i=0; i<2; ++i)
+        {
+            ::fcntl(gClosePipe[i], F_SETFD, FD_CLOEXEC);
+            ::fcntl(gClosePipe[i], F_SETFL, ::fcntl(gClosePipe[i], F_GETFL) | O_NONBLOCK);
+        }
+    }
+    else
+    {
+        gClosePipe[0] = gClosePipe[1] = -1;
+    }
+
     struct sigaction sig;
     memset(&sig, 0, sizeof(sig));
 
@@ -103,320 +160,1265 @@ static void initSignalHandler()
 
 // -----------------------------------------------------------------------
 
-#if DISTRHO_PLUGIN_HAS_UI
-class PluginJack : public DGL_NAMESPACE::IdleCallback
-#else
-class PluginJack
-#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+static void updateTimePosition(jack_client_t* const client, TimePosition& timePosition)
 {
-public:
-    PluginJack(jack_client_t* const client)
-        : fPlugin(this, writeMidiCallback, requestParameterValueChangeCallback),
-#if DISTRHO_PLUGIN_HAS_UI
-          fUI(this,
-              0, // winId
-              d_lastSampleRate,
-              nullptr, // edit param
-              setParameterValueCallback,
-              setStateCallback,
-              sendNoteCallback,
-              nullptr, // window size
-              nullptr, // file request
-              nullptr, // bundle
-              fPlugin.getInstancePointer(),
-              0.0),
-#endif
-          fClient(client)
+    jack_position_t pos;
+    timePosition.playing = (jackbridge_transport_query(client, &pos) == JackTransportRolling);
+
+    if (pos.unique_1 == pos.unique_2)
     {
-#if DISTRHO_PLUGIN_NUM_INPUTS > 0 || DISTRHO_PLUGIN_NUM_OUTPUTS > 0
-        char strBuf[0xff+1];
-        strBuf[0xff] = '\0';
+        timePosition.frame = pos.frame;
 
-# if DISTRHO_PLUGIN_NUM_INPUTS > 0
-        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
-        {
-            const AudioPort& port(fPlugin.getAudioPort(true, i));
-            fPortAudioIns[i] = jackbridge_port_register(fClient, port.symbol, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-            setAudioPortMetadata(port, fPortAudioIns[i], i);
-        }
-# endif
-# if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
-        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+        if (pos.valid & JackPositionBBT)
         {
-            std::snprintf(strBuf, 0xff, "out%i", i+1);
-            const AudioPort& port(fPlugin.getAudioPort(false, i));
-            fPortAudioOuts[i] = jackbridge_port_register(fClient, port.symbol, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-            setAudioPortMetadata(port, fPortAudioOuts[i], DISTRHO_PLUGIN_NUM_INPUTS+i);
-        }
-# endif
-#endif
-
-        fPortEventsIn = jackbridge_port_register(fClient, "events-in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
-
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-        fPortMidiOut = jackbridge_port_register(fClient, "midi-out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
-        fPortMidiOutBuffer = nullptr;
-#endif
+            timePosition.bbt.valid = true;
 
-#if DISTRHO_PLUGIN_WANT_PROGRAMS
-        if (fPlugin.getProgramCount() > 0)
-        {
-            fPlugin.loadProgram(0);
-# if DISTRHO_PLUGIN_HAS_UI
-            fUI.programLoaded(0);
-# endif
-        }
-# if DISTRHO_PLUGIN_HAS_UI
-        fProgramChanged = -1;
-# endif
+            timePosition.bbt.bar  = pos.bar;
+            timePosition.bbt.beat = pos.beat;
+            timePosition.bbt.tick = pos.tick;
+#ifdef JACK_TICK_DOUBLE
+            if (pos.valid & JackTickDouble)
+                timePosition.bbt.tick = pos.tick_double;
+            else
 #endif
+                timePosition.bbt.tick = pos.tick;
+            timePosition.bbt.barStartTick = pos.bar_start_tick;
 
-        if (const uint32_t count = fPlugin.getParameterCount())
-        {
-            fLastOutputValues = new float[count];
-            std::memset(fLastOutputValues, 0, sizeof(float)*count);
-
-#if DISTRHO_PLUGIN_HAS_UI
-            fParametersChanged = new bool[count];
-            std::memset(fParametersChanged, 0, sizeof(bool)*count);
-#endif
+            timePosition.bbt.beatsPerBar = pos.beats_per_bar;
+            timePosition.bbt.beatType    = pos.beat_type;
 
-            for (uint32_t i=0; i < count; ++i)
-            {
-#if DISTRHO_PLUGIN_HAS_UI
-                if (! fPlugin.isParameterOutput(i))
-                    fUI.parameterChanged(i, fPlugin.getParameterValue(i));
-#endif
-            }
+            timePosition.bbt.ticksPerBeat   = pos.ticks_per_beat;
+            timePosition.bbt.beatsPerMinute = pos.beats_per_minute;
         }
         else
-        {
-            fLastOutputValues = nullptr;
-#if DISTRHO_PLUGIN_HAS_UI
-            fParametersChanged = nullptr;
+            timePosition.bbt.valid = false;
+    }
+    else
+    {
+        timePosition.bbt.valid = false;
+        timePosition.frame = 0;
+    }
+}
 #endif
-        }
-
-        jackbridge_set_buffer_size_callback(fClient, jackBufferSizeCallback, this);
-        jackbridge_set_sample_rate_callback(fClient, jackSampleRateCallback, this);
-        jackbridge_set_process_callback(fClient, jackProcessCallback, this);
-        jackbridge_on_shutdown(fClient, jackShutdownCallback, this);
-
-        fPlugin.activate();
-
-        jackbridge_activate(fClient);
 
-        std::fflush(stdout);
+// -----------------------------------------------------------------------
+// Local control socket for headless mode, see the `--control` command-line option.
+// Plain text protocol, one command per line, every command gets a single "ok" or "error" reply line.
 
-#if DISTRHO_PLUGIN_HAS_UI
-        if (const char* const name = jackbridge_get_client_name(fClient))
-            fUI.setWindowTitle(name);
-        else
-            fUI.setWindowTitle(fPlugin.getName());
+#ifndef DISTRHO_OS_WINDOWS
+class PluginJackControl
+{
+public:
+    static const uint kMaxClients = 8;
+    static const uint kMaxPollFds = kMaxClients + 1;
+
+    PluginJackControl(PluginExporter* const* const plugins, const uint32_t pluginCount)
+        : fPlugins(plugins),
+          fPluginCount(pluginCount),
+          fSocket(-1),
+          fPath()
+    {
+        for (uint i=0; i < kMaxClients; ++i)
+            fClients[i].fd = -1;
+    }
 
-        fUI.exec(this);
-#else
-        while (! gCloseSignalReceived)
-            d_sleep(1);
-#endif
+    ~PluginJackControl()
+    {
+        close();
     }
 
-    ~PluginJack()
+    bool open(const char* const path)
     {
-        if (fClient != nullptr)
-            jackbridge_deactivate(fClient);
+        DISTRHO_SAFE_ASSERT_RETURN(fSocket == -1, false);
+        DISTRHO_SAFE_ASSERT_RETURN(path != nullptr && path[0] != '\0', false);
 
-        if (fLastOutputValues != nullptr)
-        {
-            delete[] fLastOutputValues;
-            fLastOutputValues = nullptr;
-        }
+        struct sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
 
-#if DISTRHO_PLUGIN_HAS_UI
-        if (fParametersChanged != nullptr)
+        if (std::strlen(path) >= sizeof(addr.sun_path))
         {
-            delete[] fParametersChanged;
-            fParametersChanged = nullptr;
+            d_stderr("Control socket path '%s' is too long", path);
+            return false;
         }
-#endif
 
-        fPlugin.deactivate();
+        std::strcpy(addr.sun_path, path);
 
-        if (fClient == nullptr)
-            return;
+        // remove stale socket from a previous run, but never anything else
+        struct stat st;
+        if (::lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+            ::unlink(path);
 
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-        jackbridge_port_unregister(fClient, fPortMidiOut);
-        fPortMidiOut = nullptr;
-#endif
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        DISTRHO_SAFE_ASSERT_RETURN(fd != -1, false);
 
-        jackbridge_port_unregister(fClient, fPortEventsIn);
-        fPortEventsIn = nullptr;
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
 
-#if DISTRHO_PLUGIN_NUM_INPUTS > 0
-        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+        if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(fd, kMaxClients) != 0)
         {
-            jackbridge_port_unregister(fClient, fPortAudioIns[i]);
-            fPortAudioIns[i] = nullptr;
+            d_stderr("Failed to open control socket '%s': %s", path, std::strerror(errno));
+            ::close(fd);
+            return false;
         }
-#endif
 
-#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
-        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
-        {
-            jackbridge_port_unregister(fClient, fPortAudioOuts[i]);
-            fPortAudioOuts[i] = nullptr;
-        }
-#endif
+        // clients might go away while we reply
+        ::signal(SIGPIPE, SIG_IGN);
 
-        jackbridge_client_close(fClient);
+        fSocket = fd;
+        fPath = path;
+
+        d_stdout("Listening for control commands on '%s'", path);
+        return true;
     }
 
-    // -------------------------------------------------------------------
+    void close()
+    {
+        for (uint i=0; i < kMaxClients; ++i)
+            closeClient(fClients[i]);
 
-protected:
-#if DISTRHO_PLUGIN_HAS_UI
-    void idleCallback() override
+        if (fSocket == -1)
+            return;
+
+        ::close(fSocket);
+        ::unlink(fPath);
+        fSocket = -1;
+    }
+
+    uint fillPollFds(struct pollfd* const fds) const noexcept
     {
-        if (gCloseSignalReceived)
-            return fUI.quit();
+        if (fSocket == -1)
+            return 0;
 
-# if DISTRHO_PLUGIN_WANT_PROGRAMS
-        if (fProgramChanged >= 0)
+        uint count = 0;
+
+        fds[count].fd = fSocket;
+        fds[count].events = POLLIN;
+        fds[count].revents = 0;
+        ++count;
+
+        for (uint i=0; i < kMaxClients; ++i)
         {
-            fUI.programLoaded(fProgramChanged);
-            fProgramChanged = -1;
+            if (fClients[i].fd == -1)
+                continue;
+
+            fds[count].fd = fClients[i].fd;
+            fds[count].events = POLLIN;
+            fds[count].revents = 0;
+            ++count;
         }
-# endif
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        return count;
+    }
+
+    void handlePollFds(const struct pollfd* const fds, const uint count)
+    {
+        for (uint i=0; i < count; ++i)
         {
-            if (fPlugin.isParameterOutput(i))
+            if (fds[i].revents == 0)
+                continue;
+
+            if (fds[i].fd == fSocket)
             {
-                const float value = fPlugin.getParameterValue(i);
+                acceptClient();
+                continue;
+            }
 
-                if (d_isEqual(fLastOutputValues[i], value))
+            for (uint j=0; j < kMaxClients; ++j)
+            {
+                if (fClients[j].fd != fds[i].fd)
                     continue;
 
-                fLastOutputValues[i] = value;
-                fUI.parameterChanged(i, value);
-            }
-            else if (fParametersChanged[i])
-            {
-                fParametersChanged[i] = false;
-                fUI.parameterChanged(i, fPlugin.getParameterValue(i));
+                readClient(fClients[j]);
+                break;
             }
         }
-
-        fUI.exec_idle();
     }
-#endif
 
-    void jackBufferSize(const jack_nframes_t nframes)
+private:
+    struct Client {
+        int fd;
+        uint32_t instance;
+        uint32_t size;
+        char buffer[1024];
+    };
+
+    PluginExporter* const* const fPlugins;
+    const uint32_t fPluginCount;
+
+    int fSocket;
+    String fPath;
+    Client fClients[kMaxClients];
+
+    void acceptClient()
     {
-        fPlugin.setBufferSize(nframes, true);
+        const int fd = ::accept(fSocket, nullptr, nullptr);
+        DISTRHO_SAFE_ASSERT_RETURN(fd != -1,);
+
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        for (uint i=0; i < kMaxClients; ++i)
+        {
+            Client& client(fClients[i]);
+
+            if (client.fd != -1)
+                continue;
+
+            client.fd = fd;
+            client.instance = 0;
+            client.size = 0;
+            return;
+        }
+
+        reply(fd, "error too many clients");
+        ::close(fd);
     }
 
-    void jackSampleRate(const jack_nframes_t nframes)
+    void closeClient(Client& client)
     {
-        fPlugin.setSampleRate(nframes, true);
+        if (client.fd == -1)
+            return;
+
+        ::close(client.fd);
+        client.fd = -1;
     }
 
-    void jackProcess(const jack_nframes_t nframes)
+    void readClient(Client& client)
     {
-#if DISTRHO_PLUGIN_NUM_INPUTS > 0
-        const float* audioIns[DISTRHO_PLUGIN_NUM_INPUTS];
-
-        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
-            audioIns[i] = (const float*)jackbridge_port_get_buffer(fPortAudioIns[i], nframes);
-#else
-        static const float** audioIns = nullptr;
-#endif
+        const ssize_t r = ::read(client.fd, client.buffer + client.size, sizeof(client.buffer) - 1 - client.size);
 
-#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
-        float* audioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+        if (r <= 0)
+        {
+            if (r < 0 && (errno == EAGAIN || errno == EINTR))
+                return;
+            return closeClient(client);
+        }
 
-        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
-            audioOuts[i] = (float*)jackbridge_port_get_buffer(fPortAudioOuts[i], nframes);
-#else
-        static float** audioOuts = nullptr;
-#endif
+        client.size += static_cast<uint32_t>(r);
+        client.buffer[client.size] = '\0';
 
-#if DISTRHO_PLUGIN_WANT_TIMEPOS
-        jack_position_t pos;
-        fTimePosition.playing = (jackbridge_transport_query(fClient, &pos) == JackTransportRolling);
+        char* line = client.buffer;
 
-        if (pos.unique_1 == pos.unique_2)
+        while (char* const end = std::strchr(line, '\n'))
         {
-            fTimePosition.frame = pos.frame;
+            *end = '\0';
 
-            if (pos.valid & JackPositionBBT)
-            {
-                fTimePosition.bbt.valid = true;
+            if (end != line && end[-1] == '\r')
+                end[-1] = '\0';
 
-                fTimePosition.bbt.bar  = pos.bar;
-                fTimePosition.bbt.beat = pos.beat;
-                fTimePosition.bbt.tick = pos.tick;
-#ifdef JACK_TICK_DOUBLE
-                if (pos.valid & JackTickDouble)
-                    fTimePosition.bbt.tick = pos.tick_double;
-                else
-#endif
-                    fTimePosition.bbt.tick = pos.tick;
-                fTimePosition.bbt.barStartTick = pos.bar_start_tick;
+            if (! processCommand(client, line))
+                return closeClient(client);
 
-                fTimePosition.bbt.beatsPerBar = pos.beats_per_bar;
-                fTimePosition.bbt.beatType    = pos.beat_type;
+            line = end + 1;
+        }
 
-                fTimePosition.bbt.ticksPerBeat   = pos.ticks_per_beat;
-                fTimePosition.bbt.beatsPerMinute = pos.beats_per_minute;
-            }
-            else
-                fTimePosition.bbt.valid = false;
+        uint32_t remaining = client.size - static_cast<uint32_t>(line - client.buffer);
+
+        if (remaining == sizeof(client.buffer) - 1)
+        {
+            reply(client.fd, "error line too long");
+            remaining = 0;
         }
-        else
+        else if (remaining != 0)
         {
-            fTimePosition.bbt.valid = false;
-            fTimePosition.frame = 0;
+            std::memmove(client.buffer, line, remaining);
         }
 
-        fPlugin.setTimePosition(fTimePosition);
-#endif
+        client.size = remaining;
+    }
 
-        updateParameterTriggers();
+    // returns false if the connection should be closed
+    bool processCommand(Client& client, char* const line)
+    {
+        char* args = line;
+        const char* const cmd = nextToken(args);
 
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-        fPortMidiOutBuffer = jackbridge_port_get_buffer(fPortMidiOut, nframes);
-        jackbridge_midi_clear_buffer(fPortMidiOutBuffer);
-#endif
+        if (cmd[0] == '\0')
+            return true;
 
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        uint32_t  midiEventCount = 0;
-        MidiEvent midiEvents[512];
+        PluginExporter& plugin(*fPlugins[client.instance]);
 
+        if (std::strcmp(cmd, "help") == 0)
+        {
+            reply(client.fd, "ok commands: instance <n>, params, get <param>, set <param> <value>"
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+                             ", program <n>"
+#endif
+#if DISTRHO_PLUGIN_WANT_STATE
+                             ", state <key> <value>"
+#endif
+                             ", quit");
+        }
+        else if (std::strcmp(cmd, "quit") == 0)
+        {
+            reply(client.fd, "ok");
+            return false;
+        }
+        else if (std::strcmp(cmd, "instance") == 0)
+        {
+            const int instance = std::atoi(nextToken(args));
+
+            if (instance < 1 || static_cast<uint32_t>(instance) > fPluginCount)
+                return reply(client.fd, "error invalid instance");
+
+            client.instance = static_cast<uint32_t>(instance - 1);
+            reply(client.fd, "ok");
+        }
+        else if (std::strcmp(cmd, "params") == 0)
+        {
+            char strBuf[0xff+1];
+            strBuf[0xff] = '\0';
+
+            for (uint32_t i=0, count=plugin.getParameterCount(); i < count; ++i)
+            {
+                std::snprintf(strBuf, 0xff, "param %u %s %f %s", i,
+                              plugin.getParameterSymbol(i).buffer(),
+                              static_cast<double>(plugin.getParameterValue(i)),
+                              plugin.isParameterOutput(i) ? "output" : "input");
+                reply(client.fd, strBuf);
+            }
+
+            reply(client.fd, "ok");
+        }
+        else if (std::strcmp(cmd, "get") == 0)
+        {
+            const int index = findParameter(plugin, nextToken(args));
+
+            if (index < 0)
+                return reply(client.fd, "error invalid parameter");
+
+            char strBuf[0xff+1];
+            strBuf[0xff] = '\0';
+            std::snprintf(strBuf, 0xff, "ok %f", static_cast<double>(plugin.getParameterValue(index)));
+            reply(client.fd, strBuf);
+        }
+        else if (std::strcmp(cmd, "set") == 0)
+        {
+            const int index = findParameter(plugin, nextToken(args));
+            const char* const value = nextToken(args);
+
+            if (index < 0 || plugin.isParameterOutput(index))
+                return reply(client.fd, "error invalid parameter");
+            if (value[0] == '\0')
+                return reply(client.fd, "error missing value");
+
+            const float fvalue = plugin.getParameterRanges(index).getFixedValue(std::atof(value));
+            plugin.setParameterValue(index, fvalue);
+            reply(client.fd, "ok");
+        }
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+        else if (std::strcmp(cmd, "program") == 0)
+        {
+            const int program = std::atoi(nextToken(args));
+
+            if (program < 0 || static_cast<uint32_t>(program) >= plugin.getProgramCount())
+                return reply(client.fd, "error invalid program");
+
+            plugin.loadProgram(program);
+            reply(client.fd, "ok");
+        }
+#endif
+#if DISTRHO_PLUGIN_WANT_STATE
+        else if (std::strcmp(cmd, "state") == 0)
+        {
+            const char* const key = nextToken(args);
+
+            // value is the rest of the line, can contain spaces
+            while (*args == ' ')
+                ++args;
+
+            if (! plugin.wantStateKey(key))
+                return reply(client.fd, "error invalid state key");
+
+            plugin.setState(key, args);
+            reply(client.fd, "ok");
+        }
+#endif
+        else
+        {
+            reply(client.fd, "error unknown command");
+        }
+
+        return true;
+    }
+
+    static int findParameter(const PluginExporter& plugin, const char* const name)
+    {
+        const uint32_t count = plugin.getParameterCount();
+
+        if (name[0] >= '0' && name[0] <= '9')
+        {
+            const int index = std::atoi(name);
+            return static_cast<uint32_t>(index) < count ? index : -1;
+        }
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (plugin.getParameterSymbol(i) == name)
+                return static_cast<int>(i);
+        }
+
+        return -1;
+    }
+
+    // split the next space-separated token off `str`, always returns a valid string
+    static const char* nextToken(char*& str) noexcept
+    {
+        while (*str == ' ')
+            ++str;
+
+        char* const token = str;
+
+        while (*str != '\0' && *str != ' ')
+            ++str;
+
+        if (*str != '\0')
+            *str++ = '\0';
+
+        return token;
+    }
+
+    static bool reply(const int fd, const char* const msg)
+    {
+        const size_t len = std::strlen(msg);
+
+        if (::write(fd, msg, len) != static_cast<ssize_t>(len) || ::write(fd, "\n", 1) != 1)
+            d_stderr("Failed to reply to control client");
+
+        return true;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(PluginJackControl)
+};
+#endif
+
+// -----------------------------------------------------------------------
+// Main loop for headless mode, blocks the main thread until something happens.
+// No polling, the process sleeps until a close signal, a control command or the timeout.
+
+class PluginJackHeadlessLoop
+{
+public:
+    PluginJackHeadlessLoop(PluginExporter* const* const plugins, const uint32_t pluginCount, const char* const controlPath)
+#ifndef DISTRHO_OS_WINDOWS
+        : fControl(plugins, pluginCount)
+#endif
+    {
+#ifdef DISTRHO_OS_WINDOWS
+        if (controlPath != nullptr)
+            d_stderr("Control socket is not supported on this platform");
+        // unused
+        (void)plugins;
+        (void)pluginCount;
+#else
+        if (controlPath != nullptr)
+            fControl.open(controlPath);
+#endif
+    }
+
+    // returns false once a close signal has been received
+    bool wait(const int timeoutInMs)
+    {
+        if (gCloseSignalReceived)
+            return false;
+
+#ifdef DISTRHO_OS_WINDOWS
+        if (gCloseEvent != nullptr)
+            WaitForSingleObject(gCloseEvent, timeoutInMs < 0 ? INFINITE : static_cast<DWORD>(timeoutInMs));
+        else
+            d_msleep(timeoutInMs < 0 || timeoutInMs > 1000 ? 1000 : static_cast<uint>(timeoutInMs));
+#else
+        struct pollfd fds[1 + PluginJackControl::kMaxPollFds];
+        fds[0].fd = gClosePipe[0];
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+
+        const uint count = 1 + fControl.fillPollFds(fds + 1);
+
+        // without a pipe we cannot be woken up by signals, do not sleep for too long
+        const int timeout = gClosePipe[0] == -1 && (timeoutInMs < 0 || timeoutInMs > 1000) ? 1000 : timeoutInMs;
+
+        if (::poll(fds, count, timeout) > 0)
+        {
+            if (fds[0].revents != 0)
+            {
+                char buf[16];
+                while (::read(gClosePipe[0], buf, sizeof(buf)) > 0) {}
+            }
+
+            fControl.handlePollFds(fds + 1, count - 1);
+        }
+#endif
+
+        return ! gCloseSignalReceived;
+    }
+
+private:
+#ifndef DISTRHO_OS_WINDOWS
+    PluginJackControl fControl;
+#endif
+
+    DISTRHO_DECLARE_NON_COPYABLE(PluginJackHeadlessLoop)
+};
+
+// -----------------------------------------------------------------------
+
+#if DISTRHO_PLUGIN_HAS_UI
+class PluginJack : public DGL_NAMESPACE::IdleCallback
+#else
+class PluginJack
+#endif
+{
+public:
+    PluginJack(jack_client_t* const client, const bool withUI, const char* const controlPath)
+        : fPlugin(this, writeMidiCallback, requestParameterValueChangeCallback),
+#if DISTRHO_PLUGIN_HAS_UI
+          fUI(),
+#endif
+          fClient(client)
+    {
+#if DISTRHO_PLUGIN_HAS_UI
+        if (withUI)
+            fUI = new UIExporter(this,
+                                 0, // winId
+                                 d_lastSampleRate,
+                                 nullptr, // edit param
+                                 setParameterValueCallback,
+                                 setStateCallback,
+                                 sendNoteCallback,
+                                 nullptr, // window size
+                                 nullptr, // file request
+                                 nullptr, // bundle
+                                 fPlugin.getInstancePointer(),
+                                 0.0);
+# if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        if (withUI)
+            fPlugin.attachVisualStream();
+# endif
+#else
+        // unused
+        (void)withUI;
+#endif
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0 || DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        char strBuf[0xff+1];
+        strBuf[0xff] = '\0';
+
+# if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+        {
+            const AudioPort& port(fPlugin.getAudioPort(true, i));
+            fPortAudioIns[i] = jackbridge_port_register(fClient, port.symbol, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+            setAudioPortMetadata(port, fPortAudioIns[i], i);
+        }
+# endif
+# if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+        {
+            std::snprintf(strBuf, 0xff, "out%i", i+1);
+            const AudioPort& port(fPlugin.getAudioPort(false, i));
+            fPortAudioOuts[i] = jackbridge_port_register(fClient, port.symbol, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+            setAudioPortMetadata(port, fPortAudioOuts[i], DISTRHO_PLUGIN_NUM_INPUTS+i);
+        }
+# endif
+#endif
+
+        fPortEventsIn = jackbridge_port_register(fClient, "events-in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fPortMidiOut = jackbridge_port_register(fClient, "midi-out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+        fPortMidiOutBuffer = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+        if (fPlugin.getProgramCount() > 0)
+        {
+            fPlugin.loadProgram(0);
+# if DISTRHO_PLUGIN_HAS_UI
+            if (fUI != nullptr)
+                fUI->programLoaded(0);
+# endif
+        }
+# if DISTRHO_PLUGIN_HAS_UI
+        fProgramChanged = -1;
+# endif
+#endif
+
+        if (const uint32_t count = fPlugin.getParameterCount())
+        {
+            fLastOutputValues = new float[count];
+            std::memset(fLastOutputValues, 0, sizeof(float)*count);
+
+#if DISTRHO_PLUGIN_HAS_UI
+            fParametersChanged = new bool[count];
+            std::memset(fParametersChanged, 0, sizeof(bool)*count);
+#endif
+
+            for (uint32_t i=0; i < count; ++i)
+            {
+#if DISTRHO_PLUGIN_HAS_UI
+                if (fUI != nullptr && ! fPlugin.isParameterOutput(i))
+                    fUI->parameterChanged(i, fPlugin.getParameterValue(i));
+#endif
+            }
+        }
+        else
+        {
+            fLastOutputValues = nullptr;
+#if DISTRHO_PLUGIN_HAS_UI
+            fParametersChanged = nullptr;
+#endif
+        }
+
+        jackbridge_set_buffer_size_callback(fClient, jackBufferSizeCallback, this);
+        jackbridge_set_sample_rate_callback(fClient, jackSampleRateCallback, this);
+        jackbridge_set_process_callback(fClient, jackProcessCallback, this);
+        jackbridge_set_xrun_callback(fClient, jackXrunCallback, nullptr);
+        jackbridge_on_shutdown(fClient, jackShutdownCallback, this);
+
+        fPlugin.activate();
+
+        jackbridge_activate(fClient);
+
+        std::fflush(stdout);
+
+#if DISTRHO_PLUGIN_HAS_UI
+        if (fUI != nullptr)
+        {
+            if (const char* const name = jackbridge_get_client_name(fClient))
+                fUI->setWindowTitle(name);
+            else
+                fUI->setWindowTitle(fPlugin.getName());
+
+            fUI->exec(this);
+            return;
+        }
+#endif
+
+        PluginExporter* const plugins[1] = { &fPlugin };
+        PluginJackHeadlessLoop loop(plugins, 1, controlPath);
+
+        while (loop.wait(-1)) {}
+    }
+
+    ~PluginJack()
+    {
+#if DISTRHO_PLUGIN_HAS_UI && DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        if (fUI != nullptr)
+            fPlugin.detachVisualStream();
+#endif
+
+        if (fClient != nullptr)
+            jackbridge_deactivate(fClient);
+
+        if (fLastOutputValues != nullptr)
+        {
+            delete[] fLastOutputValues;
+            fLastOutputValues = nullptr;
+        }
+
+#if DISTRHO_PLUGIN_HAS_UI
+        if (fParametersChanged != nullptr)
+        {
+            delete[] fParametersChanged;
+            fParametersChanged = nullptr;
+        }
+#endif
+
+        fPlugin.deactivate();
+
+        if (fClient == nullptr)
+            return;
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        jackbridge_port_unregister(fClient, fPortMidiOut);
+        fPortMidiOut = nullptr;
+#endif
+
+        jackbridge_port_unregister(fClient, fPortEventsIn);
+        fPortEventsIn = nullptr;
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+        {
+            jackbridge_port_unregister(fClient, fPortAudioIns[i]);
+            fPortAudioIns[i] = nullptr;
+        }
+#endif
+
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+        {
+            jackbridge_port_unregister(fClient, fPortAudioOuts[i]);
+            fPortAudioOuts[i] = nullptr;
+        }
+#endif
+
+        jackbridge_client_close(fClient);
+    }
+
+    // -------------------------------------------------------------------
+
+protected:
+#if DISTRHO_PLUGIN_HAS_UI
+    void idleCallback() override
+    {
+        if (gCloseSignalReceived)
+            return fUI->quit();
+
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+        if (fProgramChanged >= 0)
+        {
+            fUI->programLoaded(fProgramChanged);
+            fProgramChanged = -1;
+        }
+# endif
+
+        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        {
+            if (fPlugin.isParameterOutput(i))
+            {
+                const float value = fPlugin.getParameterValue(i);
+
+                if (d_isEqual(fLastOutputValues[i], value))
+                    continue;
+
+                fLastOutputValues[i] = value;
+                fUI->parameterChanged(i, value);
+            }
+            else if (fParametersChanged[i])
+            {
+                fParametersChanged[i] = false;
+                fUI->parameterChanged(i, fPlugin.getParameterValue(i));
+            }
+        }
+
+# if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        uint32_t visualFrameCount;
+        while (const float* const visualFrame = fPlugin.readVisualFrame(visualFrameCount))
+            fUI->visualFrameReceived(visualFrame, visualFrameCount);
+# endif
+
+        fUI->exec_idle();
+    }
+#endif
+
+    void jackBufferSize(const jack_nframes_t nframes)
+    {
+        fPlugin.setBufferSize(nframes, true);
+    }
+
+    void jackSampleRate(const jack_nframes_t nframes)
+    {
+        fPlugin.setSampleRate(nframes, true);
+    }
+
+    void jackProcess(const jack_nframes_t nframes)
+    {
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        const float* audioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+            audioIns[i] = (const float*)jackbridge_port_get_buffer(fPortAudioIns[i], nframes);
+#else
+        static const float** audioIns = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        float* audioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            audioOuts[i] = (float*)jackbridge_port_get_buffer(fPortAudioOuts[i], nframes);
+#else
+        static float** audioOuts = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        updateTimePosition(fClient, fTimePosition);
+        fPlugin.setTimePosition(fTimePosition);
+#endif
+
+        updateParameterTriggers();
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fPortMidiOutBuffer = jackbridge_port_get_buffer(fPortMidiOut, nframes);
+        jackbridge_midi_clear_buffer(fPortMidiOutBuffer);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        fMidiEvents.clear();
+
+# if DISTRHO_PLUGIN_HAS_UI
+        while (fNotesRingBuffer.isDataAvailableForReading())
+        {
+            uint8_t midiData[3];
+            if (! fNotesRingBuffer.readCustomData(midiData, 3))
+                break;
+            if (! fMidiEvents.append(0, midiData, 3))
+                break;
+        }
+# endif
+        const uint32_t midiEventCount = fMidiEvents.count;
+#else
+        static const uint32_t midiEventCount = 0;
+#endif
+
+        void* const midiInBuf = jackbridge_port_get_buffer(fPortEventsIn, nframes);
+
+        if (const uint32_t eventCount = std::min(kMaxMidiEvents - midiEventCount, jackbridge_midi_get_event_count(midiInBuf)))
+        {
+            jack_midi_event_t jevent;
+
+            for (uint32_t i=0; i < eventCount; ++i)
+            {
+                if (jackbridge_midi_event_get(&jevent, midiInBuf, i) != 0)
+                    break;
+
+                // Check if message is control change on channel 1
+                if (jevent.buffer[0] == 0xB0 && jevent.size == 3)
+                {
+                    const uint8_t control = jevent.buffer[1];
+                    const uint8_t value   = jevent.buffer[2];
+
+                    /* NOTE: This is not optimal, we're iterating all parameters on every CC message.
+                             Since the JACK standalone is more of a test tool, this will do for now. */
+                    for (uint32_t j=0, paramCount=fPlugin.getParameterCount(); j < paramCount; ++j)
+                    {
+                        if (fPlugin.isParameterOutput(j))
+                            continue;
+                        if (fPlugin.getParameterMidiCC(j) != control)
+                            continue;
+
+                        const float scaled = static_cast<float>(value)/127.0f;
+                        const float fvalue = fPlugin.getParameterRanges(j).getUnnormalizedValue(scaled);
+                        fPlugin.setParameterValue(j, fvalue);
+#if DISTRHO_PLUGIN_HAS_UI
+                        fParametersChanged[j] = true;
+#endif
+                        break;
+                    }
+                }
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+                // Check if message is program change on channel 1
+                else if (jevent.buffer[0] == 0xC0 && jevent.size == 2)
+                {
+                    const uint8_t program = jevent.buffer[1];
+
+                    if (program < fPlugin.getProgramCount())
+                    {
+                        fPlugin.loadProgram(program);
+# if DISTRHO_PLUGIN_HAS_UI
+                        fProgramChanged = program;
+# endif
+                    }
+                }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                fMidiEvents.append(jevent.time, jevent.buffer, static_cast<uint32_t>(jevent.size));
+#endif
+            }
+        }
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        fPlugin.run(audioIns, audioOuts, nframes, fMidiEvents.events, fMidiEvents.count);
+#else
+        fPlugin.run(audioIns, audioOuts, nframes);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fPortMidiOutBuffer = nullptr;
+#endif
+    }
+
+    void jackShutdown()
+    {
+        d_stderr("jack has shutdown, quitting now...");
+        fClient = nullptr;
+#if DISTRHO_PLUGIN_HAS_UI
+        if (fUI != nullptr)
+            fUI->quit();
+#endif
+        triggerCloseSignal();
+    }
+
+    // -------------------------------------------------------------------
+
+#if DISTRHO_PLUGIN_HAS_UI
+    void setParameterValue(const uint32_t index, const float value)
+    {
+        fPlugin.setParameterValue(index, value);
+    }
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    void sendNote(const uint8_t channel, const uint8_t note, const uint8_t velocity)
+    {
+        uint8_t midiData[3];
+        midiData[0] = (velocity != 0 ? 0x90 : 0x80) | channel;
+        midiData[1] = note;
+        midiData[2] = velocity;
+        fNotesRingBuffer.writeCustomData(midiData, 3);
+        fNotesRingBuffer.commitWrite();
+    }
+# endif
+
+# if DISTRHO_PLUGIN_WANT_STATE
+    void setState(const char* const key, const char* const value)
+    {
+        fPlugin.setState(key, value);
+    }
+# endif
+#endif // DISTRHO_PLUGIN_HAS_UI
+
+    // NOTE: no trigger support for JACK, simulate it here
+    void updateParameterTriggers()
+    {
+        float defValue;
+
+        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        {
+            if ((fPlugin.getParameterHints(i) & kParameterIsTrigger) != kParameterIsTrigger)
+                continue;
+
+            defValue = fPlugin.getParameterRanges(i).def;
+
+            if (d_isNotEqual(defValue, fPlugin.getParameterValue(i)))
+                fPlugin.setParameterValue(i, defValue);
+        }
+    }
+
+    // -------------------------------------------------------------------
+
+private:
+    PluginExporter fPlugin;
+#if DISTRHO_PLUGIN_HAS_UI
+    ScopedPointer<UIExporter> fUI;
+#endif
+
+    jack_client_t* fClient;
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+    jack_port_t* fPortAudioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+    jack_port_t* fPortAudioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+#endif
+    jack_port_t* fPortEventsIn;
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    jack_port_t* fPortMidiOut;
+    void*        fPortMidiOutBuffer;
+#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    TimePosition fTimePosition;
+#endif
+
+    // Temporary data
+    float* fLastOutputValues;
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEventList fMidiEvents;
+#endif
+
+#if DISTRHO_PLUGIN_HAS_UI
+    // Store DSP changes to send to UI
+    bool* fParametersChanged;
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+    int fProgramChanged;
+# endif
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    SmallStackRingBuffer fNotesRingBuffer;
+# endif
+#endif
+
+    void setAudioPortMetadata(const AudioPort& port, jack_port_t* const jackport, const uint32_t index)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(jackport != nullptr,);
+
+        const jack_uuid_t uuid = jackbridge_port_uuid(jackport);
+
+        if (uuid == JACK_UUID_EMPTY_INITIALIZER)
+            return;
+
+        jackbridge_set_property(fClient, uuid, JACK_METADATA_PRETTY_NAME, port.name, "text/plain");
+
+        {
+            char strBuf[0xff];
+            snprintf(strBuf, sizeof(0xff)-1, "%u", index);
+            jackbridge_set_property(fClient, uuid, JACK_METADATA_ORDER, strBuf, "http://www.w3.org/2001/XMLSchema#integer");
+        }
+
+        if (port.groupId != kPortGroupNone)
+        {
+            const PortGroupWithId& portGroup(fPlugin.getPortGroupById(port.groupId));
+            jackbridge_set_property(fClient, uuid, JACK_METADATA_PORT_GROUP, portGroup.name, "text/plain");
+        }
+
+        if (port.hints & kAudioPortIsCV)
+        {
+            jackbridge_set_property(fClient, uuid, JACK_METADATA_SIGNAL_TYPE, "CV", "text/plain");
+        }
+        else
+        {
+            jackbridge_set_property(fClient, uuid, JACK_METADATA_SIGNAL_TYPE, "AUDIO", "text/plain");
+            return;
+        }
+
+        // set cv ranges
+        const bool cvPortScaled = port.hints & kCVPortHasScaledRange;
+
+        if (port.hints & kCVPortHasBipolarRange)
+        {
+            if (cvPortScaled)
+            {
+                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-5", "http://www.w3.org/2001/XMLSchema#integer");
+                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "5", "http://www.w3.org/2001/XMLSchema#integer");
+            }
+            else
+            {
+                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-1", "http://www.w3.org/2001/XMLSchema#integer");
+                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "1", "http://www.w3.org/2001/XMLSchema#integer");
+            }
+        }
+        else if (port.hints & kCVPortHasNegativeUnipolarRange)
+        {
+            if (cvPortScaled)
+            {
+                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-10", "http://www.w3.org/2001/XMLSchema#integer");
+                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "0", "http://www.w3.org/2001/XMLSchema#integer");
+            }
+            else
+            {
+                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-1", "http://www.w3.org/2001/XMLSchema#integer");
+                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "0", "http://www.w3.org/2001/XMLSchema#integer");
+            }
+        }
+        else if (port.hints & kCVPortHasPositiveUnipolarRange)
+        {
+            if (cvPortScaled)
+            {
+                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "0", "http://www.w3.org/2001/XMLSchema#integer");
+                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "10", "http://www.w3.org/2001/XMLSchema#integer");
+            }
+            else
+            {
+                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "0", "http://www.w3.org/2001/XMLSchema#integer");
+                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "1", "http://www.w3.org/2001/XMLSchema#integer");
+            }
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // Callbacks
+
+    #define thisPtr ((PluginJack*)ptr)
+
+    static int jackBufferSizeCallback(jack_nframes_t nframes, void* ptr)
+    {
+        thisPtr->jackBufferSize(nframes);
+        return 0;
+    }
+
+    static int jackSampleRateCallback(jack_nframes_t nframes, void* ptr)
+    {
+        thisPtr->jackSampleRate(nframes);
+        return 0;
+    }
+
+    static int jackProcessCallback(jack_nframes_t nframes, void* ptr)
+    {
+        thisPtr->jackProcess(nframes);
+        return 0;
+    }
+
+    static void jackShutdownCallback(void* ptr)
+    {
+        thisPtr->jackShutdown();
+    }
+
+#if DISTRHO_PLUGIN_HAS_UI
+    static void setParameterValueCallback(void* ptr, uint32_t index, float value)
+    {
+        thisPtr->setParameterValue(index, value);
+    }
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    static void sendNoteCallback(void* ptr, uint8_t channel, uint8_t note, uint8_t velocity)
+    {
+        thisPtr->sendNote(channel, note, velocity);
+    }
+# endif
+
+# if DISTRHO_PLUGIN_WANT_STATE
+    static void setStateCallback(void* ptr, const char* key, const char* value)
+    {
+        thisPtr->setState(key, value);
+    }
+# endif
+#endif // DISTRHO_PLUGIN_HAS_UI
+
+#if DISTRHO_PLUGIN_WANT_PARAMETER_VALUE_CHANGE_REQUEST
+    bool requestParameterValueChange(const uint32_t index, const float value)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(index < fPlugin.getParameterCount(), false);
+
+        fPlugin.setParameterValue(index, value);
 # if DISTRHO_PLUGIN_HAS_UI
-        while (fNotesRingBuffer.isDataAvailableForReading())
+        fParametersChanged[index] = true;
+# endif
+        return true;
+    }
+
+    static bool requestParameterValueChangeCallback(void* ptr, const uint32_t index, const float value)
+    {
+        return thisPtr->requestParameterValueChange(index, value);
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    bool writeMidi(const MidiEvent& midiEvent)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fPortMidiOutBuffer != nullptr, false);
+
+        return jackbridge_midi_event_write(fPortMidiOutBuffer,
+                                           midiEvent.frame,
+                                           midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data,
+                                           midiEvent.size) == 0;
+    }
+
+    static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
+    {
+        return thisPtr->writeMidi(midiEvent);
+    }
+#endif
+
+    #undef thisPtr
+};
+
+// -----------------------------------------------------------------------
+// Multi-instance JACK client, see the `--instances` command-line option.
+// Each instance gets its own set of ports, all instances are processed in parallel.
+// This mode is DSP-only, plugin UIs are not shown.
+
+class PluginJackInstance
+{
+public:
+    PluginJackInstance(jack_client_t* const client, const uint32_t instanceIndex)
+        : fPlugin(this, writeMidiCallback, requestParameterValueChangeCallback),
+          fClient(client),
+          fTimeLast(0),
+          fTimeMax(0),
+          fTimeTotal(0),
+          fCycleCount(0)
+    {
+        char strBuf[0xff+1];
+        strBuf[0xff] = '\0';
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
         {
-            uint8_t midiData[3];
-            if (! fNotesRingBuffer.readCustomData(midiData, 3))
-                break;
+            const AudioPort& port(fPlugin.getAudioPort(true, i));
+            std::snprintf(strBuf, 0xff, "%u-%s", instanceIndex+1, port.symbol.buffer());
+            fPortAudioIns[i] = jackbridge_port_register(fClient, strBuf, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+        }
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+        {
+            const AudioPort& port(fPlugin.getAudioPort(false, i));
+            std::snprintf(strBuf, 0xff, "%u-%s", instanceIndex+1, port.symbol.buffer());
+            fPortAudioOuts[i] = jackbridge_port_register(fClient, strBuf, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        }
+#endif
+
+        std::snprintf(strBuf, 0xff, "%u-events-in", instanceIndex+1);
+        fPortEventsIn = jackbridge_port_register(fClient, strBuf, JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        std::snprintf(strBuf, 0xff, "%u-midi-out", instanceIndex+1);
+        fPortMidiOut = jackbridge_port_register(fClient, strBuf, JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+        fPortMidiOutBuffer = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+        if (fPlugin.getProgramCount() > 0)
+            fPlugin.loadProgram(0);
+#endif
+
+        fPlugin.activate();
+    }
 
-            MidiEvent& midiEvent(midiEvents[midiEventCount++]);
-            midiEvent.frame = 0;
-            midiEvent.size  = 3;
-            std::memcpy(midiEvent.data, midiData, 3);
+    ~PluginJackInstance()
+    {
+        fPlugin.deactivate();
 
-            if (midiEventCount == 512)
-                break;
-        }
-# endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        jackbridge_port_unregister(fClient, fPortMidiOut);
+#endif
+
+        jackbridge_port_unregister(fClient, fPortEventsIn);
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+            jackbridge_port_unregister(fClient, fPortAudioIns[i]);
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            jackbridge_port_unregister(fClient, fPortAudioOuts[i]);
+#endif
+    }
+
+    void setBufferSize(const jack_nframes_t nframes)
+    {
+        fPlugin.setBufferSize(nframes, true);
+    }
+
+    void setSampleRate(const jack_nframes_t nframes)
+    {
+        fPlugin.setSampleRate(nframes, true);
+    }
+
+    // called from the JACK process thread or from one of the workers
+    void process(const jack_nframes_t nframes, const TimePosition& timePosition)
+    {
+        const uint64_t timeStart = d_gettime_ns();
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        const float* audioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+            audioIns[i] = (const float*)jackbridge_port_get_buffer(fPortAudioIns[i], nframes);
 #else
-        static const uint32_t midiEventCount = 0;
+        static const float** audioIns = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        float* audioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            audioOuts[i] = (float*)jackbridge_port_get_buffer(fPortAudioOuts[i], nframes);
+#else
+        static float** audioOuts = nullptr;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        fPlugin.setTimePosition(timePosition);
+#else
+        // unused
+        (void)timePosition;
+#endif
+
+        updateParameterTriggers();
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fPortMidiOutBuffer = jackbridge_port_get_buffer(fPortMidiOut, nframes);
+        jackbridge_midi_clear_buffer(fPortMidiOutBuffer);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        fMidiEvents.clear();
+#endif
         void* const midiInBuf = jackbridge_port_get_buffer(fPortEventsIn, nframes);
 
-        if (const uint32_t eventCount = std::min(512u - midiEventCount, jackbridge_midi_get_event_count(midiInBuf)))
+        if (const uint32_t eventCount = std::min(kMaxMidiEvents, jackbridge_midi_get_event_count(midiInBuf)))
         {
             jack_midi_event_t jevent;
 
@@ -431,8 +1433,6 @@ protected:
                     const uint8_t control = jevent.buffer[1];
                     const uint8_t value   = jevent.buffer[2];
 
-                    /* NOTE: This is not optimal, we're iterating all parameters on every CC message.
-                             Since the JACK standalone is more of a test tool, this will do for now. */
                     for (uint32_t j=0, paramCount=fPlugin.getParameterCount(); j < paramCount; ++j)
                     {
                         if (fPlugin.isParameterOutput(j))
@@ -441,11 +1441,7 @@ protected:
                             continue;
 
                         const float scaled = static_cast<float>(value)/127.0f;
-                        const float fvalue = fPlugin.getParameterRanges(j).getUnnormalizedValue(scaled);
-                        fPlugin.setParameterValue(j, fvalue);
-#if DISTRHO_PLUGIN_HAS_UI
-                        fParametersChanged[j] = true;
-#endif
+                        fPlugin.setParameterValue(j, fPlugin.getParameterRanges(j).getUnnormalizedValue(scaled));
                         break;
                     }
                 }
@@ -456,31 +1452,18 @@ protected:
                     const uint8_t program = jevent.buffer[1];
 
                     if (program < fPlugin.getProgramCount())
-                    {
                         fPlugin.loadProgram(program);
-# if DISTRHO_PLUGIN_HAS_UI
-                        fProgramChanged = program;
-# endif
-                    }
                 }
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-                MidiEvent& midiEvent(midiEvents[midiEventCount++]);
-
-                midiEvent.frame = jevent.time;
-                midiEvent.size  = jevent.size;
-
-                if (midiEvent.size > MidiEvent::kDataSize)
-                    midiEvent.dataExt = jevent.buffer;
-                else
-                    std::memcpy(midiEvent.data, jevent.buffer, midiEvent.size);
+                fMidiEvents.append(jevent.time, jevent.buffer, static_cast<uint32_t>(jevent.size));
 #endif
             }
         }
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        fPlugin.run(audioIns, audioOuts, nframes, midiEvents, midiEventCount);
+        fPlugin.run(audioIns, audioOuts, nframes, fMidiEvents.events, fMidiEvents.count);
 #else
         fPlugin.run(audioIns, audioOuts, nframes);
 #endif
@@ -488,182 +1471,501 @@ protected:
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
         fPortMidiOutBuffer = nullptr;
 #endif
+
+        const uint64_t timeTaken = d_gettime_ns() - timeStart;
+        fTimeLast = timeTaken;
+        fTimeTotal += timeTaken;
+        ++fCycleCount;
+
+        if (timeTaken > fTimeMax)
+            fTimeMax = timeTaken;
     }
 
-    void jackShutdown()
+    // called from the JACK process thread for instances that did not run in the current cycle
+    void silence(const jack_nframes_t nframes)
     {
-        d_stderr("jack has shutdown, quitting now...");
-        fClient = nullptr;
-#if DISTRHO_PLUGIN_HAS_UI
-        fUI.quit();
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            std::memset(jackbridge_port_get_buffer(fPortAudioOuts[i], nframes), 0, sizeof(float)*nframes);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        jackbridge_midi_clear_buffer(jackbridge_port_get_buffer(fPortMidiOut, nframes));
 #endif
     }
 
+    PluginExporter* getPlugin() noexcept
+    {
+        return &fPlugin;
+    }
+
     // -------------------------------------------------------------------
+    // CPU statistics, written by the audio side, read from the main thread
 
-#if DISTRHO_PLUGIN_HAS_UI
-    void setParameterValue(const uint32_t index, const float value)
+    uint64_t getTimeLast()   const noexcept { return fTimeLast;   }
+    uint64_t getTimeMax()    const noexcept { return fTimeMax;    }
+    uint64_t getTimeTotal()  const noexcept { return fTimeTotal;  }
+    uint64_t getCycleCount() const noexcept { return fCycleCount; }
+
+private:
+    PluginExporter fPlugin;
+    jack_client_t* const fClient;
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+    jack_port_t* fPortAudioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+    jack_port_t* fPortAudioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+#endif
+    jack_port_t* fPortEventsIn;
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    jack_port_t* fPortMidiOut;
+    void*        fPortMidiOutBuffer;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEventList fMidiEvents;
+#endif
+
+    volatile uint64_t fTimeLast;
+    volatile uint64_t fTimeMax;
+    volatile uint64_t fTimeTotal;
+    volatile uint64_t fCycleCount;
+
+    // NOTE: no trigger support for JACK, simulate it here
+    void updateParameterTriggers()
     {
-        fPlugin.setParameterValue(index, value);
+        float defValue;
+
+        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        {
+            if ((fPlugin.getParameterHints(i) & kParameterIsTrigger) != kParameterIsTrigger)
+                continue;
+
+            defValue = fPlugin.getParameterRanges(i).def;
+
+            if (d_isNotEqual(defValue, fPlugin.getParameterValue(i)))
+                fPlugin.setParameterValue(i, defValue);
+        }
     }
 
-# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-    void sendNote(const uint8_t channel, const uint8_t note, const uint8_t velocity)
+#if DISTRHO_PLUGIN_WANT_PARAMETER_VALUE_CHANGE_REQUEST
+    static bool requestParameterValueChangeCallback(void* ptr, const uint32_t index, const float value)
     {
-        uint8_t midiData[3];
-        midiData[0] = (velocity != 0 ? 0x90 : 0x80) | channel;
-        midiData[1] = note;
-        midiData[2] = velocity;
-        fNotesRingBuffer.writeCustomData(midiData, 3);
-        fNotesRingBuffer.commitWrite();
+        PluginJackInstance* const self = (PluginJackInstance*)ptr;
+        DISTRHO_SAFE_ASSERT_RETURN(index < self->fPlugin.getParameterCount(), false);
+
+        self->fPlugin.setParameterValue(index, value);
+        return true;
     }
-# endif
+#endif
 
-# if DISTRHO_PLUGIN_WANT_STATE
-    void setState(const char* const key, const char* const value)
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
     {
-        fPlugin.setState(key, value);
+        PluginJackInstance* const self = (PluginJackInstance*)ptr;
+        DISTRHO_SAFE_ASSERT_RETURN(self->fPortMidiOutBuffer != nullptr, false);
+
+        return jackbridge_midi_event_write(self->fPortMidiOutBuffer,
+                                           midiEvent.frame,
+                                           midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data,
+                                           midiEvent.size) == 0;
+    }
+#endif
+
+    DISTRHO_DECLARE_NON_COPYABLE(PluginJackInstance)
+};
+
+// -----------------------------------------------------------------------
+
+// Wakes up the JACK process thread once all instances are done, waiting for it can have a deadline.
+// This is a binary semaphore, posting several times before a wait counts as one.
+// Deadlines use the monotonic clock, so they are not affected by changes to the system time.
+
+class PluginJackSemaphore
+{
+public:
+    PluginJackSemaphore() noexcept
+        : fCondition(),
+          fMutex(),
+          fPosted(false)
+    {
+#ifdef DISTRHO_OS_MAC
+        pthread_cond_init(&fCondition, nullptr);
+#else
+        pthread_condattr_t cattr;
+        pthread_condattr_init(&cattr);
+        pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+        pthread_cond_init(&fCondition, &cattr);
+        pthread_condattr_destroy(&cattr);
+#endif
+
+        pthread_mutexattr_t mattr;
+        pthread_mutexattr_init(&mattr);
+        pthread_mutexattr_setprotocol(&mattr, PTHREAD_PRIO_INHERIT);
+        pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_NORMAL);
+        pthread_mutex_init(&fMutex, &mattr);
+        pthread_mutexattr_destroy(&mattr);
+    }
+
+    ~PluginJackSemaphore() noexcept
+    {
+        pthread_cond_destroy(&fCondition);
+        pthread_mutex_destroy(&fMutex);
+    }
+
+    void post() noexcept
+    {
+        pthread_mutex_lock(&fMutex);
+        fPosted = true;
+        pthread_cond_signal(&fCondition);
+        pthread_mutex_unlock(&fMutex);
+    }
+
+    void wait() noexcept
+    {
+        pthread_mutex_lock(&fMutex);
+
+        while (! fPosted)
+            pthread_cond_wait(&fCondition, &fMutex);
+
+        fPosted = false;
+
+        pthread_mutex_unlock(&fMutex);
+    }
+
+    // returns false if the timeout passed without a post
+    bool timedWait(const uint64_t timeoutInNs) noexcept
+    {
+        struct timespec ts;
+#ifdef DISTRHO_OS_MAC
+        // relative timeout, no clock involved
+        ts.tv_sec  = static_cast<time_t>(timeoutInNs / 1000000000ULL);
+        ts.tv_nsec = static_cast<long>(timeoutInNs % 1000000000ULL);
+#else
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        const uint64_t deadline = static_cast<uint64_t>(ts.tv_nsec) + timeoutInNs;
+
+        ts.tv_sec += static_cast<time_t>(deadline / 1000000000ULL);
+        ts.tv_nsec = static_cast<long>(deadline % 1000000000ULL);
+#endif
+
+        pthread_mutex_lock(&fMutex);
+
+        while (! fPosted)
+        {
+#ifdef DISTRHO_OS_MAC
+            if (pthread_cond_timedwait_relative_np(&fCondition, &fMutex, &ts) != 0)
+#else
+            if (pthread_cond_timedwait(&fCondition, &fMutex, &ts) != 0)
+#endif
+                break;
+        }
+
+        const bool posted = fPosted;
+        fPosted = false;
+
+        pthread_mutex_unlock(&fMutex);
+        return posted;
+    }
+
+private:
+    pthread_cond_t  fCondition;
+    pthread_mutex_t fMutex;
+    bool            fPosted;
+
+    DISTRHO_DECLARE_NON_COPYABLE(PluginJackSemaphore)
+};
+
+// -----------------------------------------------------------------------
+
+class PluginJackMulti;
+
+class PluginJackWorker : public Thread
+{
+public:
+    PluginJackWorker(PluginJackMulti* const owner)
+        : Thread("PluginJackWorker"),
+          fOwner(owner),
+          fSignal() {}
+
+    void wakeUp() noexcept
+    {
+        fSignal.signal();
+    }
+
+    void stop() noexcept
+    {
+        signalThreadShouldExit();
+        fSignal.signal();
+        stopThread(-1);
+    }
+
+protected:
+    void run() override;
+
+private:
+    PluginJackMulti* const fOwner;
+    Signal fSignal;
+
+    DISTRHO_DECLARE_NON_COPYABLE(PluginJackWorker)
+};
+
+// -----------------------------------------------------------------------
+
+class PluginJackMulti
+{
+public:
+    PluginJackMulti(jack_client_t* const client,
+                    const uint32_t instanceCount,
+                    const uint32_t workerCount,
+                    const bool showStats,
+                    const char* const controlPath)
+        : fClient(client),
+          fInstances(new PluginJackInstance*[instanceCount]),
+          fInstanceCount(instanceCount),
+          fWorkers(workerCount != 0 ? new PluginJackWorker*[workerCount] : nullptr),
+          fWorkerCount(workerCount),
+          fBufferSize(d_lastBufferSize),
+          fSampleRate(d_lastSampleRate),
+          fProcessFrames(0),
+          fNextInstance(instanceCount),
+          fDoneInstances(instanceCount),
+          fLateInstances(0),
+          fSemaphore()
+    {
+        for (uint32_t i=0; i < fInstanceCount; ++i)
+            fInstances[i] = new PluginJackInstance(fClient, i);
+
+        for (uint32_t i=0; i < fWorkerCount; ++i)
+        {
+            fWorkers[i] = new PluginJackWorker(this);
+            fWorkers[i]->startThread(true);
+        }
+
+        jackbridge_set_buffer_size_callback(fClient, jackBufferSizeCallback, this);
+        jackbridge_set_sample_rate_callback(fClient, jackSampleRateCallback, this);
+        jackbridge_set_process_callback(fClient, jackProcessCallback, this);
+        jackbridge_set_xrun_callback(fClient, jackXrunCallback, nullptr);
+        jackbridge_on_shutdown(fClient, jackShutdownCallback, this);
+
+        jackbridge_activate(fClient);
+
+        d_stdout("Running %u instances of %s, using %u extra processing threads",
+                 fInstanceCount, DISTRHO_PLUGIN_NAME, fWorkerCount);
+        std::fflush(stdout);
+
+        uint64_t* const lastTimeTotals = new uint64_t[fInstanceCount];
+        uint64_t* const lastCycleCounts = new uint64_t[fInstanceCount];
+        std::memset(lastTimeTotals, 0, sizeof(uint64_t)*fInstanceCount);
+        std::memset(lastCycleCounts, 0, sizeof(uint64_t)*fInstanceCount);
+
+        PluginExporter** const plugins = new PluginExporter*[fInstanceCount];
+        for (uint32_t i=0; i < fInstanceCount; ++i)
+            plugins[i] = fInstances[i]->getPlugin();
+
+        {
+            PluginJackHeadlessLoop loop(plugins, fInstanceCount, controlPath);
+
+            static const uint64_t kStatsInterval = 5000;
+            uint64_t nextStatsTime = d_gettime_ms() + kStatsInterval;
+
+            for (int timeout = showStats ? static_cast<int>(kStatsInterval) : -1; loop.wait(timeout);)
+            {
+                if (! showStats)
+                    continue;
+
+                const uint64_t now = d_gettime_ms();
+
+                if (now >= nextStatsTime)
+                {
+                    printStats(lastTimeTotals, lastCycleCounts);
+                    nextStatsTime = now + kStatsInterval;
+                }
+
+                timeout = static_cast<int>(nextStatsTime - now);
+            }
+        }
+
+        delete[] plugins;
+        delete[] lastTimeTotals;
+        delete[] lastCycleCounts;
+    }
+
+    ~PluginJackMulti()
+    {
+        if (fClient != nullptr)
+            jackbridge_deactivate(fClient);
+
+        for (uint32_t i=0; i < fWorkerCount; ++i)
+        {
+            fWorkers[i]->stop();
+            delete fWorkers[i];
+        }
+
+        for (uint32_t i=0; i < fInstanceCount; ++i)
+            delete fInstances[i];
+
+        delete[] fWorkers;
+        delete[] fInstances;
+
+        if (fClient != nullptr)
+            jackbridge_client_close(fClient);
     }
-# endif
-#endif // DISTRHO_PLUGIN_HAS_UI
 
-    // NOTE: no trigger support for JACK, simulate it here
-    void updateParameterTriggers()
-    {
-        float defValue;
+    // -------------------------------------------------------------------
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+    // Process instances until there are none left to take for the current cycle.
+    // Called from the JACK process thread and all worker threads at the same time.
+    void processPendingInstances()
+    {
+        for (;;)
         {
-            if ((fPlugin.getParameterHints(i) & kParameterIsTrigger) != kParameterIsTrigger)
-                continue;
+            const uint32_t index = __atomic_fetch_add(&fNextInstance, 1, __ATOMIC_ACQ_REL);
 
-            defValue = fPlugin.getParameterRanges(i).def;
+            if (index >= fInstanceCount)
+                break;
 
-            if (d_isNotEqual(defValue, fPlugin.getParameterValue(i)))
-                fPlugin.setParameterValue(i, defValue);
+            fInstances[index]->process(__atomic_load_n(&fProcessFrames, __ATOMIC_RELAXED), fTimePosition);
+            finishInstance();
         }
     }
 
-    // -------------------------------------------------------------------
-
-private:
-    PluginExporter fPlugin;
-#if DISTRHO_PLUGIN_HAS_UI
-    UIExporter     fUI;
-#endif
+protected:
+    void finishInstance()
+    {
+        if (__atomic_add_fetch(&fDoneInstances, 1, __ATOMIC_ACQ_REL) == fInstanceCount)
+            fSemaphore.post();
+    }
 
-    jack_client_t* fClient;
+    void jackBufferSize(const jack_nframes_t nframes)
+    {
+        fBufferSize = nframes;
 
-#if DISTRHO_PLUGIN_NUM_INPUTS > 0
-    jack_port_t* fPortAudioIns[DISTRHO_PLUGIN_NUM_INPUTS];
-#endif
-#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
-    jack_port_t* fPortAudioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
-#endif
-    jack_port_t* fPortEventsIn;
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-    jack_port_t* fPortMidiOut;
-    void*        fPortMidiOutBuffer;
-#endif
-#if DISTRHO_PLUGIN_WANT_TIMEPOS
-    TimePosition fTimePosition;
-#endif
+        for (uint32_t i=0; i < fInstanceCount; ++i)
+            fInstances[i]->setBufferSize(nframes);
+    }
 
-    // Temporary data
-    float* fLastOutputValues;
+    void jackSampleRate(const jack_nframes_t nframes)
+    {
+        fSampleRate = nframes;
 
-#if DISTRHO_PLUGIN_HAS_UI
-    // Store DSP changes to send to UI
-    bool* fParametersChanged;
-# if DISTRHO_PLUGIN_WANT_PROGRAMS
-    int fProgramChanged;
-# endif
-# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-    SmallStackRingBuffer fNotesRingBuffer;
-# endif
-#endif
+        for (uint32_t i=0; i < fInstanceCount; ++i)
+            fInstances[i]->setSampleRate(nframes);
+    }
 
-    void setAudioPortMetadata(const AudioPort& port, jack_port_t* const jackport, const uint32_t index)
+    void jackProcess(const jack_nframes_t nframes)
     {
-        DISTRHO_SAFE_ASSERT_RETURN(jackport != nullptr,);
+        const uint64_t cycleStart = d_gettime_ns();
+        const uint64_t cycleTime  = static_cast<uint64_t>(static_cast<double>(nframes) / fSampleRate * 1e9);
 
-        const jack_uuid_t uuid = jackbridge_port_uuid(jackport);
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        updateTimePosition(fClient, fTimePosition);
+#endif
 
-        if (uuid == JACK_UUID_EMPTY_INITIALIZER)
-            return;
+        __atomic_store_n(&fProcessFrames, nframes, __ATOMIC_RELAXED);
+        __atomic_store_n(&fDoneInstances, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&fNextInstance, 0, __ATOMIC_RELEASE);
 
-        jackbridge_set_property(fClient, uuid, JACK_METADATA_PRETTY_NAME, port.name, "text/plain");
+        for (uint32_t i=0; i < fWorkerCount; ++i)
+            fWorkers[i]->wakeUp();
 
-        {
-            char strBuf[0xff];
-            snprintf(strBuf, sizeof(0xff)-1, "%u", index);
-            jackbridge_set_property(fClient, uuid, JACK_METADATA_ORDER, strBuf, "http://www.w3.org/2001/XMLSchema#integer");
-        }
+        // take part in the processing ourselves, then wait for the workers to finish theirs
+        processPendingInstances();
 
-        if (port.groupId != kPortGroupNone)
+        while (__atomic_load_n(&fDoneInstances, __ATOMIC_ACQUIRE) != fInstanceCount)
         {
-            const PortGroupWithId& portGroup(fPlugin.getPortGroupById(port.groupId));
-            jackbridge_set_property(fClient, uuid, JACK_METADATA_PORT_GROUP, portGroup.name, "text/plain");
-        }
+            const uint64_t elapsed = d_gettime_ns() - cycleStart;
 
-        if (port.hints & kAudioPortIsCV)
-        {
-            jackbridge_set_property(fClient, uuid, JACK_METADATA_SIGNAL_TYPE, "CV", "text/plain");
-        }
-        else
-        {
-            jackbridge_set_property(fClient, uuid, JACK_METADATA_SIGNAL_TYPE, "AUDIO", "text/plain");
-            return;
-        }
+            if (elapsed < cycleTime && fSemaphore.timedWait(cycleTime - elapsed))
+                continue;
 
-        // set cv ranges
-        const bool cvPortScaled = port.hints & kCVPortHasScaledRange;
+            // deadline passed, instances nobody started yet are silenced instead
+            const uint32_t next = __atomic_exchange_n(&fNextInstance, fInstanceCount, __ATOMIC_ACQ_REL);
 
-        if (port.hints & kCVPortHasBipolarRange)
-        {
-            if (cvPortScaled)
-            {
-                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-5", "http://www.w3.org/2001/XMLSchema#integer");
-                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "5", "http://www.w3.org/2001/XMLSchema#integer");
-            }
-            else
-            {
-                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-1", "http://www.w3.org/2001/XMLSchema#integer");
-                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "1", "http://www.w3.org/2001/XMLSchema#integer");
-            }
-        }
-        else if (port.hints & kCVPortHasNegativeUnipolarRange)
-        {
-            if (cvPortScaled)
+            for (uint32_t i=next; i < fInstanceCount; ++i)
             {
-                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-10", "http://www.w3.org/2001/XMLSchema#integer");
-                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "0", "http://www.w3.org/2001/XMLSchema#integer");
+                fInstances[i]->silence(nframes);
+                finishInstance();
             }
-            else
+
+            const uint32_t done    = __atomic_load_n(&fDoneInstances, __ATOMIC_ACQUIRE);
+            const uint32_t skipped = next < fInstanceCount ? fInstanceCount - next : 0;
+
+            if (skipped != 0 || done != fInstanceCount)
             {
-                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "-1", "http://www.w3.org/2001/XMLSchema#integer");
-                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "0", "http://www.w3.org/2001/XMLSchema#integer");
+                __atomic_add_fetch(&fLateInstances, skipped + fInstanceCount - done, __ATOMIC_RELAXED);
+                __atomic_add_fetch(&gXrunCount, 1, __ATOMIC_RELAXED);
             }
+
+            // the ones already running write into this cycle's port buffers, they must be done before returning
+            while (__atomic_load_n(&fDoneInstances, __ATOMIC_ACQUIRE) != fInstanceCount)
+                fSemaphore.wait();
+
+            break;
         }
-        else if (port.hints & kCVPortHasPositiveUnipolarRange)
+    }
+
+    void jackShutdown()
+    {
+        d_stderr("jack has shutdown, quitting now...");
+        fClient = nullptr;
+        triggerCloseSignal();
+    }
+
+    void printStats(uint64_t* const lastTimeTotals, uint64_t* const lastCycleCounts) const
+    {
+        const double cycleTimeInNs = static_cast<double>(fBufferSize) / fSampleRate * 1e9;
+
+        for (uint32_t i=0; i < fInstanceCount; ++i)
         {
-            if (cvPortScaled)
-            {
-                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "0", "http://www.w3.org/2001/XMLSchema#integer");
-                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "10", "http://www.w3.org/2001/XMLSchema#integer");
-            }
-            else
-            {
-                jackbridge_set_property(fClient, uuid, LV2_CORE__minimum, "0", "http://www.w3.org/2001/XMLSchema#integer");
-                jackbridge_set_property(fClient, uuid, LV2_CORE__maximum, "1", "http://www.w3.org/2001/XMLSchema#integer");
-            }
+            const PluginJackInstance* const instance = fInstances[i];
+            const uint64_t timeTotal  = instance->getTimeTotal();
+            const uint64_t cycleCount = instance->getCycleCount();
+
+            if (cycleCount == lastCycleCounts[i])
+                continue;
+
+            const double average = static_cast<double>(timeTotal - lastTimeTotals[i])
+                                 / static_cast<double>(cycleCount - lastCycleCounts[i]);
+
+            d_stdout("Instance %3u: DSP load avg %6.2f%%, last %6.2f%%, max %6.2f%%", i+1,
+                     average / cycleTimeInNs * 100.0,
+                     static_cast<double>(instance->getTimeLast()) / cycleTimeInNs * 100.0,
+                     static_cast<double>(instance->getTimeMax()) / cycleTimeInNs * 100.0);
+
+            lastTimeTotals[i]  = timeTotal;
+            lastCycleCounts[i] = cycleCount;
         }
+
+        d_stdout("Total xruns: %u, instances that missed their deadline: %u", gXrunCount, fLateInstances);
+        std::fflush(stdout);
     }
 
+private:
+    jack_client_t* fClient;
+
+    PluginJackInstance** const fInstances;
+    const uint32_t fInstanceCount;
+
+    PluginJackWorker** const fWorkers;
+    const uint32_t fWorkerCount;
+
+    uint32_t fBufferSize;
+    double   fSampleRate;
+
+    // shared between the JACK process thread and workers
+    jack_nframes_t fProcessFrames;
+    uint32_t fNextInstance;
+    uint32_t fDoneInstances;
+    uint32_t fLateInstances;
+    PluginJackSemaphore fSemaphore;
+    TimePosition fTimePosition;
+
     // -------------------------------------------------------------------
     // Callbacks
 
-    #define thisPtr ((PluginJack*)ptr)
+    #define thisPtr ((PluginJackMulti*)ptr)
 
     static int jackBufferSizeCallback(jack_nframes_t nframes, void* ptr)
     {
@@ -688,73 +1990,146 @@ private:
         thisPtr->jackShutdown();
     }
 
-#if DISTRHO_PLUGIN_HAS_UI
-    static void setParameterValueCallback(void* ptr, uint32_t index, float value)
-    {
-        thisPtr->setParameterValue(index, value);
-    }
-
-# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-    static void sendNoteCallback(void* ptr, uint8_t channel, uint8_t note, uint8_t velocity)
-    {
-        thisPtr->sendNote(channel, note, velocity);
-    }
-# endif
+    #undef thisPtr
 
-# if DISTRHO_PLUGIN_WANT_STATE
-    static void setStateCallback(void* ptr, const char* key, const char* value)
-    {
-        thisPtr->setState(key, value);
-    }
-# endif
-#endif // DISTRHO_PLUGIN_HAS_UI
+    DISTRHO_DECLARE_NON_COPYABLE(PluginJackMulti)
+};
 
-#if DISTRHO_PLUGIN_WANT_PARAMETER_VALUE_CHANGE_REQUEST
-    bool requestParameterValueChange(const uint32_t index, const float value)
+void PluginJackWorker::run()
+{
+    for (;;)
     {
-        DISTRHO_SAFE_ASSERT_RETURN(index < fPlugin.getParameterCount(), false);
+        fSignal.wait();
 
-        fPlugin.setParameterValue(index, value);
-# if DISTRHO_PLUGIN_HAS_UI
-        fParametersChanged[index] = true;
-# endif
-        return true;
-    }
+        if (shouldThreadExit())
+            break;
 
-    static bool requestParameterValueChangeCallback(void* ptr, const uint32_t index, const float value)
-    {
-        return thisPtr->requestParameterValueChange(index, value);
+        fOwner->processPendingInstances();
     }
-#endif
+}
 
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-    bool writeMidi(const MidiEvent& midiEvent)
-    {
-        DISTRHO_SAFE_ASSERT_RETURN(fPortMidiOutBuffer != nullptr, false);
+// -----------------------------------------------------------------------
 
-        return jackbridge_midi_event_write(fPortMidiOutBuffer,
-                                           midiEvent.frame,
-                                           midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data,
-                                           midiEvent.size) == 0;
-    }
+static uint32_t getNumberOfCPUs()
+{
+#ifdef DISTRHO_OS_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<uint32_t>(count) : 1;
+#endif
+}
 
-    static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
-    {
-        return thisPtr->writeMidi(midiEvent);
-    }
+static void setEnvironmentValue(const char* const name, const char* const value)
+{
+#ifdef DISTRHO_OS_WINDOWS
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
 #endif
+}
 
-    #undef thisPtr
-};
+static void printHelp(const char* const name)
+{
+    d_stdout("usage: %s [options]\n"
+             "\n"
+             "options:\n"
+             "  --instances N     run N plugin instances within a single client, each with its own ports\n"
+             "  --threads N       number of extra processing threads used for multiple instances\n"
+             "                    (defaults to the number of CPUs minus one, capped to the number of instances)\n"
+             "  --stats           print per-instance DSP load every 5 seconds (multiple instances only)\n"
+             "  --no-gui          do not show the plugin UI, the main thread sleeps until the process is closed\n"
+#ifndef DISTRHO_OS_WINDOWS
+             "  --control PATH    listen for text commands on a local socket (no UI only), send 'help' for a list\n"
+#endif
+             "  -h, --help        show this help and quit\n"
+             "\n"
+             "options used when JACK is not available and the native audio fallback is used (MIDI is not supported there):\n"
+             "  --device NAME     audio device index or name, defaults to the system default device\n"
+             "  --sample-rate N   sample rate in Hz, defaults to 48000\n"
+             "  --period-size N   period size in frames, defaults to 512\n"
+             "  --periods N       number of periods, defaults to the audio driver preference", name);
+}
 
 END_NAMESPACE_DISTRHO
 
 // -----------------------------------------------------------------------
 
-int main()
+int main(int argc, char* argv[])
 {
     USE_NAMESPACE_DISTRHO;
 
+    uint32_t instanceCount = 1;
+    uint32_t workerCount = 0;
+    bool workerCountSet = false;
+    bool showStats = false;
+    bool showUI = DISTRHO_PLUGIN_HAS_UI;
+    const char* controlPath = nullptr;
+
+    for (int i=1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+
+        if (std::strcmp(arg, "--instances") == 0 && i+1 < argc)
+        {
+            const int value = std::atoi(argv[++i]);
+            instanceCount = value > 1 ? static_cast<uint32_t>(value) : 1;
+        }
+        else if (std::strcmp(arg, "--threads") == 0 && i+1 < argc)
+        {
+            const int value = std::atoi(argv[++i]);
+            workerCount = value > 0 ? static_cast<uint32_t>(value) : 0;
+            workerCountSet = true;
+        }
+        else if (std::strcmp(arg, "--stats") == 0)
+        {
+            showStats = true;
+        }
+        else if (std::strcmp(arg, "--no-gui") == 0)
+        {
+            showUI = false;
+        }
+        else if (std::strcmp(arg, "--control") == 0 && i+1 < argc)
+        {
+            controlPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--device") == 0 && i+1 < argc)
+        {
+            setEnvironmentValue("DPF_RTAUDIO_DEVICE", argv[++i]);
+        }
+        else if (std::strcmp(arg, "--sample-rate") == 0 && i+1 < argc)
+        {
+            setEnvironmentValue("DPF_RTAUDIO_SAMPLE_RATE", argv[++i]);
+        }
+        else if (std::strcmp(arg, "--period-size") == 0 && i+1 < argc)
+        {
+            setEnvironmentValue("DPF_RTAUDIO_PERIOD_SIZE", argv[++i]);
+        }
+        else if (std::strcmp(arg, "--periods") == 0 && i+1 < argc)
+        {
+            setEnvironmentValue("DPF_RTAUDIO_PERIODS", argv[++i]);
+        }
+        else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0)
+        {
+            printHelp(argv[0]);
+            return 0;
+        }
+        else
+        {
+            d_stderr("Unknown or incomplete argument '%s'", arg);
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if (! workerCountSet)
+        workerCount = getNumberOfCPUs() - 1;
+
+    if (workerCount > instanceCount - 1)
+        workerCount = instanceCount - 1;
+
     jack_status_t  status = jack_status_t(0x0);
     jack_client_t* client = jackbridge_client_open(DISTRHO_PLUGIN_NAME, JackNoStartServer, &status);
 
@@ -808,7 +2183,26 @@ int main()
     d_lastSampleRate = jackbridge_get_sample_rate(client);
     d_lastCanRequestParameterValueChanges = true;
 
-    const PluginJack p(client);
+    if (instanceCount > 1)
+        showUI = false;
+
+    if (showUI && controlPath != nullptr)
+    {
+        d_stderr("The control socket is only available when running without UI, see --no-gui");
+        controlPath = nullptr;
+    }
+
+    if (instanceCount > 1)
+    {
+        const PluginJackMulti p(client, instanceCount, workerCount, showStats, controlPath);
+    }
+    else
+    {
+        const PluginJack p(client, showUI, controlPath);
+    }
+
+    if (gXrunCount != 0)
+        d_stdout("%u xruns happened during this session", gXrunCount);
 
     return 0;
 }
@@ -199,10 +199,9 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         // Get MIDI Events
-        uint32_t  midiEventCount = 0;
-        MidiEvent midiEvents[eventCount];
+        fMidiEvents.clear();
 
-        for (uint32_t i=0, j; i < eventCount; ++i)
+        for (uint32_t i=0; i < eventCount; ++i)
         {
             const snd_seq_event_t& seqEvent(events[i]);
 
@@ -210,67 +209,51 @@ public:
             if (seqEvent.data.note.channel > 0xF || seqEvent.data.control.channel > 0xF)
                 continue;
 
+            uint8_t data[MidiEvent::kDataSize] = { 0, 0, 0, 0 };
+            uint32_t size = 3;
+
             switch (seqEvent.type)
             {
             case SND_SEQ_EVENT_NOTEOFF:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0x80 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = 0;
-                midiEvents[j].data[3] = 0;
+                data[0] = 0x80 + seqEvent.data.note.channel;
+                data[1] = seqEvent.data.note.note;
                 break;
             case SND_SEQ_EVENT_NOTEON:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0x90 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = seqEvent.data.note.velocity;
-                midiEvents[j].data[3] = 0;
+                data[0] = 0x90 + seqEvent.data.note.channel;
+                data[1] = seqEvent.data.note.note;
+                data[2] = seqEvent.data.note.velocity;
                 break;
             case SND_SEQ_EVENT_KEYPRESS:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xA0 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = seqEvent.data.note.velocity;
-                midiEvents[j].data[3] = 0;
+                data[0] = 0xA0 + seqEvent.data.note.channel;
+                data[1] = seqEvent.data.note.note;
+                data[2] = seqEvent.data.note.velocity;
                 break;
             case SND_SEQ_EVENT_CONTROLLER:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xB0 + seqEvent.data.control.channel;
-                midiEvents[j].data[1] = seqEvent.data.control.param;
-                midiEvents[j].data[2] = seqEvent.data.control.value;
-                midiEvents[j].data[3] = 0;
+                data[0] = 0xB0 + seqEvent.data.control.channel;
+                data[1] = seqEvent.data.control.param;
+                data[2] = seqEvent.data.control.value;
                 break;
             case SND_SEQ_EVENT_CHANPRESS:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 2;
-                midiEvents[j].data[0] = 0xD0 + seqEvent.data.control.channel;
-                midiEvents[j].data[1] = seqEvent.data.control.value;
-                midiEvents[j].data[2] = 0;
-                midiEvents[j].data[3] = 0;
+                data[0] = 0xD0 + seqEvent.data.control.channel;
+                data[1] = seqEvent.data.control.value;
+                size = 2;
                 break;
-            case SND_SEQ_EVENT_PITCHBEND:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xE0 + seqEvent.data.control.channel;
-                uint16_t tempvalue = seqEvent.data.control.value + 8192;
-                midiEvents[j].data[1] = tempvalue & 0x7F;
-                midiEvents[j].data[2] = tempvalue >> 7;
-                midiEvents[j].data[3] = 0;
+            case SND_SEQ_EVENT_PITCHBEND: {
+                const uint16_t tempvalue = seqEvent.data.control.value + 8192;
+                data[0] = 0xE0 + seqEvent.data.control.channel;
+                data[1] = tempvalue & 0x7F;
+                data[2] = tempvalue >> 7;
                 break;
             }
+            default:
+                continue;
+            }
+
+            if (! fMidiEvents.appendFixed(seqEvent.time.tick, data, size))
+                break;
         }
 
-        fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, midiEvents, midiEventCount);
+        fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, fMidiEvents.events, fMidiEvents.count);
 #else
         fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount);
 #endif
@@ -375,6 +358,9 @@ private:
 
     // Temporary data
     LADSPA_Data* fLastControlValues;
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEventList fMidiEvents;
+#endif
 
     // -------------------------------------------------------------------
 
@@ -553,9 +539,11 @@ static const struct DescriptorInitializer
         // Create dummy plugin to get data from
         d_lastBufferSize = 512;
         d_lastSampleRate = 44100.0;
+        d_nextPluginIsDummy = true;
         const PluginExporter plugin(nullptr, nullptr, nullptr);
         d_lastBufferSize = 0;
         d_lastSampleRate = 0.0;
+        d_nextPluginIsDummy = false;
 
         // Get port count, init
         ulong port = 0;
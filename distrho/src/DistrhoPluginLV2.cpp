@@ -51,11 +51,16 @@
 # define DISTRHO_PLUGIN_LV2_STATE_PREFIX "urn:distrho:"
 #endif
 
-#define DISTRHO_LV2_USE_EVENTS_IN  (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI) || DISTRHO_PLUGIN_WANT_STATEFILES)
-#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
+#define DISTRHO_LV2_USE_EVENTS_IN  (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI) || DISTRHO_PLUGIN_WANT_STATEFILES || (DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI))
+#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || ((DISTRHO_PLUGIN_WANT_STATE || DISTRHO_PLUGIN_WANT_VISUAL_STREAM) && DISTRHO_PLUGIN_HAS_UI))
 
 START_NAMESPACE_DISTRHO
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI
+// maximum number of visualization frames sent to the UI per second, the rest are dropped
+static const double kVisualFrameRate = 30.0;
+#endif
+
 typedef std::map<const String, String> StringToStringMap;
 typedef std::map<const LV2_URID, String> UridToStringMap;
 
@@ -157,6 +162,15 @@ public:
         // unused
         (void)fWorker;
 #endif
+
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI
+        fVisualFrame = nullptr;
+        fVisualFrameCount = 0;
+        fVisualFrameTimer = 0;
+        fVisualStreamUsers = 0;
+        // the stream is attached from the audio thread once a UI shows up, so allocate here
+        fPlugin.allocateVisualStream();
+#endif
     }
 
     ~PluginLv2()
@@ -315,7 +329,7 @@ public:
     {
         // cache midi input and time position first
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        uint32_t midiEventCount = 0;
+        fMidiEvents.clear();
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS
@@ -327,27 +341,8 @@ public:
 # if DISTRHO_PLUGIN_WANT_MIDI_INPUT
             if (event->body.type == fURIDs.midiEvent)
             {
-                if (midiEventCount >= kMaxMidiEvents)
-                    continue;
-
-                const uint8_t* const data((const uint8_t*)(event + 1));
-
-                MidiEvent& midiEvent(fMidiEvents[midiEventCount++]);
-
-                midiEvent.frame = event->time.frames;
-                midiEvent.size  = event->body.size;
-
-                if (midiEvent.size > MidiEvent::kDataSize)
-                {
-                    midiEvent.dataExt = data;
-                    std::memset(midiEvent.data, 0, MidiEvent::kDataSize);
-                }
-                else
-                {
-                    midiEvent.dataExt = nullptr;
-                    std::memcpy(midiEvent.data, data, midiEvent.size);
-                }
-
+                fMidiEvents.append(static_cast<uint32_t>(event->time.frames),
+                                   (const uint8_t*)(event + 1), event->body.size);
                 continue;
             }
 # endif
@@ -541,6 +536,29 @@ public:
         }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI
+        // check for UIs opening or closing
+        LV2_ATOM_SEQUENCE_FOREACH(fPortEventsIn, event)
+        {
+            if (event == nullptr)
+                break;
+
+            if (event->body.type != fURIDs.dpfVisualStream || event->body.size != sizeof(int32_t))
+                continue;
+
+            if (((const LV2_Atom_Int*)&event->body)->body != 0)
+            {
+                if (fVisualStreamUsers++ == 0)
+                    fPlugin.attachVisualStream();
+            }
+            else if (fVisualStreamUsers != 0 && --fVisualStreamUsers == 0)
+            {
+                fPlugin.detachVisualStream();
+                fVisualFrame = nullptr;
+            }
+        }
+#endif
+
         // check for messages from UI or files
 #if DISTRHO_PLUGIN_WANT_STATE && (DISTRHO_PLUGIN_HAS_UI || DISTRHO_PLUGIN_WANT_STATEFILES)
         LV2_ATOM_SEQUENCE_FOREACH(fPortEventsIn, event)
@@ -607,7 +625,7 @@ public:
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-            fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, fMidiEvents, midiEventCount);
+            fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, fMidiEvents.events, fMidiEvents.count);
 #else
             fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount);
 #endif
@@ -730,6 +748,48 @@ public:
         }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI
+        // only the latest frame is kept, and sent no faster than the UI can show it
+        {
+            fEventsOutData.initIfNeeded(fURIDs.atomSequence);
+
+            uint32_t count;
+            while (const float* const values = fPlugin.readVisualFrame(count))
+            {
+                fVisualFrame = values;
+                fVisualFrameCount = count;
+            }
+
+            const uint32_t interval = static_cast<uint32_t>(fSampleRate / kVisualFrameRate + 0.5);
+
+            if (fVisualFrameTimer < interval)
+                fVisualFrameTimer += sampleCount;
+
+            if (fVisualFrame != nullptr && fVisualFrameTimer >= interval)
+            {
+                const uint32_t size = sizeof(LV2_Atom_Vector_Body) + fVisualFrameCount * sizeof(float);
+
+                if (sizeof(LV2_Atom_Event) + size <= fEventsOutData.capacity - fEventsOutData.offset)
+                {
+                    LV2_Atom_Event* const aev = (LV2_Atom_Event*)(LV2_ATOM_CONTENTS(LV2_Atom_Sequence, fEventsOutData.port) + fEventsOutData.offset);
+                    aev->time.frames = 0;
+                    aev->body.type   = fURIDs.atomVector;
+                    aev->body.size   = size;
+
+                    LV2_Atom_Vector_Body* const vecBody = (LV2_Atom_Vector_Body*)LV2_ATOM_BODY(&aev->body);
+                    vecBody->child_size = sizeof(float);
+                    vecBody->child_type = fURIDs.atomFloat;
+                    std::memcpy(vecBody + 1, fVisualFrame, fVisualFrameCount * sizeof(float));
+
+                    fEventsOutData.growBy(lv2_atom_pad_size(sizeof(LV2_Atom_Event) + size));
+                }
+
+                fVisualFrame = nullptr;
+                fVisualFrameTimer -= interval;
+            }
+        }
+#endif
+
 #if DISTRHO_LV2_USE_EVENTS_OUT
         fEventsOutData.endRun();
 #endif
@@ -828,11 +888,8 @@ public:
 
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
         // Update state
-        for (StringToStringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-        {
-            const String& key = cit->first;
-            fStateMap[key] = fPlugin.getState(key);
-        }
+        for (StringToStringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+            it->second = fPlugin.getState(it->first);
 # endif
     }
 #endif
@@ -844,11 +901,8 @@ public:
     {
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
         // Update current state
-        for (StringToStringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-        {
-            const String& key = cit->first;
-            fStateMap[key] = fPlugin.getState(key);
-        }
+        for (StringToStringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+            it->second = fPlugin.getState(it->first);
 # endif
 
         String dpf_lv2_key;
@@ -1052,7 +1106,7 @@ private:
     float* fLastControlValues;
     double fSampleRate;
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-    MidiEvent fMidiEvents[kMaxMidiEvents];
+    MidiEventList fMidiEvents;
 #endif
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
     TimePosition fTimePosition;
@@ -1118,6 +1172,13 @@ private:
     } fEventsOutData;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI
+    const float* fVisualFrame;
+    uint32_t     fVisualFrameCount;
+    uint32_t     fVisualFrameTimer;
+    uint32_t     fVisualStreamUsers;
+#endif
+
     // LV2 URIDs
     struct URIDs {
         const LV2_URID_Map* _uridMap;
@@ -1131,7 +1192,9 @@ private:
         LV2_URID atomSequence;
         LV2_URID atomString;
         LV2_URID atomURID;
+        LV2_URID atomVector;
         LV2_URID dpfKeyValue;
+        LV2_URID dpfVisualStream;
         LV2_URID midiEvent;
         LV2_URID patchProperty;
         LV2_URID patchValue;
@@ -1157,7 +1220,9 @@ private:
               atomSequence(map(LV2_ATOM__Sequence)),
               atomString(map(LV2_ATOM__String)),
               atomURID(map(LV2_ATOM__URID)),
+              atomVector(map(LV2_ATOM__Vector)),
               dpfKeyValue(map(DISTRHO_PLUGIN_LV2_STATE_PREFIX "KeyValueState")),
+              dpfVisualStream(map(DISTRHO_PLUGIN_LV2_STATE_PREFIX "VisualStream")),
               midiEvent(map(LV2_MIDI__MidiEvent)),
               patchProperty(map(LV2_PATCH__property)),
               patchValue(map(LV2_PATCH__value)),
@@ -1195,11 +1260,11 @@ private:
             return;
 
         // check if key already exists
+        const StringView keyView(key);
+
         for (StringToStringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
         {
-            const String& dkey(it->first);
-
-            if (dkey == key)
+            if (keyView == it->first)
             {
                 it->second = newValue;
                 return;
@@ -1293,6 +1358,10 @@ static LV2_Handle lv2_instantiate(const LV2_Descriptor*, double sampleRate, cons
     const LV2_URID_Map*       uridMap = nullptr;
     const LV2_Worker_Schedule* worker = nullptr;
     const LV2_ControlInputPort_Change_Request* ctrlInPortChangeReq = nullptr;
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+    bool fixedBlockLength = false;
+    bool powerOf2BlockLength = false;
+#endif
 
     for (int i=0; features[i] != nullptr; ++i)
     {
@@ -1304,6 +1373,12 @@ static LV2_Handle lv2_instantiate(const LV2_Descriptor*, double sampleRate, cons
             worker = (const LV2_Worker_Schedule*)features[i]->data;
         else if (std::strcmp(features[i]->URI, LV2_CONTROL_INPUT_PORT_CHANGE_REQUEST_URI) == 0)
             ctrlInPortChangeReq = (const LV2_ControlInputPort_Change_Request*)features[i]->data;
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+        else if (std::strcmp(features[i]->URI, LV2_BUF_SIZE__fixedBlockLength) == 0)
+            fixedBlockLength = true;
+        else if (std::strcmp(features[i]->URI, LV2_BUF_SIZE__powerOf2BlockLength) == 0)
+            powerOf2BlockLength = true;
+#endif
     }
 
     if (options == nullptr)
@@ -1369,6 +1444,30 @@ static LV2_Handle lv2_instantiate(const LV2_Descriptor*, double sampleRate, cons
     d_lastSampleRate = sampleRate;
     d_lastCanRequestParameterValueChanges = ctrlInPortChangeReq != nullptr;
 
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+    // skip re-blocking (and its latency) if every host block is guaranteed to be a multiple of ours
+    d_lastHostHasAlignedBlocks = false;
+
+    if (fixedBlockLength)
+    {
+        d_lastHostHasAlignedBlocks = (d_lastBufferSize % kFixedBlockSize) == 0;
+    }
+    else if (powerOf2BlockLength && (kFixedBlockSize & (kFixedBlockSize - 1)) == 0)
+    {
+        const LV2_URID minBlockLengthURID = uridMap->map(uridMap->handle, LV2_BUF_SIZE__minBlockLength);
+        const LV2_URID atomIntURID = uridMap->map(uridMap->handle, LV2_ATOM__Int);
+
+        for (int i=0; options[i].key != 0; ++i)
+        {
+            if (options[i].key == minBlockLengthURID && options[i].type == atomIntURID)
+            {
+                d_lastHostHasAlignedBlocks = *(const int*)options[i].value >= static_cast<int>(kFixedBlockSize);
+                break;
+            }
+        }
+    }
+#endif
+
     return new PluginLv2(sampleRate, uridMap, worker, ctrlInPortChangeReq, usingNominal);
 }
 
@@ -74,8 +74,8 @@
 # define DISTRHO_LV2_UI_TYPE "UI"
 #endif
 
-#define DISTRHO_LV2_USE_EVENTS_IN  (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI) || DISTRHO_PLUGIN_WANT_STATEFILES)
-#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
+#define DISTRHO_LV2_USE_EVENTS_IN  (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI) || DISTRHO_PLUGIN_WANT_STATEFILES || (DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI))
+#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || ((DISTRHO_PLUGIN_WANT_STATE || DISTRHO_PLUGIN_WANT_VISUAL_STREAM) && DISTRHO_PLUGIN_HAS_UI))
 
 #define DISTRHO_BYPASS_PARAMETER_NAME "lv2_enabled"
 
@@ -102,6 +102,10 @@ static const char* const lv2ManifestPluginOptionalFeatures[] =
     LV2_CORE__hardRTCapable,
 #endif
     LV2_BUF_SIZE__boundedBlockLength,
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+    LV2_BUF_SIZE__fixedBlockLength,
+    LV2_BUF_SIZE__powerOf2BlockLength,
+#endif
     nullptr
 };
 
@@ -122,6 +126,9 @@ static const char* const lv2ManifestPluginSupportedOptions[] =
 {
     LV2_BUF_SIZE__nominalBlockLength,
     LV2_BUF_SIZE__maxBlockLength,
+#if DISTRHO_PLUGIN_FIXED_BLOCK_SIZE
+    LV2_BUF_SIZE__minBlockLength,
+#endif
     LV2_PARAMETERS__sampleRate,
     nullptr
 };
@@ -226,9 +233,11 @@ void lv2_generate_ttl(const char* const basename)
     // Dummy plugin to get data from
     d_lastBufferSize = 512;
     d_lastSampleRate = 44100.0;
+    d_nextPluginIsDummy = true;
     PluginExporter plugin(nullptr, nullptr, nullptr);
     d_lastBufferSize = 0;
     d_lastSampleRate = 0.0;
+    d_nextPluginIsDummy = false;
 
     const String pluginDLL(basename);
     const String pluginTTL(pluginDLL + ".ttl");
@@ -601,6 +610,9 @@ void lv2_generate_ttl(const char* const basename)
 # endif
 # if DISTRHO_PLUGIN_WANT_TIMEPOS
             pluginString += "        atom:supports <" LV2_TIME__Position "> ;\n";
+# endif
+# if (DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI)
+            pluginString += "        atom:supports <" LV2_ATOM__Int "> ;\n";
 # endif
             pluginString += "    ] ;\n\n";
             ++portIndex;
@@ -612,11 +624,20 @@ void lv2_generate_ttl(const char* const basename)
             pluginString += "        lv2:index " + String(portIndex) + " ;\n";
             pluginString += "        lv2:name \"Events Output\" ;\n";
             pluginString += "        lv2:symbol \"lv2_events_out\" ;\n";
+# if (DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI)
+            // room for one full visualization frame, on top of the regular events
+            pluginString += "        rsz:minimumSize " + String(DISTRHO_PLUGIN_MINIMUM_BUFFER_SIZE
+                                                              + d_nextPowerOf2(kMaxVisualFrameSize * sizeof(float) + 64)) + " ;\n";
+# else
             pluginString += "        rsz:minimumSize " + String(DISTRHO_PLUGIN_MINIMUM_BUFFER_SIZE) + " ;\n";
+# endif
             pluginString += "        atom:bufferType atom:Sequence ;\n";
 # if (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI)
             pluginString += "        atom:supports <" LV2_ATOM__String "> ;\n";
 # endif
+# if (DISTRHO_PLUGIN_WANT_VISUAL_STREAM && DISTRHO_PLUGIN_HAS_UI)
+            pluginString += "        atom:supports <" LV2_ATOM__Vector "> ;\n";
+# endif
 # if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
             pluginString += "        atom:supports <" LV2_MIDI__MidiEvent "> ;\n";
 # endif
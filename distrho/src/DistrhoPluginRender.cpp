@@ -0,0 +1,978 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "DistrhoPluginInternal.hpp"
+
+#include "../extra/Thread.hpp"
+#include "../extra/Time.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <vector>
+
+#ifndef DISTRHO_OS_WINDOWS
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#if DISTRHO_PLUGIN_NUM_OUTPUTS == 0
+# error Offline rendering requires at least 1 audio output
+#endif
+
+// -----------------------------------------------------------------------
+// Offline renderer, streams audio files through the plugin as fast as possible.
+// Input files are WAV (16/24/32-bit integer or 32/64-bit float) or raw interleaved 32-bit float,
+// output files are written in the same container as 32-bit float.
+// NOTE: sample data is read and written as little-endian, matching the WAV format.
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+// Memory-mapped file, read-only for input and read-write for output
+
+class MappedFile
+{
+public:
+    MappedFile() noexcept
+        : fData(nullptr),
+          fSize(0),
+#ifdef DISTRHO_OS_WINDOWS
+          fFile(INVALID_HANDLE_VALUE),
+          fMapping(nullptr)
+#else
+          fFile(-1)
+#endif
+    {
+    }
+
+    ~MappedFile() noexcept
+    {
+        close();
+    }
+
+    bool openForReading(const char* const filename) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData == nullptr, false);
+
+#ifdef DISTRHO_OS_WINDOWS
+        fFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (fFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (! GetFileSizeEx(fFile, &size) || size.QuadPart == 0)
+            return close();
+
+        fMapping = CreateFileMappingA(fFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (fMapping == nullptr)
+            return close();
+
+        fData = static_cast<uint8_t*>(MapViewOfFile(fMapping, FILE_MAP_READ, 0, 0, 0));
+        if (fData == nullptr)
+            return close();
+
+        fSize = static_cast<uint64_t>(size.QuadPart);
+#else
+        fFile = ::open(filename, O_RDONLY);
+
+        if (fFile == -1)
+            return false;
+
+        struct stat st;
+        if (::fstat(fFile, &st) != 0 || st.st_size == 0)
+            return close();
+
+        void* const data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fFile, 0);
+        if (data == MAP_FAILED)
+            return close();
+
+        ::madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        fData = static_cast<uint8_t*>(data);
+        fSize = static_cast<uint64_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    bool createForWriting(const char* const filename, const uint64_t size) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData == nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(size != 0, false);
+
+#ifdef DISTRHO_OS_WINDOWS
+        fFile = CreateFileA(filename, GENERIC_READ|GENERIC_WRITE, 0, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (fFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        fMapping = CreateFileMappingA(fFile, nullptr, PAGE_READWRITE,
+                                      static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xffffffff), nullptr);
+        if (fMapping == nullptr)
+            return close();
+
+        fData = static_cast<uint8_t*>(MapViewOfFile(fMapping, FILE_MAP_WRITE, 0, 0, 0));
+        if (fData == nullptr)
+            return close();
+#else
+        fFile = ::open(filename, O_RDWR|O_CREAT|O_TRUNC, 0644);
+
+        if (fFile == -1)
+            return false;
+
+        if (::ftruncate(fFile, static_cast<off_t>(size)) != 0)
+            return close();
+
+        void* const data = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ|PROT_WRITE, MAP_SHARED, fFile, 0);
+        if (data == MAP_FAILED)
+            return close();
+
+        ::madvise(data, static_cast<size_t>(size), MADV_SEQUENTIAL);
+
+        fData = static_cast<uint8_t*>(data);
+#endif
+        fSize = size;
+        return true;
+    }
+
+    // always returns false, so it can be used as error return value
+    bool close() noexcept
+    {
+#ifdef DISTRHO_OS_WINDOWS
+        if (fData != nullptr)
+            UnmapViewOfFile(fData);
+        if (fMapping != nullptr)
+            CloseHandle(fMapping);
+        if (fFile != INVALID_HANDLE_VALUE)
+            CloseHandle(fFile);
+
+        fMapping = nullptr;
+        fFile = INVALID_HANDLE_VALUE;
+#else
+        if (fData != nullptr)
+            ::munmap(fData, static_cast<size_t>(fSize));
+        if (fFile != -1)
+            ::close(fFile);
+
+        fFile = -1;
+#endif
+        fData = nullptr;
+        fSize = 0;
+        return false;
+    }
+
+    uint8_t* getData() const noexcept
+    {
+        return fData;
+    }
+
+    uint64_t getSize() const noexcept
+    {
+        return fSize;
+    }
+
+private:
+    uint8_t* fData;
+    uint64_t fSize;
+#ifdef DISTRHO_OS_WINDOWS
+    HANDLE fFile;
+    HANDLE fMapping;
+#else
+    int fFile;
+#endif
+
+    DISTRHO_DECLARE_NON_COPYABLE(MappedFile)
+};
+
+// -----------------------------------------------------------------------
+// Audio file formats
+
+enum SampleFormat {
+    kSampleFormatInt16,
+    kSampleFormatInt24,
+    kSampleFormatInt32,
+    kSampleFormatFloat32,
+    kSampleFormatFloat64
+};
+
+struct AudioFileInfo {
+    const uint8_t* data;
+    uint64_t frames;
+    uint32_t channels;
+    uint32_t sampleRate;
+    uint32_t bytesPerFrame;
+    SampleFormat format;
+};
+
+static const uint32_t kWavHeaderSize = 44;
+
+static inline
+uint16_t readLE16(const uint8_t* const data) noexcept
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+static inline
+uint32_t readLE32(const uint8_t* const data) noexcept
+{
+    return static_cast<uint32_t>(data[0])
+        | (static_cast<uint32_t>(data[1]) << 8)
+        | (static_cast<uint32_t>(data[2]) << 16)
+        | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static inline
+void writeLE16(uint8_t* const data, const uint16_t value) noexcept
+{
+    data[0] = value & 0xff;
+    data[1] = (value >> 8) & 0xff;
+}
+
+static inline
+void writeLE32(uint8_t* const data, const uint32_t value) noexcept
+{
+    data[0] = value & 0xff;
+    data[1] = (value >> 8) & 0xff;
+    data[2] = (value >> 16) & 0xff;
+    data[3] = (value >> 24) & 0xff;
+}
+
+static bool parseWavFile(const uint8_t* const data, const uint64_t size, AudioFileInfo& info, const char* const filename)
+{
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        d_stderr("%s: not a WAV file", filename);
+        return false;
+    }
+
+    bool hasFormat = false;
+    uint16_t format = 0, bitsPerSample = 0;
+    info.channels = 0;
+
+    for (uint64_t offset = 12; offset + 8 <= size;)
+    {
+        const uint8_t* const chunk = data + offset;
+        uint64_t chunkSize = readLE32(chunk + 4);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && offset + 8 + chunkSize <= size)
+        {
+            format          = readLE16(chunk + 8);
+            info.channels   = readLE16(chunk + 10);
+            info.sampleRate = readLE32(chunk + 12);
+            bitsPerSample   = readLE16(chunk + 22);
+
+            // WAVE_FORMAT_EXTENSIBLE, real format is in the first 2 bytes of the sub-format GUID
+            if (format == 0xfffe && chunkSize >= 40)
+                format = readLE16(chunk + 32);
+
+            hasFormat = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            if (! hasFormat)
+                break;
+
+            // some writers leave the data size unset when streaming, use the rest of the file
+            if (chunkSize == 0 || chunkSize == 0xffffffff || offset + 8 + chunkSize > size)
+                chunkSize = size - offset - 8;
+
+            if (format == 1 && bitsPerSample == 16)
+                info.format = kSampleFormatInt16;
+            else if (format == 1 && bitsPerSample == 24)
+                info.format = kSampleFormatInt24;
+            else if (format == 1 && bitsPerSample == 32)
+                info.format = kSampleFormatInt32;
+            else if (format == 3 && bitsPerSample == 32)
+                info.format = kSampleFormatFloat32;
+            else if (format == 3 && bitsPerSample == 64)
+                info.format = kSampleFormatFloat64;
+            else
+            {
+                d_stderr("%s: unsupported WAV sample format %u with %u bits", filename, format, bitsPerSample);
+                return false;
+            }
+
+            if (info.channels == 0 || info.sampleRate == 0)
+            {
+                d_stderr("%s: invalid WAV format chunk", filename);
+                return false;
+            }
+
+            info.bytesPerFrame = info.channels * bitsPerSample / 8;
+            info.data = chunk + 8;
+            info.frames = chunkSize / info.bytesPerFrame;
+            return true;
+        }
+
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    d_stderr("%s: WAV file has no audio data", filename);
+    return false;
+}
+
+static void writeWavHeader(uint8_t* const data, const uint32_t channels, const uint32_t sampleRate, const uint64_t frames)
+{
+    const uint32_t dataSize = static_cast<uint32_t>(frames * channels * sizeof(float));
+
+    std::memcpy(data, "RIFF", 4);
+    writeLE32(data + 4, kWavHeaderSize - 8 + dataSize);
+    std::memcpy(data + 8, "WAVE", 4);
+
+    std::memcpy(data + 12, "fmt ", 4);
+    writeLE32(data + 16, 16);
+    writeLE16(data + 20, 3); // IEEE float
+    writeLE16(data + 22, static_cast<uint16_t>(channels));
+    writeLE32(data + 24, sampleRate);
+    writeLE32(data + 28, sampleRate * channels * sizeof(float));
+    writeLE16(data + 32, static_cast<uint16_t>(channels * sizeof(float)));
+    writeLE16(data + 34, 32);
+
+    std::memcpy(data + 36, "data", 4);
+    writeLE32(data + 40, dataSize);
+}
+
+static inline
+float readSample(const uint8_t* const data, const SampleFormat format) noexcept
+{
+    switch (format)
+    {
+    case kSampleFormatInt16:
+        return static_cast<float>(static_cast<int16_t>(readLE16(data))) / 32768.0f;
+    case kSampleFormatInt24:
+        return static_cast<float>(static_cast<int32_t>((static_cast<uint32_t>(data[0]) << 8)
+                                                     | (static_cast<uint32_t>(data[1]) << 16)
+                                                     | (static_cast<uint32_t>(data[2]) << 24)) >> 8) / 8388608.0f;
+    case kSampleFormatInt32:
+        return static_cast<float>(static_cast<double>(static_cast<int32_t>(readLE32(data))) / 2147483648.0);
+    case kSampleFormatFloat32: {
+        float value;
+        std::memcpy(&value, data, sizeof(float));
+        return value;
+    }
+    case kSampleFormatFloat64: {
+        double value;
+        std::memcpy(&value, data, sizeof(double));
+        return static_cast<float>(value);
+    }
+    }
+
+    return 0.0f;
+}
+
+// -----------------------------------------------------------------------
+// Parameter automation, loaded from a text file with one `frame parameter value` event per line.
+// The parameter can be given by index or symbol, lines starting with '#' are ignored.
+
+struct AutomationEvent {
+    uint64_t frame;
+    uint32_t index;
+    float value;
+
+    bool operator<(const AutomationEvent& other) const noexcept
+    {
+        return frame < other.frame;
+    }
+};
+
+static bool loadAutomation(const char* const filename, const PluginExporter& plugin, std::vector<AutomationEvent>& events)
+{
+    FILE* const file = std::fopen(filename, "r");
+
+    if (file == nullptr)
+    {
+        d_stderr("%s: cannot open automation file", filename);
+        return false;
+    }
+
+    char line[0xff+1];
+    char param[0xff+1];
+    unsigned long long frame;
+    double value;
+    bool ok = true;
+
+    for (uint lineNumber = 1; std::fgets(line, sizeof(line), file) != nullptr; ++lineNumber)
+    {
+        const char* start = line;
+        while (*start == ' ' || *start == '\t')
+            ++start;
+
+        if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0')
+            continue;
+
+        if (std::sscanf(start, "%llu %255s %lf", &frame, param, &value) != 3)
+        {
+            d_stderr("%s:%u: invalid automation event", filename, lineNumber);
+            ok = false;
+            break;
+        }
+
+        const uint32_t count = plugin.getParameterCount();
+        uint32_t index = count;
+
+        if (param[0] >= '0' && param[0] <= '9')
+        {
+            index = static_cast<uint32_t>(std::atoi(param));
+        }
+        else
+        {
+            for (uint32_t i=0; i < count; ++i)
+            {
+                if (plugin.getParameterSymbol(i) == param)
+                {
+                    index = i;
+                    break;
+                }
+            }
+        }
+
+        if (index >= count || plugin.isParameterOutput(index))
+        {
+            d_stderr("%s:%u: invalid parameter '%s'", filename, lineNumber, param);
+            ok = false;
+            break;
+        }
+
+        AutomationEvent event;
+        event.frame = frame;
+        event.index = index;
+        event.value = plugin.getParameterRanges(index).getFixedValue(static_cast<float>(value));
+        events.push_back(event);
+    }
+
+    std::fclose(file);
+
+    // keep the original order of events happening at the same frame
+    std::stable_sort(events.begin(), events.end());
+    return ok;
+}
+
+// -----------------------------------------------------------------------
+// Render settings and job queue, shared between all threads
+
+struct RenderJob {
+    String input;
+    String output;
+};
+
+struct RenderOptions {
+    uint32_t blockSize;
+    bool raw;
+    uint32_t rawChannels;
+    uint32_t rawSampleRate;
+    std::vector<AutomationEvent> automation;
+};
+
+// -----------------------------------------------------------------------
+// A single plugin instance with its processing buffers, one per thread
+
+class PluginRenderer
+{
+public:
+    PluginRenderer(const RenderOptions& options)
+        : fPlugin(nullptr, nullptr, nullptr),
+          fOptions(options),
+          fBuffers(new float[options.blockSize * (DISTRHO_PLUGIN_NUM_INPUTS + DISTRHO_PLUGIN_NUM_OUTPUTS)])
+    {
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+            fAudioIns[i] = fBuffers + options.blockSize * i;
+#endif
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            fAudioOuts[i] = fBuffers + options.blockSize * (DISTRHO_PLUGIN_NUM_INPUTS + i);
+    }
+
+    ~PluginRenderer()
+    {
+        fPlugin.deactivateIfNeeded();
+        delete[] fBuffers;
+    }
+
+    const PluginExporter& getPlugin() const noexcept
+    {
+        return fPlugin;
+    }
+
+    bool render(const RenderJob& job)
+    {
+        const char* const inputFilename = job.input.buffer();
+        const char* const outputFilename = job.output.buffer();
+
+        MappedFile input;
+
+        if (! input.openForReading(inputFilename))
+        {
+            d_stderr("%s: cannot open file: %s", inputFilename, std::strerror(errno));
+            return false;
+        }
+
+        AudioFileInfo info;
+
+        if (fOptions.raw)
+        {
+            info.data = input.getData();
+            info.channels = fOptions.rawChannels;
+            info.sampleRate = fOptions.rawSampleRate;
+            info.bytesPerFrame = fOptions.rawChannels * sizeof(float);
+            info.format = kSampleFormatFloat32;
+            info.frames = input.getSize() / info.bytesPerFrame;
+        }
+        else if (! parseWavFile(input.getData(), input.getSize(), info, inputFilename))
+        {
+            return false;
+        }
+
+        if (info.frames == 0)
+        {
+            d_stderr("%s: file has no audio data", inputFilename);
+            return false;
+        }
+
+        const uint32_t headerSize = fOptions.raw ? 0 : kWavHeaderSize;
+        const uint64_t outputSize = headerSize + info.frames * DISTRHO_PLUGIN_NUM_OUTPUTS * sizeof(float);
+
+        if (! fOptions.raw && outputSize > 0xffffffff)
+        {
+            d_stderr("%s: output is too big for a WAV file", inputFilename);
+            return false;
+        }
+
+        MappedFile output;
+
+        if (! output.createForWriting(outputFilename, outputSize))
+        {
+            d_stderr("%s: cannot create file: %s", outputFilename, std::strerror(errno));
+            return false;
+        }
+
+        if (! fOptions.raw)
+            writeWavHeader(output.getData(), DISTRHO_PLUGIN_NUM_OUTPUTS, info.sampleRate, info.frames);
+
+        const uint64_t timeStart = d_gettime_ns();
+
+        process(info, reinterpret_cast<float*>(output.getData() + headerSize));
+
+        const double timeTaken = static_cast<double>(d_gettime_ns() - timeStart) / 1e9;
+        const double duration = static_cast<double>(info.frames) / info.sampleRate;
+
+        d_stdout("%s: rendered %.2f seconds of audio in %.3f seconds (%.1fx realtime)",
+                 outputFilename, duration, timeTaken, timeTaken > 0.0 ? duration / timeTaken : 0.0);
+        return true;
+    }
+
+private:
+    PluginExporter fPlugin;
+    const RenderOptions& fOptions;
+
+    float* const fBuffers;
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+    float* fAudioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+#endif
+    float* fAudioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+
+    void process(const AudioFileInfo& info, float* const output)
+    {
+        // start every file from a clean state
+        fPlugin.deactivateIfNeeded();
+        fPlugin.setSampleRate(info.sampleRate, true);
+
+        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        {
+            if (! fPlugin.isParameterOutput(i))
+                fPlugin.setParameterValue(i, fPlugin.getParameterRanges(i).def);
+        }
+
+        fPlugin.activate();
+
+#if DISTRHO_PLUGIN_WANT_LATENCY
+        // render extra frames at the end and drop the same amount from the start
+        const uint64_t latency = fPlugin.getLatency();
+#else
+        const uint64_t latency = 0;
+#endif
+        const uint64_t totalFrames = info.frames + latency;
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        TimePosition timePosition;
+        timePosition.playing = true;
+        timePosition.bbt.valid = false;
+#endif
+
+        const std::vector<AutomationEvent>& automation(fOptions.automation);
+        const size_t automationCount = automation.size();
+        size_t automationIndex = 0;
+
+        for (uint64_t frame = 0; frame < totalFrames;)
+        {
+            for (; automationIndex < automationCount && automation[automationIndex].frame <= frame; ++automationIndex)
+                fPlugin.setParameterValue(automation[automationIndex].index, automation[automationIndex].value);
+
+            // split blocks at automation events, so that they are sample accurate
+            uint32_t frames = static_cast<uint32_t>(std::min<uint64_t>(fOptions.blockSize, totalFrames - frame));
+
+            if (automationIndex < automationCount && automation[automationIndex].frame < frame + frames)
+                frames = static_cast<uint32_t>(automation[automationIndex].frame - frame);
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+            readInput(info, frame, frames);
+            const float** const audioIns = const_cast<const float**>(fAudioIns);
+#else
+            static const float** const audioIns = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+            timePosition.frame = frame;
+            fPlugin.setTimePosition(timePosition);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            fPlugin.run(audioIns, fAudioOuts, frames, nullptr, 0);
+#else
+            fPlugin.run(audioIns, fAudioOuts, frames);
+#endif
+
+            writeOutput(output, frame, frames, latency, info.frames);
+            frame += frames;
+        }
+    }
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+    void readInput(const AudioFileInfo& info, const uint64_t frame, const uint32_t frames)
+    {
+        // past the end of the file, used for latency compensation
+        const uint32_t available = frame < info.frames
+                                 ? static_cast<uint32_t>(std::min<uint64_t>(frames, info.frames - frame))
+                                 : 0;
+
+        const uint32_t bytesPerSample = info.bytesPerFrame / info.channels;
+
+        for (uint32_t c=0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+        {
+            float* const buffer = fAudioIns[c];
+
+            // mono files are sent to all plugin inputs, missing channels are silent
+            if (c >= info.channels && info.channels != 1)
+            {
+                std::memset(buffer, 0, sizeof(float)*frames);
+                continue;
+            }
+
+            const uint8_t* data = info.data + frame * info.bytesPerFrame + (info.channels == 1 ? 0 : c) * bytesPerSample;
+
+            for (uint32_t i=0; i < available; ++i, data += info.bytesPerFrame)
+                buffer[i] = readSample(data, info.format);
+
+            if (available != frames)
+                std::memset(buffer + available, 0, sizeof(float)*(frames - available));
+        }
+    }
+#endif
+
+    void writeOutput(float* const output, const uint64_t frame, const uint32_t frames,
+                     const uint64_t latency, const uint64_t totalFrames)
+    {
+        // skip the initial latency
+        const uint32_t skip = frame < latency ? static_cast<uint32_t>(std::min<uint64_t>(frames, latency - frame)) : 0;
+
+        if (skip == frames)
+            return;
+
+        const uint64_t outFrame = frame + skip - latency;
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(frames - skip, totalFrames - outFrame));
+
+        float* out = output + outFrame * DISTRHO_PLUGIN_NUM_OUTPUTS;
+
+        for (uint32_t i=skip; i < skip + count; ++i)
+            for (uint32_t c=0; c < DISTRHO_PLUGIN_NUM_OUTPUTS; ++c)
+                *out++ = fAudioOuts[c][i];
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(PluginRenderer)
+};
+
+// -----------------------------------------------------------------------
+
+class RenderQueue
+{
+public:
+    RenderQueue(const std::vector<RenderJob>& jobs)
+        : fJobs(jobs),
+          fNextJob(0),
+          fFailedJobs(0) {}
+
+    // called from all threads, takes jobs until the queue is empty
+    void process(PluginRenderer* const renderer)
+    {
+        for (;;)
+        {
+            const uint32_t index = __atomic_fetch_add(&fNextJob, 1, __ATOMIC_RELAXED);
+
+            if (index >= fJobs.size())
+                break;
+
+            if (! renderer->render(fJobs[index]))
+                __atomic_add_fetch(&fFailedJobs, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    uint32_t getFailedJobCount() const noexcept
+    {
+        return __atomic_load_n(&fFailedJobs, __ATOMIC_RELAXED);
+    }
+
+private:
+    const std::vector<RenderJob>& fJobs;
+    uint32_t fNextJob;
+    uint32_t fFailedJobs;
+
+    DISTRHO_DECLARE_NON_COPYABLE(RenderQueue)
+};
+
+class RenderWorker : public Thread
+{
+public:
+    RenderWorker(RenderQueue& queue, PluginRenderer* const renderer)
+        : Thread("RenderWorker"),
+          fQueue(queue),
+          fRenderer(renderer) {}
+
+protected:
+    void run() override
+    {
+        fQueue.process(fRenderer);
+    }
+
+private:
+    RenderQueue& fQueue;
+    PluginRenderer* const fRenderer;
+
+    DISTRHO_DECLARE_NON_COPYABLE(RenderWorker)
+};
+
+// -----------------------------------------------------------------------
+
+static uint32_t getNumberOfCPUs()
+{
+#ifdef DISTRHO_OS_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<uint32_t>(count) : 1;
+#endif
+}
+
+static const char* getBaseName(const char* const filename)
+{
+    const char* base = filename;
+
+    for (const char* c = filename; *c != '\0'; ++c)
+    {
+        if (*c == '/' || *c == '\\')
+            base = c + 1;
+    }
+
+    return base;
+}
+
+static void printHelp(const char* const name)
+{
+    d_stdout("usage: %s [options] <input> <output> [<input> <output> ...]\n"
+             "       %s [options] --output-dir <dir> <input> [<input> ...]\n"
+             "\n"
+             "Render audio files through " DISTRHO_PLUGIN_NAME " as fast as possible.\n"
+             "Input files can be 16/24/32-bit integer or 32/64-bit float WAV, output is always 32-bit float.\n"
+             "\n"
+             "options:\n"
+             "  --automation FILE   apply parameter automation, one \"frame parameter value\" event per line\n"
+             "                      (parameters are given by index or symbol)\n"
+             "  --block-size N      maximum number of frames processed at once, defaults to 4096\n"
+             "  --jobs N            number of files rendered in parallel, defaults to the number of CPUs\n"
+             "  --output-dir DIR    write outputs to DIR using the input filenames\n"
+             "  --raw               read and write raw interleaved 32-bit float files instead of WAV\n"
+             "  --channels N        number of channels in raw input files, defaults to %u\n"
+             "  --sample-rate N     sample rate of raw input files, defaults to 48000\n"
+             "  -h, --help          show this help and quit",
+             name, name, static_cast<uint>(std::max(1, DISTRHO_PLUGIN_NUM_INPUTS)));
+}
+
+END_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    USE_NAMESPACE_DISTRHO;
+
+    RenderOptions options;
+    options.blockSize = 4096;
+    options.raw = false;
+    options.rawChannels = std::max(1, DISTRHO_PLUGIN_NUM_INPUTS);
+    options.rawSampleRate = 48000;
+
+    const char* automationFile = nullptr;
+    const char* outputDir = nullptr;
+    uint32_t threadCount = getNumberOfCPUs();
+    std::vector<const char*> files;
+
+    for (int i=1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+
+        if (std::strcmp(arg, "--automation") == 0 && i+1 < argc)
+        {
+            automationFile = argv[++i];
+        }
+        else if (std::strcmp(arg, "--block-size") == 0 && i+1 < argc)
+        {
+            const int value = std::atoi(argv[++i]);
+            options.blockSize = value > 0 ? static_cast<uint32_t>(value) : 4096;
+        }
+        else if (std::strcmp(arg, "--jobs") == 0 && i+1 < argc)
+        {
+            const int value = std::atoi(argv[++i]);
+            threadCount = value > 0 ? static_cast<uint32_t>(value) : 1;
+        }
+        else if (std::strcmp(arg, "--output-dir") == 0 && i+1 < argc)
+        {
+            outputDir = argv[++i];
+        }
+        else if (std::strcmp(arg, "--raw") == 0)
+        {
+            options.raw = true;
+        }
+        else if (std::strcmp(arg, "--channels") == 0 && i+1 < argc)
+        {
+            const int value = std::atoi(argv[++i]);
+            options.rawChannels = value > 0 ? static_cast<uint32_t>(value) : 1;
+        }
+        else if (std::strcmp(arg, "--sample-rate") == 0 && i+1 < argc)
+        {
+            const int value = std::atoi(argv[++i]);
+            options.rawSampleRate = value > 0 ? static_cast<uint32_t>(value) : 48000;
+        }
+        else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0)
+        {
+            printHelp(argv[0]);
+            return 0;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            d_stderr("Unknown or incomplete argument '%s'", arg);
+            printHelp(argv[0]);
+            return 1;
+        }
+        else
+        {
+            files.push_back(arg);
+        }
+    }
+
+    std::vector<RenderJob> jobs;
+
+    if (outputDir != nullptr)
+    {
+        for (size_t i=0; i < files.size(); ++i)
+        {
+            RenderJob job;
+            job.input = files[i];
+            job.output = outputDir;
+            job.output += "/";
+            job.output += getBaseName(files[i]);
+            jobs.push_back(job);
+        }
+    }
+    else
+    {
+        if (files.size() % 2 != 0)
+        {
+            d_stderr("Missing output filename for '%s'", files.back());
+            return 1;
+        }
+
+        for (size_t i=0; i < files.size(); i += 2)
+        {
+            RenderJob job;
+            job.input = files[i];
+            job.output = files[i+1];
+            jobs.push_back(job);
+        }
+    }
+
+    if (jobs.empty())
+    {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+    if (threadCount > jobs.size())
+        threadCount = static_cast<uint32_t>(jobs.size());
+
+    // plugin instances must be created serially, they take their initial values from these globals
+    d_lastBufferSize = options.blockSize;
+    d_lastSampleRate = options.rawSampleRate;
+
+    std::vector<PluginRenderer*> renderers;
+    for (uint32_t i=0; i < threadCount; ++i)
+        renderers.push_back(new PluginRenderer(options));
+
+    if (automationFile != nullptr && ! loadAutomation(automationFile, renderers[0]->getPlugin(), options.automation))
+    {
+        for (uint32_t i=0; i < threadCount; ++i)
+            delete renderers[i];
+        return 1;
+    }
+
+    const uint64_t timeStart = d_gettime_ns();
+
+    RenderQueue queue(jobs);
+    std::vector<RenderWorker*> workers;
+
+    // the main thread renders too, using the first plugin instance
+    for (uint32_t i=1; i < threadCount; ++i)
+    {
+        RenderWorker* const worker = new RenderWorker(queue, renderers[i]);
+        worker->startThread();
+        workers.push_back(worker);
+    }
+
+    queue.process(renderers[0]);
+
+    // the queue is empty at this point, this only waits for the other threads to finish their jobs
+    for (size_t i=0; i < workers.size(); ++i)
+    {
+        workers[i]->stopThread(-1);
+        delete workers[i];
+    }
+
+    for (uint32_t i=0; i < threadCount; ++i)
+        delete renderers[i];
+
+    const uint32_t failed = queue.getFailedJobCount();
+
+    d_stdout("Rendered %u of %u files in %.3f seconds using %u threads",
+             static_cast<uint32_t>(jobs.size()) - failed, static_cast<uint32_t>(jobs.size()),
+             static_cast<double>(d_gettime_ns() - timeStart) / 1e9, threadCount);
+
+    return failed == 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------
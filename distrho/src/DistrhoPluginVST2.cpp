@@ -199,9 +199,19 @@ public:
     {
 # if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         fNotesRingBuffer.setRingBuffer(&uiHelper->notesRingBuffer, false);
+# endif
+# if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        fPlugin->attachVisualStream();
 # endif
     }
 
+# if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+    ~UIVst()
+    {
+        fPlugin->detachVisualStream();
+    }
+# endif
+
     // -------------------------------------------------------------------
 
     void idle()
@@ -215,6 +225,12 @@ public:
             }
         }
 
+# if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        uint32_t visualFrameCount;
+        while (const float* const visualFrame = fPlugin->readVisualFrame(visualFrameCount))
+            fUI.visualFrameReceived(visualFrame, visualFrameCount);
+# endif
+
         fUI.plugin_idle();
     }
 
@@ -503,10 +519,6 @@ public:
                 parameterValues[i] = NAN;
         }
 
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        fMidiEventCount = 0;
-#endif
-
 #if DISTRHO_PLUGIN_HAS_UI
         fVstUI           = nullptr;
         fVstRect.top     = 0;
@@ -651,7 +663,7 @@ public:
             if (value != 0)
             {
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-                fMidiEventCount = 0;
+                fMidiEvents.clear();
 
                 // tell host we want MIDI events
                 hostCallback(audioMasterWantMidi);
@@ -670,6 +682,18 @@ public:
                 if (sampleRate != 0.0)
                     fPlugin.setSampleRate(sampleRate, true);
 
+#if DISTRHO_PLUGIN_WANT_LATENCY
+                // initialDelay was set from the dummy instance, update it with the real one,
+                // which includes the buffering for fixed block sizes
+                const int latency = static_cast<int>(fPlugin.getLatency());
+
+                if (fEffect->initialDelay != latency)
+                {
+                    fEffect->initialDelay = latency;
+                    hostCallback(audioMasterIOChanged);
+                }
+#endif
+
                 fPlugin.activate();
             }
             else
@@ -722,11 +746,8 @@ public:
 
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
                 // Update current state from plugin side
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-                {
-                    const String& key = cit->first;
-                    fStateMap[key] = fPlugin.getState(key);
-                }
+                for (StringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+                    it->second = fPlugin.getState(it->first);
 # endif
 
 # if DISTRHO_PLUGIN_WANT_STATE
@@ -798,11 +819,8 @@ public:
             {
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
                 // Update current state
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-                {
-                    const String& key = cit->first;
-                    fStateMap[key] = fPlugin.getState(key);
-                }
+                for (StringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+                    it->second = fPlugin.getState(it->first);
 # endif
 
                 String chunkStr;
@@ -963,13 +981,8 @@ public:
                         break;
                     if (vstMidiEvent->type != kVstMidiType)
                         continue;
-                    if (fMidiEventCount >= kMaxMidiEvents)
+                    if (! fMidiEvents.appendFixed(static_cast<uint32_t>(vstMidiEvent->deltaFrames), vstMidiEvent->midiData, 3))
                         break;
-
-                    MidiEvent& midiEvent(fMidiEvents[fMidiEventCount++]);
-                    midiEvent.frame  = vstMidiEvent->deltaFrames;
-                    midiEvent.size   = 3;
-                    std::memcpy(midiEvent.data, vstMidiEvent->midiData, sizeof(uint8_t)*3);
                 }
             }
             break;
@@ -1150,29 +1163,23 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
 # if DISTRHO_PLUGIN_HAS_UI
-        if (fMidiEventCount != kMaxMidiEvents && fNotesRingBuffer.isDataAvailableForReading())
+        if (! fMidiEvents.isFull() && fNotesRingBuffer.isDataAvailableForReading())
         {
             uint8_t midiData[3];
-            uint32_t frame = fMidiEventCount != 0 ? fMidiEvents[fMidiEventCount-1].frame : 0;
+            uint32_t frame = fMidiEvents.count != 0 ? fMidiEvents.events[fMidiEvents.count-1].frame : 0;
 
             while (fNotesRingBuffer.isDataAvailableForReading())
             {
                 if (! fNotesRingBuffer.readCustomData(midiData, 3))
                     break;
-
-                MidiEvent& midiEvent(fMidiEvents[fMidiEventCount++]);
-                midiEvent.frame = frame;
-                midiEvent.size  = 3;
-                std::memcpy(midiEvent.data, midiData, 3);
-
-                if (fMidiEventCount == kMaxMidiEvents)
+                if (! fMidiEvents.append(frame, midiData, 3))
                     break;
             }
         }
 # endif
 
-        fPlugin.run(inputs, outputs, sampleFrames, fMidiEvents, fMidiEventCount);
-        fMidiEventCount = 0;
+        fPlugin.run(inputs, outputs, sampleFrames, fMidiEvents.events, fMidiEvents.count);
+        fMidiEvents.clear();
 #else
         fPlugin.run(inputs, outputs, sampleFrames);
 #endif
@@ -1196,8 +1203,7 @@ private:
     char fProgramName[32+1];
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-    uint32_t  fMidiEventCount;
-    MidiEvent fMidiEvents[kMaxMidiEvents];
+    MidiEventList fMidiEvents;
 #endif
 
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
@@ -1356,11 +1362,11 @@ private:
             return;
 
         // check if key already exists
+        const StringView keyView(key);
+
         for (StringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
         {
-            const String& dkey(it->first);
-
-            if (dkey == key)
+            if (keyView == it->first)
             {
                 it->second = newValue;
                 return;
@@ -1395,6 +1401,7 @@ static intptr_t vst_dispatcherCallback(AEffect* effect, int32_t opcode, int32_t
         d_lastBufferSize = 512;
         d_lastSampleRate = 44100.0;
         d_lastCanRequestParameterValueChanges = true;
+        d_nextPluginIsDummy = true;
     }
 
     // Create dummy plugin to get data from
@@ -1406,6 +1413,7 @@ static intptr_t vst_dispatcherCallback(AEffect* effect, int32_t opcode, int32_t
         d_lastBufferSize = 0;
         d_lastSampleRate = 0.0;
         d_lastCanRequestParameterValueChanges = false;
+        d_nextPluginIsDummy = false;
 
         *(PluginExporter**)ptr = &plugin;
         return 0;
@@ -1693,6 +1701,9 @@ const AEffect* VSTPluginMain(audioMasterCallback audioMaster)
     effect->numPrograms = 1;
     effect->numInputs   = DISTRHO_PLUGIN_NUM_INPUTS;
     effect->numOutputs  = DISTRHO_PLUGIN_NUM_OUTPUTS;
+#if DISTRHO_PLUGIN_WANT_LATENCY
+    effect->initialDelay = static_cast<int>(plugin->getLatency());
+#endif
 
     // plugin flags
     effect->flags |= effFlagsCanReplacing;
@@ -185,9 +185,11 @@ static void gPluginInit()
 
     d_lastBufferSize = 512;
     d_lastSampleRate = 44100.0;
+    d_nextPluginIsDummy = true;
     gPluginInfo = new PluginExporter(nullptr, nullptr, nullptr);
     d_lastBufferSize = 0;
     d_lastSampleRate = 0.0;
+    d_nextPluginIsDummy = false;
 
     dpf_tuid_class[3] = dpf_tuid_component[3] = dpf_tuid_controller[3]
         = dpf_tuid_processor[3] = dpf_tuid_view[3] = gPluginInfo->getUniqueId();
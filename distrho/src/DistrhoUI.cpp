@@ -186,6 +186,12 @@ void UI::sampleRateChanged(double)
 {
 }
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+void UI::visualFrameReceived(const float*, uint32_t)
+{
+}
+#endif
+
 /* ------------------------------------------------------------------------------------------------------------
  * UI Callbacks (optional) */
 
@@ -32,6 +32,103 @@ static const sendNoteFunc sendNoteCallback = nullptr;
 
 // -----------------------------------------------------------------------
 
+/**
+   Parameter values waiting to be sent or applied on the next idle tick.
+   Only the latest value per index is kept, and indexes are returned in the order they first changed.
+ */
+struct PendingParameterValues {
+    PendingParameterValues() noexcept
+        : values(nullptr),
+          isPending(nullptr),
+          order(nullptr),
+          count(0),
+          size(0) {}
+
+    ~PendingParameterValues()
+    {
+        delete[] values;
+        delete[] isPending;
+        delete[] order;
+    }
+
+    void set(const uint32_t index, const float value)
+    {
+        if (index >= size)
+            grow(index);
+
+        values[index] = value;
+
+        if (isPending[index])
+            return;
+
+        isPending[index] = true;
+        order[count++] = index;
+    }
+
+    uint32_t getCount() const noexcept
+    {
+        return count;
+    }
+
+    uint32_t getIndex(const uint32_t i) const noexcept
+    {
+        return order[i];
+    }
+
+    float getValue(const uint32_t i) const noexcept
+    {
+        return values[order[i]];
+    }
+
+    void clear() noexcept
+    {
+        for (uint32_t i=0; i < count; ++i)
+            isPending[order[i]] = false;
+
+        count = 0;
+    }
+
+private:
+    float*    values;
+    bool*     isPending;
+    uint32_t* order;
+    uint32_t  count;
+    uint32_t  size;
+
+    void grow(const uint32_t index)
+    {
+        uint32_t newSize = size != 0 ? size : 32;
+        while (newSize <= index)
+            newSize *= 2;
+
+        float*    const newValues    = new float[newSize];
+        bool*     const newIsPending = new bool[newSize];
+        uint32_t* const newOrder     = new uint32_t[newSize];
+
+        std::memset(newIsPending, 0, sizeof(bool)*newSize);
+
+        if (size != 0)
+        {
+            std::memcpy(newValues, values, sizeof(float)*size);
+            std::memcpy(newIsPending, isPending, sizeof(bool)*size);
+            std::memcpy(newOrder, order, sizeof(uint32_t)*count);
+        }
+
+        delete[] values;
+        delete[] isPending;
+        delete[] order;
+
+        values    = newValues;
+        isPending = newIsPending;
+        order     = newOrder;
+        size      = newSize;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(PendingParameterValues)
+};
+
+// -----------------------------------------------------------------------
+
 struct OscData {
     lo_address  addr;
     const char* path;
@@ -66,6 +163,42 @@ struct OscData {
         lo_send(addr, targetPath, "if", index, value);
     }
 
+    // sends all pending values as control messages, bundled to avoid flooding the socket
+    void send_controls(const PendingParameterValues& pending) const
+    {
+        // keep each bundle well under the usual UDP packet size
+        static const uint32_t kMaxMessagesPerBundle = 64;
+
+        const uint32_t count = pending.getCount();
+
+        if (count == 0)
+            return;
+
+        if (count == 1)
+            return send_control(static_cast<int32_t>(pending.getIndex(0)), pending.getValue(0));
+
+        char targetPath[std::strlen(path)+9];
+        std::strcpy(targetPath, path);
+        std::strcat(targetPath, "/control");
+
+        for (uint32_t i=0; i < count;)
+        {
+            const lo_bundle bundle = lo_bundle_new(LO_TT_IMMEDIATE);
+            DISTRHO_SAFE_ASSERT_RETURN(bundle != nullptr,);
+
+            for (uint32_t j=0; j < kMaxMessagesPerBundle && i < count; ++i, ++j)
+            {
+                const lo_message message = lo_message_new();
+                lo_message_add_int32(message, static_cast<int32_t>(pending.getIndex(i)));
+                lo_message_add_float(message, pending.getValue(i));
+                lo_bundle_add_message(bundle, targetPath, message);
+            }
+
+            lo_send_bundle(addr, bundle);
+            lo_bundle_free_messages(bundle);
+        }
+    }
+
     void send_midi(uchar data[4]) const
     {
         char targetPath[std::strlen(path)+6];
@@ -100,7 +233,9 @@ public:
         : fUI(this, 0, sampleRate, nullptr,
               setParameterCallback, setStateCallback, sendNoteCallback, nullptr, nullptr),
           fHostClosed(false),
-          fOscData(oscData)
+          fOscData(oscData),
+          fIncomingParameterValues(),
+          fOutgoingParameterValues()
     {
         fUI.setWindowTitle(uiTitle);
     }
@@ -108,7 +243,10 @@ public:
     ~UIDssi()
     {
         if (fOscData.server != nullptr && ! fHostClosed)
+        {
+            flushOutgoingParameterValues();
             fOscData.send_exiting();
+        }
     }
 
     void exec_start()
@@ -123,7 +261,9 @@ public:
         if (fHostClosed)
             return;
 
+        flushIncomingParameterValues();
         fUI.exec_idle();
+        flushOutgoingParameterValues();
     }
 
     // -------------------------------------------------------------------
@@ -131,18 +271,23 @@ public:
 #if DISTRHO_PLUGIN_WANT_STATE
     void dssiui_configure(const char* key, const char* value)
     {
+        // keep host messages in the order they were received
+        flushIncomingParameterValues();
         fUI.stateChanged(key, value);
     }
 #endif
 
     void dssiui_control(ulong index, float value)
     {
-        fUI.parameterChanged(index, value);
+        // applied on the next idle, so a full parameter dump from the host only updates the UI once
+        fIncomingParameterValues.set(index, value);
     }
 
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
     void dssiui_program(ulong bank, ulong program)
     {
+        // values received before the program change must not be applied on top of it later
+        flushIncomingParameterValues();
         fUI.programLoaded(bank * 128 + program);
     }
 #endif
@@ -179,7 +324,8 @@ protected:
         if (fOscData.server == nullptr)
             return;
 
-        fOscData.send_control(rindex, value);
+        // sent on the next idle, together with any other changes
+        fOutgoingParameterValues.set(rindex, value);
     }
 
     void setState(const char* const key, const char* const value)
@@ -187,6 +333,8 @@ protected:
         if (fOscData.server == nullptr)
             return;
 
+        // keep parameter changes ordered before the state change
+        flushOutgoingParameterValues();
         fOscData.send_configure(key, value);
     }
 
@@ -204,6 +352,9 @@ protected:
             note,
             velocity
         };
+
+        // keep parameter changes ordered before the note
+        flushOutgoingParameterValues();
         fOscData.send_midi(mdata);
     }
 #endif
@@ -214,6 +365,25 @@ private:
 
     const OscData& fOscData;
 
+    PendingParameterValues fIncomingParameterValues;
+    PendingParameterValues fOutgoingParameterValues;
+
+    void flushIncomingParameterValues()
+    {
+        for (uint32_t i=0, count=fIncomingParameterValues.getCount(); i < count; ++i)
+            fUI.parameterChanged(fIncomingParameterValues.getIndex(i), fIncomingParameterValues.getValue(i));
+
+        fIncomingParameterValues.clear();
+    }
+
+    void flushOutgoingParameterValues()
+    {
+        if (fOscData.server != nullptr)
+            fOscData.send_controls(fOutgoingParameterValues);
+
+        fOutgoingParameterValues.clear();
+    }
+
     // -------------------------------------------------------------------
     // Callbacks
 
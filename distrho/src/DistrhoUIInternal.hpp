@@ -189,6 +189,16 @@ public:
     }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+    void visualFrameReceived(const float* const values, const uint32_t count)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(ui != nullptr,);
+        DISTRHO_SAFE_ASSERT_RETURN(values != nullptr && count != 0,);
+
+        ui->visualFrameReceived(values, count);
+    }
+#endif
+
     // -------------------------------------------------------------------
 
 #if DISTRHO_UI_IS_STANDALONE
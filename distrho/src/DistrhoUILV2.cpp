@@ -106,6 +106,10 @@ public:
         // tell the DSP we're ready to receive msgs
         setState("__dpf_ui_data__", "");
 #endif
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+        // tell the DSP to start sending visualization frames
+        sendVisualStreamState(true);
+#endif
 
         if (winId != 0)
             return;
@@ -149,6 +153,14 @@ public:
             fUI.setWindowTitle(DISTRHO_PLUGIN_NAME);
     }
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+    ~UiLv2()
+    {
+        // stop the DSP from queueing frames nobody will read
+        sendVisualStreamState(false);
+    }
+#endif
+
     // -------------------------------------------------------------------
 
     void lv2ui_port_event(const uint32_t rindex, const uint32_t bufferSize, const uint32_t format, const void* const buffer)
@@ -169,22 +181,36 @@ public:
 
             fUI.parameterChanged(rindex-parameterOffset, value);
         }
-#if DISTRHO_PLUGIN_WANT_STATE
+#if DISTRHO_PLUGIN_WANT_STATE || DISTRHO_PLUGIN_WANT_VISUAL_STREAM
         else if (format == fURIDs.atomEventTransfer)
         {
             const LV2_Atom* const atom = (const LV2_Atom*)buffer;
 
+# if DISTRHO_PLUGIN_WANT_STATE
             if (atom->type == fURIDs.dpfKeyValue)
             {
                 const char* const key   = (const char*)LV2_ATOM_BODY_CONST(atom);
                 const char* const value = key+(std::strlen(key)+1);
 
                 fUI.stateChanged(key, value);
+                return;
             }
-            else
+# endif
+# if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+            if (atom->type == fURIDs.atomVector)
             {
-                d_stdout("received atom not dpfKeyValue");
+                const LV2_Atom_Vector_Body* const vecBody = (const LV2_Atom_Vector_Body*)LV2_ATOM_BODY_CONST(atom);
+                DISTRHO_SAFE_ASSERT_RETURN(atom->size > sizeof(LV2_Atom_Vector_Body),);
+                DISTRHO_SAFE_ASSERT_RETURN(vecBody->child_type == fURIDs.atomFloat,);
+                DISTRHO_SAFE_ASSERT_RETURN(vecBody->child_size == sizeof(float),);
+
+                fUI.visualFrameReceived((const float*)(vecBody + 1),
+                                        (atom->size - sizeof(LV2_Atom_Vector_Body)) / sizeof(float));
+                return;
             }
+# endif
+
+            d_stdout("received atom not dpfKeyValue");
         }
 #endif
     }
@@ -331,6 +357,24 @@ protected:
     }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_VISUAL_STREAM
+    void sendVisualStreamState(const bool active)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fWriteFunction != nullptr,);
+
+        const uint32_t eventInPortIndex = DISTRHO_PLUGIN_NUM_INPUTS + DISTRHO_PLUGIN_NUM_OUTPUTS;
+
+        LV2_Atom_Int atom;
+        atom.atom.size = sizeof(int32_t);
+        atom.atom.type = fURIDs.dpfVisualStream;
+        atom.body = active ? 1 : 0;
+
+        // send to DSP side
+        fWriteFunction(fController, eventInPortIndex, lv2_atom_total_size(&atom.atom),
+                       fURIDs.atomEventTransfer, &atom);
+    }
+#endif
+
     bool fileRequest(const char* const key)
     {
         d_stdout("UI file request %s %p", key, fUiRequestValue);
@@ -367,11 +411,13 @@ private:
     const struct URIDs {
         const LV2_URID_Map* _uridMap;
         LV2_URID dpfKeyValue;
+        LV2_URID dpfVisualStream;
         LV2_URID atomEventTransfer;
         LV2_URID atomFloat;
         LV2_URID atomLong;
         LV2_URID atomPath;
         LV2_URID atomString;
+        LV2_URID atomVector;
         LV2_URID midiEvent;
         LV2_URID paramSampleRate;
         LV2_URID patchSet;
@@ -379,11 +425,13 @@ private:
         URIDs(const LV2_URID_Map* const uridMap)
             : _uridMap(uridMap),
               dpfKeyValue(map(DISTRHO_PLUGIN_LV2_STATE_PREFIX "KeyValueState")),
+              dpfVisualStream(map(DISTRHO_PLUGIN_LV2_STATE_PREFIX "VisualStream")),
               atomEventTransfer(map(LV2_ATOM__eventTransfer)),
               atomFloat(map(LV2_ATOM__Float)),
               atomLong(map(LV2_ATOM__Long)),
               atomPath(map(LV2_ATOM__Path)),
               atomString(map(LV2_ATOM__String)),
+              atomVector(map(LV2_ATOM__Vector)),
               midiEvent(map(LV2_MIDI__MidiEvent)),
               paramSampleRate(map(LV2_PARAMETERS__sampleRate)),
               patchSet(map(LV2_PATCH__Set)) {}
@@ -1294,7 +1294,15 @@ bool jackbridge_set_xrun_callback(jack_client_t* client, JackXRunCallback xrun_c
 #elif defined(JACKBRIDGE_DIRECT)
     return (jack_set_xrun_callback(client, xrun_callback, arg) == 0);
 #else
-    if (! JackBridge::usingRtAudio && getBridgeInstance().set_xrun_callback_ptr != nullptr)
+# ifdef RTAUDIO_API_TYPE
+    if (JackBridge::usingRtAudio)
+    {
+        JackBridge::rtAudio.jackXrunCallback = xrun_callback;
+        JackBridge::rtAudio.jackXrunArg = arg;
+        return true;
+    }
+# endif
+    if (getBridgeInstance().set_xrun_callback_ptr != nullptr)
     {
 # ifdef __WINE__
         WineBridge::getInstance().set_xrun(xrun_callback);
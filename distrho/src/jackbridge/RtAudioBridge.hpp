@@ -37,12 +37,23 @@
 # define Point CorePoint /* fix conflict between DGL and macOS Point name */
 # include "rtaudio/RtAudio.h"
 # undef Point
-# include "../../extra/RingBuffer.hpp"
 # include "../../extra/ScopedPointer.hpp"
 
-using DISTRHO_NAMESPACE::HeapRingBuffer;
+# include <cctype>
+# include <cstdlib>
+
 using DISTRHO_NAMESPACE::ScopedPointer;
 
+/*
+ * The RtAudio stream can be configured through the following environment variables:
+ *  - DPF_RTAUDIO_DEVICE: device index or (part of) device name, uses system default device if unset
+ *  - DPF_RTAUDIO_SAMPLE_RATE: sample rate in Hz, defaults to 48000
+ *  - DPF_RTAUDIO_PERIOD_SIZE: period (buffer) size in frames, defaults to 512
+ *  - DPF_RTAUDIO_PERIODS: number of periods, uses the RtAudio default if unset
+ * The JACK standalone sets these from its command-line options.
+ *
+ * There is no MIDI support, MIDI ports can be registered but never receive or send any events.
+ */
 struct RtAudioBridge {
     // pointer to RtAudio instance
     ScopedPointer<RtAudio> handle;
@@ -51,6 +62,9 @@ struct RtAudioBridge {
     uint bufferSize = 0;
     uint sampleRate = 0;
 
+    // xrun information, xrunCount is only ever written by the audio thread
+    volatile uint xrunCount = 0;
+
     // Port caching information
     uint numAudioIns = 0;
     uint numAudioOuts = 0;
@@ -60,6 +74,8 @@ struct RtAudioBridge {
     // JACK callbacks
     JackProcessCallback jackProcessCallback = nullptr;
     void* jackProcessArg = nullptr;
+    JackXRunCallback jackXrunCallback = nullptr;
+    void* jackXrunArg = nullptr;
 
     // Runtime buffers
     enum PortMask {
@@ -73,12 +89,6 @@ struct RtAudioBridge {
 #if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
     float* audioBuffers[DISTRHO_PLUGIN_NUM_INPUTS + DISTRHO_PLUGIN_NUM_OUTPUTS];
 #endif
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-    HeapRingBuffer midiInBuffer;
-#endif
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-    HeapRingBuffer midiOutBuffer;
-#endif
 
     bool open()
     {
@@ -88,7 +98,8 @@ struct RtAudioBridge {
             rtAudio = new RtAudio(RtAudio::RTAUDIO_API_TYPE);
         } DISTRHO_SAFE_EXCEPTION_RETURN("new RtAudio()", false);
 
-        uint rtAudioBufferFrames = 512;
+        uint rtAudioBufferFrames = getEnvUInt("DPF_RTAUDIO_PERIOD_SIZE", 512);
+        const uint rtAudioSampleRate = getEnvUInt("DPF_RTAUDIO_SAMPLE_RATE", 48000);
 
         RtAudio::StreamParameters inParams;
         inParams.deviceId = rtAudio->getDefaultInputDevice();
@@ -99,22 +110,45 @@ struct RtAudioBridge {
         outParams.nChannels = DISTRHO_PLUGIN_NUM_OUTPUTS;
 
         RtAudio::StreamOptions opts;
-        opts.flags = RTAUDIO_NONINTERLEAVED | RTAUDIO_MINIMIZE_LATENCY | RTAUDIO_ALSA_USE_DEFAULT;
+        opts.flags = RTAUDIO_NONINTERLEAVED | RTAUDIO_MINIMIZE_LATENCY;
+        opts.numberOfBuffers = getEnvUInt("DPF_RTAUDIO_PERIODS", 0);
+
+        const char* const deviceName = std::getenv("DPF_RTAUDIO_DEVICE");
+
+        if (deviceName != nullptr && deviceName[0] != '\0')
+        {
+            uint deviceId;
+            if (! findDevice(rtAudio, deviceName, deviceId))
+            {
+                d_stderr("RtAudio device '%s' not found", deviceName);
+                return false;
+            }
+
+            RtAudio::DeviceInfo info;
+            try {
+                info = rtAudio->getDeviceInfo(deviceId);
+            } DISTRHO_SAFE_EXCEPTION_RETURN("rtAudio->getDeviceInfo()", false);
+
+            if (info.inputChannels != 0)
+                inParams.deviceId = deviceId;
+            if (info.outputChannels != 0)
+                outParams.deviceId = deviceId;
+
+            d_stdout("Using RtAudio device '%s'", info.name.c_str());
+        }
+        else
+        {
+            opts.flags |= RTAUDIO_ALSA_USE_DEFAULT;
+        }
 
         try {
-            rtAudio->openStream(&outParams, &inParams, RTAUDIO_FLOAT32, 48000, &rtAudioBufferFrames, RtAudioCallback, this, &opts, nullptr);
+            rtAudio->openStream(&outParams, &inParams, RTAUDIO_FLOAT32, rtAudioSampleRate, &rtAudioBufferFrames, RtAudioCallback, this, &opts, nullptr);
         } DISTRHO_SAFE_EXCEPTION_RETURN("rtAudio->openStream()", false);
 
         handle = rtAudio;
         bufferSize = rtAudioBufferFrames;
         sampleRate = handle->getStreamSampleRate();
-
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        midiInBuffer.createBuffer(128);
-#endif
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-        midiOutBuffer.createBuffer(128);
-#endif
+        xrunCount = 0;
         return true;
     }
 
@@ -189,27 +223,81 @@ struct RtAudioBridge {
         if (portMask & kPortMaskAudio)
             return audioBuffers[(portMask & kPortMaskInput ? 0 : DISTRHO_PLUGIN_NUM_INPUTS) + (portMask & 0x0fff)];
 #endif
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        if ((portMask & kPortMaskInputMIDI) == kPortMaskInputMIDI)
-            return &midiInBuffer;
-#endif
-#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-        if ((portMask & kPortMaskOutputMIDI) == kPortMaskOutputMIDI)
-            return &midiOutBuffer;
-#endif
+
+        // no MIDI support, jackbridge_midi_* functions never look into this buffer
+        if (portMask & kPortMaskMIDI)
+            return this;
 
         return nullptr;
     }
 
+    static uint getEnvUInt(const char* const name, const uint fallback)
+    {
+        const char* const value = std::getenv(name);
+
+        if (value == nullptr || value[0] == '\0')
+            return fallback;
+
+        const int ivalue = std::atoi(value);
+        DISTRHO_SAFE_ASSERT_RETURN(ivalue > 0, fallback);
+
+        return static_cast<uint>(ivalue);
+    }
+
+    static bool findDevice(RtAudio* const rtAudio, const char* const deviceName, uint& deviceId)
+    {
+        const uint deviceCount = rtAudio->getDeviceCount();
+
+        // device index
+        if (std::isdigit(deviceName[0]))
+        {
+            deviceId = static_cast<uint>(std::atoi(deviceName));
+            return deviceId < deviceCount;
+        }
+
+        // device name, first exact match then partial
+        for (int exact = 1; exact >= 0; --exact)
+        {
+            for (uint i=0; i < deviceCount; ++i)
+            {
+                RtAudio::DeviceInfo info;
+
+                try {
+                    info = rtAudio->getDeviceInfo(i);
+                } DISTRHO_SAFE_EXCEPTION_CONTINUE("rtAudio->getDeviceInfo()");
+
+                if (! info.probed)
+                    continue;
+
+                if (exact ? info.name == deviceName : info.name.find(deviceName) != std::string::npos)
+                {
+                    deviceId = i;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
     static int RtAudioCallback(void* const outputBuffer,
                                void* const inputBuffer,
                                const uint numFrames,
                                const double /* streamTime */,
-                               const RtAudioStreamStatus /* status */,
+                               const RtAudioStreamStatus status,
                                void* const userData)
     {
         RtAudioBridge* const self = (RtAudioBridge*)userData;
 
+        if (status & (RTAUDIO_INPUT_OVERFLOW|RTAUDIO_OUTPUT_UNDERFLOW))
+        {
+            ++self->xrunCount;
+
+            // NOTE: unlike JACK, this is called from the audio thread
+            if (self->jackXrunCallback != nullptr)
+                self->jackXrunCallback(self->jackXrunArg);
+        }
+
         if (self->jackProcessCallback == nullptr)
         {
             if (outputBuffer != nullptr)
@@ -33,6 +33,11 @@ public:
           fBuffer(nullptr),
           fBufferPos(0)
     {
+        // hosts and wrappers create "dummy" instances only to read plugin information,
+        // those never run, so do not waste memory on a buffer they would not use (about 1MiB at 44.1kHz)
+        if (isDummyInstance())
+            return;
+
         // allocates buffer
         sampleRateChanged(getSampleRate());
     }
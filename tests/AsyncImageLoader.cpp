@@ -0,0 +1,164 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+#include "dgl/src/AsyncImageLoader.cpp"
+#include "distrho/extra/Sleep.hpp"
+
+// --------------------------------------------------------------------------------------------------------------------
+
+START_NAMESPACE_DGL
+
+static int gNumDecoded = 0;
+static int gNumDeleted = 0;
+static int gBlocked = 0;
+
+// stands in for image decoding, optionally waiting until unblocked to keep its worker busy
+struct TestJob : AsyncImageJob {
+    const bool blocking;
+    int decodeCount;
+
+    TestJob(const bool b = false)
+        : AsyncImageJob(),
+          blocking(b),
+          decodeCount(0) {}
+
+    ~TestJob() override
+    {
+        __atomic_add_fetch(&gNumDeleted, 1, __ATOMIC_SEQ_CST);
+    }
+
+    void decode() override
+    {
+        while (blocking && __atomic_load_n(&gBlocked, __ATOMIC_SEQ_CST) != 0)
+            d_msleep(1);
+
+        ++decodeCount;
+        __atomic_add_fetch(&gNumDecoded, 1, __ATOMIC_SEQ_CST);
+    }
+};
+
+static bool waitUntilDone(const AsyncImageJob* const job)
+{
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (job->isDone())
+            return true;
+        d_msleep(1);
+    }
+
+    return false;
+}
+
+static bool waitForCount(const int* const counter, const int value)
+{
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (__atomic_load_n(counter, __ATOMIC_SEQ_CST) == value)
+            return true;
+        d_msleep(1);
+    }
+
+    return false;
+}
+
+END_NAMESPACE_DGL
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    USE_NAMESPACE_DGL;
+
+    initAsyncImageLoader();
+
+    const uint numThreads = getNumberOfAsyncImageThreads();
+    DISTRHO_ASSERT_EQUAL((numThreads >= 1 && numThreads <= kMaxAsyncImageThreads), true, "thread count within limits");
+    DISTRHO_ASSERT_EQUAL(getAsyncImageLoader().numWorkers, 0u, "no threads are started before the first job");
+
+    // jobs queued one after the other reuse the idle worker instead of starting new ones
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            TestJob* const job = new TestJob;
+            queueAsyncImageJob(job);
+            DISTRHO_ASSERT_EQUAL(waitUntilDone(job), true, "serial job finishes");
+            DISTRHO_ASSERT_EQUAL(job->decodeCount, 1, "serial job decoded once");
+            releaseAsyncImageJob(job);
+        }
+
+        DISTRHO_ASSERT_EQUAL(getAsyncImageLoader().numWorkers, 1u, "a single worker for serial jobs");
+        DISTRHO_ASSERT_EQUAL(getAsyncImageJobsFinishedCount(), 10u, "finished count of serial jobs");
+        DISTRHO_ASSERT_EQUAL(gNumDeleted, 10, "released serial jobs are deleted");
+    }
+
+    // many jobs at once are spread over all threads, each decoded exactly once
+    {
+        static const int kNumJobs = 256;
+        TestJob* jobs[kNumJobs];
+
+        for (int i = 0; i < kNumJobs; ++i)
+            queueAsyncImageJob(jobs[i] = new TestJob);
+
+        for (int i = 0; i < kNumJobs; ++i)
+        {
+            DISTRHO_ASSERT_EQUAL(waitUntilDone(jobs[i]), true, "parallel job finishes");
+            DISTRHO_ASSERT_EQUAL(jobs[i]->decodeCount, 1, "parallel job decoded once");
+        }
+
+        DISTRHO_ASSERT_EQUAL((getAsyncImageLoader().numWorkers <= numThreads), true, "thread count stays within limits");
+        DISTRHO_ASSERT_EQUAL(getAsyncImageJobsFinishedCount(), 10u + kNumJobs, "finished count of parallel jobs");
+
+        for (int i = 0; i < kNumJobs; ++i)
+            releaseAsyncImageJob(jobs[i]);
+
+        DISTRHO_ASSERT_EQUAL(gNumDeleted, 10 + kNumJobs, "released parallel jobs are deleted");
+    }
+
+    // releasing jobs that are still queued or being decoded
+    {
+        gNumDecoded = gNumDeleted = 0;
+        __atomic_store_n(&gBlocked, 1, __ATOMIC_SEQ_CST);
+
+        // keep every possible worker busy
+        TestJob* blockers[kMaxAsyncImageThreads];
+
+        for (uint i = 0; i < numThreads; ++i)
+            queueAsyncImageJob(blockers[i] = new TestJob(true));
+
+        TestJob* const queued = new TestJob;
+        queueAsyncImageJob(queued);
+        d_msleep(50);
+
+        releaseAsyncImageJob(queued);
+        DISTRHO_ASSERT_EQUAL(gNumDeleted, 1, "queued job is deleted right away");
+
+        for (uint i = 0; i < numThreads; ++i)
+            releaseAsyncImageJob(blockers[i]);
+        DISTRHO_ASSERT_EQUAL(gNumDeleted, 1, "jobs being decoded are not deleted by the caller");
+
+        __atomic_store_n(&gBlocked, 0, __ATOMIC_SEQ_CST);
+
+        DISTRHO_ASSERT_EQUAL(waitForCount(&gNumDeleted, 1 + static_cast<int>(numThreads)), true,
+                             "released jobs being decoded are deleted once done");
+        DISTRHO_ASSERT_EQUAL(gNumDecoded, static_cast<int>(numThreads), "released queued job is never decoded");
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
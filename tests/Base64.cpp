@@ -0,0 +1,125 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+#include "distrho/extra/Base64.hpp"
+#include "distrho/extra/String.hpp"
+#include "distrho/extra/Time.hpp"
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    // test vectors from RFC 4648
+    {
+        static const char* const kVectors[7][2] = {
+            { "", "" },
+            { "f", "Zg==" },
+            { "fo", "Zm8=" },
+            { "foo", "Zm9v" },
+            { "foob", "Zm9vYg==" },
+            { "fooba", "Zm9vYmE=" },
+            { "foobar", "Zm9vYmFy" },
+        };
+
+        for (int i=0; i<7; ++i)
+        {
+            const String encoded(String::asBase64(kVectors[i][0], std::strlen(kVectors[i][0])));
+            DISTRHO_ASSERT_EQUAL(encoded, kVectors[i][1], "encoding matches RFC 4648");
+
+            const std::vector<uint8_t> decoded(d_getChunkFromBase64String(kVectors[i][1]));
+            DISTRHO_ASSERT_EQUAL(decoded.size(), std::strlen(kVectors[i][0]), "decoded size matches RFC 4648");
+            DISTRHO_ASSERT_EQUAL(std::memcmp(decoded.data(), kVectors[i][0], decoded.size()), 0, "decoding matches RFC 4648");
+        }
+    }
+
+    // whitespace is skipped, missing padding still decodes the last bytes
+    {
+        const std::vector<uint8_t> decoded(d_getChunkFromBase64String("Zm9v\nYm E\r\n"));
+        DISTRHO_ASSERT_EQUAL(decoded.size(), 5u, "decoded size ignores whitespace");
+        DISTRHO_ASSERT_EQUAL(std::memcmp(decoded.data(), "fooba", 5), 0, "decoded data ignores whitespace");
+    }
+
+    // decoding stops at padding
+    {
+        const std::vector<uint8_t> decoded(d_getChunkFromBase64String("Zm8=Zm9v"));
+        DISTRHO_ASSERT_EQUAL(decoded.size(), 2u, "nothing decoded after padding");
+    }
+
+    // streaming in chunks of every size gives the same result as one-shot calls
+    {
+        uint8_t data[1000];
+        for (uint i=0; i<sizeof(data); ++i)
+            data[i] = static_cast<uint8_t>(i * 7 + i / 3);
+
+        char text[1400];
+        const std::size_t textSize = d_encodeBase64(data, sizeof(data), text);
+        DISTRHO_ASSERT_EQUAL(textSize, d_getBase64EncodedSize(sizeof(data)), "encoded size matches");
+
+        for (std::size_t chunk=1; chunk<=16; ++chunk)
+        {
+            Base64Encoder encoder;
+            char streamText[1400];
+            std::size_t streamTextSize = 0;
+
+            for (std::size_t i=0; i<sizeof(data); i+=chunk)
+                streamTextSize += encoder.encode(data + i, std::min(chunk, sizeof(data) - i), streamText + streamTextSize);
+            streamTextSize += encoder.finish(streamText + streamTextSize);
+
+            DISTRHO_ASSERT_EQUAL(streamTextSize, textSize, "streamed encoding size matches");
+            DISTRHO_ASSERT_EQUAL(std::memcmp(streamText, text, textSize), 0, "streamed encoding matches");
+
+            Base64Decoder decoder;
+            uint8_t streamData[1100];
+            std::size_t streamDataSize = 0;
+
+            for (std::size_t i=0; i<textSize; i+=chunk)
+                streamDataSize += decoder.decode(text + i, std::min(chunk, textSize - i), streamData + streamDataSize);
+            streamDataSize += decoder.finish(streamData + streamDataSize);
+
+            DISTRHO_ASSERT_EQUAL(streamDataSize, sizeof(data), "streamed decoding size matches");
+            DISTRHO_ASSERT_EQUAL(std::memcmp(streamData, data, sizeof(data)), 0, "streamed decoding matches");
+        }
+    }
+
+    // throughput with a big blob, as with binary state
+    {
+        const std::size_t size = 16*1024*1024;
+        std::vector<uint8_t> data(size);
+        for (std::size_t i=0; i<size; ++i)
+            data[i] = static_cast<uint8_t>(i ^ (i >> 8));
+
+        const uint64_t start = d_gettime_ns();
+        const String encoded(String::asBase64(data.data(), size));
+        const uint64_t encoded_ns = d_gettime_ns();
+        const std::vector<uint8_t> decoded(d_getChunkFromBase64String(encoded));
+        const uint64_t decoded_ns = d_gettime_ns();
+
+        DISTRHO_ASSERT_EQUAL(decoded.size(), size, "big blob size matches");
+        DISTRHO_ASSERT_EQUAL(std::memcmp(decoded.data(), data.data(), size), 0, "big blob data matches");
+
+        d_stdout("Base64 16 MiB: encoding %.1f MB/s, decoding %.1f MB/s",
+                 double(size) * 1e3 / double(encoded_ns - start),
+                 double(size) * 1e3 / double(decoded_ns - encoded_ns));
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,332 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+#include "distrho/extra/ExternalChannel.hpp"
+#include "distrho/extra/String.hpp"
+#include "distrho/extra/Time.hpp"
+
+#include <csignal>
+#include <sys/wait.h>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static const uint32_t kNumRoundTrips = 1000;
+
+// keeps received messages, in order
+struct MessageRecorder : ExternalChannel::Callbacks {
+    uint32_t parameters, states, notes;
+    uint32_t lastIndex;
+    float lastValue;
+    String lastKey, lastState;
+    uint8_t lastChannel, lastNote, lastVelocity;
+    bool outOfOrder;
+
+    MessageRecorder()
+        : parameters(0),
+          states(0),
+          notes(0),
+          lastIndex(0),
+          lastValue(0.0f),
+          lastKey(),
+          lastState(),
+          lastChannel(0),
+          lastNote(0),
+          lastVelocity(0),
+          outOfOrder(false) {}
+
+    // each round trip is sent as parameter, state and note, in this order
+    void channelParameterValue(const uint32_t index, const float value) override
+    {
+        if (parameters != states || parameters != notes || index != parameters)
+            outOfOrder = true;
+
+        ++parameters;
+        lastIndex = index;
+        lastValue = value;
+    }
+
+    void channelState(const char* const key, const char* const value) override
+    {
+        if (states + 1 != parameters)
+            outOfOrder = true;
+
+        ++states;
+        lastKey = key;
+        lastState = value;
+    }
+
+    void channelNote(const uint8_t channel, const uint8_t note, const uint8_t velocity) override
+    {
+        if (notes + 1 != parameters)
+            outOfOrder = true;
+
+        ++notes;
+        lastChannel = channel;
+        lastNote = note;
+        lastVelocity = velocity;
+    }
+};
+
+// external side running in a thread, sends back everything it receives
+class EchoPeer : public Thread,
+                 private ExternalChannel::Callbacks
+{
+    ExternalChannel channel;
+    const char* const name;
+
+public:
+    EchoPeer(const char* const n)
+        : Thread("ExternalChannelPeer"),
+          channel(),
+          name(n) {}
+
+private:
+    void run() override
+    {
+        if (! channel.connect(name))
+            return;
+
+        while (channel.isPeerConnected() && ! shouldThreadExit())
+        {
+            if (channel.waitForMessages(50))
+                channel.readMessages(*this);
+        }
+
+        channel.close();
+    }
+
+    void channelParameterValue(const uint32_t index, const float value) override
+    {
+        while (! channel.writeParameterValue(index, value * 2.0f))
+            d_msleep(1);
+    }
+
+    void channelState(const char* const key, const char* const value) override
+    {
+        while (! channel.writeState(key, value))
+            d_msleep(1);
+    }
+
+    void channelNote(const uint8_t ch, const uint8_t note, const uint8_t velocity) override
+    {
+        while (! channel.writeNote(ch, note, velocity))
+            d_msleep(1);
+    }
+};
+
+// reads what is pending, waiting a little if there is nothing, so both sides keep going when the ring buffers are full
+static void readSome(ExternalChannel& channel, MessageRecorder& recorder)
+{
+    if (channel.waitForMessages(1))
+        channel.readMessages(recorder);
+}
+
+// reads messages until @a count parameters arrived, or a second passed without any
+static void readUntil(ExternalChannel& channel, MessageRecorder& recorder, const uint32_t count)
+{
+    while (recorder.parameters < count || recorder.notes < count)
+    {
+        if (! channel.waitForMessages(1000))
+            break;
+
+        channel.readMessages(recorder);
+    }
+}
+
+// changes the version field of a created channel, which is the first value in shared memory
+// returns the previous version, or 0 on failure
+static uint32_t swapVersion(const char* const name, const uint32_t version)
+{
+    const int fd = ::shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+        return 0;
+
+    void* const ptr = ::mmap(nullptr, sizeof(uint32_t), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (ptr == MAP_FAILED)
+        return 0;
+
+    const uint32_t previous = *static_cast<uint32_t*>(ptr);
+    *static_cast<uint32_t*>(ptr) = version;
+    ::munmap(ptr, sizeof(uint32_t));
+    return previous;
+}
+
+END_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    // round trip through another thread, every message type in order
+    {
+        ExternalChannel channel;
+        DISTRHO_ASSERT_EQUAL(channel.create(), true, "channel is created");
+        DISTRHO_ASSERT_EQUAL(channel.isPeerConnected(), false, "no peer before connecting");
+
+        EchoPeer peer(channel.getName());
+        peer.startThread();
+
+        MessageRecorder recorder;
+        char key[32];
+
+        for (uint32_t i=0; i < kNumRoundTrips; ++i)
+        {
+            std::snprintf(key, sizeof(key), "key%u", i);
+
+            while (! channel.writeParameterValue(i, float(i)))
+                readSome(channel, recorder);
+            while (! channel.writeState(key, "value"))
+                readSome(channel, recorder);
+            while (! channel.writeNote(i % 16, i % 128, (i + 1) % 128))
+                readSome(channel, recorder);
+
+            channel.readMessages(recorder);
+        }
+
+        readUntil(channel, recorder, kNumRoundTrips);
+
+        DISTRHO_ASSERT_EQUAL(channel.isPeerConnected(), true, "peer is connected");
+        DISTRHO_ASSERT_EQUAL(recorder.parameters, kNumRoundTrips, "all parameters came back");
+        DISTRHO_ASSERT_EQUAL(recorder.states, kNumRoundTrips, "all states came back");
+        DISTRHO_ASSERT_EQUAL(recorder.notes, kNumRoundTrips, "all notes came back");
+        DISTRHO_ASSERT_EQUAL(recorder.outOfOrder, false, "messages came back in order");
+        DISTRHO_ASSERT_EQUAL(recorder.lastValue, float(kNumRoundTrips - 1) * 2.0f, "parameter value was echoed");
+        DISTRHO_ASSERT_EQUAL((recorder.lastKey == "key999"), true, "state key was echoed");
+        DISTRHO_ASSERT_EQUAL((recorder.lastState == "value"), true, "state value was echoed");
+        DISTRHO_ASSERT_EQUAL(recorder.lastVelocity, kNumRoundTrips % 128, "note was echoed");
+
+        // closing wakes up the peer, which then closes its side too
+        channel.close();
+        DISTRHO_ASSERT_EQUAL(peer.stopThread(1000), true, "peer stops after the channel is closed");
+    }
+
+    // overflow, full writes fail as a whole and the channel keeps working after reading
+    {
+        ExternalChannel plugin, external;
+        DISTRHO_ASSERT_EQUAL(plugin.create(), true, "channel is created");
+        DISTRHO_ASSERT_EQUAL(external.connect(plugin.getName()), true, "external side connects");
+        DISTRHO_ASSERT_EQUAL(plugin.isPeerConnected(), true, "plugin side sees the external side");
+        DISTRHO_ASSERT_EQUAL(external.isPeerConnected(), true, "external side sees the plugin side");
+
+        char value[10000];
+        std::memset(value, 'x', sizeof(value) - 1);
+        value[sizeof(value) - 1] = '\0';
+
+        uint32_t written = 0;
+        while (written < 100 && plugin.writeState("big", value))
+            ++written;
+
+        DISTRHO_ASSERT_EQUAL((written > 0 && written < 100), true, "writes fail once the ring buffer is full");
+
+        MessageRecorder recorder;
+        const uint32_t read = external.readMessages(recorder);
+        DISTRHO_ASSERT_EQUAL(recorder.states, written, "every accepted state is received");
+        DISTRHO_ASSERT_EQUAL(read, written, "no partial message is received");
+        DISTRHO_ASSERT_EQUAL(recorder.lastState.length(), sizeof(value) - 1, "big state is received whole");
+        DISTRHO_ASSERT_EQUAL(plugin.writeState("big", value), true, "writing works again after reading");
+        DISTRHO_ASSERT_EQUAL(external.isOpen(), true, "channel stays open");
+    }
+
+    // peer process closing the channel
+    {
+        ExternalChannel channel;
+        DISTRHO_ASSERT_EQUAL(channel.create(), true, "channel is created");
+
+        const pid_t pid = ::fork();
+        DISTRHO_ASSERT_EQUAL((pid >= 0), true, "fork works");
+
+        if (pid == 0)
+        {
+            ExternalChannel external;
+            if (! external.connect(channel.getName()))
+                ::_exit(1);
+            external.writeParameterValue(7, 0.25f);
+            external.close();
+            ::_exit(0);
+        }
+
+        int status = -1;
+        ::waitpid(pid, &status, 0);
+        DISTRHO_ASSERT_EQUAL((WIFEXITED(status) && WEXITSTATUS(status) == 0), true, "peer process connected and exited");
+        DISTRHO_ASSERT_EQUAL(channel.isPeerConnected(), false, "closed peer is noticed");
+
+        MessageRecorder recorder;
+        DISTRHO_ASSERT_EQUAL(channel.readMessages(recorder), 1u, "messages sent before closing are kept");
+        DISTRHO_ASSERT_EQUAL(recorder.lastIndex, 7u, "message from peer process is received");
+        DISTRHO_ASSERT_EQUAL(recorder.lastValue, 0.25f, "value from peer process is received");
+
+        const uint64_t start = d_gettime_ms();
+        DISTRHO_ASSERT_EQUAL(channel.waitForMessages(5000), false, "nothing to wait for after the peer closed");
+        DISTRHO_ASSERT_EQUAL((d_gettime_ms() - start < 1000), true, "waiting returns right away after the peer closed");
+    }
+
+    // peer process killed, writes never block
+    {
+        ExternalChannel channel;
+        DISTRHO_ASSERT_EQUAL(channel.create(), true, "channel is created");
+
+        const pid_t pid = ::fork();
+        DISTRHO_ASSERT_EQUAL((pid >= 0), true, "fork works");
+
+        if (pid == 0)
+        {
+            ExternalChannel external;
+            if (! external.connect(channel.getName()))
+                ::_exit(1);
+            ::raise(SIGKILL);
+            ::_exit(0);
+        }
+
+        int status = -1;
+        ::waitpid(pid, &status, 0);
+        DISTRHO_ASSERT_EQUAL(WIFSIGNALED(status), true, "peer process was killed");
+
+        uint32_t written = 0;
+        while (written < 1000000 && channel.writeParameterValue(written, 0.0f))
+            ++written;
+
+        DISTRHO_ASSERT_EQUAL((written < 1000000), true, "writes fail without a reader instead of blocking");
+        DISTRHO_ASSERT_EQUAL(channel.isOpen(), true, "channel stays open");
+    }
+
+    // version mismatch
+    {
+        ExternalChannel plugin, external;
+        DISTRHO_ASSERT_EQUAL(plugin.create(), true, "channel is created");
+        const uint32_t version = swapVersion(plugin.getName(), 0xdead);
+        DISTRHO_ASSERT_NOT_EQUAL(version, 0u, "version is changed");
+        DISTRHO_ASSERT_EQUAL(external.connect(plugin.getName()), false, "connecting with another version fails");
+        DISTRHO_ASSERT_EQUAL(external.isOpen(), false, "failed connection leaves the channel closed");
+        DISTRHO_ASSERT_EQUAL(plugin.isPeerConnected(), false, "failed connection is not seen as a peer");
+
+        // the name stays valid until someone connects successfully
+        swapVersion(plugin.getName(), version);
+        DISTRHO_ASSERT_EQUAL(external.connect(plugin.getName()), true, "connecting with the same version works");
+        DISTRHO_ASSERT_EQUAL(plugin.isPeerConnected(), true, "peer is seen after connecting");
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
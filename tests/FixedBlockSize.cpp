@@ -0,0 +1,218 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+// uses fixedblock_res/DistrhoPluginInfo.h, with a fixed block size of 64 frames
+#include "distrho/src/DistrhoPlugin.cpp"
+
+#include <vector>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+// passes audio through, remembers how it was called
+class FixedBlockSizePlugin : public Plugin
+{
+public:
+    FixedBlockSizePlugin()
+        : Plugin(0, 0, 0),
+          runCount(0),
+          wrongSizeCount(0),
+          wrongMidiFrameCount(0),
+          midiEventCount(0) {}
+
+    uint32_t runCount;
+    uint32_t wrongSizeCount;
+    uint32_t wrongMidiFrameCount;
+    uint32_t midiEventCount;
+    std::vector<uint8_t> midiNotes;
+
+protected:
+    const char* getLabel() const override { return "FixedBlockSize"; }
+    const char* getMaker() const override { return "DISTRHO"; }
+    const char* getLicense() const override { return "ISC"; }
+    uint32_t getVersion() const override { return d_version(1, 0, 0); }
+    int64_t getUniqueId() const override { return d_cconst('d', 'F', 'b', 's'); }
+
+    void initParameter(uint32_t, Parameter&) override {}
+    float getParameterValue(uint32_t) const override { return 0.0f; }
+    void setParameterValue(uint32_t, float) override {}
+
+    void run(const float** const inputs, float** const outputs, const uint32_t frames,
+             const MidiEvent* const midiEvents, const uint32_t count) override
+    {
+        ++runCount;
+
+        if (frames != kFixedBlockSize || getBufferSize() != kFixedBlockSize)
+            ++wrongSizeCount;
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (midiEvents[i].frame >= frames)
+                ++wrongMidiFrameCount;
+
+            midiNotes.push_back(midiEvents[i].data[1]);
+        }
+
+        midiEventCount += count;
+
+        if (outputs[0] != inputs[0])
+            std::memcpy(outputs[0], inputs[0], sizeof(float)*frames);
+    }
+};
+
+Plugin* createPlugin()
+{
+    return new FixedBlockSizePlugin();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+// runs a ramp through the plugin with the given host block sizes, returns the output
+static std::vector<float> runHostBlocks(PluginExporter& plugin, const uint32_t* const blockSizes, const uint32_t numBlocks)
+{
+    std::vector<float> input, output;
+    uint8_t note = 0;
+
+    for (uint32_t b=0; b < numBlocks; ++b)
+    {
+        const uint32_t frames = blockSizes[b];
+        const uint32_t start = static_cast<uint32_t>(input.size());
+
+        for (uint32_t i=0; i < frames; ++i)
+            input.push_back(static_cast<float>(start + i + 1));
+
+        output.resize(input.size());
+
+        const float* ins[1] = { &input[start] };
+        float* outs[1] = { &output[start] };
+
+        // one note at the start and one at the end of every host block
+        MidiEvent midiEvents[2];
+        std::memset(midiEvents, 0, sizeof(midiEvents));
+        midiEvents[0].size = midiEvents[1].size = 3;
+        midiEvents[0].data[0] = midiEvents[1].data[0] = 0x90;
+        midiEvents[0].frame = 0;
+        midiEvents[0].data[1] = note++;
+        midiEvents[1].frame = frames - 1;
+        midiEvents[1].data[1] = note++;
+
+        plugin.run(ins, outs, frames, midiEvents, 2);
+    }
+
+    return output;
+}
+
+END_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    d_lastBufferSize = 512;
+    d_lastSampleRate = 48000.0;
+
+    // uneven host blocks are buffered, run() only ever sees the fixed size, output is delayed by one block
+    {
+        d_lastHostHasAlignedBlocks = false;
+        PluginExporter plugin(nullptr, nullptr, nullptr);
+        FixedBlockSizePlugin* const fbs = static_cast<FixedBlockSizePlugin*>(plugin.getInstancePointer());
+
+        DISTRHO_ASSERT_EQUAL(plugin.getLatency(), kFixedBlockSize, "buffering latency is reported");
+
+        // host buffer size changes do not reach the plugin
+        plugin.setBufferSize(1000, true);
+        DISTRHO_ASSERT_EQUAL(fbs->getBufferSize(), kFixedBlockSize, "buffer size stays fixed");
+
+        static const uint32_t kBlockSizes[] = { 1, 7, 63, 64, 65, 100, 2, 128, 255, 3, 512, 31 };
+        static const uint32_t kNumBlocks = sizeof(kBlockSizes)/sizeof(kBlockSizes[0]);
+
+        plugin.activate();
+        const std::vector<float> output(runHostBlocks(plugin, kBlockSizes, kNumBlocks));
+        plugin.deactivate();
+
+        // MIDI events inside complete internal blocks have been delivered
+        uint32_t total = 0, completeEvents = 0;
+        const uint32_t complete = output.size() / kFixedBlockSize * kFixedBlockSize;
+
+        for (uint32_t i=0; i < kNumBlocks; ++i)
+        {
+            if (total < complete)
+                ++completeEvents;
+            if (total + kBlockSizes[i] - 1 < complete)
+                ++completeEvents;
+            total += kBlockSizes[i];
+        }
+
+        DISTRHO_ASSERT_EQUAL(fbs->wrongSizeCount, 0u, "run() only sees the fixed block size");
+        DISTRHO_ASSERT_EQUAL(fbs->runCount, total / kFixedBlockSize, "all complete blocks are run");
+        DISTRHO_ASSERT_EQUAL(fbs->wrongMidiFrameCount, 0u, "MIDI events are inside the block");
+        DISTRHO_ASSERT_EQUAL(fbs->midiEventCount, completeEvents, "MIDI events of complete blocks arrive");
+
+        uint32_t errors = 0;
+        for (uint32_t i=0; i < total; ++i)
+        {
+            const float expected = i < kFixedBlockSize ? 0.0f : static_cast<float>(i - kFixedBlockSize + 1);
+            if (d_isNotEqual(output[i], expected))
+                ++errors;
+        }
+        DISTRHO_ASSERT_EQUAL(errors, 0u, "output is the input delayed by one block");
+
+        errors = 0;
+        for (uint32_t i=0; i < fbs->midiNotes.size(); ++i)
+            if (fbs->midiNotes[i] != i)
+                ++errors;
+        DISTRHO_ASSERT_EQUAL(errors, 0u, "MIDI events keep their order");
+    }
+
+    // aligned host blocks are sliced without latency, until the host breaks its promise
+    {
+        d_lastHostHasAlignedBlocks = true;
+        PluginExporter plugin(nullptr, nullptr, nullptr);
+        d_lastHostHasAlignedBlocks = false;
+        FixedBlockSizePlugin* const fbs = static_cast<FixedBlockSizePlugin*>(plugin.getInstancePointer());
+
+        DISTRHO_ASSERT_EQUAL(plugin.getLatency(), 0u, "no latency when aligned");
+
+        static const uint32_t kAlignedSizes[] = { 64, 256, 128 };
+
+        plugin.activate();
+        const std::vector<float> output(runHostBlocks(plugin, kAlignedSizes, 3));
+
+        uint32_t errors = 0;
+        for (uint32_t i=0; i < output.size(); ++i)
+            if (d_isNotEqual(output[i], static_cast<float>(i + 1)))
+                ++errors;
+        DISTRHO_ASSERT_EQUAL(errors, 0u, "output is not delayed when aligned");
+        DISTRHO_ASSERT_EQUAL(fbs->runCount, 7u, "aligned blocks are sliced");
+
+        static const uint32_t kUnalignedSizes[] = { 100, 28, 64 };
+        runHostBlocks(plugin, kUnalignedSizes, 3);
+        plugin.deactivate();
+
+        DISTRHO_ASSERT_EQUAL(fbs->wrongSizeCount, 0u, "short host blocks are buffered");
+        DISTRHO_ASSERT_EQUAL(fbs->runCount, 10u, "buffered blocks are run");
+        DISTRHO_ASSERT_EQUAL(plugin.getLatency(), kFixedBlockSize, "buffering latency is reported once needed");
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,147 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+#include "dgl/src/ImageConversion.cpp"
+#include "distrho/extra/Time.hpp"
+
+#include <cmath>
+#include <vector>
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    USE_NAMESPACE_DGL;
+
+    static const ImageFormat kFormats[5] = {
+        kImageFormatGrayscale, kImageFormatBGR, kImageFormatBGRA, kImageFormatRGB, kImageFormatRGBA
+    };
+
+    // premultiplication matches rounded floating point math
+    {
+        uint errors = 0;
+
+        for (uint x = 0; x < 256; ++x)
+            for (uint a = 0; a < 256; ++a)
+                if (mulDiv255(x, a) != static_cast<uint>(std::floor(x * a / 255.0 + 0.5)))
+                    ++errors;
+
+        DISTRHO_ASSERT_EQUAL(errors, 0u, "premultiplication is exact");
+    }
+
+    // known values
+    {
+        const uchar rgba[8] = { 10, 20, 30, 255, 200, 100, 50, 128 };
+        uchar bgra[8];
+
+        convertImageData(rgba, kImageFormatRGBA, 8, bgra, kImageFormatBGRA, 8, 2, 1, true);
+        DISTRHO_ASSERT_EQUAL(bgra[0], 30, "red and blue are swapped");
+        DISTRHO_ASSERT_EQUAL(bgra[2], 10, "red and blue are swapped");
+        DISTRHO_ASSERT_EQUAL(bgra[3], 255, "alpha is kept");
+        DISTRHO_ASSERT_EQUAL(bgra[4], 25, "blue is premultiplied");
+        DISTRHO_ASSERT_EQUAL(bgra[5], 50, "green is premultiplied");
+        DISTRHO_ASSERT_EQUAL(bgra[6], 100, "red is premultiplied");
+        DISTRHO_ASSERT_EQUAL(bgra[7], 128, "alpha is not premultiplied");
+
+        const uchar white[3] = { 255, 255, 255 };
+        uchar gray;
+        convertImageData(white, kImageFormatRGB, 3, &gray, kImageFormatGrayscale, 1, 1, 1, false);
+        DISTRHO_ASSERT_EQUAL(gray, 255, "white stays white in grayscale");
+    }
+
+    // vectorized code gives the same result as scalar code, for all format pairs and odd sizes
+    {
+        const uint kMaxWidth = 67, kHeight = 3, kPadding = 5;
+
+        std::vector<uchar> src((kMaxWidth * 4 + kPadding) * kHeight);
+        for (std::size_t i = 0; i < src.size(); ++i)
+            src[i] = static_cast<uchar>(i * 37 + i / 7);
+
+        uint errors = 0;
+
+        for (uint s = 0; s < 5; ++s)
+        {
+            for (uint d = 0; d < 5; ++d)
+            {
+                const uint srcPixelSize = getImageFormatPixelSize(kFormats[s]);
+                const uint dstPixelSize = getImageFormatPixelSize(kFormats[d]);
+
+                for (uint width = 1; width <= kMaxWidth; ++width)
+                {
+                    for (int premultiply = 0; premultiply < 2; ++premultiply)
+                    {
+                        const uint srcStride = width * srcPixelSize + kPadding;
+                        const uint dstStride = width * dstPixelSize + kPadding;
+
+                        std::vector<uchar> converted(dstStride * kHeight, 0x55);
+                        std::vector<uchar> expected(dstStride * kHeight, 0x55);
+
+                        convertImageData(src.data(), kFormats[s], srcStride,
+                                         converted.data(), kFormats[d], dstStride,
+                                         width, kHeight, premultiply != 0);
+
+                        for (uint y = 0; y < kHeight; ++y)
+                            convertRowScalar(src.data() + y * srcStride, kFormats[s],
+                                             expected.data() + y * dstStride, kFormats[d],
+                                             width, premultiply != 0);
+
+                        if (converted != expected)
+                            ++errors;
+                    }
+                }
+            }
+        }
+
+        DISTRHO_ASSERT_EQUAL(errors, 0u, "vectorized conversion matches scalar, padding untouched");
+    }
+
+    // throughput with a big image, as with large skins
+    {
+        const uint width = 2048, height = 2048;
+        std::vector<uchar> src(width * height * 4);
+        std::vector<uchar> dst(width * height * 4);
+
+        for (std::size_t i = 0; i < src.size(); ++i)
+            src[i] = static_cast<uchar>(i ^ (i >> 9));
+
+        for (uint s = 1; s < 5; ++s)
+        {
+            const uint srcStride = width * getImageFormatPixelSize(kFormats[s]);
+
+            const uint64_t start = d_gettime_ns();
+            convertImageData(src.data(), kFormats[s], srcStride, dst.data(), kImageFormatBGRA, width * 4,
+                             width, height, true);
+            const uint64_t vectorized_ns = d_gettime_ns();
+
+            for (uint y = 0; y < height; ++y)
+                convertRowScalar(src.data() + y * srcStride, kFormats[s],
+                                 dst.data() + y * width * 4, kImageFormatBGRA, width, true);
+
+            const uint64_t scalar_ns = d_gettime_ns();
+
+            d_stdout("ImageConversion %u to premultiplied BGRA, 2048x2048: %.2f ms, scalar %.2f ms",
+                     static_cast<uint>(kFormats[s]),
+                     double(vectorized_ns - start) / 1e6,
+                     double(scalar_ns - vectorized_ns) / 1e6);
+        }
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,87 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+#include "distrho/extra/LZ4.hpp"
+#include "distrho/extra/Time.hpp"
+
+#include "dgl/src/Resources.cpp"
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    // blocks made by utils/res2c.py, matches overlap their own output
+    {
+        static const uint8_t kRepeated[] = { 31, 97, 1, 0, 11, 80, 97, 97, 97, 97, 97 };
+        static const uint8_t kPattern[] = { 63, 97, 98, 99, 3, 0, 7, 80, 99, 97, 98, 99, 33 };
+
+        char out[64];
+        std::size_t size = d_decompressLZ4(kRepeated, sizeof(kRepeated), out, sizeof(out));
+        DISTRHO_ASSERT_EQUAL(size, 36u, "repeated data size matches");
+        DISTRHO_ASSERT_EQUAL(std::memcmp(out, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 36), 0, "repeated data matches");
+
+        size = d_decompressLZ4(kPattern, sizeof(kPattern), out, sizeof(out));
+        DISTRHO_ASSERT_EQUAL(size, 34u, "pattern size matches");
+        DISTRHO_ASSERT_EQUAL(std::memcmp(out, "abcabcabcabcabcabcabcabcabcabcabc!", 34), 0, "pattern matches");
+
+        // every truncation fails instead of reading out of bounds
+        uint errors = 0;
+        for (std::size_t i = 1; i < sizeof(kPattern); ++i)
+            if (d_decompressLZ4(kPattern, i, out, sizeof(out)) == 34)
+                ++errors;
+        DISTRHO_ASSERT_EQUAL(errors, 0u, "truncated data fails");
+
+        // too small output fails instead of writing out of bounds
+        DISTRHO_ASSERT_EQUAL(d_decompressLZ4(kPattern, sizeof(kPattern), out, 33), 0u, "small output fails");
+
+        // match offset before the start of the output fails
+        static const uint8_t kBadOffset[] = { 16, 97, 2, 0, 0 };
+        DISTRHO_ASSERT_EQUAL(d_decompressLZ4(kBadOffset, sizeof(kBadOffset), out, sizeof(out)), 0u, "bad offset fails");
+    }
+
+    // embedded font is decompressed once, then shared
+    {
+        using namespace dpf_resources;
+
+        const uint64_t start = d_gettime_ns();
+        const char* const data = d_getDecompressedResource(dejavusans_ttf_compressed,
+                                                           dejavusans_ttf_compressed_size,
+                                                           dejavusans_ttf_size);
+        const uint64_t decompressed_ns = d_gettime_ns();
+
+        DISTRHO_ASSERT_NOT_EQUAL(data, nullptr, "font decompression works");
+
+        uint32_t hash = 0x811c9dc5;
+        for (uint i = 0; i < dejavusans_ttf_size; ++i)
+            hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x01000193;
+        DISTRHO_ASSERT_EQUAL(hash, 0x172cd785u, "font data matches the original file");
+
+        DISTRHO_ASSERT_EQUAL(d_getDecompressedResource(dejavusans_ttf_compressed,
+                                                       dejavusans_ttf_compressed_size,
+                                                       dejavusans_ttf_size), data, "font data is shared");
+
+        d_stdout("LZ4 font %u -> %u bytes: decompressed in %.2f ms (%.1f MB/s)",
+                 dejavusans_ttf_compressed_size, dejavusans_ttf_size,
+                 double(decompressed_ns - start) / 1e6,
+                 double(dejavusans_ttf_size) * 1e3 / double(decompressed_ns - start));
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
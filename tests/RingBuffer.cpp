@@ -0,0 +1,284 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+#include "distrho/extra/RingBuffer.hpp"
+#include "distrho/extra/Time.hpp"
+
+#ifndef DISTRHO_OS_WINDOWS
+# include <sched.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static const uint32_t kNumValues = 4*1024*1024;
+
+// give the other side a chance to run when the buffer is full or empty, needed on single-core systems
+static void yieldThread()
+{
+#ifdef DISTRHO_OS_WINDOWS
+    ::Sleep(0);
+#else
+    ::sched_yield();
+#endif
+}
+
+// writes an increasing sequence of values, either one at a time or in bulk through spans
+class RingBufferWriter : public Thread
+{
+    HeapRingBuffer& ring;
+    const bool useSpans;
+
+public:
+    RingBufferWriter(HeapRingBuffer& r, const bool s)
+        : Thread("RingBufferWriter"),
+          ring(r),
+          useSpans(s) {}
+
+private:
+    void run() override
+    {
+        uint32_t value = 0;
+
+        while (value < kNumValues && ! shouldThreadExit())
+        {
+            if (useSpans)
+            {
+                RingBufferSpans spans;
+                const uint32_t size = ring.peekWriteSpans(spans) & ~3u;
+
+                if (size == 0)
+                {
+                    yieldThread();
+                    continue;
+                }
+
+                // spans always split at buffer end, which is a multiple of 4
+                uint32_t written = 0;
+                for (uint32_t i=0; i < size/4 && value < kNumValues; ++i, ++value, written += 4)
+                {
+                    uint8_t* const ptr = i < spans.size1/4 ? spans.data1 + i*4 : spans.data2 + (i - spans.size1/4)*4;
+                    std::memcpy(ptr, &value, 4);
+                }
+
+                ring.commitWriteSpans(written);
+            }
+            else
+            {
+                if (ring.getAvailableDataSize() <= sizeof(uint32_t))
+                {
+                    yieldThread();
+                    continue;
+                }
+
+                ring.writeUInt(value++);
+                ring.commitWrite();
+            }
+        }
+    }
+};
+
+// reads the sequence back and checks its order, returns the number of invalid values
+static uint32_t readSequence(HeapRingBuffer& ring, const bool useSpans)
+{
+    uint32_t expected = 0, errors = 0;
+
+    while (expected < kNumValues)
+    {
+        if (useSpans)
+        {
+            RingBufferSpans spans;
+            const uint32_t size = ring.peekReadSpans(spans);
+
+            if (size == 0)
+            {
+                yieldThread();
+                continue;
+            }
+
+            for (uint32_t i=0; i < size/4; ++i, ++expected)
+            {
+                const uint8_t* const ptr = i < spans.size1/4 ? spans.data1 + i*4 : spans.data2 + (i - spans.size1/4)*4;
+                uint32_t value;
+                std::memcpy(&value, ptr, 4);
+
+                if (value != expected)
+                    ++errors;
+            }
+
+            ring.commitReadSpans(size & ~3u);
+        }
+        else
+        {
+            if (! ring.isDataAvailableForReading())
+            {
+                yieldThread();
+                continue;
+            }
+
+            if (ring.readUInt() != expected++)
+                ++errors;
+        }
+    }
+
+    return errors;
+}
+
+// checks every placement of the struct within a cache line, the writer fields and tail must never share one
+template <class BufferStruct>
+static bool fieldsOnSeparateCacheLines()
+{
+    static uint8_t storage[sizeof(BufferStruct) + kRingBufferCacheLineSize * 2];
+
+    for (uintptr_t offset = 0; offset < kRingBufferCacheLineSize; offset += sizeof(uint32_t))
+    {
+        const uintptr_t base = (reinterpret_cast<uintptr_t>(storage) + kRingBufferCacheLineSize - 1) & ~uintptr_t(kRingBufferCacheLineSize - 1);
+        BufferStruct* const buf = reinterpret_cast<BufferStruct*>(base + offset);
+
+        const uintptr_t tailLine = reinterpret_cast<uintptr_t>(&buf->tail) / kRingBufferCacheLineSize;
+
+        if (reinterpret_cast<uintptr_t>(&buf->head) / kRingBufferCacheLineSize == tailLine)
+            return false;
+        if (reinterpret_cast<uintptr_t>(&buf->wrtn) / kRingBufferCacheLineSize == tailLine)
+            return false;
+        if (reinterpret_cast<uintptr_t>(&buf->invalidateCommit) / kRingBufferCacheLineSize == tailLine)
+            return false;
+    }
+
+    return true;
+}
+
+static uint32_t runThreaded(const bool useSpans)
+{
+    HeapRingBuffer ring;
+    ring.createBuffer(16384);
+
+    RingBufferWriter writer(ring, useSpans);
+
+    const uint64_t start = d_gettime_ns();
+    writer.startThread();
+    const uint32_t errors = readSequence(ring, useSpans);
+    const uint64_t elapsed = d_gettime_ns() - start;
+    writer.stopThread(-1);
+
+    d_stdout("RingBuffer %s: %u values in %.2f ms, %.1f MB/s",
+             useSpans ? "spans" : "single values",
+             kNumValues, double(elapsed) / 1e6, double(kNumValues) * 4.0 * 1e3 / double(elapsed));
+
+    return errors;
+}
+
+END_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    // padding keeps reader and writer positions on separate cache lines, wherever the struct is placed
+    DISTRHO_ASSERT_EQUAL(fieldsOnSeparateCacheLines<HeapBuffer>(), true, "heap buffer positions are a cache line apart");
+    DISTRHO_ASSERT_EQUAL(fieldsOnSeparateCacheLines<SmallStackBuffer>(), true, "small buffer positions are a cache line apart");
+    DISTRHO_ASSERT_EQUAL(fieldsOnSeparateCacheLines<BigStackBuffer>(), true, "big buffer positions are a cache line apart");
+    DISTRHO_ASSERT_EQUAL(fieldsOnSeparateCacheLines<HugeStackBuffer>(), true, "huge buffer positions are a cache line apart");
+
+    // data is only visible after committing
+    {
+        SmallStackRingBuffer ring;
+        DISTRHO_ASSERT_EQUAL(ring.isDataAvailableForReading(), false, "new buffer is empty");
+
+        ring.writeUInt(1234);
+        ring.writeFloat(0.5f);
+        DISTRHO_ASSERT_EQUAL(ring.isDataAvailableForReading(), false, "uncommitted data is not readable");
+
+        DISTRHO_ASSERT_EQUAL(ring.commitWrite(), true, "commit succeeds");
+        DISTRHO_ASSERT_EQUAL(ring.isDataAvailableForReading(), true, "committed data is readable");
+        DISTRHO_ASSERT_EQUAL(ring.readUInt(), 1234u, "read uint matches");
+        DISTRHO_ASSERT_EQUAL(ring.readFloat(), 0.5f, "read float matches");
+        DISTRHO_ASSERT_EQUAL(ring.isDataAvailableForReading(), false, "buffer is empty after reading all");
+    }
+
+    // failed writes invalidate the whole commit
+    {
+        SmallStackRingBuffer ring;
+        uint8_t data[3000] = {};
+
+        ring.writeCustomData(data, sizeof(data));
+        ring.writeCustomData(data, sizeof(data));
+        DISTRHO_ASSERT_EQUAL(ring.commitWrite(), false, "commit fails after a write did not fit");
+        DISTRHO_ASSERT_EQUAL(ring.isDataAvailableForReading(), false, "nothing readable after invalidated commit");
+        DISTRHO_ASSERT_EQUAL(ring.getAvailableDataSize(), SmallStackBuffer::size, "invalidated writes are discarded");
+    }
+
+    // spans give in-place access, split in 2 when wrapping around
+    {
+        SmallStackRingBuffer ring;
+        RingBufferSpans spans;
+        uint8_t data[3000];
+
+        for (uint i=0; i<sizeof(data); ++i)
+            data[i] = static_cast<uint8_t>(i);
+
+        DISTRHO_ASSERT_EQUAL(ring.peekWriteSpans(spans), SmallStackBuffer::size - 1, "all space but 1 byte is writable");
+        DISTRHO_ASSERT_EQUAL(spans.size2, 0u, "no 2nd span when not wrapping");
+        DISTRHO_ASSERT_EQUAL(ring.peekReadSpans(spans), 0u, "nothing to read");
+
+        // move positions close to the end
+        ring.writeCustomData(data, sizeof(data));
+        ring.commitWrite();
+        ring.readCustomData(data, sizeof(data));
+
+        ring.peekWriteSpans(spans);
+        DISTRHO_ASSERT_EQUAL(spans.size1, SmallStackBuffer::size - 3000u, "1st write span goes until buffer end");
+        DISTRHO_ASSERT_EQUAL(spans.size2, 3000u - 1u, "2nd write span goes until tail");
+
+        std::memcpy(spans.data1, data, spans.size1);
+        std::memcpy(spans.data2, data + spans.size1, 2000 - spans.size1);
+        DISTRHO_ASSERT_EQUAL(ring.isDataAvailableForReading(), false, "span data is not readable before commit");
+        DISTRHO_ASSERT_EQUAL(ring.commitWriteSpans(2000), true, "span commit succeeds");
+
+        DISTRHO_ASSERT_EQUAL(ring.peekReadSpans(spans), 2000u, "committed span data is readable");
+        DISTRHO_ASSERT_EQUAL(spans.size1, SmallStackBuffer::size - 3000u, "1st read span goes until buffer end");
+        DISTRHO_ASSERT_EQUAL(spans.size2, 2000u - spans.size1, "2nd read span has the rest");
+        DISTRHO_ASSERT_EQUAL(std::memcmp(spans.data1, data, spans.size1), 0, "1st read span data matches");
+        DISTRHO_ASSERT_EQUAL(std::memcmp(spans.data2, data + spans.size1, spans.size2), 0, "2nd read span data matches");
+
+        DISTRHO_ASSERT_EQUAL(ring.commitReadSpans(1000), true, "partial read commit succeeds");
+        DISTRHO_ASSERT_EQUAL(ring.readByte(), data[1000], "regular reads continue after spans");
+    }
+
+    // committing nothing is a no-op
+    {
+        SmallStackRingBuffer ring;
+        DISTRHO_ASSERT_EQUAL(ring.commitWriteSpans(0), true, "empty span commit succeeds");
+        DISTRHO_ASSERT_EQUAL(ring.isDataAvailableForReading(), false, "empty span commit writes nothing");
+
+        ring.writeUInt(1234);
+        DISTRHO_ASSERT_EQUAL(ring.commitWriteSpans(0), true, "empty span commit still commits previous writes");
+        DISTRHO_ASSERT_EQUAL(ring.readUInt(), 1234u, "previous writes are readable");
+    }
+
+    // concurrent writer and reader, also reports throughput
+    DISTRHO_ASSERT_EQUAL(runThreaded(false), 0u, "sequence read in order with single values");
+    DISTRHO_ASSERT_EQUAL(runThreaded(true), 0u, "sequence read in order with spans");
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,227 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "tests.hpp"
+
+#include "distrho/extra/String.hpp"
+
+#ifdef DISTRHO_OS_LINUX
+# include <cstdio>
+# include <sys/resource.h>
+# include <unistd.h>
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+
+// the inline buffer holds 30 chars plus terminator, so these are the first 2 sizes going to the heap
+static const char* const k31 = "0123456789012345678901234567890";
+static const char* const k32 = "01234567890123456789012345678901";
+
+// checks that the buffer is inside the String object itself, meaning no heap allocation
+static bool isInline(const DISTRHO_NAMESPACE::String& str)
+{
+    const char* const buffer = str.buffer();
+    const char* const object = reinterpret_cast<const char*>(&str);
+    return buffer >= object && buffer < object + sizeof(str);
+}
+
+#ifdef DISTRHO_OS_LINUX
+// limits the address space to a bit more than what is in use now, so big allocations fail
+static bool limitAddressSpace(struct rlimit& previous)
+{
+    unsigned long pages = 0;
+
+    if (FILE* const fd = std::fopen("/proc/self/statm", "r"))
+    {
+        if (std::fscanf(fd, "%lu", &pages) != 1)
+            pages = 0;
+        std::fclose(fd);
+    }
+
+    if (pages == 0 || ::getrlimit(RLIMIT_AS, &previous) != 0)
+        return false;
+
+    struct rlimit limit = previous;
+    limit.rlim_cur = pages * static_cast<unsigned long>(::sysconf(_SC_PAGESIZE)) + 16 * 1024 * 1024;
+    return ::setrlimit(RLIMIT_AS, &limit) == 0;
+}
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    // inline and heap storage boundary
+    {
+        String empty;
+        DISTRHO_ASSERT_EQUAL(empty.length(), 0u, "empty string has no length");
+        DISTRHO_ASSERT_EQUAL(empty.isEmpty(), true, "empty string is empty");
+
+        String s31(k31), s32(k32);
+        DISTRHO_ASSERT_EQUAL(s31.length(), 31u, "31 chars length");
+        DISTRHO_ASSERT_EQUAL(s32.length(), 32u, "32 chars length");
+        DISTRHO_ASSERT_EQUAL((s31 == k31), true, "31 chars contents");
+        DISTRHO_ASSERT_EQUAL((s32 == k32), true, "32 chars contents");
+        DISTRHO_ASSERT_EQUAL(isInline(String(k31 + 1)), true, "30 chars are stored inline");
+        DISTRHO_ASSERT_EQUAL(isInline(s31), false, "31 chars go to the heap");
+        DISTRHO_ASSERT_EQUAL(isInline(s32), false, "32 chars go to the heap");
+
+        // switching between storage types
+        String str(k32);
+        str = "short";
+        DISTRHO_ASSERT_EQUAL(isInline(str), true, "heap to inline");
+        DISTRHO_ASSERT_EQUAL((str == "short"), true, "heap to inline contents");
+        str = k32;
+        DISTRHO_ASSERT_EQUAL(isInline(str), false, "inline to heap");
+        DISTRHO_ASSERT_EQUAL((str == k32), true, "inline to heap contents");
+        str = String(k31);
+        DISTRHO_ASSERT_EQUAL((str == k31), true, "heap to heap contents");
+        str.clear();
+        DISTRHO_ASSERT_EQUAL(str.isEmpty(), true, "cleared string is empty");
+    }
+
+#ifdef DISTRHO_PROPER_CPP11_SUPPORT
+    // move constructor
+    {
+        String heap(k32);
+        const char* const heapBuffer = heap.buffer();
+        String movedHeap(static_cast<String&&>(heap));
+        DISTRHO_ASSERT_EQUAL(movedHeap.buffer(), heapBuffer, "heap buffer changes owner");
+        DISTRHO_ASSERT_EQUAL((movedHeap == k32), true, "moved heap contents");
+        DISTRHO_ASSERT_EQUAL(heap.isEmpty(), true, "moved-from heap string is empty");
+
+        String small("small");
+        String movedSmall(static_cast<String&&>(small));
+        DISTRHO_ASSERT_EQUAL(isInline(movedSmall), true, "inline buffer is copied into the new string");
+        DISTRHO_ASSERT_EQUAL((movedSmall == "small"), true, "moved inline contents");
+        DISTRHO_ASSERT_EQUAL(small.isEmpty(), true, "moved-from inline string is empty");
+
+        String none;
+        String movedNone(static_cast<String&&>(none));
+        DISTRHO_ASSERT_EQUAL(movedNone.isEmpty(), true, "moved empty string is empty");
+    }
+
+    // move assignment, over all combinations of storage
+    {
+        String target(k32), source(k31);
+        target = static_cast<String&&>(source);
+        DISTRHO_ASSERT_EQUAL((target == k31), true, "heap over heap");
+        DISTRHO_ASSERT_EQUAL(source.isEmpty(), true, "heap over heap leaves source empty");
+
+        source = "small";
+        target = static_cast<String&&>(source);
+        DISTRHO_ASSERT_EQUAL((target == "small"), true, "inline over heap");
+        DISTRHO_ASSERT_EQUAL(isInline(target), true, "inline over heap stays inline");
+
+        source = k32;
+        target = static_cast<String&&>(source);
+        DISTRHO_ASSERT_EQUAL((target == k32), true, "heap over inline");
+
+        target = static_cast<String&&>(source);
+        DISTRHO_ASSERT_EQUAL(target.isEmpty(), true, "empty over heap");
+    }
+#endif
+
+    // self-assignment
+    {
+        String heap(k32), small("small");
+        String& heapRef(heap);
+        String& smallRef(small);
+
+        heap = heapRef;
+        small = smallRef;
+        DISTRHO_ASSERT_EQUAL((heap == k32), true, "heap self-assignment");
+        DISTRHO_ASSERT_EQUAL((small == "small"), true, "inline self-assignment");
+
+        heap = heap.buffer() + 20;
+        small = small.buffer() + 2;
+        DISTRHO_ASSERT_EQUAL((heap == k32 + 20), true, "assigning part of own heap data");
+        DISTRHO_ASSERT_EQUAL((small == "all"), true, "assigning part of own inline data");
+
+#ifdef DISTRHO_PROPER_CPP11_SUPPORT
+        heap = k32;
+        heap = static_cast<String&&>(heapRef);
+        small = static_cast<String&&>(smallRef);
+        DISTRHO_ASSERT_EQUAL((heap == k32), true, "heap self-move");
+        DISTRHO_ASSERT_EQUAL((small == "all"), true, "inline self-move");
+#endif
+    }
+
+    // appending across the boundary
+    {
+        String str("0123456789");
+        str += "01234567890123456789";
+        DISTRHO_ASSERT_EQUAL(str.length(), 30u, "appending up to 30 chars");
+        DISTRHO_ASSERT_EQUAL(isInline(str), true, "30 chars stay inline when appending");
+
+        str += "0";
+        DISTRHO_ASSERT_EQUAL((str == k31), true, "appending into the heap");
+        DISTRHO_ASSERT_EQUAL(isInline(str), false, "31 chars go to the heap when appending");
+
+        str += "1";
+        DISTRHO_ASSERT_EQUAL((str == k32), true, "appending to heap data");
+
+        String small("abc");
+        small += small;
+        DISTRHO_ASSERT_EQUAL((small == "abcabc"), true, "appending inline string to itself");
+
+        String heap(k32);
+        heap += heap;
+        DISTRHO_ASSERT_EQUAL(heap.length(), 64u, "appending heap string to itself");
+        DISTRHO_ASSERT_EQUAL((heap.startsWith(k32) && heap.endsWith(k32)), true, "appending heap string to itself contents");
+
+        const String sum = String("0123456789") + "012345678901234567890";
+        DISTRHO_ASSERT_EQUAL((sum == k31), true, "operator+ across the boundary");
+    }
+
+#ifdef DISTRHO_OS_LINUX
+    // allocation failure leaves an empty string
+    {
+        const std::size_t bigSize = 64 * 1024 * 1024;
+        char* const big = static_cast<char*>(std::malloc(bigSize + 1));
+        DISTRHO_ASSERT_NOT_EQUAL(big, nullptr, "big source string allocated");
+        std::memset(big, 'x', bigSize);
+        big[bigSize] = '\0';
+
+        String str(k32);
+        struct rlimit previous;
+
+        if (limitAddressSpace(previous))
+        {
+            str = big;
+            ::setrlimit(RLIMIT_AS, &previous);
+
+            DISTRHO_ASSERT_EQUAL(str.isEmpty(), true, "failed allocation gives an empty string");
+            DISTRHO_ASSERT_EQUAL(str.buffer()[0], '\0', "failed allocation gives a valid buffer");
+
+            str = k32;
+            DISTRHO_ASSERT_EQUAL((str == k32), true, "string works after a failed allocation");
+        }
+        else
+        {
+            d_stdout("Could not limit address space, skipping allocation failure test");
+        }
+
+        std::free(big);
+    }
+#endif
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,870 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Minimal host that loads compiled plugin binaries through their C ABI and measures the cost of each process call.
+// Running the same plugin built as LADSPA, LV2 and VST2 side by side shows how much each wrapper adds on top of the DSP.
+
+#include "distrho/extra/Time.hpp"
+
+#include "distrho/src/ladspa/ladspa.h"
+#include "distrho/src/lv2/atom.h"
+#include "distrho/src/lv2/atom-util.h"
+#include "distrho/src/lv2/buf-size.h"
+#include "distrho/src/lv2/lv2.h"
+#include "distrho/src/lv2/midi.h"
+#include "distrho/src/lv2/options.h"
+#include "distrho/src/lv2/parameters.h"
+#include "distrho/src/lv2/urid.h"
+#include "distrho/src/lv2/worker.h"
+#include "distrho/src/vestige/vestige.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct HostOptions {
+    uint32_t blockSize;
+    double sampleRate;
+    uint32_t calls;
+    uint32_t repeats;
+    uint32_t midiEvents;
+
+    HostOptions()
+        : blockSize(256),
+          sampleRate(48000.0),
+          calls(10000),
+          repeats(5),
+          midiEvents(0) {}
+};
+
+static HostOptions gOptions;
+
+static void fillNoise(float* const buffer, const uint32_t frames, uint32_t seed)
+{
+    for (uint32_t i=0; i < frames; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        buffer[i] = static_cast<float>(static_cast<int32_t>(seed)) / 2147483648.0f * 0.5f;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// audio buffers shared by all formats
+
+class AudioBuffers
+{
+public:
+    AudioBuffers()
+        : fInputs(),
+          fOutputs() {}
+
+    ~AudioBuffers()
+    {
+        clear();
+    }
+
+    void allocate(const uint32_t numInputs, const uint32_t numOutputs)
+    {
+        clear();
+
+        for (uint32_t i=0; i < numInputs; ++i)
+        {
+            float* const buffer = new float[gOptions.blockSize];
+            fillNoise(buffer, gOptions.blockSize, 0x1234u + i);
+            fInputs.push_back(buffer);
+        }
+
+        for (uint32_t i=0; i < numOutputs; ++i)
+        {
+            float* const buffer = new float[gOptions.blockSize];
+            std::memset(buffer, 0, sizeof(float)*gOptions.blockSize);
+            fOutputs.push_back(buffer);
+        }
+
+        // never hand out null arrays, VST2 hosts always pass valid pointers
+        fInputs.push_back(nullptr);
+        fOutputs.push_back(nullptr);
+    }
+
+    float** getInputs() noexcept
+    {
+        return &fInputs[0];
+    }
+
+    float** getOutputs() noexcept
+    {
+        return &fOutputs[0];
+    }
+
+private:
+    std::vector<float*> fInputs;
+    std::vector<float*> fOutputs;
+
+    void clear()
+    {
+        for (size_t i=0; i < fInputs.size(); ++i)
+            delete[] fInputs[i];
+        for (size_t i=0; i < fOutputs.size(); ++i)
+            delete[] fOutputs[i];
+
+        fInputs.clear();
+        fOutputs.clear();
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// common format interface
+
+class FormatHost
+{
+public:
+    virtual ~FormatHost() {}
+    virtual const char* getFormatName() const = 0;
+    virtual const char* getPluginName() const = 0;
+    virtual bool start() = 0;
+    virtual void process() = 0;
+    virtual void stop() = 0;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// LADSPA
+
+class LadspaHost : public FormatHost
+{
+public:
+    LadspaHost(const LADSPA_Descriptor_Function descFn)
+        : fDescriptor(descFn(0)),
+          fHandle(nullptr),
+          fBuffers(),
+          fControls() {}
+
+    const char* getFormatName() const override
+    {
+        return "LADSPA";
+    }
+
+    const char* getPluginName() const override
+    {
+        return fDescriptor != nullptr ? fDescriptor->Name : "";
+    }
+
+    bool start() override
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fDescriptor != nullptr, false);
+
+        fHandle = fDescriptor->instantiate(fDescriptor, static_cast<ulong>(gOptions.sampleRate));
+        DISTRHO_SAFE_ASSERT_RETURN(fHandle != nullptr, false);
+
+        uint32_t numInputs = 0, numOutputs = 0;
+
+        for (ulong i=0; i < fDescriptor->PortCount; ++i)
+        {
+            const LADSPA_PortDescriptor portDesc = fDescriptor->PortDescriptors[i];
+
+            if (LADSPA_IS_PORT_AUDIO(portDesc))
+            {
+                if (LADSPA_IS_PORT_INPUT(portDesc))
+                    ++numInputs;
+                else
+                    ++numOutputs;
+            }
+        }
+
+        fBuffers.allocate(numInputs, numOutputs);
+        fControls.resize(fDescriptor->PortCount, 0.0f);
+
+        uint32_t audioIn = 0, audioOut = 0;
+
+        for (ulong i=0; i < fDescriptor->PortCount; ++i)
+        {
+            const LADSPA_PortDescriptor portDesc = fDescriptor->PortDescriptors[i];
+
+            if (LADSPA_IS_PORT_AUDIO(portDesc))
+            {
+                float* const buffer = LADSPA_IS_PORT_INPUT(portDesc) ? fBuffers.getInputs()[audioIn++]
+                                                                     : fBuffers.getOutputs()[audioOut++];
+                fDescriptor->connect_port(fHandle, i, buffer);
+            }
+            else
+            {
+                fControls[i] = getDefaultValue(fDescriptor->PortRangeHints[i]);
+                fDescriptor->connect_port(fHandle, i, &fControls[i]);
+            }
+        }
+
+        if (fDescriptor->activate != nullptr)
+            fDescriptor->activate(fHandle);
+
+        return true;
+    }
+
+    void process() override
+    {
+        fDescriptor->run(fHandle, gOptions.blockSize);
+    }
+
+    void stop() override
+    {
+        if (fHandle == nullptr)
+            return;
+
+        if (fDescriptor->deactivate != nullptr)
+            fDescriptor->deactivate(fHandle);
+
+        fDescriptor->cleanup(fHandle);
+        fHandle = nullptr;
+    }
+
+private:
+    const LADSPA_Descriptor* const fDescriptor;
+    LADSPA_Handle fHandle;
+    AudioBuffers fBuffers;
+    std::vector<LADSPA_Data> fControls;
+
+    static LADSPA_Data getDefaultValue(const LADSPA_PortRangeHint& hint)
+    {
+        const LADSPA_PortRangeHintDescriptor hints = hint.HintDescriptor;
+        const LADSPA_Data min = LADSPA_IS_HINT_BOUNDED_BELOW(hints) ? hint.LowerBound : 0.0f;
+        const LADSPA_Data max = LADSPA_IS_HINT_BOUNDED_ABOVE(hints) ? hint.UpperBound : 1.0f;
+
+        switch (hints & LADSPA_HINT_DEFAULT_MASK)
+        {
+        case LADSPA_HINT_DEFAULT_MINIMUM: return min;
+        case LADSPA_HINT_DEFAULT_LOW:     return min * 0.75f + max * 0.25f;
+        case LADSPA_HINT_DEFAULT_MIDDLE:  return (min + max) * 0.5f;
+        case LADSPA_HINT_DEFAULT_HIGH:    return min * 0.25f + max * 0.75f;
+        case LADSPA_HINT_DEFAULT_MAXIMUM: return max;
+        case LADSPA_HINT_DEFAULT_0:       return 0.0f;
+        case LADSPA_HINT_DEFAULT_1:       return 1.0f;
+        case LADSPA_HINT_DEFAULT_100:     return 100.0f;
+        case LADSPA_HINT_DEFAULT_440:     return 440.0f;
+        }
+
+        return min;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// LV2
+
+class Lv2Host : public FormatHost
+{
+    enum PortType {
+        kPortAudio,
+        kPortCV,
+        kPortControl,
+        kPortAtom
+    };
+
+    struct Port {
+        uint32_t index;
+        bool isInput;
+        PortType type;
+        float defaultValue;
+    };
+
+public:
+    Lv2Host(const LV2_Descriptor_Function descFn, const char* const filename)
+        : fDescriptor(descFn(0)),
+          fHandle(nullptr),
+          fFilename(filename),
+          fPorts(),
+          fBuffers(),
+          fControls(),
+          fEventsIn(nullptr),
+          fEventsOut(nullptr),
+          fURIs(),
+          fChunkURID(0),
+          fNominalBlockLength(0),
+          fMaxBlockLength(0),
+          fSampleRate(0.0f)
+    {
+        fUridMap.handle = this;
+        fUridMap.map = uridMap;
+        fWorker.handle = this;
+        fWorker.schedule_work = scheduleWork;
+    }
+
+    ~Lv2Host() override
+    {
+        delete[] fEventsIn;
+        delete[] fEventsOut;
+    }
+
+    const char* getFormatName() const override
+    {
+        return "LV2";
+    }
+
+    const char* getPluginName() const override
+    {
+        return fDescriptor != nullptr ? fDescriptor->URI : "";
+    }
+
+    bool start() override
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fDescriptor != nullptr, false);
+
+        if (! parsePorts())
+            return false;
+
+        fNominalBlockLength = static_cast<int32_t>(gOptions.blockSize);
+        fMaxBlockLength = static_cast<int32_t>(gOptions.blockSize);
+        fSampleRate = static_cast<float>(gOptions.sampleRate);
+
+        const LV2_URID atomInt = uridMap(this, LV2_ATOM__Int);
+        const LV2_URID atomFloat = uridMap(this, LV2_ATOM__Float);
+
+        const LV2_Options_Option options[] = {
+            { LV2_OPTIONS_INSTANCE, 0, uridMap(this, LV2_BUF_SIZE__nominalBlockLength),
+              sizeof(int32_t), atomInt, &fNominalBlockLength },
+            { LV2_OPTIONS_INSTANCE, 0, uridMap(this, LV2_BUF_SIZE__maxBlockLength),
+              sizeof(int32_t), atomInt, &fMaxBlockLength },
+            { LV2_OPTIONS_INSTANCE, 0, uridMap(this, LV2_PARAMETERS__sampleRate),
+              sizeof(float), atomFloat, &fSampleRate },
+            { LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, nullptr }
+        };
+
+        const LV2_Feature featOptions = { LV2_OPTIONS__options, (void*)options };
+        const LV2_Feature featUridMap = { LV2_URID__map, &fUridMap };
+        const LV2_Feature featWorker = { LV2_WORKER__schedule, &fWorker };
+        const LV2_Feature featBounded = { LV2_BUF_SIZE__boundedBlockLength, nullptr };
+        const LV2_Feature* const features[] = { &featOptions, &featUridMap, &featWorker, &featBounded, nullptr };
+
+        const std::string bundlePath(getBundlePath());
+        fHandle = fDescriptor->instantiate(fDescriptor, gOptions.sampleRate, bundlePath.c_str(), features);
+        DISTRHO_SAFE_ASSERT_RETURN(fHandle != nullptr, false);
+
+        fChunkURID = uridMap(this, LV2_ATOM__Chunk);
+
+        uint32_t numInputs = 0, numOutputs = 0;
+
+        for (size_t i=0; i < fPorts.size(); ++i)
+        {
+            const Port& port(fPorts[i]);
+
+            if (port.type == kPortAudio || port.type == kPortCV)
+            {
+                if (port.isInput)
+                    ++numInputs;
+                else
+                    ++numOutputs;
+            }
+        }
+
+        fBuffers.allocate(numInputs, numOutputs);
+        fControls.resize(fPorts.size(), 0.0f);
+
+        uint32_t audioIn = 0, audioOut = 0;
+
+        for (size_t i=0; i < fPorts.size(); ++i)
+        {
+            const Port& port(fPorts[i]);
+
+            switch (port.type)
+            {
+            case kPortAudio:
+            case kPortCV:
+                fDescriptor->connect_port(fHandle, port.index, port.isInput ? fBuffers.getInputs()[audioIn++]
+                                                                            : fBuffers.getOutputs()[audioOut++]);
+                break;
+            case kPortControl:
+                fControls[i] = port.defaultValue;
+                fDescriptor->connect_port(fHandle, port.index, &fControls[i]);
+                break;
+            case kPortAtom:
+                if (port.isInput)
+                {
+                    if (fEventsIn == nullptr)
+                    {
+                        fEventsIn = new uint64_t[kAtomBufferSize/sizeof(uint64_t)];
+                        fillEventsIn();
+                    }
+                    fDescriptor->connect_port(fHandle, port.index, fEventsIn);
+                }
+                else
+                {
+                    if (fEventsOut == nullptr)
+                        fEventsOut = new uint64_t[kAtomBufferSize/sizeof(uint64_t)];
+                    fDescriptor->connect_port(fHandle, port.index, fEventsOut);
+                }
+                break;
+            }
+        }
+
+        if (fDescriptor->activate != nullptr)
+            fDescriptor->activate(fHandle);
+
+        return true;
+    }
+
+    void process() override
+    {
+        // hosts must reset the capacity of output sequences before every run
+        if (fEventsOut != nullptr)
+        {
+            LV2_Atom* const atom = (LV2_Atom*)fEventsOut;
+            atom->size = kAtomBufferSize - sizeof(LV2_Atom);
+            atom->type = fChunkURID;
+        }
+
+        fDescriptor->run(fHandle, gOptions.blockSize);
+    }
+
+    void stop() override
+    {
+        if (fHandle == nullptr)
+            return;
+
+        if (fDescriptor->deactivate != nullptr)
+            fDescriptor->deactivate(fHandle);
+
+        fDescriptor->cleanup(fHandle);
+        fHandle = nullptr;
+    }
+
+private:
+    static const uint32_t kAtomBufferSize = 64 * 1024;
+
+    const LV2_Descriptor* const fDescriptor;
+    LV2_Handle fHandle;
+    const std::string fFilename;
+    std::vector<Port> fPorts;
+    AudioBuffers fBuffers;
+    std::vector<float> fControls;
+    uint64_t* fEventsIn;
+    uint64_t* fEventsOut;
+
+    std::vector<std::string> fURIs;
+    LV2_URID fChunkURID;
+    LV2_URID_Map fUridMap;
+    LV2_Worker_Schedule fWorker;
+    int32_t fNominalBlockLength;
+    int32_t fMaxBlockLength;
+    float fSampleRate;
+
+    std::string getBundlePath() const
+    {
+        const size_t sep = fFilename.rfind('/');
+        return sep != std::string::npos ? fFilename.substr(0, sep + 1) : std::string("./");
+    }
+
+    // DPF writes one "lv2:port [ ... ]" block per port with a fixed layout,
+    // which is enough to find indexes, types and defaults without a full turtle parser.
+    bool parsePorts()
+    {
+        std::string ttlFilename(fFilename);
+        const size_t ext = ttlFilename.rfind('.');
+        if (ext != std::string::npos)
+            ttlFilename.resize(ext);
+        ttlFilename += ".ttl";
+
+        FILE* const fp = std::fopen(ttlFilename.c_str(), "r");
+
+        if (fp == nullptr)
+        {
+            d_stderr2("Cannot open '%s', generate the LV2 turtle files first (make gen)", ttlFilename.c_str());
+            return false;
+        }
+
+        char line[1024];
+        Port* port = nullptr;
+
+        while (std::fgets(line, sizeof(line), fp) != nullptr)
+        {
+            const bool isInput = std::strstr(line, "a lv2:InputPort") != nullptr;
+
+            if (isInput || std::strstr(line, "a lv2:OutputPort") != nullptr)
+            {
+                Port newPort;
+                newPort.index = UINT32_MAX;
+                newPort.isInput = isInput;
+                newPort.defaultValue = 0.0f;
+
+                if (std::strstr(line, "lv2:AudioPort") != nullptr)
+                    newPort.type = kPortAudio;
+                else if (std::strstr(line, "lv2:CVPort") != nullptr)
+                    newPort.type = kPortCV;
+                else if (std::strstr(line, "atom:AtomPort") != nullptr)
+                    newPort.type = kPortAtom;
+                else
+                    newPort.type = kPortControl;
+
+                fPorts.push_back(newPort);
+                port = &fPorts.back();
+                continue;
+            }
+
+            if (port == nullptr)
+                continue;
+
+            if (const char* const index = std::strstr(line, "lv2:index "))
+                port->index = static_cast<uint32_t>(std::strtoul(index + 10, nullptr, 10));
+            else if (const char* const def = std::strstr(line, "lv2:default "))
+                port->defaultValue = static_cast<float>(std::strtod(def + 12, nullptr));
+        }
+
+        std::fclose(fp);
+
+        for (size_t i=0; i < fPorts.size(); ++i)
+        {
+            if (fPorts[i].index == UINT32_MAX)
+            {
+                d_stderr2("Port without index in '%s'", ttlFilename.c_str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void fillEventsIn()
+    {
+        LV2_Atom_Sequence* const seq = (LV2_Atom_Sequence*)fEventsIn;
+        seq->atom.type = uridMap(this, LV2_ATOM__Sequence);
+        seq->atom.size = sizeof(LV2_Atom_Sequence_Body);
+        seq->body.unit = 0;
+        seq->body.pad = 0;
+
+        const LV2_URID midiEvent = uridMap(this, LV2_MIDI__MidiEvent);
+        const uint32_t eventSize = lv2_atom_pad_size(sizeof(LV2_Atom_Event) + 3);
+        uint8_t* ptr = (uint8_t*)(seq + 1);
+
+        for (uint32_t i=0; i < gOptions.midiEvents; ++i)
+        {
+            if (sizeof(LV2_Atom_Sequence) + seq->atom.size + eventSize > kAtomBufferSize)
+                break;
+
+            LV2_Atom_Event* const event = (LV2_Atom_Event*)ptr;
+            event->time.frames = i * gOptions.blockSize / gOptions.midiEvents;
+            event->body.type = midiEvent;
+            event->body.size = 3;
+
+            uint8_t* const data = (uint8_t*)(event + 1);
+            data[0] = (i % 2) == 0 ? 0x90 : 0x80;
+            data[1] = 60 + (i / 2) % 12;
+            data[2] = 100;
+
+            ptr += eventSize;
+            seq->atom.size += eventSize;
+        }
+    }
+
+    static LV2_URID uridMap(const LV2_URID_Map_Handle handle, const char* const uri)
+    {
+        std::vector<std::string>& uris(((Lv2Host*)handle)->fURIs);
+
+        for (size_t i=0; i < uris.size(); ++i)
+        {
+            if (uris[i] == uri)
+                return static_cast<LV2_URID>(i + 1);
+        }
+
+        uris.push_back(uri);
+        return static_cast<LV2_URID>(uris.size());
+    }
+
+    static LV2_Worker_Status scheduleWork(LV2_Worker_Schedule_Handle, uint32_t, const void*)
+    {
+        return LV2_WORKER_SUCCESS;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// VST2
+
+typedef AEffect* (*VstEntryFunction)(audioMasterCallback);
+
+class Vst2Host : public FormatHost
+{
+public:
+    Vst2Host(const VstEntryFunction entry)
+        : fEntry(entry),
+          fEffect(nullptr),
+          fBuffers(),
+          fEvents(nullptr),
+          fMidiEvents()
+    {
+        std::memset(fProductName, 0, sizeof(fProductName));
+    }
+
+    ~Vst2Host() override
+    {
+        std::free(fEvents);
+    }
+
+    const char* getFormatName() const override
+    {
+        return "VST2";
+    }
+
+    const char* getPluginName() const override
+    {
+        return fProductName;
+    }
+
+    bool start() override
+    {
+        fEffect = fEntry(hostCallback);
+        DISTRHO_SAFE_ASSERT_RETURN(fEffect != nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(fEffect->magic == kEffectMagic, false);
+        DISTRHO_SAFE_ASSERT_RETURN(fEffect->processReplacing != nullptr, false);
+
+        fEffect->dispatcher(fEffect, effOpen, 0, 0, nullptr, 0.0f);
+        fEffect->dispatcher(fEffect, effGetEffectName, 0, 0, fProductName, 0.0f);
+        fEffect->dispatcher(fEffect, effSetSampleRate, 0, 0, nullptr, static_cast<float>(gOptions.sampleRate));
+        fEffect->dispatcher(fEffect, effSetBlockSize, 0, static_cast<intptr_t>(gOptions.blockSize), nullptr, 0.0f);
+
+        fBuffers.allocate(static_cast<uint32_t>(fEffect->numInputs), static_cast<uint32_t>(fEffect->numOutputs));
+
+        if (gOptions.midiEvents != 0)
+        {
+            fMidiEvents.resize(gOptions.midiEvents);
+            fEvents = (VstEvents*)std::calloc(1, sizeof(VstEvents) + sizeof(VstEvent*) * gOptions.midiEvents);
+            fEvents->numEvents = static_cast<int>(gOptions.midiEvents);
+
+            for (uint32_t i=0; i < gOptions.midiEvents; ++i)
+            {
+                VstMidiEvent& event(fMidiEvents[i]);
+                std::memset(&event, 0, sizeof(VstMidiEvent));
+                event.type = kVstMidiType;
+                event.byteSize = sizeof(VstMidiEvent);
+                event.deltaFrames = static_cast<int>(i * gOptions.blockSize / gOptions.midiEvents);
+                event.midiData[0] = static_cast<char>((i % 2) == 0 ? 0x90 : 0x80);
+                event.midiData[1] = static_cast<char>(60 + (i / 2) % 12);
+                event.midiData[2] = 100;
+                fEvents->events[i] = (VstEvent*)&event;
+            }
+        }
+
+        fEffect->dispatcher(fEffect, effMainsChanged, 0, 1, nullptr, 0.0f);
+        fEffect->dispatcher(fEffect, effStartProcess, 0, 0, nullptr, 0.0f);
+        return true;
+    }
+
+    void process() override
+    {
+        if (fEvents != nullptr)
+            fEffect->dispatcher(fEffect, effProcessEvents, 0, 0, fEvents, 0.0f);
+
+        fEffect->processReplacing(fEffect, fBuffers.getInputs(), fBuffers.getOutputs(),
+                                  static_cast<int>(gOptions.blockSize));
+    }
+
+    void stop() override
+    {
+        if (fEffect == nullptr)
+            return;
+
+        fEffect->dispatcher(fEffect, effStopProcess, 0, 0, nullptr, 0.0f);
+        fEffect->dispatcher(fEffect, effMainsChanged, 0, 0, nullptr, 0.0f);
+        fEffect->dispatcher(fEffect, effClose, 0, 0, nullptr, 0.0f);
+        fEffect = nullptr;
+    }
+
+private:
+    const VstEntryFunction fEntry;
+    AEffect* fEffect;
+    AudioBuffers fBuffers;
+    VstEvents* fEvents;
+    std::vector<VstMidiEvent> fMidiEvents;
+    char fProductName[VestigeMaxNameLen + 1];
+
+    static intptr_t hostCallback(AEffect*, const int32_t opcode, int32_t, intptr_t, void*, float)
+    {
+        switch (opcode)
+        {
+        case audioMasterVersion:
+            return 2400;
+        case audioMasterGetSampleRate:
+            return static_cast<intptr_t>(gOptions.sampleRate);
+        case audioMasterGetBlockSize:
+            return static_cast<intptr_t>(gOptions.blockSize);
+        }
+
+        return 0;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static FormatHost* createFormatHost(void* const lib, const char* const filename)
+{
+    if (const LV2_Descriptor_Function descFn = (LV2_Descriptor_Function)dlsym(lib, "lv2_descriptor"))
+        return new Lv2Host(descFn, filename);
+
+    // DPF exports the VST2 entry point as "main" on Linux, like the old SDK did
+    if (const VstEntryFunction entry = (VstEntryFunction)dlsym(lib, "VSTPluginMain"))
+        return new Vst2Host(entry);
+    if (const VstEntryFunction entry = (VstEntryFunction)dlsym(lib, "main"))
+        return new Vst2Host(entry);
+
+    if (const LADSPA_Descriptor_Function descFn = (LADSPA_Descriptor_Function)dlsym(lib, "ladspa_descriptor"))
+        return new LadspaHost(descFn);
+
+    return nullptr;
+}
+
+// returns the best (lowest) average cost of a single process call, in nanoseconds
+static double measure(FormatHost* const host)
+{
+    // warm up caches and any lazy allocations in the wrapper
+    for (uint32_t i=0, count = std::min(gOptions.calls, 100u); i < count; ++i)
+        host->process();
+
+    double best = 0.0;
+
+    for (uint32_t r=0; r < gOptions.repeats; ++r)
+    {
+        const uint64_t start = d_gettime_ns();
+
+        for (uint32_t i=0; i < gOptions.calls; ++i)
+            host->process();
+
+        const double perCall = static_cast<double>(d_gettime_ns() - start) / gOptions.calls;
+
+        if (r == 0 || perCall < best)
+            best = perCall;
+    }
+
+    return best;
+}
+
+static void printHelp(const char* const name)
+{
+    d_stdout("Usage: %s [options] plugin-binary...", name);
+    d_stdout("Loads each plugin binary through its LADSPA, LV2 or VST2 ABI and measures the cost of a process call.");
+    d_stdout("Pass the same plugin built in different formats to compare the overhead of each wrapper.");
+    d_stdout("LV2 binaries need their turtle files, generate them with 'make gen' first.");
+    d_stdout("");
+    d_stdout("Options:");
+    d_stdout("  --block-size N    Frames per process call (default 256)");
+    d_stdout("  --sample-rate N   Sample rate to run at (default 48000)");
+    d_stdout("  --calls N         Process calls per measurement (default 10000)");
+    d_stdout("  --repeats N       Measurements per plugin, the best one is reported (default 5)");
+    d_stdout("  --midi N          MIDI events sent per call, where supported (default 0)");
+    d_stdout("  -h, --help        Show this help and exit");
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<const char*> filenames;
+
+    for (int i=1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        bool ok = true;
+
+        if (std::strcmp(arg, "--block-size") == 0 && i+1 < argc)
+            ok = (gOptions.blockSize = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])))) > 0;
+        else if (std::strcmp(arg, "--sample-rate") == 0 && i+1 < argc)
+            ok = (gOptions.sampleRate = std::atof(argv[++i])) > 0.0;
+        else if (std::strcmp(arg, "--calls") == 0 && i+1 < argc)
+            ok = (gOptions.calls = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])))) > 0;
+        else if (std::strcmp(arg, "--repeats") == 0 && i+1 < argc)
+            ok = (gOptions.repeats = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])))) > 0;
+        else if (std::strcmp(arg, "--midi") == 0 && i+1 < argc)
+            gOptions.midiEvents = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0)
+        {
+            printHelp(argv[0]);
+            return 0;
+        }
+        else if (arg[0] == '-')
+            ok = false;
+        else
+            filenames.push_back(arg);
+
+        if (! ok)
+        {
+            d_stderr("Invalid or incomplete argument '%s'", arg);
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if (filenames.empty())
+    {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+    std::vector<double> results(filenames.size(), 0.0);
+    std::vector<std::string> names(filenames.size());
+    double fastest = 0.0;
+    int ret = 0;
+
+    for (size_t i=0; i < filenames.size(); ++i)
+    {
+        void* const lib = dlopen(filenames[i], RTLD_NOW|RTLD_LOCAL);
+
+        if (lib == nullptr)
+        {
+            d_stderr2("Failed to load '%s': %s", filenames[i], dlerror());
+            ret = 1;
+            continue;
+        }
+
+        if (FormatHost* const host = createFormatHost(lib, filenames[i]))
+        {
+            if (host->start())
+            {
+                results[i] = measure(host);
+                names[i] = std::string(host->getFormatName()) + " " + host->getPluginName();
+
+                if (fastest == 0.0 || results[i] < fastest)
+                    fastest = results[i];
+            }
+            else
+            {
+                d_stderr2("Failed to start '%s'", filenames[i]);
+                ret = 1;
+            }
+
+            host->stop();
+            delete host;
+        }
+        else
+        {
+            d_stderr2("'%s' is not a LADSPA, LV2 or VST2 plugin", filenames[i]);
+            ret = 1;
+        }
+
+        dlclose(lib);
+    }
+
+    d_stdout("Block size %u, sample rate %.0f, %u MIDI events per call",
+             gOptions.blockSize, gOptions.sampleRate, gOptions.midiEvents);
+
+    for (size_t i=0; i < filenames.size(); ++i)
+    {
+        if (results[i] == 0.0)
+            continue;
+
+        d_stdout("%-52s %10.1f ns/call %8.3f ns/sample  +%.1f ns/call vs fastest",
+                 names[i].c_str(), results[i], results[i] / gOptions.blockSize, results[i] - fastest);
+    }
+
+    return ret;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
@@ -2,7 +2,7 @@
 # -*- coding: utf-8 -*-
 
 # DISTRHO Plugin Framework (DPF)
-# Copyright (C) 2012-2019 Filipe Coelho <falktx@falktx.com>
+# Copyright (C) 2012-2021 Filipe Coelho <falktx@falktx.com>
 #
 # Permission to use, copy, modify, and/or distribute this software for any purpose with
 # or without fee is hereby granted, provided that the above copyright notice and this
@@ -18,8 +18,114 @@
 import os, sys
 
 # -----------------------------------------------------
+# LZ4 block format, as decoded by d_decompressLZ4 in distrho/extra/LZ4.hpp
 
-def res2c(namespace, filenames):
+def lz4_write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+def lz4_write_sequence(out, literals, offset, matchLength):
+    litLength = len(literals)
+    token = min(litLength, 15) << 4
+
+    if offset != 0:
+        token |= min(matchLength - 4, 15)
+
+    out.append(token)
+
+    if litLength >= 15:
+        lz4_write_length(out, litLength - 15)
+
+    out += literals
+
+    if offset == 0:
+        return
+
+    out.append(offset & 0xff)
+    out.append(offset >> 8)
+
+    if matchLength - 4 >= 15:
+        lz4_write_length(out, matchLength - 4 - 15)
+
+def lz4_compress(data):
+    size = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+
+    # the last match must start 12 bytes before the end, and the last 5 bytes are always literals
+    matchStartLimit = size - 12
+    matchEndLimit = size - 5
+
+    while i < matchStartLimit:
+        key = data[i:i+4]
+        ref = table.get(key)
+        table[key] = i
+
+        if ref is None or i - ref > 0xffff:
+            i += 1
+            continue
+
+        length = 4
+        while i + length < matchEndLimit and data[ref+length] == data[i+length]:
+            length += 1
+
+        while i > anchor and ref > 0 and data[i-1] == data[ref-1]:
+            i -= 1
+            ref -= 1
+            length += 1
+
+        lz4_write_sequence(out, data[anchor:i], i - ref, length)
+
+        i += length
+        anchor = i
+
+        if i - 2 > 0 and i - 2 < matchStartLimit:
+            table[data[i-2:i+2]] = i - 2
+
+    lz4_write_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+def lz4_read_length(data, i, length):
+    if length == 15:
+        while True:
+            byte = data[i]
+            i += 1
+            length += byte
+            if byte != 255:
+                break
+    return i, length
+
+def lz4_decompress(data):
+    out = bytearray()
+    i = 0
+
+    while i < len(data):
+        token = data[i]
+        i += 1
+
+        i, length = lz4_read_length(data, i, token >> 4)
+        out += data[i:i+length]
+        i += length
+
+        if i == len(data):
+            break
+
+        offset = data[i] | (data[i+1] << 8)
+        i += 2
+
+        i, length = lz4_read_length(data, i, token & 15)
+        for _ in range(length + 4):
+            out.append(out[-offset])
+
+    return bytes(out)
+
+# -----------------------------------------------------
+
+def res2c(namespace, filenames, compress = False):
 
     fdH = open("%s.hpp" % namespace, "w")
     fdH.write("/* (Auto-generated binary data file). */\n")
@@ -46,8 +152,23 @@ def res2c(namespace, filenames):
 
         print("Generating data for \"%s\"" % (filename))
 
-        fdH.write("    extern const char* %sData;\n" % shortFilename)
-        fdH.write("    const unsigned int %sDataSize = %i;\n" % (shortFilename, len(resData)))
+        if compress:
+            origData = resData
+            resData = lz4_compress(origData)
+
+            if lz4_decompress(resData) != origData:
+                print("Compression of \"%s\" failed" % (filename))
+                quit(1)
+
+            dataName = "%sCompressedData" % shortFilename
+            fdH.write("    extern const char* %s;\n" % dataName)
+            fdH.write("    const unsigned int %sCompressedDataSize = %i;\n" % (shortFilename, len(resData)))
+            fdH.write("    const unsigned int %sDataSize = %i;\n" % (shortFilename, len(origData)))
+
+        else:
+            dataName = "%sData" % shortFilename
+            fdH.write("    extern const char* %s;\n" % dataName)
+            fdH.write("    const unsigned int %sDataSize = %i;\n" % (shortFilename, len(resData)))
 
         if tempIndex != len(filenames):
             fdH.write("\n")
@@ -70,7 +191,7 @@ def res2c(namespace, filenames):
                 curColumn += 1
 
         fdC.write("};\n")
-        fdC.write("const char* %s::%sData = (const char*)temp_%s_%i;\n" % (namespace, shortFilename, shortFilename, tempIndex))
+        fdC.write("const char* %s::%s = (const char*)temp_%s_%i;\n" % (namespace, dataName, shortFilename, tempIndex))
 
         if tempIndex != len(filenames):
             fdC.write("\n")
@@ -89,12 +210,19 @@ def res2c(namespace, filenames):
 # -----------------------------------------------------
 
 if __name__ == '__main__':
-    if len(sys.argv) != 3:
-        print("Usage: %s <namespace> <resource-folder>" % sys.argv[0])
+    args = sys.argv[1:]
+    compress = "--compress" in args
+
+    if compress:
+        args.remove("--compress")
+
+    if len(args) != 2:
+        print("Usage: %s [--compress] <namespace> <resource-folder>" % sys.argv[0])
+        print("  --compress  store LZ4 compressed data, to be decoded at runtime with d_getDecompressedResource")
         quit()
 
-    namespace = sys.argv[1].replace("-","_")
-    resFolder = sys.argv[2]
+    namespace = args[0].replace("-","_")
+    resFolder = args[1]
 
     if not os.path.exists(resFolder):
         print("Folder '%s' does not exist" % resFolder)
@@ -110,4 +238,4 @@ if __name__ == '__main__':
     resFiles.sort()
 
     # create code now
-    res2c(namespace, resFiles)
+    res2c(namespace, resFiles, compress)